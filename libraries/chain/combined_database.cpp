@@ -6,7 +6,40 @@
 #include <eosio/chain/backing_store/db_context.hpp>
 #include <eosio/chain/backing_store/db_key_value_format.hpp>
 
+#include <rocksdb/cache.h>
+#include <rocksdb/slice_transform.h>
+#include <rocksdb/statistics.h>
+
 namespace eosio { namespace chain {
+   namespace {
+      // number of parts the contract tables of chainbase are written in, independent of the threads writing them so
+      // that a snapshot does not depend on the node which wrote it
+      constexpr int64_t contract_tables_snapshot_parts = 16;
+
+      // The contract, scope and table of DB API keys and the contract of KV API keys, so that bloom filters on these
+      // prefixes let seeks within a table skip the files which do not hold it.
+      class contract_prefix_transform : public rocksdb::SliceTransform {
+       public:
+         static constexpr size_t kv_prefix_size = sizeof(char) + sizeof(uint64_t);     // type + contract
+         static constexpr size_t db_prefix_size = sizeof(char) + sizeof(uint64_t) * 3; // type + contract + scope + table
+
+         const char* Name() const override { return "eosio.contract_prefix.v1"; }
+
+         rocksdb::Slice Transform(const rocksdb::Slice& key) const override { return { key.data(), prefix_size(key) }; }
+
+         bool InDomain(const rocksdb::Slice& key) const override { return prefix_size(key) != 0; }
+
+       private:
+         static size_t prefix_size(const rocksdb::Slice& key) {
+            if (key.size() >= db_prefix_size && key[0] == backing_store::rocksdb_contract_db_prefix)
+               return db_prefix_size;
+            if (key.size() >= kv_prefix_size && key[0] == backing_store::rocksdb_contract_kv_prefix)
+               return kv_prefix_size;
+            return 0;
+         }
+      };
+   }
+
    combined_session::combined_session(chainbase::database& cb_database, eosio::session::undo_stack<rocks_db_type>* undo_stack)
        : kv_undo_stack{ undo_stack } {
       cb_session = std::make_unique<chainbase::database::session>(cb_database.start_undo_session(true));
@@ -222,6 +255,44 @@ namespace eosio { namespace chain {
 	          table_options.filter_policy.reset(rocksdb::NewBloomFilterPolicy(15, false));
 	          table_options.index_type = rocksdb::BlockBasedTableOptions::kBinarySearch;
 
+            // The prefix of a key is added to the bloom filters next to the whole key.  The session iterators seek in
+            // total order, the prefix filters serve the memtable and seeks bounded to a prefix.
+            if (cfg.persistent_storage_prefix_bloom) {
+               options.prefix_extractor                 = std::make_shared<contract_prefix_transform>();
+               options.memtable_prefix_bloom_size_ratio = 0.02;
+            }
+
+            // One block cache shared by data, index and filter blocks.  Index and filter blocks are kept in its high
+            // priority pool so that scans do not evict them.
+            if (cfg.persistent_storage_clock_cache) {
+               kv_block_cache = rocksdb::NewClockCache(cfg.persistent_storage_block_cache_size);
+               if (!kv_block_cache)
+                  wlog("rocksdb is built without clock cache support, using an LRU block cache");
+            }
+            if (!kv_block_cache)
+               kv_block_cache = rocksdb::NewLRUCache(cfg.persistent_storage_block_cache_size, -1, false, 0.5);
+            table_options.block_cache                                       = kv_block_cache;
+            table_options.cache_index_and_filter_blocks                     = true;
+            table_options.cache_index_and_filter_blocks_with_high_priority = true;
+            table_options.pin_l0_filter_and_index_blocks_in_cache           = true;
+
+            // Partitioned index and filters only keep a small top level index of the partitions in memory and load the
+            // partitions a read needs, instead of the whole index and filter of a file.
+            if (cfg.persistent_storage_partitioned_index) {
+               table_options.index_type                      = rocksdb::BlockBasedTableOptions::kTwoLevelIndexSearch;
+               table_options.partition_filters               = true;
+               table_options.metadata_block_size             = 4096;
+               table_options.pin_top_level_index_and_filter = true;
+            }
+
+            if (cfg.persistent_storage_row_cache_size > 0) {
+               kv_row_cache = rocksdb::NewLRUCache(cfg.persistent_storage_row_cache_size);
+               options.row_cache = kv_row_cache;
+            }
+
+            kv_statistics = rocksdb::CreateDBStatistics();
+            options.statistics = kv_statistics;
+
             // Incorporates the Table options into options
             options.table_factory.reset(NewBlockBasedTableFactory(table_options));
 
@@ -229,11 +300,15 @@ namespace eosio { namespace chain {
             auto         status = rocksdb::DB::Open(options, (cfg.state_dir / "chain-kv").string(), &p);
             if (!status.ok())
                throw std::runtime_error(std::string{ "database::database: rocksdb::DB::Open: " } + status.ToString());
-            auto rdb        = std::shared_ptr<rocksdb::DB>{ p };
-            return std::make_unique<rocks_db_type>(eosio::session::make_session(std::move(rdb), 1024));
+            kv_rocksdb = std::shared_ptr<rocksdb::DB>{ p };
+            return std::make_unique<rocks_db_type>(eosio::session::make_session(kv_rocksdb, 1024));
          }() },
          kv_undo_stack(std::make_unique<eosio::session::undo_stack<rocks_db_type>>(*kv_database, cfg.state_dir)),
-         kv_snapshot_batch_threashold(cfg.persistent_storage_mbytes_batch * 1024 * 1024)  {}
+         kv_snapshot_batch_threashold(cfg.persistent_storage_mbytes_batch * 1024 * 1024)  {
+      // Irreversible changes are written into rocksdb in the background.  Rocksdb is written without a WAL, so after a
+      // crash the state is replayed from the block log either way.
+      kv_undo_stack->async_commit(cfg.persistent_storage_async_commit);
+   }
 
    void combined_database::check_backing_store_setting(bool clean_startup) {
       if (backing_store != db.get<kv_db_config_object>().backing_store) {   
@@ -318,6 +393,7 @@ namespace eosio { namespace chain {
       if (backing_store == backing_store_type::ROCKSDB) {
          try {
             try {
+               kv_undo_stack->wait_for_commit();
                kv_database->flush();
             }
             FC_LOG_AND_RETHROW()
@@ -326,6 +402,37 @@ namespace eosio { namespace chain {
       }
    }
 
+   persistent_storage_stats combined_database::get_persistent_storage_stats() const {
+      EOS_ASSERT(backing_store == backing_store_type::ROCKSDB, unsupported_feature,
+                 "persistent storage statistics are only available with the rocksdb backing store");
+
+      persistent_storage_stats stats;
+      stats.block_cache_capacity     = kv_block_cache->GetCapacity();
+      stats.block_cache_usage        = kv_block_cache->GetUsage();
+      stats.block_cache_pinned_usage = kv_block_cache->GetPinnedUsage();
+      if (kv_row_cache) {
+         stats.row_cache_capacity = kv_row_cache->GetCapacity();
+         stats.row_cache_usage    = kv_row_cache->GetUsage();
+      }
+
+      stats.block_cache_hits            = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_HIT);
+      stats.block_cache_misses          = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_MISS);
+      stats.index_block_hits            = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_INDEX_HIT);
+      stats.index_block_misses          = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_INDEX_MISS);
+      stats.filter_block_hits           = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_FILTER_HIT);
+      stats.filter_block_misses         = kv_statistics->getTickerCount(rocksdb::BLOCK_CACHE_FILTER_MISS);
+      stats.bloom_filter_useful         = kv_statistics->getTickerCount(rocksdb::BLOOM_FILTER_USEFUL);
+      stats.bloom_filter_prefix_checked = kv_statistics->getTickerCount(rocksdb::BLOOM_FILTER_PREFIX_CHECKED);
+      stats.bloom_filter_prefix_useful  = kv_statistics->getTickerCount(rocksdb::BLOOM_FILTER_PREFIX_USEFUL);
+      stats.row_cache_hits              = kv_statistics->getTickerCount(rocksdb::ROW_CACHE_HIT);
+      stats.row_cache_misses            = kv_statistics->getTickerCount(rocksdb::ROW_CACHE_MISS);
+
+      kv_rocksdb->GetIntProperty(rocksdb::DB::Properties::kEstimateNumKeys, &stats.estimate_num_keys);
+      kv_rocksdb->GetIntProperty(rocksdb::DB::Properties::kEstimateTableReadersMem, &stats.estimate_table_readers_mem);
+      kv_rocksdb->GetIntProperty(rocksdb::DB::Properties::kTotalSstFilesSize, &stats.total_sst_files_size);
+      return stats;
+   }
+
    std::unique_ptr<kv_context> combined_database::create_kv_context(name receiver, kv_resource_manager resource_manager,
                                                                     const kv_database_config& limits) const {
       switch (backing_store) {
@@ -361,19 +468,125 @@ namespace eosio { namespace chain {
       snapshot->write_section<block_state>(
             [this, &head](auto& section) { section.template add_row<block_header_state>(head, db); });
 
-      eosio::chain::controller_index_set::walk_indices([this, &snapshot](auto utils) {
+      // The sections only read the state and are written concurrently, except for the rocksdb sections which share
+      // the iterators of the undo stack session and are written one after the other.
+      std::vector<snapshot_writer::task> tasks;
+      eosio::chain::controller_index_set::walk_indices([this, &tasks](auto utils) {
          using value_t = typename decltype(utils)::index_t::value_type;
 
-         snapshot->write_section<value_t>([utils, this](auto& section) {
-            walk_index(utils, db, [this, &section](const auto& row) { section.add_row(row, db); });
+         tasks.emplace_back([utils, this](const snapshot_writer_ptr& snapshot) {
+            snapshot->write_section<value_t>([utils, this](auto& section) {
+               walk_index(utils, db, [this, &section](const auto& row) { section.add_row(row, db); });
+            });
          });
       });
+      tasks.emplace_back([this](const snapshot_writer_ptr& snapshot) { add_kv_table_to_snapshot(snapshot, db, kv_undo_stack); });
+      snapshot->write_concurrently(tasks);
 
-      add_kv_table_to_snapshot(snapshot, db, kv_undo_stack);
       add_contract_tables_to_snapshot(snapshot);
 
-      authorization.add_to_snapshot(snapshot);
-      resource_limits.add_to_snapshot(snapshot);
+      snapshot->write_concurrently({
+         [&authorization](const snapshot_writer_ptr& snapshot) { authorization.add_to_snapshot(snapshot); },
+         [&resource_limits](const snapshot_writer_ptr& snapshot) { resource_limits.add_to_snapshot(snapshot); }
+      });
+   }
+
+   template <typename Section>
+   void chainbase_read_contract_tables_from_snapshot(chainbase::database& db, Section& section) {
+      bool more = !section.empty();
+      while (more) {
+         // read the row for the table
+         table_id_object::id_type t_id;
+
+         index_utils<table_id_multi_index>::create(db, [&db, &section, &t_id](auto& row) {
+            section.read_row(row, db);
+            t_id = row.id;
+         });
+
+         // read the size and data rows for each type of table
+         contract_database_index_set::walk_indices([&db, &section, &t_id, &more](auto utils) {
+            using utils_t = decltype(utils);
+
+            unsigned_int size;
+            more = section.read_row(size, db);
+
+            for (size_t idx = 0; idx < size.value; ++idx) {
+               utils_t::create(db, [&db, &section, &more, &t_id](auto& row) {
+                  row.t_id = t_id;
+                  more     = section.read_row(row, db);
+               });
+            }
+         });
+      }
+   }
+
+   template <typename Section>
+   void rocksdb_read_contract_tables_from_snapshot(rocks_db_type& kv_database, chainbase::database& db,
+                                                   Section& section, uint64_t snapshot_batch_threashold) {
+      std::vector<std::pair<eosio::session::shared_bytes, eosio::session::shared_bytes>> batch;
+      bool                more     = !section.empty();
+      auto                read_row = [&section, &more, &db](auto& row) { more = section.read_row(row, db); };
+      uint64_t            batch_mem_size = 0;
+
+      while (more) {
+         // read the row for the table
+         backing_store::table_id_object_view table_obj;
+         read_row(table_obj);
+         auto put = [&batch, &table_obj, &batch_mem_size, &kv_database, snapshot_batch_threashold]
+               (auto&& value, auto create_fun, auto&&... args) {
+            auto composite_key = create_fun(table_obj.scope, table_obj.table, std::forward<decltype(args)>(args)...);
+            batch.emplace_back(backing_store::db_key_value_format::create_full_key(composite_key, table_obj.code),
+                               std::forward<decltype(value)>(value));
+
+            const auto& back = batch.back();
+            const auto size = back.first.size() + back.second.size();
+            if (size >= snapshot_batch_threashold || snapshot_batch_threashold - size < batch_mem_size) {
+               kv_database.write(batch);
+               batch_mem_size = 0;
+               batch.clear();
+            }
+            else {
+               batch_mem_size += size;
+            }
+         };
+
+         // handle the primary key index
+         unsigned_int size;
+         read_row(size);
+         for (size_t i = 0; i < size.value; ++i) {
+            backing_store::primary_index_view row;
+            read_row(row);
+            backing_store::payer_payload pp{row.payer, row.value.data(), row.value.size()};
+            put(pp.as_payload(), backing_store::db_key_value_format::create_primary_key, row.primary_key);
+         }
+
+         auto write_secondary_index = [&put, &read_row](auto index) {
+            using index_t = decltype(index);
+            static const eosio::session::shared_bytes  empty_payload;
+            unsigned_int       size;
+            read_row(size);
+            for (uint32_t i = 0; i < size.value; ++i) {
+               backing_store::secondary_index_view<index_t> row;
+               read_row(row);
+               backing_store::payer_payload pp{row.payer, nullptr, 0};
+               put(pp.as_payload(), &backing_store::db_key_value_format::create_secondary_key<index_t>,
+                   row.secondary_key, row.primary_key);
+
+               put(empty_payload, &backing_store::db_key_value_format::create_primary_to_secondary_key<index_t>,
+                   row.primary_key, row.secondary_key);
+            }
+         };
+
+         // handle secondary key indices
+         std::tuple<uint64_t, uint128_t, key256_t, float64_t, float128_t> indices;
+         std::apply([&write_secondary_index](auto... index) { (write_secondary_index(index), ...); }, indices);
+
+         backing_store::payer_payload pp{table_obj.payer, nullptr, 0};
+         b1::chain_kv::bytes (*create_table_key)(name scope, name table) = backing_store::db_key_value_format::create_table_key;
+         put(pp.as_payload(), create_table_key);
+
+      }
+      kv_database.write(batch);
    }
 
    void combined_database::read_from_snapshot(const snapshot_reader_ptr& snapshot,
@@ -420,6 +633,50 @@ namespace eosio { namespace chain {
          snapshot_head_block = head->block_num;
       }
 
+      // chainbase is loaded by a single task.  In rocksdb the kv table and the parts of the contract tables are
+      // loaded by tasks of their own, concurrently with chainbase.
+      std::vector<snapshot_reader::task> tasks;
+      tasks.emplace_back([this, &header, &authorization, &resource_limits](const snapshot_reader_ptr& snapshot) {
+         read_chainbase_from_snapshot(snapshot, header);
+         if (backing_store != backing_store_type::ROCKSDB) {
+            read_kv_table_from_snapshot(snapshot, db, kv_database, header.version, backing_store);
+            snapshot->read_section("contract_tables", [this](auto& section) {
+               chainbase_read_contract_tables_from_snapshot(db, section);
+            });
+         }
+
+         authorization.read_from_snapshot(snapshot);
+         resource_limits.read_from_snapshot(snapshot, header.version);
+      });
+      if (backing_store == backing_store_type::ROCKSDB) {
+         tasks.emplace_back([this, &header](const snapshot_reader_ptr& snapshot) {
+            read_kv_table_from_snapshot(snapshot, db, kv_database, header.version, backing_store);
+         });
+         const auto parts = snapshot->section_parts("contract_tables");
+         for (size_t part = 0; part < parts; ++part) {
+            tasks.emplace_back([this, part](const snapshot_reader_ptr& snapshot) {
+               snapshot->read_section_part("contract_tables", part, [this](auto& section) {
+                  rocksdb_read_contract_tables_from_snapshot(*kv_database, db, section, kv_snapshot_batch_threashold);
+               });
+            });
+         }
+      }
+      snapshot->read_concurrently(tasks);
+
+      set_revision(head->block_num);
+      db.create<database_header_object>([](const auto& header) {
+         // nothing to do
+      });
+
+      const auto& gpo = db.get<global_property_object>();
+      EOS_ASSERT(gpo.chain_id == chain_id, chain_id_type_exception,
+                 "chain ID in snapshot (${snapshot_chain_id}) does not match the chain ID that controller was "
+                 "constructed with (${controller_chain_id})",
+                 ("snapshot_chain_id", gpo.chain_id)("controller_chain_id", chain_id));
+   }
+
+   void combined_database::read_chainbase_from_snapshot(const snapshot_reader_ptr& snapshot,
+                                                        const chain_snapshot_header& header) {
       controller_index_set::walk_indices([this, &snapshot, &header](auto utils) {
          using value_t = typename decltype(utils)::index_t::value_type;
 
@@ -496,28 +753,12 @@ namespace eosio { namespace chain {
             }
          });
       });
-
-      read_kv_table_from_snapshot(snapshot, db, kv_database, header.version, backing_store);
-      read_contract_tables_from_snapshot(snapshot);
-
-      authorization.read_from_snapshot(snapshot);
-      resource_limits.read_from_snapshot(snapshot, header.version);
-
-      set_revision(head->block_num);
-      db.create<database_header_object>([](const auto& header) {
-         // nothing to do
-      });
-
-      const auto& gpo = db.get<global_property_object>();
-      EOS_ASSERT(gpo.chain_id == chain_id, chain_id_type_exception,
-                 "chain ID in snapshot (${snapshot_chain_id}) does not match the chain ID that controller was "
-                 "constructed with (${controller_chain_id})",
-                 ("snapshot_chain_id", gpo.chain_id)("controller_chain_id", chain_id));
    }
 
    template <typename Section>
-   void chainbase_add_contract_tables_to_snapshot(const chainbase::database& db, Section& section) {
-      index_utils<table_id_multi_index>::walk(db, [&db, &section](const table_id_object& table_row) {
+   void chainbase_add_contract_tables_to_snapshot(const chainbase::database& db, Section& section,
+                                                  table_id_object::id_type begin_id, table_id_object::id_type end_id) {
+      index_utils<table_id_multi_index>::walk_range<by_id>(db, begin_id, end_id, [&db, &section](const table_id_object& table_row) {
          // add a row for the table
          section.add_row(table_row, db);
 
@@ -541,8 +782,8 @@ namespace eosio { namespace chain {
    }
 
    void combined_database::add_contract_tables_to_snapshot(const snapshot_writer_ptr& snapshot) const {
-      snapshot->write_section("contract_tables", [this](auto& section) {
-         if (kv_undo_stack && db.get<kv_db_config_object>().backing_store == backing_store_type::ROCKSDB) {
+      if (kv_undo_stack && db.get<kv_db_config_object>().backing_store == backing_store_type::ROCKSDB) {
+         snapshot->write_section("contract_tables", [this](auto& section) {
             using add_database_section_receiver = backing_store::add_database_receiver<std::decay_t < decltype(section)>>;
             using table_collector = backing_store::rocksdb_whole_db_table_collector<add_database_section_receiver>;
 
@@ -552,118 +793,21 @@ namespace eosio { namespace chain {
             const auto begin_key = eosio::session::shared_bytes(&backing_store::rocksdb_contract_db_prefix, 1);
             const auto end_key = begin_key.next();
             backing_store::walk_rocksdb_entries_with_prefix(kv_undo_stack, begin_key, end_key, writer);
-         }
-         else {
-            chainbase_add_contract_tables_to_snapshot(db, section);
-         }
-      });
-   }
-
-   template <typename Section>
-   void chainbase_read_contract_tables_from_snapshot(chainbase::database& db, Section& section) {
-      bool more = !section.empty();
-      while (more) {
-         // read the row for the table
-         table_id_object::id_type t_id;
-
-         index_utils<table_id_multi_index>::create(db, [&db, &section, &t_id](auto& row) {
-            section.read_row(row, db);
-            t_id = row.id;
-         });
-
-         // read the size and data rows for each type of table
-         contract_database_index_set::walk_indices([&db, &section, &t_id, &more](auto utils) {
-            using utils_t = decltype(utils);
-
-            unsigned_int size;
-            more = section.read_row(size, db);
-
-            for (size_t idx = 0; idx < size.value; ++idx) {
-               utils_t::create(db, [&db, &section, &more, &t_id](auto& row) {
-                  row.t_id = t_id;
-                  more     = section.read_row(row, db);
-               });
-            }
          });
       }
-   }
-
-   template <typename Section>
-   void rocksdb_read_contract_tables_from_snapshot(rocks_db_type& kv_database, chainbase::database& db,
-                                                   Section& section, uint64_t snapshot_batch_threashold) {
-      std::vector<std::pair<eosio::session::shared_bytes, eosio::session::shared_bytes>> batch;
-      bool                more     = !section.empty();
-      auto                read_row = [&section, &more, &db](auto& row) { more = section.read_row(row, db); };
-      uint64_t            batch_mem_size = 0;
-
-      while (more) {
-         // read the row for the table
-         backing_store::table_id_object_view table_obj;
-         read_row(table_obj);
-         auto put = [&batch, &table_obj, &batch_mem_size, &kv_database, snapshot_batch_threashold]
-               (auto&& value, auto create_fun, auto&&... args) {
-            auto composite_key = create_fun(table_obj.scope, table_obj.table, std::forward<decltype(args)>(args)...);
-            batch.emplace_back(backing_store::db_key_value_format::create_full_key(composite_key, table_obj.code),
-                               std::forward<decltype(value)>(value));
-
-            const auto& back = batch.back();
-            const auto size = back.first.size() + back.second.size();
-            if (size >= snapshot_batch_threashold || snapshot_batch_threashold - size < batch_mem_size) {
-               kv_database.write(batch);
-               batch_mem_size = 0;
-               batch.clear();
-            }
-            else {
-               batch_mem_size += size;
-            }
-         };
-
-         // handle the primary key index
-         unsigned_int size;
-         read_row(size);
-         for (size_t i = 0; i < size.value; ++i) {
-            backing_store::primary_index_view row;
-            read_row(row);
-            backing_store::payer_payload pp{row.payer, row.value.data(), row.value.size()};
-            put(pp.as_payload(), backing_store::db_key_value_format::create_primary_key, row.primary_key);
-         }
-
-         auto write_secondary_index = [&put, &read_row](auto index) {
-            using index_t = decltype(index);
-            static const eosio::session::shared_bytes  empty_payload;
-            unsigned_int       size;
-            read_row(size);
-            for (uint32_t i = 0; i < size.value; ++i) {
-               backing_store::secondary_index_view<index_t> row;
-               read_row(row);
-               backing_store::payer_payload pp{row.payer, nullptr, 0};
-               put(pp.as_payload(), &backing_store::db_key_value_format::create_secondary_key<index_t>,
-                   row.secondary_key, row.primary_key);
-
-               put(empty_payload, &backing_store::db_key_value_format::create_primary_to_secondary_key<index_t>,
-                   row.primary_key, row.secondary_key);
-            }
-         };
-
-         // handle secondary key indices
-         std::tuple<uint64_t, uint128_t, key256_t, float64_t, float128_t> indices;
-         std::apply([&write_secondary_index](auto... index) { (write_secondary_index(index), ...); }, indices);
-
-         backing_store::payer_payload pp{table_obj.payer, nullptr, 0};
-         b1::chain_kv::bytes (*create_table_key)(name scope, name table) = backing_store::db_key_value_format::create_table_key;
-         put(pp.as_payload(), create_table_key);
-
+      else {
+         // the tables are written in parts of consecutive table ids
+         const auto& tables = db.get_index<table_id_multi_index, by_id>();
+         const int64_t first_id = tables.empty() ? 0 : tables.begin()->id._id;
+         const int64_t end_id = tables.empty() ? 0 : tables.rbegin()->id._id + 1;
+         const int64_t part_size = (end_id - first_id + contract_tables_snapshot_parts - 1) / contract_tables_snapshot_parts;
+         snapshot->write_section_parts("contract_tables", contract_tables_snapshot_parts,
+                                       [this, first_id, end_id, part_size](size_t part, auto& section) {
+            const int64_t begin = std::min(end_id, first_id + int64_t(part) * part_size);
+            const int64_t end = std::min(end_id, begin + part_size);
+            chainbase_add_contract_tables_to_snapshot(db, section, table_id_object::id_type(begin), table_id_object::id_type(end));
+         });
       }
-      kv_database.write(batch);
-   }
-
-   void combined_database::read_contract_tables_from_snapshot(const snapshot_reader_ptr& snapshot) {
-      snapshot->read_section("contract_tables", [this](auto& section) {
-         if (kv_undo_stack && db.get<kv_db_config_object>().backing_store == backing_store_type::ROCKSDB)
-            rocksdb_read_contract_tables_from_snapshot(*kv_database, db, section, kv_snapshot_batch_threashold);
-         else
-            chainbase_read_contract_tables_from_snapshot(db, section);
-      });
    }
 
    std::optional<eosio::chain::genesis_state> extract_legacy_genesis_state(snapshot_reader& snapshot,
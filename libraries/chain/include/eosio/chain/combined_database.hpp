@@ -81,6 +81,31 @@ namespace eosio { namespace chain {
       eosio::session::undo_stack<rocks_db_type>*     kv_undo_stack = nullptr;
    };
 
+   /**
+    * Cache and filter statistics of the rocksdb backing store, the counters are totals since startup
+    */
+   struct persistent_storage_stats {
+      uint64_t block_cache_capacity = 0;
+      uint64_t block_cache_usage = 0;
+      uint64_t block_cache_pinned_usage = 0;
+      uint64_t row_cache_capacity = 0;
+      uint64_t row_cache_usage = 0;
+      uint64_t block_cache_hits = 0;
+      uint64_t block_cache_misses = 0;
+      uint64_t index_block_hits = 0;
+      uint64_t index_block_misses = 0;
+      uint64_t filter_block_hits = 0;
+      uint64_t filter_block_misses = 0;
+      uint64_t bloom_filter_useful = 0;          ///< point reads answered by a bloom filter
+      uint64_t bloom_filter_prefix_checked = 0;  ///< seeks which checked a prefix bloom filter
+      uint64_t bloom_filter_prefix_useful = 0;   ///< seeks which skipped a file by its prefix bloom filter
+      uint64_t row_cache_hits = 0;
+      uint64_t row_cache_misses = 0;
+      uint64_t estimate_num_keys = 0;
+      uint64_t estimate_table_readers_mem = 0;   ///< memory of index and filter blocks held outside of the block cache
+      uint64_t total_sst_files_size = 0;
+   };
+
    class combined_database {
     public:
       explicit combined_database(chainbase::database& chain_db,
@@ -113,6 +138,9 @@ namespace eosio { namespace chain {
 
       void flush();
 
+      /// @throws unsupported_feature if the backing store is not rocksdb
+      persistent_storage_stats get_persistent_storage_stats() const;
+
       static void destroy(const fc::path& p);
 
       std::unique_ptr<kv_context> create_kv_context(name receiver, kv_resource_manager resource_manager,
@@ -136,10 +164,15 @@ namespace eosio { namespace chain {
 
     private:
       void add_contract_tables_to_snapshot(const snapshot_writer_ptr& snapshot) const;
-      void read_contract_tables_from_snapshot(const snapshot_reader_ptr& snapshot);
+      void read_chainbase_from_snapshot(const snapshot_reader_ptr& snapshot, const chain_snapshot_header& header);
 
       backing_store_type                                         backing_store;
       chainbase::database&                                       db;
+      // set up before kv_database
+      std::shared_ptr<rocksdb::Cache>                            kv_block_cache;
+      std::shared_ptr<rocksdb::Cache>                            kv_row_cache;
+      std::shared_ptr<rocksdb::Statistics>                       kv_statistics;
+      std::shared_ptr<rocksdb::DB>                               kv_rocksdb;
       std::unique_ptr<rocks_db_type>                             kv_database;
       kv_undo_stack_ptr                                          kv_undo_stack;
       const uint64_t                                             kv_snapshot_batch_threashold;
@@ -151,3 +184,9 @@ namespace eosio { namespace chain {
    char make_rocksdb_contract_db_prefix();
 
 }} // namespace eosio::chain
+
+FC_REFLECT( eosio::chain::persistent_storage_stats, (block_cache_capacity)(block_cache_usage)(block_cache_pinned_usage)
+            (row_cache_capacity)(row_cache_usage)(block_cache_hits)(block_cache_misses)(index_block_hits)(index_block_misses)
+            (filter_block_hits)(filter_block_misses)(bloom_filter_useful)(bloom_filter_prefix_checked)
+            (bloom_filter_prefix_useful)(row_cache_hits)(row_cache_misses)(estimate_num_keys)(estimate_table_readers_mem)
+            (total_sst_files_size) )
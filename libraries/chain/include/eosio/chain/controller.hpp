@@ -90,6 +90,12 @@ namespace eosio { namespace chain {
             uint64_t                 persistent_storage_write_buffer_size = chain::config::default_persistent_storage_write_buffer_size;
             uint64_t                 persistent_storage_bytes_per_sync = chain::config::default_persistent_storage_bytes_per_sync;
             uint32_t                 persistent_storage_mbytes_batch = chain::config::default_persistent_storage_mbytes_batch;
+            bool                     persistent_storage_async_commit = true;
+            uint64_t                 persistent_storage_block_cache_size = chain::config::default_persistent_storage_block_cache_size;
+            bool                     persistent_storage_clock_cache = false;
+            uint64_t                 persistent_storage_row_cache_size = chain::config::default_persistent_storage_row_cache_size;
+            bool                     persistent_storage_partitioned_index = true;
+            bool                     persistent_storage_prefix_bloom = false;
             fc::microseconds         abi_serializer_max_time_us = fc::microseconds(chain::config::default_abi_serializer_max_time_us);
             uint32_t   max_nonprivileged_inline_action_size =  chain::config::default_max_nonprivileged_inline_action_size;
             bool                     read_only                  = false;
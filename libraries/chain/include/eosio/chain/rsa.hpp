@@ -0,0 +1,120 @@
+#pragma once
+
+#include <fc/crypto/sha256.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace eosio { namespace chain { namespace rsa {
+
+   namespace detail {
+      /**
+       * Fixed width Montgomery form of an odd modulus of up to 64*N bits, R = 2^(64*N).
+       * Limbs are stored least significant first.
+       */
+      template<size_t N>
+      struct montgomery_key {
+         using limbs = std::array<uint64_t, N>;
+
+         limbs    modulus;
+         uint64_t modulus_inv;   ///< -modulus^-1 mod 2^64
+         limbs    r2;            ///< R^2 mod modulus
+         limbs    exponent;
+         uint32_t exponent_bits;
+      };
+   }
+
+   /**
+    * RSA public key parsed from the hexadecimal exponent and modulus of the WAX verify_rsa_sha256_sig intrinsic.
+    *
+    * Exponentiation works on fixed width integers of 1024, 2048 or 4096 bits without allocating. Keys the engine
+    * does not cover (even or wider moduli, exponents wider than the modulus) are rejected by from_hex and have to be
+    * handled by a generic implementation.
+    */
+   class public_key {
+   public:
+      static constexpr size_t max_size = 512;
+
+      /**
+       * @param exponent hexadecimal digits of any length
+       * @param modulus hexadecimal digits, two per byte of the key size
+       * @return the parsed key, empty if the key is not supported
+       */
+      static std::optional<public_key> from_hex(std::string_view exponent, std::string_view modulus);
+
+      /// size of the modulus in bytes, leading zero bytes included
+      size_t size() const { return _size; }
+
+      /**
+       * Computes signature^exponent mod modulus
+       * @param signature hexadecimal digits, two per byte of size()
+       * @param out receives the result as size() big endian bytes
+       * @return false if the signature is not size() bytes of hexadecimal digits
+       */
+      bool power(std::string_view signature, unsigned char* out) const;
+
+      /**
+       * Verifies an EMSA-PKCS1-v1_5 encoded SHA-256 signature
+       * @return empty if the signature is not size() bytes of hexadecimal digits
+       */
+      std::optional<bool> verify_sha256(const fc::sha256& digest, std::string_view signature) const;
+
+   private:
+      size_t                                        _size = 0;
+      std::variant<detail::montgomery_key<16>,
+                   detail::montgomery_key<32>,
+                   detail::montgomery_key<64>>       _key;
+   };
+
+   /**
+    * Bounded cache of parsed public keys, keyed by the hexadecimal exponent and modulus as passed to the intrinsic.
+    *
+    * A cached key is identical to a freshly parsed one, so hits and evictions only change how long a verification
+    * takes, never its result. The least recently used key is evicted once the cache is full. Thread safe.
+    */
+   class key_cache {
+   public:
+      struct stats {
+         uint64_t hits   = 0;
+         uint64_t misses = 0;
+         size_t   size   = 0;
+      };
+
+      explicit key_cache(size_t capacity);
+
+      /// @return the cached or newly parsed key, null if public_key::from_hex does not support it
+      std::shared_ptr<const public_key> get(std::string_view exponent, std::string_view modulus);
+
+      stats get_stats() const;
+      void  clear();
+
+   private:
+      struct entry {
+         size_t                            hash;
+         std::string                       exponent;
+         std::string                       modulus;
+         std::shared_ptr<const public_key> key;
+         uint64_t                          last_used;
+      };
+
+      const size_t          _capacity;
+      mutable std::mutex    _mtx;
+      std::vector<entry>    _entries;
+      uint64_t              _tick = 0;
+      std::atomic<uint64_t> _hits{0};
+      std::atomic<uint64_t> _misses{0};
+   };
+
+   /// key cache of the verify_rsa_sha256_sig intrinsic
+   key_cache& intrinsic_key_cache();
+
+}}} // namespace eosio::chain::rsa
@@ -2,9 +2,15 @@
 
 #include <eosio/chain/database_utils.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <fc/filesystem.hpp>
 #include <fc/variant_object.hpp>
 #include <boost/core/demangle.hpp>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <memory>
 #include <ostream>
+#include <vector>
 
 namespace eosio { namespace chain {
    /**
@@ -13,6 +19,14 @@ namespace eosio { namespace chain {
     */
    static const uint32_t current_snapshot_version = 1;
 
+   class named_thread_pool;
+
+   class snapshot_writer;
+   using snapshot_writer_ptr = std::shared_ptr<snapshot_writer>;
+
+   class snapshot_reader;
+   using snapshot_reader_ptr = std::shared_ptr<snapshot_reader>;
+
    namespace detail {
       template<typename T>
       struct snapshot_section_traits {
@@ -144,16 +158,33 @@ namespace eosio { namespace chain {
             write_section(detail::snapshot_section_traits<T>::section_name(), f);
          }
 
+         /**
+          * Writes a section whose rows are produced by `parts` calls of f(part, section), concurrently if the writer
+          * supports it.  The rows are stored in the order of the parts, as if they were produced by a single section.
+          */
+         template<typename F>
+         void write_section_parts(const std::string& section_name, size_t parts, F f) {
+            write_parts(section_name, parts, [&f](size_t part, section_writer& section) { f(part, section); });
+         }
+
+         using task = std::function<void(const snapshot_writer_ptr&)>;
+
+         /**
+          * Runs each task with a writer of its own, concurrently if the writer supports it.  The sections written by
+          * the tasks are stored in the order of the tasks.
+          */
+         virtual void write_concurrently( const std::vector<task>& tasks );
+
       virtual ~snapshot_writer(){};
 
       protected:
          virtual void write_start_section( const std::string& section_name ) = 0;
          virtual void write_row( const detail::abstract_snapshot_row_writer& row_writer ) = 0;
          virtual void write_end_section() = 0;
+         virtual void write_parts( const std::string& section_name, size_t parts,
+                                   const std::function<void(size_t, section_writer&)>& f );
    };
 
-   using snapshot_writer_ptr = std::shared_ptr<snapshot_writer>;
-
    namespace detail {
       struct abstract_snapshot_row_reader {
          virtual void provide(std::istream& in) const = 0;
@@ -277,6 +308,26 @@ namespace eosio { namespace chain {
          return has_section(suffix + detail::snapshot_section_traits<T>::section_name());
       }
 
+      /**
+       * Reads one of the parts of a section, which can be read independently of each other.  The rows of the parts
+       * in order are the rows of the section.
+       */
+      template<typename F>
+      void read_section_part(const std::string& section_name, size_t part, F f) {
+         set_section_part(section_name, part);
+         auto section = section_reader(*this);
+         f(section);
+         clear_section();
+      }
+
+      /// Number of parts of a section which can be read with read_section_part
+      virtual size_t section_parts( const std::string& section_name ) { return 1; }
+
+      using task = std::function<void(const snapshot_reader_ptr&)>;
+
+      /// Runs each task with a reader of its own, concurrently if the reader supports it.
+      virtual void read_concurrently( const std::vector<task>& tasks );
+
       virtual void validate() const = 0;
 
       virtual void return_to_header() = 0;
@@ -286,13 +337,12 @@ namespace eosio { namespace chain {
       protected:
          virtual bool has_section( const std::string& section_name ) = 0;
          virtual void set_section( const std::string& section_name ) = 0;
+         virtual void set_section_part( const std::string& section_name, size_t part );
          virtual bool read_row( detail::abstract_snapshot_row_reader& row_reader ) = 0;
          virtual bool empty( ) = 0;
          virtual void clear_section() = 0;
    };
 
-   using snapshot_reader_ptr = std::shared_ptr<snapshot_reader>;
-
    class variant_snapshot_writer : public snapshot_writer {
       public:
          variant_snapshot_writer(fc::mutable_variant_object& snapshot);
@@ -366,6 +416,181 @@ namespace eosio { namespace chain {
          uint64_t       cur_row;
    };
 
+   /**
+    * Writes the format of ostream_snapshot_writer with the sections written concurrently into chunk files of their
+    * own, which finalize concatenates.  The end marker is followed by a directory of the sections and the parts they
+    * were written in, so that parallel_istream_snapshot_reader can seek to every part directly.  Readers of the format
+    * of ostream_snapshot_writer stop at the end marker and read these snapshots unchanged.
+    *
+    * Directory: magic number, section count, then per section its name (length prefixed), part count and per part the
+    * offset of its first row and its row count.  The offset of the directory ends the snapshot.  Offsets are relative
+    * to the start of the snapshot.
+    */
+   class parallel_ostream_snapshot_writer : public snapshot_writer {
+      public:
+         /**
+          * @param chunk_dir : directory created for the chunks while the sections are written, removed by finalize
+          * @param threads : number of threads writing sections concurrently
+          */
+         parallel_ostream_snapshot_writer(std::ostream& snapshot, const fc::path& chunk_dir, uint32_t threads);
+         ~parallel_ostream_snapshot_writer();
+
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void write_concurrently( const std::vector<task>& tasks ) override;
+         void finalize();
+
+         static const uint32_t directory_magic_number = 0x30510551;
+
+      protected:
+         void write_parts( const std::string& section_name, size_t parts,
+                           const std::function<void(size_t, section_writer&)>& f ) override;
+
+      private:
+         class chunk_writer;
+
+         std::shared_ptr<chunk_writer> make_chunk_writer();
+
+         detail::ostream_wrapper             snapshot;
+         std::streampos                      header_pos;
+         fc::path                            chunk_dir;
+         std::atomic<uint64_t>               chunk_count{0};
+         std::unique_ptr<named_thread_pool>  thread_pool;
+         std::shared_ptr<chunk_writer>       main_writer; ///< sections written outside of tasks
+   };
+
+   /**
+    * Reads binary snapshots from a file, opened once for every task of read_concurrently so that sections and parts
+    * of sections are read in parallel.  Snapshots without the directory of parallel_ostream_snapshot_writer are read
+    * as well, with a single part per section.
+    */
+   class parallel_istream_snapshot_reader : public snapshot_reader {
+      public:
+         /// @param threads : number of threads running the tasks of read_concurrently
+         parallel_istream_snapshot_reader(const fc::path& snapshot_path, uint32_t threads);
+         ~parallel_istream_snapshot_reader();
+
+         void validate() const override;
+         bool has_section( const string& section_name ) override;
+         void set_section( const string& section_name ) override;
+         void set_section_part( const string& section_name, size_t part ) override;
+         size_t section_parts( const string& section_name ) override;
+         bool read_row( detail::abstract_snapshot_row_reader& row_reader ) override;
+         bool empty ( ) override;
+         void clear_section() override;
+         void return_to_header() override;
+         void read_concurrently( const std::vector<task>& tasks ) override;
+
+      private:
+         struct section_part {
+            uint64_t pos  = 0;
+            uint64_t rows = 0;
+         };
+
+         struct section_entry {
+            std::string               name;
+            std::vector<section_part> parts;
+         };
+
+         using directory = std::vector<section_entry>;
+
+         parallel_istream_snapshot_reader(const fc::path& snapshot_path, const std::shared_ptr<const directory>& dir);
+
+         const directory& get_directory() const;
+         const section_entry& get_section( const string& section_name );
+         std::shared_ptr<const directory> load_directory() const;
+
+         fc::path                                 snapshot_path;
+         mutable std::ifstream                    snapshot;
+         mutable std::shared_ptr<const directory> dir;
+         std::unique_ptr<named_thread_pool>       thread_pool; ///< none for the readers of tasks
+         uint64_t                                 num_rows;
+         uint64_t                                 cur_row;
+   };
+
+   /**
+    * Writes snapshots compressed with zstd, without seeking so that they can be written to a pipe.  The integrity hash
+    * of integrity_hash_snapshot_writer is computed from the rows as they are written.
+    *
+    * Format: magic number and version, then per section its name (length prefixed) and its frames, each of them the
+    * compressed size, the row count and a zstd frame of whole rows.  A compressed size of 0 ends a section.  The
+    * sections are followed by an end marker, an index of the sections (name, offset and row count), the integrity
+    * hash, the offset of the end marker and the magic number again.  Offsets are relative to the start of the
+    * snapshot.
+    */
+   class zstd_ostream_snapshot_writer : public snapshot_writer {
+      public:
+         explicit zstd_ostream_snapshot_writer(std::ostream& snapshot, int compression_level = default_compression_level);
+         ~zstd_ostream_snapshot_writer();
+
+         void write_start_section( const std::string& section_name ) override;
+         void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override;
+         void write_end_section( ) override;
+         void finalize();
+
+         /// the hash of the rows written, set by finalize
+         const fc::sha256& get_integrity_hash() const { return integrity_hash; }
+
+         static const uint32_t magic_number = 0x30510552;
+         static const int      default_compression_level = 3;
+
+      private:
+         struct section_index_entry {
+            std::string name;
+            uint64_t    pos  = 0;
+            uint64_t    rows = 0;
+         };
+
+         struct impl;
+
+         void write( const char* data, size_t size );
+         void write_frame();
+
+         std::ostream&                    snapshot;
+         std::unique_ptr<impl>            my;
+         uint64_t                         pos = 0; ///< bytes written, as the stream may not tell its position
+         bool                             in_section = false;
+         std::vector<section_index_entry> sections;
+         fc::sha256::encoder              enc;
+         fc::sha256                       integrity_hash;
+   };
+
+   /**
+    * Reads the snapshots of zstd_ostream_snapshot_writer from a stream without seeking, so that they can be read from
+    * a pipe.  The frames of a section are decompressed on a thread of their own, ahead of the rows being read.
+    *
+    * Sections are read from the stream in the order they were written.  A section passed over to reach a section
+    * requested ahead of it is kept compressed in memory until it is read.  A reader opened for two passes also keeps
+    * every section read before the first call of return_to_header, which can only be called once, and only on such a
+    * reader.  The tasks of read_concurrently are given the sections they ask for as they come.  The integrity hash of
+    * the trailer is checked against the rows once the stream is read to its end.
+    */
+   class zstd_istream_snapshot_reader : public snapshot_reader {
+      public:
+         explicit zstd_istream_snapshot_reader(std::istream& snapshot, bool two_pass = false);
+         ~zstd_istream_snapshot_reader();
+
+         void validate() const override;
+         bool has_section( const string& section_name ) override;
+         void set_section( const string& section_name ) override;
+         bool read_row( detail::abstract_snapshot_row_reader& row_reader ) override;
+         bool empty ( ) override;
+         void clear_section() override;
+         void return_to_header() override;
+         void read_concurrently( const std::vector<task>& tasks ) override;
+
+      private:
+         class source;
+         class section;
+
+         explicit zstd_istream_snapshot_reader(const std::shared_ptr<source>& src);
+
+         std::shared_ptr<source>   src;         ///< shared with the readers of tasks
+         bool                      task_reader = false;
+         std::unique_ptr<section>  cur_section;
+   };
+
    class integrity_hash_snapshot_writer : public snapshot_writer {
       public:
          explicit integrity_hash_snapshot_writer(fc::sha256::encoder&  enc);
@@ -8,6 +8,8 @@
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/composite_key.hpp>
 
 namespace fc {
   inline std::size_t hash_value( const fc::sha256& v ) {
@@ -37,6 +39,7 @@ struct unapplied_transaction {
    next_func_t                    next;
 
    const transaction_id_type& id()const { return trx_meta->id(); }
+   account_name first_authorizer()const { return trx_meta->packed_trx()->get_transaction().first_authorizer(); }
 
    unapplied_transaction(const unapplied_transaction&) = delete;
    unapplied_transaction() = delete;
@@ -53,6 +56,7 @@ private:
    struct by_trx_id;
    struct by_type;
    struct by_expiry;
+   struct by_account;
 
    typedef multi_index_container< unapplied_transaction,
       indexed_by<
@@ -60,7 +64,13 @@ private:
                const_mem_fun<unapplied_transaction, const transaction_id_type&, &unapplied_transaction::id>
          >,
          ordered_non_unique< tag<by_type>, member<unapplied_transaction, trx_enum_type, &unapplied_transaction::trx_type> >,
-         ordered_non_unique< tag<by_expiry>, member<unapplied_transaction, const fc::time_point, &unapplied_transaction::expiry> >
+         ordered_non_unique< tag<by_expiry>, member<unapplied_transaction, const fc::time_point, &unapplied_transaction::expiry> >,
+         ordered_non_unique< tag<by_account>,
+               composite_key< unapplied_transaction,
+                     const_mem_fun<unapplied_transaction, account_name, &unapplied_transaction::first_authorizer>,
+                     member<unapplied_transaction, trx_enum_type, &unapplied_transaction::trx_type>
+               >
+         >
       >
    > unapplied_trx_queue_type;
 
@@ -89,6 +99,49 @@ public:
       return incoming_count;
    }
 
+   /// number of queued transactions with first authorizer a
+   size_t account_size( const account_name& a ) const {
+      return queue.get<by_account>().count( std::make_tuple( a ) );
+   }
+
+   /**
+    * Call f( first authorizer, number of queued transactions ) for each first authorizer not less than lower_bound,
+    * in account order, until f returns false.
+    */
+   template <typename Func>
+   void for_each_account( const account_name& lower_bound, Func&& f ) const {
+      const auto& idx = queue.get<by_account>();
+      auto itr = idx.lower_bound( std::make_tuple( lower_bound ) );
+      while( itr != idx.end() ) {
+         const account_name a = itr->first_authorizer();
+         const auto next = idx.upper_bound( std::make_tuple( a ) );
+         if( !f( a, static_cast<size_t>( std::distance( itr, next ) ) ) )
+            return;
+         itr = next;
+      }
+   }
+
+   /**
+    * Erase all transactions with first authorizer a and a type in [first, last] in one step.
+    * Iterators to other transactions remain valid.
+    * @param callback called with each transaction before it is erased, caller's responsibility to call next() if applicable
+    * @return number of erased transactions
+    */
+   template <typename Func>
+   size_t erase_account( const account_name& a, trx_enum_type first, trx_enum_type last, Func&& callback ) {
+      auto& idx = queue.get<by_account>();
+      auto itr = idx.lower_bound( std::make_tuple( a, first ) );
+      const auto end = idx.upper_bound( std::make_tuple( a, last ) );
+      size_t erased = 0;
+      while( itr != end ) {
+         callback( *itr );
+         removed( itr );
+         itr = idx.erase( itr );
+         ++erased;
+      }
+      return erased;
+   }
+
    transaction_metadata_ptr get_trx( const transaction_id_type& id ) const {
       auto itr = queue.get<by_trx_id>().find( id );
       if( itr == queue.get<by_trx_id>().end() ) return {};
@@ -0,0 +1,281 @@
+#include <eosio/chain/rsa.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace eosio { namespace chain { namespace rsa {
+
+   namespace {
+
+      using detail::montgomery_key;
+
+      // EMSA-PKCS1-v1_5 DigestInfo prefix of SHA-256
+      constexpr unsigned char sha256_digest_info[] = { 0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+                                                       0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+      constexpr size_t sha256_size = 32;
+      constexpr size_t encoding_size = sizeof(sha256_digest_info) + sha256_size;
+      constexpr uint64_t exponent_65537 = 65537;
+
+      int hex_digit(char c) {
+         if (c >= '0' && c <= '9')
+            return c - '0';
+         if (c >= 'a' && c <= 'f')
+            return c - 'a' + 10;
+         if (c >= 'A' && c <= 'F')
+            return c - 'A' + 10;
+         return -1;
+      }
+
+      // parses big endian hexadecimal digits, fails on anything but hexadecimal digits or on values wider than N limbs
+      template<size_t N>
+      bool parse_hex(std::string_view hex, std::array<uint64_t, N>& out) {
+         out.fill(0);
+         size_t first = 0;
+         while (first < hex.size() && hex[first] == '0')
+            ++first;
+         if (hex.size() - first > N * 16)
+            return false;
+         for (size_t i = 0; i < hex.size() - first; ++i) {
+            int digit = hex_digit(hex[hex.size() - 1 - i]);
+            if (digit < 0)
+               return false;
+            out[i / 16] |= uint64_t(digit) << (4 * (i % 16));
+         }
+         for (size_t i = 0; i < first; ++i) {
+            if (hex[i] != '0')
+               return false;
+         }
+         return true;
+      }
+
+      template<size_t N>
+      uint32_t bit_length(const std::array<uint64_t, N>& a) {
+         for (size_t i = N; i-- > 0;) {
+            if (a[i])
+               return i * 64 + 64 - __builtin_clzll(a[i]);
+         }
+         return 0;
+      }
+
+      template<size_t N>
+      bool bit(const std::array<uint64_t, N>& a, uint32_t i) {
+         return (a[i / 64] >> (i % 64)) & 1;
+      }
+
+      // a -= b over n limbs, returns the borrow
+      uint64_t sub(uint64_t* a, const uint64_t* b, size_t n) {
+         uint64_t borrow = 0;
+         for (size_t i = 0; i < n; ++i) {
+            unsigned __int128 d = (unsigned __int128)a[i] - b[i] - borrow;
+            a[i]   = uint64_t(d);
+            borrow = uint64_t(d >> 64) & 1;
+         }
+         return borrow;
+      }
+
+      template<size_t N>
+      bool less(const uint64_t* a, const std::array<uint64_t, N>& b) {
+         for (size_t i = N; i-- > 0;) {
+            if (a[i] != b[i])
+               return a[i] < b[i];
+         }
+         return false;
+      }
+
+      /**
+       * r = a * b * R^-1 mod modulus, for a < R and b < modulus. r may alias a or b.
+       * Every row adds a[i] * b and a multiple of the modulus that clears the lowest limb, then shifts by one limb,
+       * so the accumulator never exceeds N + 1 limbs.
+       */
+      template<size_t N>
+      void mont_mul(std::array<uint64_t, N>& r, const std::array<uint64_t, N>& a, const std::array<uint64_t, N>& b,
+                    const montgomery_key<N>& key) {
+         uint64_t t[N + 1] = {};
+         for (size_t i = 0; i < N; ++i) {
+            const uint64_t ai = a[i];
+            unsigned __int128 p = (unsigned __int128)ai * b[0] + t[0];
+            const uint64_t q = uint64_t(p) * key.modulus_inv;
+            unsigned __int128 s = (unsigned __int128)q * key.modulus[0] + uint64_t(p);
+            uint64_t carry_p = uint64_t(p >> 64);
+            uint64_t carry_s = uint64_t(s >> 64);
+            for (size_t j = 1; j < N; ++j) {
+               p        = (unsigned __int128)ai * b[j] + t[j] + carry_p;
+               carry_p  = uint64_t(p >> 64);
+               s        = (unsigned __int128)q * key.modulus[j] + uint64_t(p) + carry_s;
+               carry_s  = uint64_t(s >> 64);
+               t[j - 1] = uint64_t(s);
+            }
+            p        = (unsigned __int128)t[N] + carry_p + carry_s;
+            t[N - 1] = uint64_t(p);
+            t[N]     = uint64_t(p >> 64);
+         }
+         // t < 2 * modulus
+         if (t[N] || !less(t, key.modulus))
+            sub(t, key.modulus.data(), N);
+         std::memcpy(r.data(), t, sizeof(uint64_t) * N);
+      }
+
+      // a = 2 * a mod modulus, for a < modulus
+      template<size_t N>
+      void mod_double(std::array<uint64_t, N>& a, const std::array<uint64_t, N>& modulus) {
+         uint64_t carry = 0;
+         for (size_t i = 0; i < N; ++i) {
+            uint64_t next = a[i] >> 63;
+            a[i]          = (a[i] << 1) | carry;
+            carry         = next;
+         }
+         if (carry || !less(a.data(), modulus))
+            sub(a.data(), modulus.data(), N);
+      }
+
+      template<size_t N>
+      bool init_key(montgomery_key<N>& key, std::string_view exponent, std::string_view modulus) {
+         if (!parse_hex(modulus, key.modulus) || !parse_hex(exponent, key.exponent))
+            return false;
+         uint32_t modulus_bits = bit_length(key.modulus);
+         if (!(key.modulus[0] & 1) || modulus_bits < 2)
+            return false;
+         key.exponent_bits = bit_length(key.exponent);
+
+         // Newton iteration, every step doubles the number of correct low bits of the inverse
+         uint64_t inv = key.modulus[0];
+         for (int i = 0; i < 5; ++i)
+            inv *= 2 - key.modulus[0] * inv;
+         key.modulus_inv = -inv;
+
+         // 2^(64N + 64) mod modulus by doubling from the highest power of 2 below the modulus, then squaring in
+         // Montgomery form, which turns 2^(64N + d) into 2^(64N + 2d), until d reaches 64N
+         key.r2.fill(0);
+         key.r2[(modulus_bits - 1) / 64] = uint64_t(1) << ((modulus_bits - 1) % 64);
+         for (uint32_t i = modulus_bits - 1; i < N * 64 + 64; ++i)
+            mod_double(key.r2, key.modulus);
+         for (size_t d = 64; d < N * 64; d *= 2)
+            mont_mul(key.r2, key.r2, key.r2, key);
+         return true;
+      }
+
+      template<size_t N>
+      bool power(const montgomery_key<N>& key, size_t size, std::string_view signature, unsigned char* out) {
+         using limbs = std::array<uint64_t, N>;
+         limbs base;
+         if (signature.size() != size * 2 || !parse_hex(signature, base))
+            return false;
+
+         limbs result = {};
+         if (key.exponent_bits == 0) {
+            result[0] = 1;
+         } else {
+            limbs x;
+            mont_mul(x, base, key.r2, key);
+            limbs acc = x;
+            if (key.exponent_bits == 17 && key.exponent[0] == exponent_65537) {
+               for (int i = 0; i < 16; ++i)
+                  mont_mul(acc, acc, acc, key);
+               mont_mul(acc, acc, x, key);
+            } else {
+               for (uint32_t i = key.exponent_bits - 1; i-- > 0;) {
+                  mont_mul(acc, acc, acc, key);
+                  if (bit(key.exponent, i))
+                     mont_mul(acc, acc, x, key);
+               }
+            }
+            const limbs one = { 1 };
+            mont_mul(result, acc, one, key);
+         }
+
+         for (size_t i = 0; i < size; ++i)
+            out[size - 1 - i] = uint8_t(result[i / 8] >> (8 * (i % 8)));
+         return true;
+      }
+
+   } // namespace
+
+   std::optional<public_key> public_key::from_hex(std::string_view exponent, std::string_view modulus) {
+      if (modulus.empty() || modulus.size() % 2 || modulus.size() / 2 > max_size)
+         return {};
+
+      public_key result;
+      result._size = modulus.size() / 2;
+      bool ok;
+      if (result._size <= 128)
+         ok = init_key(result._key.emplace<detail::montgomery_key<16>>(), exponent, modulus);
+      else if (result._size <= 256)
+         ok = init_key(result._key.emplace<detail::montgomery_key<32>>(), exponent, modulus);
+      else
+         ok = init_key(result._key.emplace<detail::montgomery_key<64>>(), exponent, modulus);
+      if (!ok)
+         return {};
+      return result;
+   }
+
+   bool public_key::power(std::string_view signature, unsigned char* out) const {
+      return std::visit([&](const auto& key) { return rsa::power(key, _size, signature, out); }, _key);
+   }
+
+   std::optional<bool> public_key::verify_sha256(const fc::sha256& digest, std::string_view signature) const {
+      unsigned char em[max_size];
+      if (!power(signature, em))
+         return {};
+      if (_size < encoding_size + 11)
+         return false;
+
+      // 0x00 0x01 0xff...0xff 0x00 DigestInfo digest
+      const size_t padding_end = _size - encoding_size - 1;
+      if (em[0] != 0x00 || em[1] != 0x01 || em[padding_end] != 0x00)
+         return false;
+      for (size_t i = 2; i < padding_end; ++i) {
+         if (em[i] != 0xff)
+            return false;
+      }
+      return std::memcmp(em + padding_end + 1, sha256_digest_info, sizeof(sha256_digest_info)) == 0 &&
+             std::memcmp(em + _size - sha256_size, digest.data(), sha256_size) == 0;
+   }
+
+   key_cache::key_cache(size_t capacity)
+      : _capacity(std::max<size_t>(capacity, 1)) {
+      _entries.reserve(_capacity);
+   }
+
+   std::shared_ptr<const public_key> key_cache::get(std::string_view exponent, std::string_view modulus) {
+      const size_t hash = std::hash<std::string_view>{}(modulus) ^ (std::hash<std::string_view>{}(exponent) << 1);
+      {
+         std::lock_guard<std::mutex> lock(_mtx);
+         for (auto& e : _entries) {
+            if (e.hash == hash && e.modulus == modulus && e.exponent == exponent) {
+               e.last_used = ++_tick;
+               ++_hits;
+               return e.key;
+            }
+         }
+      }
+
+      ++_misses;
+      auto parsed = public_key::from_hex(exponent, modulus);
+      if (!parsed)
+         return {};
+      auto key = std::make_shared<const public_key>(*parsed);
+
+      std::lock_guard<std::mutex> lock(_mtx);
+      entry added{ hash, std::string(exponent), std::string(modulus), key, ++_tick };
+      if (_entries.size() < _capacity) {
+         _entries.push_back(std::move(added));
+      } else {
+         auto lru = std::min_element(_entries.begin(), _entries.end(),
+                                     [](const entry& a, const entry& b) { return a.last_used < b.last_used; });
+         *lru = std::move(added);
+      }
+      return key;
+   }
+
+   key_cache::stats key_cache::get_stats() const {
+      std::lock_guard<std::mutex> lock(_mtx);
+      return { _hits.load(), _misses.load(), _entries.size() };
+   }
+
+   void key_cache::clear() {
+      std::lock_guard<std::mutex> lock(_mtx);
+      _entries.clear();
+   }
+
+}}} // namespace eosio::chain::rsa
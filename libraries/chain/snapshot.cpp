@@ -1,9 +1,67 @@
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <fc/scoped_exit.hpp>
 
+#include <zstd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+
 namespace eosio { namespace chain {
 
+namespace {
+   // runs f(0) to f(count - 1) on the thread pool, waiting for all of them before rethrowing the first failure
+   void run_concurrently( named_thread_pool& thread_pool, size_t count, const std::function<void(size_t)>& f ) {
+      std::vector<std::future<void>> futures;
+      futures.reserve( count );
+      for( size_t i = 0; i < count; ++i ) {
+         futures.emplace_back( async_thread_pool( thread_pool.get_executor(), [&f, i]() { f( i ); } ) );
+      }
+      for( auto& fut : futures ) {
+         fut.wait();
+      }
+      for( auto& fut : futures ) {
+         fut.get();
+      }
+   }
+}
+
+void snapshot_writer::write_concurrently( const std::vector<task>& tasks ) {
+   // the tasks share this writer without owning it
+   auto self = snapshot_writer_ptr( snapshot_writer_ptr(), this );
+   for( const auto& t : tasks ) {
+      t( self );
+   }
+}
+
+void snapshot_writer::write_parts( const std::string& section_name, size_t parts,
+                                   const std::function<void(size_t, section_writer&)>& f ) {
+   write_section( section_name, [parts, &f]( auto& section ) {
+      for( size_t part = 0; part < parts; ++part ) {
+         f( part, section );
+      }
+   });
+}
+
+void snapshot_reader::read_concurrently( const std::vector<task>& tasks ) {
+   // the tasks share this reader without owning it
+   auto self = snapshot_reader_ptr( snapshot_reader_ptr(), this );
+   for( const auto& t : tasks ) {
+      t( self );
+   }
+}
+
+void snapshot_reader::set_section_part( const std::string& section_name, size_t part ) {
+   EOS_ASSERT( part == 0, snapshot_exception, "Snapshot section ${n} has no part ${p}", ("n", section_name)("p", part) );
+   set_section( section_name );
+}
+
 variant_snapshot_writer::variant_snapshot_writer(fc::mutable_variant_object& snapshot)
 : snapshot(snapshot)
 {
@@ -346,6 +404,1111 @@ void istream_snapshot_reader::return_to_header() {
    clear_section();
 }
 
+class parallel_ostream_snapshot_writer::chunk_writer : public snapshot_writer {
+   public:
+      struct chunk {
+         fc::path path;
+         uint64_t size = 0;
+         uint64_t rows = 0;
+      };
+
+      struct section {
+         std::string        name;
+         std::vector<chunk> parts;
+      };
+
+      explicit chunk_writer( parallel_ostream_snapshot_writer& parent )
+      :parent(parent)
+      ,out(chunk_out)
+      {
+      }
+
+      void write_start_section( const std::string& section_name ) override {
+         EOS_ASSERT(!chunk_out.is_open(), snapshot_exception, "Attempting to write a new section without closing the previous section");
+         const auto path = parent.chunk_dir / ("chunk-" + std::to_string(parent.chunk_count++));
+         sections.push_back(section{ section_name, { chunk{ path } } });
+         chunk_out.open(path.generic_string(), (std::ios::out | std::ios::binary | std::ios::trunc));
+         EOS_ASSERT(chunk_out.good(), snapshot_exception, "Unable to create snapshot chunk ${p}", ("p", path.generic_string()));
+      }
+
+      void write_row( const detail::abstract_snapshot_row_writer& row_writer ) override {
+         auto restore = chunk_out.tellp();
+         try {
+            row_writer.write(out);
+         } catch (...) {
+            chunk_out.seekp(restore);
+            throw;
+         }
+         sections.back().parts.back().rows++;
+      }
+
+      void write_end_section( ) override {
+         auto& c = sections.back().parts.back();
+         c.size = chunk_out.tellp();
+         chunk_out.close();
+         EOS_ASSERT(!chunk_out.fail(), snapshot_exception, "Unable to write snapshot chunk ${p}", ("p", c.path.generic_string()));
+      }
+
+      std::vector<section> sections;
+
+   private:
+      parallel_ostream_snapshot_writer& parent;
+      std::ofstream                     chunk_out;
+      detail::ostream_wrapper           out;
+};
+
+parallel_ostream_snapshot_writer::parallel_ostream_snapshot_writer(std::ostream& snapshot, const fc::path& chunk_dir, uint32_t threads)
+:snapshot(snapshot)
+,header_pos(snapshot.tellp())
+,chunk_dir(chunk_dir)
+,thread_pool(std::make_unique<named_thread_pool>("snap", std::max<uint32_t>(threads, 1)))
+{
+   fc::create_directories(chunk_dir);
+   main_writer = make_chunk_writer();
+
+   // write magic number
+   auto totem = ostream_snapshot_writer::magic_number;
+   snapshot.write((char*)&totem, sizeof(totem));
+
+   // write version
+   auto version = current_snapshot_version;
+   snapshot.write((char*)&version, sizeof(version));
+}
+
+parallel_ostream_snapshot_writer::~parallel_ostream_snapshot_writer() {
+   thread_pool->stop();
+   main_writer.reset();
+   try {
+      fc::remove_all(chunk_dir);
+   } catch (...) {
+      wlog("Unable to remove the snapshot chunks in ${d}", ("d", chunk_dir.generic_string()));
+   }
+}
+
+std::shared_ptr<parallel_ostream_snapshot_writer::chunk_writer> parallel_ostream_snapshot_writer::make_chunk_writer() {
+   return std::make_shared<chunk_writer>(*this);
+}
+
+void parallel_ostream_snapshot_writer::write_start_section( const std::string& section_name ) {
+   main_writer->write_start_section(section_name);
+}
+
+void parallel_ostream_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   main_writer->write_row(row_writer);
+}
+
+void parallel_ostream_snapshot_writer::write_end_section( ) {
+   main_writer->write_end_section();
+}
+
+void parallel_ostream_snapshot_writer::write_concurrently( const std::vector<task>& tasks ) {
+   std::vector<std::shared_ptr<chunk_writer>> writers;
+   for( size_t i = 0; i < tasks.size(); ++i ) {
+      writers.emplace_back(make_chunk_writer());
+   }
+
+   run_concurrently(*thread_pool, tasks.size(), [&tasks, &writers](size_t i) {
+      tasks[i](writers[i]);
+   });
+
+   for( auto& w : writers ) {
+      std::move(w->sections.begin(), w->sections.end(), std::back_inserter(main_writer->sections));
+   }
+}
+
+void parallel_ostream_snapshot_writer::write_parts( const std::string& section_name, size_t parts,
+                                                    const std::function<void(size_t, section_writer&)>& f ) {
+   std::vector<std::shared_ptr<chunk_writer>> writers;
+   for( size_t i = 0; i < parts; ++i ) {
+      writers.emplace_back(make_chunk_writer());
+   }
+
+   run_concurrently(*thread_pool, parts, [&section_name, &f, &writers](size_t part) {
+      writers[part]->write_section(section_name, [part, &f](auto& section) {
+         f(part, section);
+      });
+   });
+
+   auto s = chunk_writer::section{ section_name };
+   for( auto& w : writers ) {
+      s.parts.push_back(w->sections.front().parts.front());
+   }
+   main_writer->sections.push_back(std::move(s));
+}
+
+void parallel_ostream_snapshot_writer::finalize() {
+   std::vector<std::vector<std::pair<uint64_t, uint64_t>>> part_positions;
+   std::vector<char> buffer(1024 * 1024);
+
+   for( const auto& s : main_writer->sections ) {
+      uint64_t data_size = 0;
+      uint64_t row_count = 0;
+      for( const auto& c : s.parts ) {
+         data_size += c.size;
+         row_count += c.rows;
+      }
+
+      // the section size and row count as written by ostream_snapshot_writer
+      uint64_t section_size = sizeof(row_count) + s.name.size() + 1 + data_size;
+      snapshot.write((char*)&section_size, sizeof(section_size));
+      snapshot.write((char*)&row_count, sizeof(row_count));
+      snapshot.write(s.name.data(), s.name.size());
+      snapshot.put(0);
+
+      auto& positions = part_positions.emplace_back();
+      for( const auto& c : s.parts ) {
+         positions.emplace_back(snapshot.tellp() - header_pos, c.rows);
+
+         std::ifstream chunk_in(c.path.generic_string(), (std::ios::in | std::ios::binary));
+         for( uint64_t remaining = c.size; remaining > 0; ) {
+            const auto n = std::min<uint64_t>(remaining, buffer.size());
+            chunk_in.read(buffer.data(), n);
+            EOS_ASSERT(chunk_in.gcount() == std::streamsize(n), snapshot_exception,
+                       "Unable to read snapshot chunk ${p}", ("p", c.path.generic_string()));
+            snapshot.write(buffer.data(), n);
+            remaining -= n;
+         }
+         chunk_in.close();
+         fc::remove(c.path);
+      }
+   }
+
+   uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+   snapshot.write((char*)&end_marker, sizeof(end_marker));
+
+   // write the directory
+   uint64_t directory_pos = snapshot.tellp() - header_pos;
+   auto totem = directory_magic_number;
+   snapshot.write((char*)&totem, sizeof(totem));
+   uint32_t section_count = main_writer->sections.size();
+   snapshot.write((char*)&section_count, sizeof(section_count));
+   for( size_t i = 0; i < section_count; ++i ) {
+      const auto& name = main_writer->sections[i].name;
+      uint32_t name_size = name.size();
+      snapshot.write((char*)&name_size, sizeof(name_size));
+      snapshot.write(name.data(), name.size());
+
+      uint32_t part_count = part_positions[i].size();
+      snapshot.write((char*)&part_count, sizeof(part_count));
+      for( const auto& p : part_positions[i] ) {
+         snapshot.write((char*)&p.first, sizeof(p.first));
+         snapshot.write((char*)&p.second, sizeof(p.second));
+      }
+   }
+   snapshot.write((char*)&directory_pos, sizeof(directory_pos));
+
+   main_writer->sections.clear();
+   fc::remove_all(chunk_dir);
+}
+
+parallel_istream_snapshot_reader::parallel_istream_snapshot_reader(const fc::path& snapshot_path, uint32_t threads)
+:snapshot_path(snapshot_path)
+,snapshot(snapshot_path.generic_string(), (std::ios::in | std::ios::binary))
+,thread_pool(std::make_unique<named_thread_pool>("snap", std::max<uint32_t>(threads, 1)))
+,num_rows(0)
+,cur_row(0)
+{
+   EOS_ASSERT(snapshot.good(), snapshot_exception, "Unable to open snapshot ${p}", ("p", snapshot_path.generic_string()));
+}
+
+parallel_istream_snapshot_reader::parallel_istream_snapshot_reader(const fc::path& snapshot_path, const std::shared_ptr<const directory>& dir)
+:snapshot_path(snapshot_path)
+,snapshot(snapshot_path.generic_string(), (std::ios::in | std::ios::binary))
+,dir(dir)
+,num_rows(0)
+,cur_row(0)
+{
+   EOS_ASSERT(snapshot.good(), snapshot_exception, "Unable to open snapshot ${p}", ("p", snapshot_path.generic_string()));
+}
+
+parallel_istream_snapshot_reader::~parallel_istream_snapshot_reader() {
+}
+
+void parallel_istream_snapshot_reader::validate() const {
+   snapshot.clear();
+   snapshot.seekg(0);
+   istream_snapshot_reader(snapshot).validate();
+
+   // the directory is checked against the snapshot as it is loaded
+   get_directory();
+}
+
+const parallel_istream_snapshot_reader::directory& parallel_istream_snapshot_reader::get_directory() const {
+   if (!dir) {
+      dir = load_directory();
+   }
+   return *dir;
+}
+
+std::shared_ptr<const parallel_istream_snapshot_reader::directory> parallel_istream_snapshot_reader::load_directory() const {
+   auto restore_exceptions = fc::make_scoped_exit([this,ex=snapshot.exceptions()](){
+      snapshot.exceptions(ex);
+   });
+
+   snapshot.clear();
+   snapshot.exceptions(std::istream::failbit|std::istream::eofbit);
+
+   auto result = std::make_shared<directory>();
+   const uint64_t header_size = sizeof(ostream_snapshot_writer::magic_number) + sizeof(current_snapshot_version);
+   const uint64_t end_marker = std::numeric_limits<uint64_t>::max();
+
+   try {
+      snapshot.seekg(0, std::ios::end);
+      const uint64_t size = snapshot.tellg();
+
+      // a directory follows the end marker and its offset ends the snapshot
+      uint64_t directory_pos = 0;
+      uint64_t marker = 0;
+      uint32_t totem = 0;
+      if (size >= header_size + sizeof(marker) + sizeof(totem) + sizeof(directory_pos)) {
+         snapshot.seekg(size - sizeof(directory_pos));
+         snapshot.read((char*)&directory_pos, sizeof(directory_pos));
+      }
+      if (directory_pos >= header_size + sizeof(marker) && directory_pos <= size - sizeof(totem) - sizeof(directory_pos)) {
+         snapshot.seekg(directory_pos - sizeof(marker));
+         snapshot.read((char*)&marker, sizeof(marker));
+         snapshot.read((char*)&totem, sizeof(totem));
+      }
+
+      if (marker == end_marker && totem == parallel_ostream_snapshot_writer::directory_magic_number) {
+         uint32_t section_count = 0;
+         snapshot.read((char*)&section_count, sizeof(section_count));
+         for (uint32_t i = 0; i < section_count; ++i) {
+            auto& entry = result->emplace_back();
+            uint32_t name_size = 0;
+            snapshot.read((char*)&name_size, sizeof(name_size));
+            EOS_ASSERT(name_size < directory_pos, snapshot_exception, "Binary snapshot directory is corrupted");
+            entry.name.resize(name_size);
+            snapshot.read(entry.name.data(), name_size);
+
+            uint32_t part_count = 0;
+            snapshot.read((char*)&part_count, sizeof(part_count));
+            for (uint32_t p = 0; p < part_count; ++p) {
+               auto& part = entry.parts.emplace_back();
+               snapshot.read((char*)&part.pos, sizeof(part.pos));
+               snapshot.read((char*)&part.rows, sizeof(part.rows));
+               EOS_ASSERT(part.pos >= header_size && part.pos <= directory_pos, snapshot_exception,
+                          "Binary snapshot directory refers to a part of section ${n} outside of the sections", ("n", entry.name));
+            }
+         }
+      } else {
+         // without a directory every section is a single part
+         uint64_t section_pos = header_size;
+         while (true) {
+            snapshot.seekg(section_pos);
+            uint64_t section_size = 0;
+            snapshot.read((char*)&section_size, sizeof(section_size));
+            if (section_size == end_marker) {
+               break;
+            }
+
+            auto& entry = result->emplace_back();
+            uint64_t row_count = 0;
+            snapshot.read((char*)&row_count, sizeof(row_count));
+            std::getline(snapshot, entry.name, '\0');
+            entry.parts.push_back(section_part{ static_cast<uint64_t>(snapshot.tellg()), row_count });
+            section_pos += sizeof(section_size) + section_size;
+         }
+      }
+   } catch( const std::exception& e ) {
+      snapshot_exception fce(FC_LOG_MESSAGE( warn, "Binary snapshot directory threw IO exception (${what})",("what",e.what())));
+      throw fce;
+   }
+
+   return result;
+}
+
+const parallel_istream_snapshot_reader::section_entry& parallel_istream_snapshot_reader::get_section( const string& section_name ) {
+   const auto& sections = get_directory();
+   auto itr = std::find_if(sections.begin(), sections.end(), [&section_name](const auto& s) { return s.name == section_name; });
+   EOS_ASSERT(itr != sections.end(), snapshot_exception, "Binary snapshot has no section named ${n}", ("n", section_name));
+   return *itr;
+}
+
+bool parallel_istream_snapshot_reader::has_section( const string& section_name ) {
+   const auto& sections = get_directory();
+   return std::any_of(sections.begin(), sections.end(), [&section_name](const auto& s) { return s.name == section_name; });
+}
+
+void parallel_istream_snapshot_reader::set_section( const string& section_name ) {
+   const auto& section = get_section(section_name);
+
+   // the parts of a section follow each other
+   cur_row = 0;
+   num_rows = 0;
+   for (const auto& part : section.parts) {
+      num_rows += part.rows;
+   }
+   if (!section.parts.empty()) {
+      snapshot.clear();
+      snapshot.seekg(section.parts.front().pos);
+   }
+}
+
+void parallel_istream_snapshot_reader::set_section_part( const string& section_name, size_t part ) {
+   const auto& section = get_section(section_name);
+   EOS_ASSERT(part < section.parts.size(), snapshot_exception,
+              "Binary snapshot section ${n} has no part ${p}", ("n", section_name)("p", part));
+
+   cur_row = 0;
+   num_rows = section.parts[part].rows;
+   snapshot.clear();
+   snapshot.seekg(section.parts[part].pos);
+}
+
+size_t parallel_istream_snapshot_reader::section_parts( const string& section_name ) {
+   return get_section(section_name).parts.size();
+}
+
+bool parallel_istream_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+   row_reader.provide(snapshot);
+   return ++cur_row < num_rows;
+}
+
+bool parallel_istream_snapshot_reader::empty ( ) {
+   return num_rows == 0;
+}
+
+void parallel_istream_snapshot_reader::clear_section() {
+   num_rows = 0;
+   cur_row = 0;
+}
+
+void parallel_istream_snapshot_reader::return_to_header() {
+   snapshot.clear();
+   snapshot.seekg(0);
+   clear_section();
+}
+
+void parallel_istream_snapshot_reader::read_concurrently( const std::vector<task>& tasks ) {
+   // readers of tasks run their own tasks in turn
+   if (!thread_pool) {
+      snapshot_reader::read_concurrently(tasks);
+      return;
+   }
+
+   get_directory();
+   std::vector<snapshot_reader_ptr> readers;
+   for (size_t i = 0; i < tasks.size(); ++i) {
+      readers.emplace_back(new parallel_istream_snapshot_reader(snapshot_path, dir));
+   }
+
+   run_concurrently(*thread_pool, tasks.size(), [&tasks, &readers](size_t i) {
+      tasks[i](readers[i]);
+   });
+}
+
+namespace {
+   constexpr uint32_t zstd_snapshot_end_marker   = std::numeric_limits<uint32_t>::max();
+   constexpr size_t   zstd_snapshot_frame_size   = 1024 * 1024; // uncompressed bytes of rows after which a frame is written
+   constexpr size_t   zstd_snapshot_queued_frames = 4;          // decompressed frames queued ahead of the reader of a section
+
+   // appends to a vector, rows are packed into it before they are compressed
+   class vector_streambuf : public std::streambuf {
+      public:
+         explicit vector_streambuf(std::vector<char>& data)
+         :data(data) {}
+
+      protected:
+         std::streamsize xsputn( const char* s, std::streamsize n ) override {
+            data.insert(data.end(), s, s + n);
+            return n;
+         }
+
+         int_type overflow( int_type c ) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+               data.push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+         }
+
+      private:
+         std::vector<char>& data;
+   };
+
+   // reads the rows of a decompressed frame
+   class frame_streambuf : public std::streambuf {
+      public:
+         void reset( std::vector<char>& data ) {
+            setg(data.data(), data.data(), data.data() + data.size());
+         }
+
+         bool exhausted() const {
+            return gptr() == egptr();
+         }
+   };
+
+   struct zstd_dctx_deleter {
+      void operator()( ZSTD_DCtx* dctx ) const { ZSTD_freeDCtx(dctx); }
+   };
+   using zstd_dctx_ptr = std::unique_ptr<ZSTD_DCtx, zstd_dctx_deleter>;
+
+   zstd_dctx_ptr make_zstd_dctx() {
+      zstd_dctx_ptr dctx(ZSTD_createDCtx());
+      EOS_ASSERT(dctx, snapshot_exception, "Unable to create zstd context");
+      return dctx;
+   }
+
+   struct zstd_frame {
+      uint32_t          rows = 0;
+      std::vector<char> data; ///< compressed in the frames of the snapshot, decompressed in the frames read
+   };
+
+   std::vector<char> decompress_frame( ZSTD_DCtx* dctx, const zstd_frame& frame ) {
+      const auto content_size = ZSTD_getFrameContentSize(frame.data.data(), frame.data.size());
+      EOS_ASSERT(content_size != ZSTD_CONTENTSIZE_ERROR && content_size != ZSTD_CONTENTSIZE_UNKNOWN, snapshot_exception,
+                 "Compressed snapshot has an invalid zstd frame");
+
+      std::vector<char> result(content_size);
+      const size_t size = ZSTD_decompressDCtx(dctx, result.data(), result.size(), frame.data.data(), frame.data.size());
+      EOS_ASSERT(!ZSTD_isError(size) && size == content_size, snapshot_exception,
+                 "Compressed snapshot frame cannot be decompressed: ${e}",
+                 ("e", ZSTD_isError(size) ? ZSTD_getErrorName(size) : "size mismatch"));
+      return result;
+   }
+
+   // the decompressed frames of a section, queued ahead of its reader
+   class zstd_channel {
+      public:
+         /// @return false once the reader stopped reading the section
+         bool push( zstd_frame&& frame ) {
+            std::unique_lock<std::mutex> g(mtx);
+            cv.wait(g, [this]() { return abandoned || frames.size() < zstd_snapshot_queued_frames; });
+            if (abandoned) {
+               return false;
+            }
+            frames.emplace_back(std::move(frame));
+            cv.notify_all();
+            return true;
+         }
+
+         void finish( std::exception_ptr e ) {
+            std::lock_guard<std::mutex> g(mtx);
+            done = true;
+            error = e;
+            cv.notify_all();
+         }
+
+         /// @return the next frame, none at the end of the section
+         std::optional<zstd_frame> pop() {
+            std::unique_lock<std::mutex> g(mtx);
+            cv.wait(g, [this]() { return !frames.empty() || done; });
+            if (frames.empty()) {
+               if (error) {
+                  std::rethrow_exception(error);
+               }
+               return {};
+            }
+            std::optional<zstd_frame> result(std::move(frames.front()));
+            frames.pop_front();
+            cv.notify_all();
+            return result;
+         }
+
+         void abandon() {
+            std::lock_guard<std::mutex> g(mtx);
+            abandoned = true;
+            frames.clear();
+            cv.notify_all();
+         }
+
+      private:
+         std::mutex              mtx;
+         std::condition_variable cv;
+         std::deque<zstd_frame>  frames;
+         bool                    done      = false;
+         bool                    abandoned = false;
+         std::exception_ptr      error;
+   };
+}
+
+struct zstd_ostream_snapshot_writer::impl {
+   ZSTD_CCtx*              cctx = ZSTD_createCCtx();
+   std::vector<char>       rows;           ///< packed rows of the frame being written
+   uint32_t                frame_rows = 0;
+   vector_streambuf        buf{rows};
+   std::ostream            out{&buf};
+   detail::ostream_wrapper wrapper{out};
+   std::vector<char>       compressed;
+
+   ~impl() {
+      ZSTD_freeCCtx(cctx);
+   }
+};
+
+zstd_ostream_snapshot_writer::zstd_ostream_snapshot_writer(std::ostream& snapshot, int compression_level)
+:snapshot(snapshot)
+,my(new impl)
+{
+   EOS_ASSERT(my->cctx, snapshot_exception, "Unable to create zstd context");
+   ZSTD_CCtx_setParameter(my->cctx, ZSTD_c_compressionLevel, compression_level);
+   ZSTD_CCtx_setParameter(my->cctx, ZSTD_c_checksumFlag, 1);
+
+   auto totem = magic_number;
+   write((const char*)&totem, sizeof(totem));
+   auto version = current_snapshot_version;
+   write((const char*)&version, sizeof(version));
+}
+
+zstd_ostream_snapshot_writer::~zstd_ostream_snapshot_writer() {
+}
+
+void zstd_ostream_snapshot_writer::write( const char* data, size_t size ) {
+   snapshot.write(data, size);
+   pos += size;
+}
+
+void zstd_ostream_snapshot_writer::write_start_section( const std::string& section_name )
+{
+   EOS_ASSERT(!in_section, snapshot_exception, "Attempting to write a new section without closing the previous section");
+   in_section = true;
+   sections.push_back({section_name, pos, 0});
+
+   uint32_t name_size = section_name.size();
+   write((const char*)&name_size, sizeof(name_size));
+   write(section_name.data(), section_name.size());
+}
+
+void zstd_ostream_snapshot_writer::write_row( const detail::abstract_snapshot_row_writer& row_writer ) {
+   const auto restore = my->rows.size();
+   try {
+      row_writer.write(my->wrapper);
+   } catch (...) {
+      my->rows.resize(restore);
+      throw;
+   }
+   enc.write(my->rows.data() + restore, my->rows.size() - restore);
+   ++my->frame_rows;
+   ++sections.back().rows;
+
+   if (my->rows.size() >= zstd_snapshot_frame_size) {
+      write_frame();
+   }
+}
+
+void zstd_ostream_snapshot_writer::write_frame() {
+   if (my->frame_rows == 0) {
+      return;
+   }
+
+   my->compressed.resize(ZSTD_compressBound(my->rows.size()));
+   const size_t size = ZSTD_compress2(my->cctx, my->compressed.data(), my->compressed.size(), my->rows.data(), my->rows.size());
+   EOS_ASSERT(!ZSTD_isError(size), snapshot_exception, "zstd compression of snapshot failed: ${e}", ("e", ZSTD_getErrorName(size)));
+
+   uint32_t frame_size = size;
+   write((const char*)&frame_size, sizeof(frame_size));
+   write((const char*)&my->frame_rows, sizeof(my->frame_rows));
+   write(my->compressed.data(), size);
+
+   my->rows.clear();
+   my->frame_rows = 0;
+}
+
+void zstd_ostream_snapshot_writer::write_end_section( ) {
+   write_frame();
+
+   uint32_t end_of_section = 0;
+   write((const char*)&end_of_section, sizeof(end_of_section));
+   in_section = false;
+}
+
+void zstd_ostream_snapshot_writer::finalize() {
+   const uint64_t end_pos = pos;
+   auto end_marker = zstd_snapshot_end_marker;
+   write((const char*)&end_marker, sizeof(end_marker));
+
+   uint32_t section_count = sections.size();
+   write((const char*)&section_count, sizeof(section_count));
+   for (const auto& s : sections) {
+      uint32_t name_size = s.name.size();
+      write((const char*)&name_size, sizeof(name_size));
+      write(s.name.data(), s.name.size());
+      write((const char*)&s.pos, sizeof(s.pos));
+      write((const char*)&s.rows, sizeof(s.rows));
+   }
+
+   integrity_hash = enc.result();
+   write(integrity_hash.data(), integrity_hash.data_size());
+   write((const char*)&end_pos, sizeof(end_pos));
+
+   auto totem = magic_number;
+   write((const char*)&totem, sizeof(totem));
+}
+
+/**
+ * The stream of a compressed snapshot, shared by the readers of read_concurrently.  A single thread reads it, one
+ * section after the other, and decompresses the frames of the section for the reader which asked for it.  It moves
+ * on to another section when the one before is read, and passes over a section only when every reader asks for a
+ * section which is not the next one.
+ */
+class zstd_istream_snapshot_reader::source {
+   public:
+      source(std::istream& in, bool two_pass);
+      ~source();
+
+      void validate();
+      bool contains( const std::string& section_name );
+      std::unique_ptr<section> open( const std::string& section_name );
+      void return_to_header();
+
+      void set_readers( uint32_t count );
+      void remove_reader();
+
+   private:
+      void start_pump( const std::shared_ptr<zstd_channel>& channel );
+      void pump( const std::string& section_name, std::shared_ptr<zstd_channel> channel, bool keep );
+      void read_next_section();
+      void read( char* data, size_t size );
+
+      template<typename T>
+      void read( T& value ) {
+         read((char*)&value, sizeof(value));
+      }
+
+      std::istream&                                    in;
+      std::streampos                                   header_pos;
+      uint32_t                                         magic = 0;
+      uint32_t                                         version = 0;
+      zstd_dctx_ptr                                    dctx;  ///< used by the pipeline only
+      fc::sha256::encoder                              enc;   ///< hash of the rows of the stream
+      std::atomic<bool>                                stopping{false};
+
+      std::mutex                                       mtx;
+      std::condition_variable                          cv;
+      bool                                             busy = false;   ///< the pipeline reads the stream
+      bool                                             at_end = false;
+      std::optional<std::string>                       next_section;   ///< name of the next section of the stream
+      std::exception_ptr                               error;          ///< failure reading the stream
+      std::set<std::string>                            seen;           ///< sections of the stream so far
+      std::map<std::string, std::vector<zstd_frame>>   kept;           ///< sections read from the stream but not read yet
+      bool                                             keep_all = false; ///< two pass readers, until return_to_header
+      uint32_t                                         readers = 1;
+      std::multiset<std::string>                       wanted;         ///< sections readers are waiting for
+
+      named_thread_pool                                pipeline{"snapzs", 1};
+};
+
+/// The section being read by a reader, from the pipeline or from memory
+class zstd_istream_snapshot_reader::section {
+   public:
+      explicit section(const std::shared_ptr<zstd_channel>& channel)
+      :channel(channel)
+      {
+         stream.exceptions(std::istream::failbit | std::istream::eofbit);
+         next_frame();
+      }
+
+      explicit section(std::vector<zstd_frame>&& frames)
+      :frames(std::move(frames))
+      ,dctx(make_zstd_dctx())
+      {
+         stream.exceptions(std::istream::failbit | std::istream::eofbit);
+         next_frame();
+      }
+
+      ~section() {
+         if (channel) {
+            channel->abandon();
+         }
+      }
+
+      bool empty() const {
+         return rows_left == 0;
+      }
+
+      bool read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+         EOS_ASSERT(rows_left > 0, snapshot_exception, "Compressed snapshot section has no more rows");
+         row_reader.provide(stream);
+         if (--rows_left == 0) {
+            EOS_ASSERT(buf.exhausted(), snapshot_exception, "Compressed snapshot frame has data past its rows");
+            next_frame();
+         }
+         return rows_left > 0;
+      }
+
+   private:
+      void next_frame() {
+         std::optional<zstd_frame> frame;
+         if (channel) {
+            frame = channel->pop();
+         } else if (next_kept < frames.size()) {
+            const auto& compressed = frames[next_kept++];
+            frame = zstd_frame{compressed.rows, decompress_frame(dctx.get(), compressed)};
+         }
+         if (!frame) {
+            rows_left = 0;
+            return;
+         }
+
+         cur_frame = std::move(*frame);
+         rows_left = cur_frame.rows;
+         buf.reset(cur_frame.data);
+         stream.clear();
+      }
+
+      std::shared_ptr<zstd_channel> channel;
+      std::vector<zstd_frame>       frames;
+      size_t                        next_kept = 0;
+      zstd_dctx_ptr                 dctx;
+      zstd_frame                    cur_frame;
+      uint32_t                      rows_left = 0;
+      frame_streambuf               buf;
+      std::istream                  stream{&buf};
+};
+
+zstd_istream_snapshot_reader::source::source(std::istream& in, bool two_pass)
+:in(in)
+,header_pos(in.tellg())
+,dctx(make_zstd_dctx())
+,keep_all(two_pass)
+{
+   in.read((char*)&magic, sizeof(magic));
+   in.read((char*)&version, sizeof(version));
+   if (magic == zstd_ostream_snapshot_writer::magic_number && version == current_snapshot_version) {
+      busy = true;
+      boost::asio::post(pipeline.get_executor(), [this]() {
+         std::exception_ptr failure;
+         try {
+            read_next_section();
+         } catch (...) {
+            failure = std::current_exception();
+         }
+         std::lock_guard<std::mutex> g(mtx);
+         error = failure;
+         busy = false;
+         cv.notify_all();
+      });
+   }
+}
+
+zstd_istream_snapshot_reader::source::~source() {
+   stopping = true;
+   pipeline.stop();
+}
+
+void zstd_istream_snapshot_reader::source::read( char* data, size_t size ) {
+   in.read(data, size);
+   EOS_ASSERT(in.gcount() == std::streamsize(size), snapshot_exception, "Compressed snapshot is truncated");
+}
+
+void zstd_istream_snapshot_reader::source::validate() {
+   EOS_ASSERT(magic == zstd_ostream_snapshot_writer::magic_number, snapshot_exception,
+              "Compressed snapshot has unexpected magic number!");
+   EOS_ASSERT(version == current_snapshot_version, snapshot_exception,
+              "Compressed snapshot is an unsuppored version.  Expected : ${expected}, Got: ${actual}",
+              ("expected", current_snapshot_version)("actual", version));
+
+   // a stream which cannot seek is checked as it is read
+   if (header_pos == std::streampos(-1)) {
+      return;
+   }
+
+   std::unique_lock<std::mutex> g(mtx);
+   cv.wait(g, [this]() { return !busy; });
+   if (error) {
+      std::rethrow_exception(error);
+   }
+   busy = true;
+   g.unlock();
+
+   auto restore = fc::make_scoped_exit([this, pos = in.tellg()]() {
+      in.clear();
+      in.seekg(pos);
+      std::lock_guard<std::mutex> g(mtx);
+      busy = false;
+      cv.notify_all();
+   });
+
+   try {
+      uint64_t end_pos = 0;
+      uint32_t totem = 0;
+      in.seekg(-std::streamoff(sizeof(end_pos) + sizeof(totem)), std::ios::end);
+      read(end_pos);
+      read(totem);
+      EOS_ASSERT(totem == zstd_ostream_snapshot_writer::magic_number, snapshot_exception,
+                 "Compressed snapshot has no trailer, it may be truncated");
+
+      in.seekg(header_pos + std::streamoff(end_pos));
+      uint32_t end_marker = 0;
+      read(end_marker);
+      EOS_ASSERT(end_marker == zstd_snapshot_end_marker, snapshot_exception, "Compressed snapshot has an invalid index");
+
+      uint32_t section_count = 0;
+      read(section_count);
+      std::vector<std::pair<std::string, uint64_t>> index;
+      for (uint32_t i = 0; i < section_count; ++i) {
+         uint32_t name_size = 0;
+         read(name_size);
+         std::string name(name_size, '\0');
+         read(name.data(), name.size());
+         uint64_t pos = 0, rows = 0;
+         read(pos);
+         read(rows);
+         index.emplace_back(std::move(name), pos);
+      }
+
+      for (const auto& [name, pos] : index) {
+         EOS_ASSERT(pos < end_pos, snapshot_exception, "Compressed snapshot index has an invalid offset for ${n}", ("n", name));
+         in.seekg(header_pos + std::streamoff(pos));
+         uint32_t name_size = 0;
+         read(name_size);
+         std::string actual(name_size, '\0');
+         read(actual.data(), actual.size());
+         EOS_ASSERT(actual == name, snapshot_exception, "Compressed snapshot index does not match the section ${n}", ("n", name));
+      }
+   } catch( const std::exception& e ) {
+      snapshot_exception fce(FC_LOG_MESSAGE( warn, "Compressed snapshot validation threw IO exception (${what})",("what",e.what())));
+      throw fce;
+   }
+}
+
+void zstd_istream_snapshot_reader::source::read_next_section() {
+   uint32_t name_size = 0;
+   read(name_size);
+   if (name_size != zstd_snapshot_end_marker) {
+      std::string name(name_size, '\0');
+      read(name.data(), name.size());
+      std::lock_guard<std::mutex> g(mtx);
+      seen.insert(name);
+      next_section = std::move(name);
+      return;
+   }
+
+   // the trailer ends the stream
+   uint32_t section_count = 0;
+   read(section_count);
+   for (uint32_t i = 0; i < section_count; ++i) {
+      read(name_size);
+      std::string name(name_size, '\0');
+      read(name.data(), name.size());
+      uint64_t pos = 0, rows = 0;
+      read(pos);
+      read(rows);
+   }
+   fc::sha256 integrity_hash;
+   read(integrity_hash.data(), integrity_hash.data_size());
+   uint64_t end_pos = 0;
+   read(end_pos);
+   uint32_t totem = 0;
+   read(totem);
+   EOS_ASSERT(totem == zstd_ostream_snapshot_writer::magic_number, snapshot_exception, "Compressed snapshot has an invalid trailer");
+
+   const auto rows_hash = enc.result();
+   EOS_ASSERT(integrity_hash == rows_hash, snapshot_exception,
+              "Compressed snapshot integrity hash ${h} does not match the hash of its rows ${r}",
+              ("h", integrity_hash)("r", rows_hash));
+
+   std::lock_guard<std::mutex> g(mtx);
+   next_section.reset();
+   at_end = true;
+}
+
+void zstd_istream_snapshot_reader::source::start_pump( const std::shared_ptr<zstd_channel>& channel ) {
+   busy = true;
+   auto name = std::move(*next_section);
+   next_section.reset();
+   boost::asio::post(pipeline.get_executor(), [this, name, channel, keep = keep_all || !channel]() {
+      pump(name, channel, keep);
+   });
+}
+
+void zstd_istream_snapshot_reader::source::pump( const std::string& section_name, std::shared_ptr<zstd_channel> channel, bool keep ) {
+   std::vector<zstd_frame> frames;
+   std::exception_ptr      failure;
+   try {
+      while (!stopping) {
+         uint32_t size = 0;
+         read(size);
+         if (size == 0) {
+            break;
+         }
+
+         zstd_frame frame;
+         read(frame.rows);
+         EOS_ASSERT(frame.rows > 0, snapshot_exception, "Compressed snapshot has a frame without rows in ${n}", ("n", section_name));
+         frame.data.resize(size);
+         read(frame.data.data(), frame.data.size());
+
+         auto data = decompress_frame(dctx.get(), frame);
+         enc.write(data.data(), data.size());
+         if (channel && !channel->push(zstd_frame{frame.rows, std::move(data)})) {
+            channel.reset();
+         }
+         if (keep) {
+            frames.emplace_back(std::move(frame));
+         }
+      }
+      if (!stopping) {
+         read_next_section();
+      }
+   } catch (...) {
+      failure = std::current_exception();
+   }
+
+   {
+      std::lock_guard<std::mutex> g(mtx);
+      if (failure) {
+         error = failure;
+      } else if (keep) {
+         kept[section_name] = std::move(frames);
+      }
+      busy = false;
+      cv.notify_all();
+   }
+
+   if (channel) {
+      channel->finish(failure);
+   }
+}
+
+bool zstd_istream_snapshot_reader::source::contains( const std::string& section_name ) {
+   std::unique_lock<std::mutex> g(mtx);
+   while (true) {
+      if (error) {
+         std::rethrow_exception(error);
+      }
+      if (seen.count(section_name)) {
+         return true;
+      }
+      if (!busy) {
+         if (at_end) {
+            return false;
+         }
+         start_pump(nullptr);
+      }
+      cv.wait(g);
+   }
+}
+
+std::unique_ptr<zstd_istream_snapshot_reader::section> zstd_istream_snapshot_reader::source::open( const std::string& section_name ) {
+   EOS_ASSERT(magic == zstd_ostream_snapshot_writer::magic_number && version == current_snapshot_version, snapshot_exception,
+              "Compressed snapshot has an invalid header");
+
+   std::shared_ptr<zstd_channel> channel;
+   std::vector<zstd_frame>       frames;
+   {
+      std::unique_lock<std::mutex> g(mtx);
+      auto w = wanted.insert(section_name);
+      auto done_waiting = fc::make_scoped_exit([this, w]() { wanted.erase(w); });
+
+      while (true) {
+         if (error) {
+            std::rethrow_exception(error);
+         }
+
+         auto k = kept.find(section_name);
+         if (k != kept.end()) {
+            if (keep_all) {
+               frames = k->second;
+            } else {
+               frames = std::move(k->second);
+               kept.erase(k);
+            }
+            break;
+         }
+
+         if (!busy) {
+            EOS_ASSERT(!at_end, snapshot_exception, "Compressed snapshot has no section named ${n}", ("n", section_name));
+            if (next_section == section_name) {
+               channel = std::make_shared<zstd_channel>();
+               start_pump(channel);
+               break;
+            }
+
+            // every reader is waiting for a section further in the stream
+            if (!wanted.count(*next_section) && wanted.size() >= readers) {
+               start_pump(nullptr);
+            }
+         }
+         cv.wait(g);
+      }
+   }
+
+   // the first frame is waited for without holding the lock, which the pipeline takes to finish the section
+   return channel ? std::make_unique<section>(channel) : std::make_unique<section>(std::move(frames));
+}
+
+void zstd_istream_snapshot_reader::source::return_to_header() {
+   std::lock_guard<std::mutex> g(mtx);
+   EOS_ASSERT(keep_all, snapshot_exception, "A compressed snapshot can only return to its header once, when it is read in two passes");
+   keep_all = false;
+}
+
+void zstd_istream_snapshot_reader::source::set_readers( uint32_t count ) {
+   std::lock_guard<std::mutex> g(mtx);
+   readers = count;
+   cv.notify_all();
+}
+
+void zstd_istream_snapshot_reader::source::remove_reader() {
+   std::lock_guard<std::mutex> g(mtx);
+   --readers;
+   cv.notify_all();
+}
+
+zstd_istream_snapshot_reader::zstd_istream_snapshot_reader(std::istream& snapshot, bool two_pass)
+:src(std::make_shared<source>(snapshot, two_pass))
+{
+}
+
+zstd_istream_snapshot_reader::zstd_istream_snapshot_reader(const std::shared_ptr<source>& src)
+:src(src)
+,task_reader(true)
+{
+}
+
+zstd_istream_snapshot_reader::~zstd_istream_snapshot_reader() {
+}
+
+void zstd_istream_snapshot_reader::validate() const {
+   src->validate();
+}
+
+bool zstd_istream_snapshot_reader::has_section( const string& section_name ) {
+   EOS_ASSERT(!cur_section, snapshot_exception, "Compressed snapshot cannot look for a section while reading a section");
+   return src->contains(section_name);
+}
+
+void zstd_istream_snapshot_reader::set_section( const string& section_name ) {
+   cur_section.reset();
+   cur_section = src->open(section_name);
+}
+
+bool zstd_istream_snapshot_reader::read_row( detail::abstract_snapshot_row_reader& row_reader ) {
+   EOS_ASSERT(cur_section, snapshot_exception, "No section of the compressed snapshot is being read");
+   return cur_section->read_row(row_reader);
+}
+
+bool zstd_istream_snapshot_reader::empty ( ) {
+   return !cur_section || cur_section->empty();
+}
+
+void zstd_istream_snapshot_reader::clear_section() {
+   cur_section.reset();
+}
+
+void zstd_istream_snapshot_reader::return_to_header() {
+   clear_section();
+   src->return_to_header();
+}
+
+void zstd_istream_snapshot_reader::read_concurrently( const std::vector<task>& tasks ) {
+   // readers of tasks run their own tasks in turn
+   if (task_reader || tasks.empty()) {
+      snapshot_reader::read_concurrently(tasks);
+      return;
+   }
+
+   // every task has a thread, as a task waiting for a section holds its thread until the section comes
+   src->set_readers(tasks.size());
+   auto restore = fc::make_scoped_exit([this]() { src->set_readers(1); });
+   named_thread_pool thread_pool("snapzr", tasks.size());
+   run_concurrently(thread_pool, tasks.size(), [this, &tasks](size_t i) {
+      auto done = fc::make_scoped_exit([this]() { src->remove_reader(); });
+      tasks[i](snapshot_reader_ptr(new zstd_istream_snapshot_reader(src)));
+   });
+}
+
 integrity_hash_snapshot_writer::integrity_hash_snapshot_writer(fc::sha256::encoder& enc)
 :enc(enc)
 {
@@ -2,8 +2,19 @@
 #include <eosio/chain/protocol_state_object.hpp>
 #include <eosio/chain/transaction_context.hpp>
 #include <eosio/chain/apply_context.hpp>
+#include <eosio/chain/rsa.hpp>
 
-namespace eosio { namespace chain { namespace webassembly {
+namespace eosio { namespace chain {
+
+   namespace rsa {
+      key_cache& intrinsic_key_cache() {
+         // contracts verify against a handful of keys, usually a single oracle or RNG key
+         static key_cache cache(64);
+         return cache;
+      }
+   }
+
+namespace webassembly {
 
    void interface::assert_recover_key( legacy_ptr<const fc::sha256> digest,
                                        legacy_span<const char> sig,
@@ -101,6 +112,38 @@ namespace eosio { namespace chain { namespace webassembly {
       *hash_val = context.trx_context.hash_with_checktime<fc::ripemd160>( data.data(), data.size() );
    }
 
+   namespace {
+      /**
+       * Generic verification with boost::multiprecision, the reference for inputs the fixed width engine does not
+       * cover. Throws on invalid hexadecimal strings.
+       */
+      bool verify_rsa_sha256_sig_generic(const fc::sha256& msg_sha256,
+                                         std::string_view signature,
+                                         std::string_view exponent,
+                                         std::string_view modulus) {
+         using std::string;
+         using namespace std::string_literals;
+         using namespace boost::multiprecision;
+
+         auto pkcs1_encoding =
+                "3031300d060960864801650304020105000420"s +
+                fc::to_hex(msg_sha256.data(), msg_sha256.data_size());
+
+         auto emLen = modulus.size() / 2;
+         auto tLen = pkcs1_encoding.size() / 2;
+
+         pkcs1_encoding = "0001"s + string(2*(emLen - tLen - 3), 'f') + "00"s + pkcs1_encoding;
+
+         const cpp_int signature_int { "0x"s + string{signature} };
+         const cpp_int exponent_int  { "0x"s + string{exponent} };
+         const cpp_int modulus_int   { "0x"s + string{modulus} };
+
+         const cpp_int decoded = powm(signature_int, exponent_int, modulus_int);
+
+         return cpp_int{"0x"s + pkcs1_encoding} == decoded;
+      }
+   }
+
    /**
     * WAX specific
     *
@@ -111,9 +154,7 @@ namespace eosio { namespace chain { namespace webassembly {
                                             legacy_span<const char> exponent,
                                             legacy_span<const char> modulus)
    {
-       using std::string;
        using namespace std::string_literals;
-       using namespace boost::multiprecision;
 
        const auto errPrefix = "[ERROR] verify_rsa_sha256_sig: "s;
 
@@ -127,23 +168,20 @@ namespace eosio { namespace chain { namespace webassembly {
           {
              fc::sha256 msg_sha256 = context.trx_context.hash_with_checktime<fc::sha256>( message.data(), message.size() );
 
-             auto pkcs1_encoding =
-                    "3031300d060960864801650304020105000420"s +
-                    fc::to_hex(msg_sha256.data(), msg_sha256.data_size());
-
+             // DigestInfo of SHA-256 is 51 bytes, the padding takes at least 11
              auto emLen = modulus_len / 2;
-             auto tLen = pkcs1_encoding.size() / 2;
-
-             if (emLen >= tLen + 11) {
-                pkcs1_encoding = "0001"s + string(2*(emLen - tLen - 3), 'f') + "00"s + pkcs1_encoding;
-
-                const cpp_int signature_int { "0x"s + string{signature.data(), signature_len} };
-                const cpp_int exponent_int  { "0x"s + string{exponent.data(), exponent_len} };
-                const cpp_int modulus_int   { "0x"s + string{modulus.data(), modulus_len} };
-
-                const cpp_int decoded = powm(signature_int, exponent_int, modulus_int);
-
-                return cpp_int{"0x"s + pkcs1_encoding} == decoded;
+             if (emLen >= 51 + 11) {
+                const std::string_view signature_hex{signature.data(), signature_len};
+                const std::string_view exponent_hex{exponent.data(), exponent_len};
+                const std::string_view modulus_hex{modulus.data(), modulus_len};
+
+                // inputs outside the fixed width engine, including malformed hex strings, take the generic path,
+                // which keeps results and console output of every input unchanged
+                if (auto key = rsa::intrinsic_key_cache().get(exponent_hex, modulus_hex)) {
+                   if (auto valid = key->verify_sha256(msg_sha256, signature_hex))
+                      return *valid;
+                }
+                return verify_rsa_sha256_sig_generic(msg_sha256, signature_hex, exponent_hex, modulus_hex);
              }
              else
                 context.console_append(errPrefix + "Intended encoding message lenght too short\n");
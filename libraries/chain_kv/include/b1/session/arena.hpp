@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace eosio::session {
+
+/// \brief A bump allocator whose memory is only returned to the heap all at once.
+/// \remarks Small deallocations are kept on free lists by size class and reused by the next allocations of their class,
+/// so that a cache whose entries are replaced does not grow the arena.  Larger deallocations are ignored.  The memory is
+/// returned by release, which must only be called when nothing allocated from the arena is in use anymore.  The first
+/// block is kept by release so that a session which is reused does not go back to the heap for every commit or undo.
+class arena {
+ public:
+   static constexpr size_t default_block_size = 64 * 1024;
+
+   explicit arena(size_t block_size = default_block_size) : m_block_size{ block_size } {}
+   arena(const arena&) = delete;
+   arena(arena&&)      = delete;
+
+   arena& operator=(const arena&) = delete;
+   arena& operator=(arena&&) = delete;
+
+   void* allocate(size_t size, size_t alignment);
+   void  deallocate(void* ptr, size_t size, size_t alignment);
+
+   /// \brief Frees everything allocated from this arena.
+   void release();
+
+   /// \brief Returns the number of bytes allocated from this arena and not deallocated since the last release.
+   size_t allocated() const { return m_allocated; }
+
+ private:
+   static constexpr size_t granularity     = alignof(std::max_align_t);
+   static constexpr size_t max_reused_size = 512;
+
+   struct block {
+      std::unique_ptr<char[]> data;
+      size_t                  size{ 0 };
+   };
+
+   struct free_node {
+      free_node* next{ nullptr };
+   };
+
+   static bool   reused(size_t size, size_t alignment) { return size <= max_reused_size && alignment <= granularity; }
+   static size_t size_class(size_t size) { return size == 0 ? 0 : (size - 1) / granularity; }
+
+   void* carve(size_t size, size_t alignment);
+
+   size_t             m_block_size{ default_block_size };
+   std::vector<block> m_blocks;
+   char*              m_cursor{ nullptr };
+   char*              m_end{ nullptr };
+   size_t             m_allocated{ 0 };
+   std::array<free_node*, max_reused_size / granularity> m_free{}; ///< freed allocations by size class
+};
+
+/// \brief A standard allocator carving its memory from an arena.
+/// \remarks The allocator travels with the container on move assignment and swap so that the nodes of a container are
+/// always freed by the arena they came from.
+template <typename T>
+class arena_allocator {
+ public:
+   using value_type                             = T;
+   using propagate_on_container_copy_assignment = std::true_type;
+   using propagate_on_container_move_assignment = std::true_type;
+   using propagate_on_container_swap            = std::true_type;
+
+   template <typename U>
+   friend class arena_allocator;
+
+   explicit arena_allocator(arena& a) : m_arena{ &a } {}
+
+   template <typename U>
+   arena_allocator(const arena_allocator<U>& other) : m_arena{ other.m_arena } {}
+
+   T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+   void deallocate(T* p, size_t n) { m_arena->deallocate(p, n * sizeof(T), alignof(T)); }
+
+   template <typename U>
+   bool operator==(const arena_allocator<U>& other) const {
+      return m_arena == other.m_arena;
+   }
+
+   template <typename U>
+   bool operator!=(const arena_allocator<U>& other) const {
+      return m_arena != other.m_arena;
+   }
+
+ private:
+   arena* m_arena{ nullptr };
+};
+
+inline void* arena::allocate(size_t size, size_t alignment) {
+   m_allocated += size;
+   if (!reused(size, alignment)) {
+      return carve(size, alignment);
+   }
+   // Every allocation of a size class is carved whole and aligned for any type, so any of them can be handed out again.
+   auto& head = m_free[size_class(size)];
+   if (head) {
+      auto* node = head;
+      head       = node->next;
+      return node;
+   }
+   return carve((size_class(size) + 1) * granularity, granularity);
+}
+
+inline void arena::deallocate(void* ptr, size_t size, size_t alignment) {
+   m_allocated -= size;
+   if (!reused(size, alignment)) {
+      return;
+   }
+   auto& head = m_free[size_class(size)];
+   head       = ::new (ptr) free_node{ head };
+}
+
+inline void* arena::carve(size_t size, size_t alignment) {
+   auto space = static_cast<size_t>(m_end - m_cursor);
+   auto ptr   = static_cast<void*>(m_cursor);
+   if (!m_cursor || !std::align(alignment, size, ptr, space)) {
+      // Oversized requests get a block of their own.
+      auto block_size = std::max(m_block_size, size + alignment);
+      m_blocks.push_back(block{ std::make_unique<char[]>(block_size), block_size });
+      m_cursor = m_blocks.back().data.get();
+      m_end    = m_cursor + block_size;
+      space    = block_size;
+      ptr      = m_cursor;
+      std::align(alignment, size, ptr, space);
+   }
+   m_cursor = static_cast<char*>(ptr) + size;
+   return ptr;
+}
+
+inline void arena::release() {
+   if (m_blocks.empty()) {
+      return;
+   }
+   m_blocks.resize(1);
+   m_cursor    = m_blocks.front().data.get();
+   m_end       = m_cursor + m_blocks.front().size;
+   m_allocated = 0;
+   m_free.fill(nullptr);
+}
+
+} // namespace eosio::session
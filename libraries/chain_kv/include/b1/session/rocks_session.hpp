@@ -198,6 +198,8 @@ inline session<rocksdb_t>::session(std::shared_ptr<rocksdb::DB> db, size_t max_i
          read_options.verify_checksums                     = false;
          read_options.fill_cache                           = false;
          read_options.background_purge_on_iterator_cleanup = true;
+         // Iterators walk all the keys in order, also when the db has a prefix extractor for its bloom filters.
+         read_options.total_order_seek = true;
          return read_options;
       }() },
       m_iterators{ [&]() {
@@ -309,10 +311,11 @@ void session<rocksdb_t>::write(const Iterable& key_values) {
 
 template <typename Iterable>
 void session<rocksdb_t>::erase(const Iterable& keys) {
-   for (const auto& key : keys) {
-      auto key_slice = rocksdb::Slice{ key.data(), key.size() };
-      auto status    = m_db->Delete(m_write_options, column_family_(), key_slice);
-   }
+   auto batch = rocksdb::WriteBatch{ 1024 * 1024 };
+
+   for (const auto& key : keys) { batch.Delete(column_family_(), { key.data(), key.size() }); }
+
+   auto status = m_db->Write(m_write_options, &batch);
 }
 
 template <typename Other_data_store, typename Iterable>
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <memory>
 #include <optional>
 #include <queue>
 #include <set>
@@ -9,6 +11,7 @@
 #include <unordered_set>
 #include <variant>
 
+#include <b1/session/arena.hpp>
 #include <b1/session/shared_bytes.hpp>
 
 namespace eosio::session {
@@ -44,7 +47,11 @@ class session {
 
    using type                = session;
    using parent_type         = Parent;
-   using cache_type          = std::map<shared_bytes, value_state>;
+   /// The nodes of the cache are carved from an arena owned by the session, the nodes erased are reused by the arena
+   /// and all of them are freed at once when the cache is cleared by a commit or an undo.  A node based container is kept since iterators into the cache must stay valid
+   /// while keys are added to it.
+   using cache_allocator_type = arena_allocator<std::pair<const shared_bytes, value_state>>;
+   using cache_type           = std::map<shared_bytes, value_state, std::less<shared_bytes>, cache_allocator_type>;
    using parent_variant_type = std::variant<type*, parent_type*>;
 
    friend Parent;
@@ -155,6 +162,10 @@ class session {
    /// \brief Returns the set of keys that have been deleted in this session.
    std::unordered_set<shared_bytes> deleted_keys() const;
 
+   /// \brief Returns the changes of this session, the updated key/value pairs and the deleted keys.
+   /// \remarks These are the changes written into the parent by commit.
+   std::pair<std::unordered_map<shared_bytes, shared_bytes>, std::unordered_set<shared_bytes>> changes() const;
+
    /// \brief Attaches a new parent to the session.
    void attach(Parent& parent);
 
@@ -176,6 +187,9 @@ class session {
    void                        erase(const shared_bytes& key);
    void                        clear();
 
+   /// \brief Returns the number of bytes the nodes of the cache of this session hold in its arena.
+   size_t cache_allocated() const { return m_arena->allocated(); }
+
    /// \brief Reads a batch of keys from this session.
    /// \param keys A type that supports iteration and returns in its iterator a shared_bytes type representing the key.
    template <typename Iterable>
@@ -259,8 +273,9 @@ class session {
    It& first_not_deleted_in_iterator_cache_(It& it, const It& end) const;
 
  private:
-   parent_variant_type m_parent{ static_cast<Parent*>(nullptr) };
-   cache_type          m_cache;
+   parent_variant_type    m_parent{ static_cast<Parent*>(nullptr) };
+   std::unique_ptr<arena> m_arena{ std::make_unique<arena>() };
+   cache_type             m_cache{ cache_allocator_type{ *m_arena } };
 };
 
 template <typename Parent>
@@ -273,7 +288,7 @@ void session<Parent>::prime_cache_() {
    // Get the bounds of the parent cache and use those to
    // seed the cache of this session.
    auto update = [&](const auto& key, const auto& value) {
-      auto it = m_cache.emplace(key, value_state{});
+      auto it = m_cache.try_emplace(key);
       if (it.second) {
          it.first->second.value = value;
       }
@@ -296,6 +311,7 @@ void session<Parent>::prime_cache_() {
 template <typename Parent>
 void session<Parent>::clear() {
    m_cache.clear();
+   m_arena->release();
 }
 
 template <typename Parent>
@@ -309,9 +325,12 @@ session<Parent>::session(session& parent, std::nullptr_t) : m_parent{ &parent }
 }
 
 template <typename Parent>
-session<Parent>::session(session&& other) : m_parent{ std::move(other.m_parent) }, m_cache{ std::move(other.m_cache) } {
+session<Parent>::session(session&& other)
+    : m_parent{ std::move(other.m_parent) }, m_arena{ std::move(other.m_arena) }, m_cache{ std::move(other.m_cache) } {
    session* null_parent = nullptr;
    other.m_parent       = null_parent;
+   other.m_arena        = std::make_unique<arena>();
+   other.m_cache        = cache_type{ cache_allocator_type{ *other.m_arena } };
 }
 
 template <typename Parent>
@@ -320,11 +339,15 @@ session<Parent>& session<Parent>::operator=(session&& other) {
       return *this;
    }
 
+   // The cache takes the allocator of the other cache, so the nodes of this cache are gone before its arena is.
    m_parent = std::move(other.m_parent);
    m_cache  = std::move(other.m_cache);
+   m_arena  = std::move(other.m_arena);
 
    session* null_parent = nullptr;
    other.m_parent       = null_parent;
+   other.m_arena        = std::make_unique<arena>();
+   other.m_cache        = cache_type{ cache_allocator_type{ *other.m_arena } };
 
    return *this;
 }
@@ -348,7 +371,7 @@ void session<Parent>::previous_key_(It& it, Parent_it& pit, Parent_it& pbegin, P
       if (pit != pbegin) {
          --pit;
          if (pit != pend) {
-            auto cit = m_cache.emplace(pit.key(), value_state{});
+            auto cit = m_cache.try_emplace(pit.key());
             if (cit.second) {
                cit.first->second.value = *(*pit).second;
             }
@@ -375,7 +398,7 @@ void session<Parent>::next_key_(It& it, Parent_it& pit, Parent_it& pend) {
          decrement = true;
       }
       if (pit != pend) {
-         auto cit = m_cache.emplace(pit.key(), value_state{});
+         auto cit = m_cache.try_emplace(pit.key());
          if (cit.second) {
             cit.first->second.value = *(*pit).second;
          }
@@ -395,7 +418,7 @@ void session<Parent>::next_key_(It& it, Parent_it& pit, Parent_it& pend) {
 
 template <typename Parent>
 typename session<Parent>::cache_type::iterator session<Parent>::update_iterator_cache_(const shared_bytes& key) {
-   auto  result = m_cache.emplace(key, value_state{});
+   auto  result = m_cache.try_emplace(key);
    auto& it     = result.first;
 
    if (result.second) {
@@ -466,6 +489,21 @@ std::unordered_set<shared_bytes> session<Parent>::deleted_keys() const {
    return results;
 }
 
+template <typename Parent>
+std::pair<std::unordered_map<shared_bytes, shared_bytes>, std::unordered_set<shared_bytes>>
+session<Parent>::changes() const {
+   auto updates = std::unordered_map<shared_bytes, shared_bytes>{};
+   auto deletes = std::unordered_set<shared_bytes>{};
+   for (const auto& p : m_cache) {
+      if (p.second.deleted) {
+         deletes.emplace(p.first);
+      } else if (p.second.updated) {
+         updates.emplace(p.first, p.second.value);
+      }
+   }
+   return { std::move(updates), std::move(deletes) };
+}
+
 template <typename Parent>
 void session<Parent>::attach(Parent& parent) {
    m_parent = &parent;
@@ -492,16 +530,7 @@ void session<Parent>::commit() {
    }
 
    auto write_through = [&](auto& ds) {
-      auto deletes = std::unordered_set<shared_bytes>{};
-      auto updates = std::unordered_map<shared_bytes, shared_bytes>{};
-
-      for (const auto& p : m_cache) {
-         if (p.second.deleted) {
-            deletes.emplace(p.first);
-         } else if (p.second.updated) {
-            updates.emplace(p.first, p.second.value);
-         }
-      }
+      auto [updates, deletes] = changes();
 
       if (deletes.size() > 0) {
          ds.erase(deletes);
@@ -667,7 +696,9 @@ It& session<Parent>::first_not_deleted_in_iterator_cache_(It& it, const It& end,
       update_previous_flag(it);
       ++it;
    }
-   update_previous_flag(it);
+   if (it != end) {
+      update_previous_flag(it);
+   }
    previous_in_cache = previous_known;
    return it;
 }
@@ -697,7 +728,7 @@ typename session<Parent>::iterator session<Parent>::find(const shared_bytes& key
             [&](auto* p) {
                auto pit = p->find(key);
                if (pit != std::end(*p)) {
-                  auto result = m_cache.emplace(key, value_state{});
+                  auto result = m_cache.try_emplace(key);
                   it          = result.first;
                   if (result.second) {
                      it->second.value = *(*pit).second;
@@ -741,7 +772,7 @@ typename session<Parent>::iterator session<Parent>::begin() {
                auto pend = std::end(*p);
                first_not_deleted_in_iterator_cache_(pit, pend);
                if (pit != pend && pit.key() < pending_key) {
-                  auto result = m_cache.emplace(pit.key(), value_state{});
+                  auto result = m_cache.try_emplace(pit.key());
                   it          = result.first;
                   if (result.second) {
                      it->second.value = *(*pit).second;
@@ -787,7 +818,7 @@ typename session<Parent>::iterator session<Parent>::lower_bound(const shared_byt
                first_not_deleted_in_iterator_cache_(pit, pend);
                if (pit != pend) {
                   if (!pending_key || pit.key() < pending_key) {
-                     auto result = m_cache.emplace(pit.key(), value_state{});
+                     auto result = m_cache.try_emplace(pit.key());
                      it          = result.first;
                      if (result.second) {
                         it->second.value = *(*pit).second;
@@ -874,7 +905,7 @@ void session<Parent>::session_iterator<Iterator_traits>::move_next_() {
       }
 
       if (key) {
-         auto nit                            = m_active_session->m_cache.emplace(key, value_state{});
+         auto nit                            = m_active_session->m_cache.try_emplace(key);
          nit.first->second.previous_in_cache = true;
          it->second.next_in_cache            = true;
          if (nit.second) {
@@ -935,7 +966,7 @@ void session<Parent>::session_iterator<Iterator_traits>::move_previous_() {
       }
 
       if (key) {
-         auto nit                        = m_active_session->m_cache.emplace(key, value_state{});
+         auto nit                        = m_active_session->m_cache.try_emplace(key);
          nit.first->second.next_in_cache = true;
          it->second.previous_in_cache    = true;
          if (nit.second) {
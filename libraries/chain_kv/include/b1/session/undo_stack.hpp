@@ -1,6 +1,11 @@
 #pragma once
 
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <queue>
+#include <thread>
+#include <utility>
 
 #include <fc/filesystem.hpp>
 #include <fc/io/fstream.hpp>
@@ -16,6 +21,7 @@ namespace eosio::session {
    constexpr uint32_t undo_stack_min_supported_version = 1;
    constexpr uint32_t undo_stack_max_supported_version = 1;
    constexpr auto undo_stack_filename = "undo_stack.dat";
+   constexpr size_t undo_stack_max_pending_commit_keys = 1024 * 1024;
 
 /// \brief Represents a container of pending sessions to be committed.
 template <typename Session>
@@ -47,9 +53,21 @@ class undo_stack {
 
    /// \brief Commits the sessions at the bottom of the stack up to and including the provided revision.
    /// \param revision The revision number to commit up to.
-   /// \remarks Each time a session is push onto the stack, a revision is assigned to it.
+   /// \remarks Each time a session is push onto the stack, a revision is assigned to it.  With asynchronous commits
+   /// the changes are written into the head session by a background thread.  Until they are written, the stack reads
+   /// them from a session of committed changes between the head session and the bottom of the stack.
    void commit(int64_t revision);
 
+   /// \brief Enables or disables writing committed changes into the head session on a background thread.
+   /// \param max_pending_keys The number of changed keys that may be committed but not yet written.  A commit which
+   /// goes past it waits until the background thread has written all of them.
+   /// \remarks The background thread groups the changes of the commits made while it was writing into one write.  The
+   /// head session must allow its batch write and erase to run concurrently with reads.
+   void async_commit(bool enabled, size_t max_pending_keys = undo_stack_max_pending_commit_keys);
+
+   /// \brief Waits until the committed changes are written into the head session.
+   void wait_for_commit();
+
    bool   empty() const;
    size_t size() const;
 
@@ -62,13 +80,17 @@ class undo_stack {
    void revision(int64_t revision);
 
    /// \brief Returns the head session (the session at the top of the stack.
+   /// \remarks When the stack is empty, this waits until the committed changes are written so that changes made
+   /// through the returned session go into the head session.
    variant_type top();
 
    /// \brief Returns the head session (the session at the top of the stack.
+   /// \remarks When the stack is empty while committed changes are being written, this is the session of the
+   /// committed changes.
    const_variant_type top() const;
 
    /// \brief Returns the session at the bottom of the stack.
-   /// \remarks This is the next session to be committed.
+   /// \remarks This is the next session to be committed.  When the stack is empty, this is the same session as top.
    variant_type bottom();
 
    /// \brief Returns the session at the bottom of the stack.
@@ -79,11 +101,40 @@ class undo_stack {
    void close();
 
  private:
-   int64_t                  m_revision{ 0 };
-   Session*                 m_head;
-   std::deque<session_type> m_sessions; // Need a deque so pointers don't become invalidated.  The session holds a
-                                        // pointer to the parent internally.
-   fc::path                 m_datadir;
+   using write_set = std::pair<std::unordered_map<shared_bytes, shared_bytes>, std::unordered_set<shared_bytes>>;
+
+   /// \brief The background thread writing committed changes into the head session.
+   struct committer {
+      std::mutex              mutex;
+      std::condition_variable cv;
+      std::vector<write_set>  queue;
+      bool                    busy{ false };
+      bool                    stop{ false };
+      std::exception_ptr      error;
+      std::thread             thread;
+   };
+
+   static void run_committer_(committer& c, Session& head);
+
+   /// \brief Commits the bottom session into the session below it, handing its changes to the committer when that is
+   /// the session of the committed changes.
+   void commit_bottom_();
+
+   /// \brief Drops the session of the committed changes once the committer has written all of them.
+   void release_committed_();
+
+   /// \brief The session the bottom of the stack is attached to.
+   variant_type base_();
+
+   int64_t                       m_revision{ 0 };
+   Session*                      m_head;
+   std::deque<session_type>      m_sessions; // Need a deque so pointers don't become invalidated.  The session holds a
+                                             // pointer to the parent internally.
+   fc::path                      m_datadir;
+   std::unique_ptr<session_type> m_committed; // changes handed to the committer which may not be in the head yet
+   size_t                        m_committed_keys{ 0 }; // changed keys handed to the committer, bounds m_committed
+   size_t                        m_max_pending_keys{ undo_stack_max_pending_commit_keys };
+   std::unique_ptr<committer>    m_committer;
 };
 
 template <typename Session>
@@ -94,12 +145,18 @@ undo_stack<Session>::undo_stack(Session& head, const fc::path& datadir) : m_head
 template <typename Session>
 undo_stack<Session>::~undo_stack() {
    close();
+   async_commit(false);
 }
 
 template <typename Session>
 void undo_stack<Session>::push() {
    if (m_sessions.empty()) {
-      m_sessions.emplace_back(*m_head);
+      release_committed_();
+      if (m_committed) {
+         m_sessions.emplace_back(*m_committed, nullptr);
+      } else {
+         m_sessions.emplace_back(*m_head);
+      }
    } else {
       m_sessions.emplace_back(m_sessions.back(), nullptr);
    }
@@ -111,7 +168,11 @@ void undo_stack<Session>::squash() {
    if (m_sessions.empty()) {
       return;
    }
-   m_sessions.back().commit();
+   if (m_sessions.size() == 1) {
+      commit_bottom_();
+   } else {
+      m_sessions.back().commit();
+   }
    m_sessions.back().detach();
    m_sessions.pop_back();
    --m_revision;
@@ -141,11 +202,153 @@ void undo_stack<Session>::commit(int64_t revision) {
 
    const auto start_index = revision - initial_revision;
 
-   for (int64_t i = start_index; i >= 0; --i) { m_sessions[i].commit(); }
+   if (m_committer) {
+      release_committed_();
+      if (!m_committed) {
+         m_committed = std::make_unique<session_type>(*m_head);
+         m_sessions.front().attach(*m_committed);
+      }
+   }
+
+   for (int64_t i = start_index; i > 0; --i) { m_sessions[i].commit(); }
+   commit_bottom_();
    m_sessions.erase(std::begin(m_sessions), std::begin(m_sessions) + start_index + 1);
+   if (!m_sessions.empty()) {
+      std::visit([&](auto* base) { m_sessions.front().attach(*base); }, base_().holder());
+   }
+
+   // The committed changes are held in memory until they are written, don't let them pile up when the committer falls
+   // behind.
+   if (m_committed && m_committed_keys > m_max_pending_keys) {
+      wait_for_commit();
+   }
+}
+
+template <typename Session>
+void undo_stack<Session>::commit_bottom_() {
+   auto& bottom = m_sessions.front();
+   if (m_committed) {
+      auto changes = bottom.changes();
+      if (!changes.first.empty() || !changes.second.empty()) {
+         m_committed_keys += changes.first.size() + changes.second.size();
+         auto lock = std::lock_guard{ m_committer->mutex };
+         m_committer->queue.emplace_back(std::move(changes));
+         m_committer->cv.notify_all();
+      }
+   }
+   bottom.commit();
+}
+
+template <typename Session>
+void undo_stack<Session>::run_committer_(committer& c, Session& head) {
+   auto lock = std::unique_lock{ c.mutex };
+   while (true) {
+      c.cv.wait(lock, [&]() { return c.stop || !c.queue.empty(); });
+      if (c.queue.empty()) {
+         return;
+      }
+      auto sets = std::move(c.queue);
+      c.queue.clear();
+      c.busy = true;
+      lock.unlock();
+
+      auto error = std::exception_ptr{};
+      try {
+         // Group the changes of all the waiting commits, the changes of a later commit replace those of an earlier one.
+         auto& [updates, deletes] = sets.front();
+         for (size_t i = 1; i < sets.size(); ++i) {
+            for (const auto& key : sets[i].second) {
+               updates.erase(key);
+               deletes.emplace(key);
+            }
+            for (const auto& kv : sets[i].first) {
+               deletes.erase(kv.first);
+               updates.insert_or_assign(kv.first, kv.second);
+            }
+         }
+
+         if (deletes.size() > 0) {
+            head.erase(deletes);
+         }
+         if (updates.size() > 0) {
+            head.write(updates);
+         }
+      } catch (...) { error = std::current_exception(); }
+
+      lock.lock();
+      if (error) {
+         c.error = error;
+      }
+      c.busy = false;
+      c.cv.notify_all();
+   }
+}
+
+template <typename Session>
+void undo_stack<Session>::async_commit(bool enabled, size_t max_pending_keys) {
+   m_max_pending_keys = max_pending_keys;
+   if (enabled == static_cast<bool>(m_committer)) {
+      return;
+   }
+
+   if (enabled) {
+      m_committer        = std::make_unique<committer>();
+      m_committer->thread = std::thread(run_committer_, std::ref(*m_committer), std::ref(*m_head));
+      return;
+   }
+
+   {
+      auto lock = std::lock_guard{ m_committer->mutex };
+      m_committer->stop = true;
+      m_committer->cv.notify_all();
+   }
+   m_committer->thread.join();
+   release_committed_();
+   m_committer.reset();
+}
+
+template <typename Session>
+void undo_stack<Session>::wait_for_commit() {
+   if (!m_committer) {
+      return;
+   }
+   {
+      auto lock = std::unique_lock{ m_committer->mutex };
+      m_committer->cv.wait(lock, [&]() { return m_committer->queue.empty() && !m_committer->busy; });
+   }
+   release_committed_();
+}
+
+template <typename Session>
+void undo_stack<Session>::release_committed_() {
+   if (!m_committed) {
+      return;
+   }
+   {
+      auto lock = std::lock_guard{ m_committer->mutex };
+      if (m_committer->error) {
+         std::rethrow_exception(std::exchange(m_committer->error, nullptr));
+      }
+      if (!m_committer->queue.empty() || m_committer->busy) {
+         return;
+      }
+   }
+
+   // Everything committed is in the head session, read it from there again.
    if (!m_sessions.empty()) {
       m_sessions.front().attach(*m_head);
    }
+   m_committed->detach();
+   m_committed.reset();
+   m_committed_keys = 0;
+}
+
+template <typename Session>
+typename undo_stack<Session>::variant_type undo_stack<Session>::base_() {
+   if (m_committed) {
+      return { *m_committed, nullptr };
+   }
+   return { *m_head, nullptr };
 }
 
 template <typename Session>
@@ -182,7 +385,9 @@ typename undo_stack<Session>::variant_type undo_stack<Session>::top() {
       auto& back = m_sessions.back();
       return { back, nullptr };
    }
-   return { *m_head, nullptr };
+   // Changes written into the session of the committed changes would never reach the head session.
+   wait_for_commit();
+   return base_();
 }
 
 template <typename Session>
@@ -191,6 +396,10 @@ typename undo_stack<Session>::const_variant_type undo_stack<Session>::top() cons
       auto& back = m_sessions.back();
       return { back, nullptr };
    }
+   if (m_committed) {
+      const auto& committed = *m_committed;
+      return { committed, nullptr };
+   }
    return { *m_head, nullptr };
 }
 
@@ -200,7 +409,7 @@ typename undo_stack<Session>::variant_type undo_stack<Session>::bottom() {
       auto& front = m_sessions.front();
       return { front, nullptr };
    }
-   return { *m_head, nullptr };
+   return top();
 }
 
 template <typename Session>
@@ -209,7 +418,7 @@ typename undo_stack<Session>::const_variant_type undo_stack<Session>::bottom() c
       auto& front = m_sessions.front();
       return { front, nullptr };
    }
-   return { *m_head, nullptr };
+   return top();
 }
 
 template <typename Session>
@@ -280,6 +489,8 @@ void undo_stack<Session>::open() {
 
 template <typename Session>
 void undo_stack<Session>::close() {
+   wait_for_commit();
+
    if (m_datadir.empty())
       return;
 
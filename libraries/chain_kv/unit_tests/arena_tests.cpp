@@ -0,0 +1,88 @@
+#include <b1/session/arena.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <map>
+#include <string>
+
+using namespace eosio::session;
+
+BOOST_AUTO_TEST_SUITE(arena_tests)
+
+BOOST_AUTO_TEST_CASE(allocate_test) {
+   auto a = arena{ 256 };
+   BOOST_REQUIRE(a.allocated() == 0);
+
+   auto* p1 = a.allocate(10, 1);
+   auto* p2 = a.allocate(8, 8);
+   BOOST_REQUIRE(reinterpret_cast<uintptr_t>(p2) % 8 == 0);
+   BOOST_REQUIRE(static_cast<char*>(p2) >= static_cast<char*>(p1) + 10);
+   BOOST_REQUIRE(a.allocated() == 18);
+
+   // Larger than a block.
+   auto* p3 = a.allocate(1024, 64);
+   BOOST_REQUIRE(reinterpret_cast<uintptr_t>(p3) % 64 == 0);
+   std::memset(p3, 0, 1024);
+
+   a.release();
+   BOOST_REQUIRE(a.allocated() == 0);
+   a.allocate(10, 1);
+   BOOST_REQUIRE(a.allocated() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(deallocate_test) {
+   auto a = arena{ 256 };
+
+   // Small allocations are reused by the next allocation of their size class.
+   auto* p1 = a.allocate(24, 8);
+   auto* p2 = a.allocate(24, 8);
+   a.deallocate(p1, 24, 8);
+   BOOST_REQUIRE(a.allocated() == 24);
+   BOOST_REQUIRE(a.allocate(20, 4) == p1);
+   a.deallocate(p2, 24, 8);
+   BOOST_REQUIRE(a.allocate(24, 16) == p2);
+   BOOST_REQUIRE(a.allocate(24, 8) != p1);
+
+   // Large ones are not.
+   auto* p3 = a.allocate(1024, 8);
+   a.deallocate(p3, 1024, 8);
+   BOOST_REQUIRE(a.allocate(1024, 8) != p3);
+}
+
+BOOST_AUTO_TEST_CASE(allocator_test) {
+   using allocator_type = arena_allocator<std::pair<const std::string, int>>;
+   using map_type       = std::map<std::string, int, std::less<std::string>, allocator_type>;
+
+   auto a1 = std::make_unique<arena>(512);
+   auto m1 = map_type{ allocator_type{ *a1 } };
+   for (int i = 0; i < 100; ++i) { m1.emplace(std::to_string(i), i); }
+   BOOST_REQUIRE(m1.size() == 100);
+   BOOST_REQUIRE(a1->allocated() > 0);
+
+   // The allocator moves with the map.
+   auto a2 = std::make_unique<arena>();
+   auto m2 = map_type{ allocator_type{ *a2 } };
+   m2.emplace("a", 1);
+   m2 = std::move(m1);
+   a2 = std::move(a1);
+   BOOST_REQUIRE(m2.get_allocator() == allocator_type{ *a2 });
+   BOOST_REQUIRE(m2.size() == 100);
+   BOOST_REQUIRE(m2.find("42")->second == 42);
+
+   // Erased nodes are reused.
+   auto allocated = a2->allocated();
+   for (int i = 0; i < 100; ++i) {
+      m2.erase(std::to_string(i));
+      m2.emplace(std::to_string(i), i);
+   }
+   BOOST_REQUIRE(a2->allocated() == allocated);
+
+   m2.clear();
+   BOOST_REQUIRE(a2->allocated() == 0);
+   a2->release();
+   m2.emplace("b", 2);
+   BOOST_REQUIRE(m2.size() == 1);
+   BOOST_REQUIRE(m2.begin()->second == 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -422,6 +422,29 @@ BOOST_AUTO_TEST_CASE(session_delete_key_in_child) {
    root_session.commit();
 }
 
+BOOST_AUTO_TEST_CASE(session_cached_key_does_not_allocate) {
+   auto root_session  = eosio::session_tests::make_session("/tmp/session24");
+   using session_type = eosio::session::session<decltype(root_session)>;
+   write(root_session, std::unordered_map<uint16_t, uint16_t>{ { 0, 10 }, { 1, 9 }, { 2, 8 }, { 3, 7 } });
+
+   auto     block_session = session_type(root_session);
+   uint16_t key           = 2;
+   uint16_t value         = 8;
+   auto     key_          = eosio::session::shared_bytes(&key, 1);
+   auto     value_        = eosio::session::shared_bytes(&value, 1);
+   BOOST_REQUIRE(block_session.read(key_) == value_);
+
+   // The arena never reuses freed nodes, so looking up a key which is already cached must not allocate one.
+   const auto allocated = block_session.cache_allocated();
+   for (size_t i = 0; i < 1000; ++i) {
+      BOOST_REQUIRE(block_session.read(key_) == value_);
+      BOOST_REQUIRE(block_session.contains(key_));
+      BOOST_REQUIRE(block_session.find(key_) != std::end(block_session));
+      block_session.write(key_, value_);
+   }
+   BOOST_REQUIRE(block_session.cache_allocated() == allocated);
+}
+
 // BOOST_AUTO_TEST_CASE(session_iteration) {
 //     using rocks_db_type = rocks_data_store<>;
 //     using cache_type = cache<>;
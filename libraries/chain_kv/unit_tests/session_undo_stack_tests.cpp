@@ -93,4 +93,91 @@ BOOST_AUTO_TEST_CASE(undo_stack_test) {
                 int_t{});
 }
 
+BOOST_AUTO_TEST_CASE(undo_stack_async_commit_test) {
+   auto data_store    = eosio::session::make_session(make_rocks_db(), 16);
+   auto undo          = eosio::session::undo_stack(data_store);
+   auto session_kvs_1 = std::unordered_map<uint16_t, uint16_t>{
+      { 1, 100 }, { 2, 200 }, { 3, 300 }, { 4, 400 }, { 5, 500 },
+   };
+   write(data_store, session_kvs_1);
+   undo.async_commit(true);
+
+   auto top = [&]() -> decltype(undo)::session_type& {
+      return *std::get<decltype(undo)::session_type*>(undo.top().holder());
+   };
+
+   auto session_kvs_2 = std::unordered_map<uint16_t, uint16_t>{
+      { 6, 600 }, { 7, 700 }, { 8, 800 }, { 9, 900 }, { 10, 1000 },
+   };
+   auto session_kvs_3 = std::unordered_map<uint16_t, uint16_t>{
+      { 1, 1100 }, { 7, 1700 }, { 11, 1100 }, { 12, 1200 }, { 13, 1300 },
+   };
+   auto session_kvs_4 = std::unordered_map<uint16_t, uint16_t>{
+      { 16, 1600 }, { 17, 1700 }, { 18, 1800 }, { 19, 1900 }, { 20, 2000 },
+   };
+   undo.push();
+   write(top(), session_kvs_2);
+   undo.push();
+   write(top(), session_kvs_3);
+   undo.push();
+   write(top(), session_kvs_4);
+   BOOST_REQUIRE(undo.revision() == 3);
+
+   // The committed changes are read from the stack while they are written in the background.
+   undo.commit(1);
+   BOOST_REQUIRE(undo.size() == 2);
+   verify_equal(top(), collapse({ session_kvs_1, session_kvs_2, session_kvs_3, session_kvs_4 }), int_t{});
+   undo.commit(2);
+   BOOST_REQUIRE(undo.size() == 1);
+   verify_equal(top(), collapse({ session_kvs_1, session_kvs_2, session_kvs_3, session_kvs_4 }), int_t{});
+   undo.undo();
+   BOOST_REQUIRE(undo.empty());
+   BOOST_REQUIRE(undo.revision() == 2);
+
+   undo.wait_for_commit();
+   BOOST_REQUIRE(std::holds_alternative<decltype(undo)::root_type*>(undo.top().holder()));
+   verify_equal(data_store, collapse({ session_kvs_1, session_kvs_2, session_kvs_3 }), int_t{});
+}
+
+BOOST_AUTO_TEST_CASE(undo_stack_async_commit_backpressure_test) {
+   auto data_store = eosio::session::make_session(make_rocks_db(), 16);
+   auto undo       = eosio::session::undo_stack(data_store);
+   undo.async_commit(true, 8);
+
+   auto top = [&]() -> decltype(undo)::session_type& {
+      return *std::get<decltype(undo)::session_type*>(undo.top().holder());
+   };
+
+   auto session_kvs_1 = std::unordered_map<uint16_t, uint16_t>{
+      { 1, 100 }, { 2, 200 }, { 3, 300 }, { 4, 400 }, { 5, 500 },
+   };
+   auto session_kvs_2 = std::unordered_map<uint16_t, uint16_t>{
+      { 6, 600 }, { 7, 700 }, { 8, 800 }, { 9, 900 }, { 10, 1000 },
+   };
+   auto session_kvs_3 = std::unordered_map<uint16_t, uint16_t>{
+      { 1, 1100 }, { 7, 1700 }, { 11, 1100 }, { 12, 1200 }, { 13, 1300 },
+   };
+   undo.push();
+   write(top(), session_kvs_1);
+   undo.push();
+   write(top(), session_kvs_2);
+
+   // More changed keys than allowed are committed, the commit waits until they are written.
+   undo.commit(2);
+   BOOST_REQUIRE(undo.empty());
+   verify_equal(data_store, collapse({ session_kvs_1, session_kvs_2 }), int_t{});
+
+   undo.push();
+   write(top(), session_kvs_3);
+   undo.commit(3);
+   BOOST_REQUIRE(undo.empty());
+
+   // The head session is returned once the committed changes are written, so writes through it are kept.
+   auto session_kvs_4 = std::unordered_map<uint16_t, uint16_t>{ { 14, 1400 } };
+   auto head          = undo.top();
+   BOOST_REQUIRE(std::holds_alternative<decltype(undo)::root_type*>(head.holder()));
+   write(*std::get<decltype(undo)::root_type*>(head.holder()), session_kvs_4);
+   verify_equal(data_store, collapse({ session_kvs_1, session_kvs_2, session_kvs_3, session_kvs_4 }), int_t{});
+}
+
 BOOST_AUTO_TEST_SUITE_END();
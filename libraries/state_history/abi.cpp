@@ -46,6 +46,20 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "fetch_block_header", "type": "bool" }
             ]
         },
+        {
+            "name": "get_blocks_request_v2", "fields": [
+                { "name": "start_block_num", "type": "uint32" },
+                { "name": "end_block_num", "type": "uint32" },
+                { "name": "max_messages_in_flight", "type": "uint32" },
+                { "name": "have_positions", "type": "block_position[]" },
+                { "name": "irreversible_only", "type": "bool" },
+                { "name": "fetch_block", "type": "bool" },
+                { "name": "fetch_traces", "type": "bool" },
+                { "name": "fetch_deltas", "type": "bool" },
+                { "name": "fetch_block_header", "type": "bool" },
+                { "name": "fetch_compressed_entries", "type": "bool" }
+            ]
+        },
         {
             "name": "get_blocks_ack_request_v0", "fields": [
                 { "name": "num_messages", "type": "uint32" }
@@ -85,6 +99,24 @@ extern const char* const state_history_plugin_abi = R"({
                 { "name": "deltas",        "type": "bytes" }
             ]
         },
+        {
+            "name": "log_entry", "fields": [
+                { "name": "compression", "type": "uint8" },
+                { "name": "data", "type": "bytes" }
+            ]
+        },
+        {
+            "name": "get_blocks_result_v3", "fields": [
+                { "name": "head", "type": "block_position" },
+                { "name": "last_irreversible", "type": "block_position" },
+                { "name": "this_block", "type": "block_position?" },
+                { "name": "prev_block", "type": "block_position?" },
+                { "name": "block",         "type": "bytes" },
+                { "name": "block_header",  "type": "bytes" },
+                { "name": "traces",        "type": "log_entry" },
+                { "name": "deltas",        "type": "log_entry" }
+            ]
+        },
         {
             "name": "row_v0", "fields": [
                 { "name": "present", "type": "bool" },
@@ -652,8 +684,8 @@ extern const char* const state_history_plugin_abi = R"({
         { "new_type_name": "transaction_id", "type": "checksum256" }
     ],
     "variants": [
-        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1"] },
-        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_blocks_result_v2"] },
+        { "name": "request", "types": ["get_status_request_v0", "get_blocks_request_v0", "get_blocks_ack_request_v0", "get_blocks_request_v1", "get_blocks_request_v2"] },
+        { "name": "result", "types": ["get_status_result_v0", "get_blocks_result_v0", "get_blocks_result_v1", "get_blocks_result_v2", "get_blocks_result_v3"] },
 
         { "name": "action_receipt", "types": ["action_receipt_v0"] },
         { "name": "action_trace", "types": ["action_trace_v0", "action_trace_v1"] },
@@ -0,0 +1,120 @@
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/state_history/compression.hpp>
+
+#include <zdict.h>
+#include <zstd.h>
+
+#include <atomic>
+#include <memory>
+
+namespace eosio {
+namespace state_history {
+
+struct zstd_codec::dictionary {
+   ZSTD_CDict* cdict = nullptr;
+   ZSTD_DDict* ddict = nullptr;
+   uint32_t    id    = 0;
+
+   ~dictionary() {
+      ZSTD_freeCDict(cdict);
+      ZSTD_freeDDict(ddict);
+   }
+};
+
+struct zstd_codec::impl {
+   ZSTD_CCtx* cctx = ZSTD_createCCtx();
+   // replaced by set_dictionary() while other threads decompress, accessed with std::atomic_load/atomic_store
+   std::shared_ptr<const dictionary> dict;
+
+   ~impl() { ZSTD_freeCCtx(cctx); }
+};
+
+namespace {
+ZSTD_DCtx* thread_dctx() {
+   struct dctx_holder {
+      ZSTD_DCtx* dctx = ZSTD_createDCtx();
+      ~dctx_holder() { ZSTD_freeDCtx(dctx); }
+   };
+   thread_local dctx_holder holder;
+   EOS_ASSERT(holder.dctx, chain::state_history_exception, "unable to create zstd decompression context");
+   return holder.dctx;
+}
+} // namespace
+
+zstd_codec::zstd_codec(int level)
+    : my(new impl)
+    , level(level) {
+   EOS_ASSERT(my->cctx, chain::state_history_exception, "unable to create zstd compression context");
+}
+
+zstd_codec::~zstd_codec() = default;
+
+void zstd_codec::set_dictionary(const std::vector<char>& dict) {
+   uint32_t id = ZDICT_getDictID(dict.data(), dict.size());
+   EOS_ASSERT(id != 0, chain::state_history_exception, "invalid zstd dictionary");
+   auto d   = std::make_shared<dictionary>();
+   d->cdict = ZSTD_createCDict(dict.data(), dict.size(), level);
+   d->ddict = ZSTD_createDDict(dict.data(), dict.size());
+   d->id    = id;
+   EOS_ASSERT(d->cdict && d->ddict, chain::state_history_exception, "unable to load zstd dictionary ${id}", ("id", id));
+   std::atomic_store(&my->dict, std::shared_ptr<const dictionary>(std::move(d)));
+}
+
+uint32_t zstd_codec::dictionary_id() const {
+   auto dict = std::atomic_load(&my->dict);
+   return dict ? dict->id : 0;
+}
+
+std::vector<char> zstd_codec::compress(const std::vector<char>& data) {
+   auto              dict = std::atomic_load(&my->dict);
+   std::vector<char> result(ZSTD_compressBound(data.size()));
+   size_t            size = dict
+                               ? ZSTD_compress_usingCDict(my->cctx, result.data(), result.size(), data.data(),
+                                                          data.size(), dict->cdict)
+                               : ZSTD_compressCCtx(my->cctx, result.data(), result.size(), data.data(), data.size(), level);
+   EOS_ASSERT(!ZSTD_isError(size), chain::state_history_exception, "zstd compression failed: ${e}",
+              ("e", ZSTD_getErrorName(size)));
+   result.resize(size);
+   return result;
+}
+
+std::vector<char> zstd_codec::decompress(const char* data, size_t size) const {
+   auto content_size = ZSTD_getFrameContentSize(data, size);
+   EOS_ASSERT(content_size != ZSTD_CONTENTSIZE_ERROR && content_size != ZSTD_CONTENTSIZE_UNKNOWN,
+              chain::state_history_exception, "invalid zstd frame");
+
+   std::vector<char> result(content_size);
+   uint32_t          frame_dict_id = frame_dictionary_id(data, size);
+   size_t            decompressed_size;
+   if (frame_dict_id == 0) {
+      decompressed_size = ZSTD_decompressDCtx(thread_dctx(), result.data(), result.size(), data, size);
+   } else {
+      auto dict = std::atomic_load(&my->dict);
+      EOS_ASSERT(dict && frame_dict_id == dict->id, chain::state_history_exception,
+                 "zstd dictionary ${id} required to decompress entry is not loaded", ("id", frame_dict_id));
+      decompressed_size =
+          ZSTD_decompress_usingDDict(thread_dctx(), result.data(), result.size(), data, size, dict->ddict);
+   }
+   EOS_ASSERT(!ZSTD_isError(decompressed_size) && decompressed_size == content_size, chain::state_history_exception,
+              "zstd decompression failed: ${e}",
+              ("e", ZSTD_isError(decompressed_size) ? ZSTD_getErrorName(decompressed_size) : "size mismatch"));
+   return result;
+}
+
+uint32_t zstd_codec::frame_dictionary_id(const char* data, size_t size) {
+   return ZSTD_getDictID_fromFrame(data, size);
+}
+
+std::vector<char> zstd_codec::train_dictionary(const std::vector<char>&   samples,
+                                               const std::vector<size_t>& sample_sizes, size_t dict_capacity) {
+   std::vector<char> dict(dict_capacity);
+   size_t            size =
+       ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sample_sizes.data(), sample_sizes.size());
+   if (ZDICT_isError(size))
+      return {};
+   dict.resize(size);
+   return dict;
+}
+
+} // namespace state_history
+} // namespace eosio
@@ -2,8 +2,12 @@
 #include <eosio/state_history/rocksdb_receiver.hpp>
 #include <eosio/state_history/serialization.hpp>
 #include <eosio/chain/backing_store/db_combined.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <b1/session/rocks_session.hpp>
 
+#include <functional>
+#include <future>
+
 namespace eosio {
 namespace state_history {
 
@@ -58,8 +62,12 @@ bool include_delta(const chain::protocol_state_object& old, const chain::protoco
    return old.activated_protocol_features != curr.activated_protocol_features;
 }
 
-std::vector<table_delta> create_deltas(const chainbase::database& db, bool full_snapshot) {
-   std::vector<table_delta>                          deltas;
+// Tables are independent of each other and only read while the main thread waits for the deltas, so they can be
+// processed concurrently. The deltas are merged in the fixed order below, which keeps the result identical to a
+// serial pass. `while_processing` is called on the calling thread while the tables are processed.
+template <typename F>
+std::vector<table_delta> create_deltas(const chainbase::database& db, bool full_snapshot,
+                                       boost::asio::io_context* thread_pool, F while_processing) {
    const auto&                                       table_id_index = db.get_index<chain::table_id_multi_index>();
    std::map<uint64_t, const chain::table_id_object*> removed_table_id;
    for (auto& rem : table_id_index.last_undo_session().removed_values)
@@ -79,21 +87,20 @@ std::vector<table_delta> create_deltas(const chainbase::database& db, bool full_
       return fc::raw::pack(make_history_context_wrapper(db, get_table_id(row.t_id._id), row));
    };
 
-   auto process_table = [&](auto* name, auto& index, auto& pack_row) {
+   auto process_table = [&](auto* name, auto& index, auto& pack_row) -> std::optional<table_delta> {
       if (full_snapshot) {
          if (index.indices().empty())
-            return;
-         deltas.push_back({});
-         auto& delta = deltas.back();
+            return {};
+         table_delta delta;
          delta.name  = name;
          for (auto& row : index.indices())
             delta.rows.obj.emplace_back(2, pack_row(row));
+         return delta;
       } else {
          auto undo = index.last_undo_session();
          if (undo.old_values.empty() && undo.new_values.empty() && undo.removed_values.empty())
-            return;
-         deltas.push_back({});
-         auto& delta = deltas.back();
+            return {};
+         table_delta delta;
          delta.name  = name;
          for (auto& old : undo.old_values) {
             auto& row = index.get(old.id);
@@ -107,39 +114,78 @@ std::vector<table_delta> create_deltas(const chainbase::database& db, bool full_
          }
 
          if(delta.rows.obj.empty()) {
-            deltas.pop_back();
+            return {};
          }
+         return delta;
       }
    };
 
-   process_table("account", db.get_index<chain::account_index>(), pack_row);
-   process_table("account_metadata", db.get_index<chain::account_metadata_index>(), pack_row);
-   process_table("code", db.get_index<chain::code_index>(), pack_row);
+   std::vector<std::function<std::optional<table_delta>()>> tasks;
+   auto add_table = [&](auto* name, auto& index, auto& pack_row) {
+      tasks.push_back([&process_table, name, &index, &pack_row]() { return process_table(name, index, pack_row); });
+   };
+
+   add_table("account", db.get_index<chain::account_index>(), pack_row);
+   add_table("account_metadata", db.get_index<chain::account_metadata_index>(), pack_row);
+   add_table("code", db.get_index<chain::code_index>(), pack_row);
 
-   process_table("contract_table", db.get_index<chain::table_id_multi_index>(), pack_row);
-   process_table("contract_row", db.get_index<chain::key_value_index>(), pack_contract_row);
-   process_table("contract_index64", db.get_index<chain::index64_index>(), pack_contract_row);
-   process_table("contract_index128", db.get_index<chain::index128_index>(), pack_contract_row);
-   process_table("contract_index256", db.get_index<chain::index256_index>(), pack_contract_row);
-   process_table("contract_index_double", db.get_index<chain::index_double_index>(), pack_contract_row);
-   process_table("contract_index_long_double", db.get_index<chain::index_long_double_index>(), pack_contract_row);
+   add_table("contract_table", db.get_index<chain::table_id_multi_index>(), pack_row);
+   add_table("contract_row", db.get_index<chain::key_value_index>(), pack_contract_row);
+   add_table("contract_index64", db.get_index<chain::index64_index>(), pack_contract_row);
+   add_table("contract_index128", db.get_index<chain::index128_index>(), pack_contract_row);
+   add_table("contract_index256", db.get_index<chain::index256_index>(), pack_contract_row);
+   add_table("contract_index_double", db.get_index<chain::index_double_index>(), pack_contract_row);
+   add_table("contract_index_long_double", db.get_index<chain::index_long_double_index>(), pack_contract_row);
 
-   process_table("key_value", db.get_index<chain::kv_index>(), pack_row);
+   add_table("key_value", db.get_index<chain::kv_index>(), pack_row);
 
-   process_table("global_property", db.get_index<chain::global_property_multi_index>(), pack_row);
-   process_table("generated_transaction", db.get_index<chain::generated_transaction_multi_index>(), pack_row);
-   process_table("protocol_state", db.get_index<chain::protocol_state_multi_index>(), pack_row);
+   add_table("global_property", db.get_index<chain::global_property_multi_index>(), pack_row);
+   add_table("generated_transaction", db.get_index<chain::generated_transaction_multi_index>(), pack_row);
+   add_table("protocol_state", db.get_index<chain::protocol_state_multi_index>(), pack_row);
 
-   process_table("permission", db.get_index<chain::permission_index>(), pack_row);
-   process_table("permission_link", db.get_index<chain::permission_link_index>(), pack_row);
+   add_table("permission", db.get_index<chain::permission_index>(), pack_row);
+   add_table("permission_link", db.get_index<chain::permission_link_index>(), pack_row);
 
-   process_table("resource_limits", db.get_index<chain::resource_limits::resource_limits_index>(), pack_row);
-   process_table("resource_usage", db.get_index<chain::resource_limits::resource_usage_index>(), pack_row);
-   process_table("resource_limits_state", db.get_index<chain::resource_limits::resource_limits_state_index>(),
+   add_table("resource_limits", db.get_index<chain::resource_limits::resource_limits_index>(), pack_row);
+   add_table("resource_usage", db.get_index<chain::resource_limits::resource_usage_index>(), pack_row);
+   add_table("resource_limits_state", db.get_index<chain::resource_limits::resource_limits_state_index>(),
                  pack_row);
-   process_table("resource_limits_config", db.get_index<chain::resource_limits::resource_limits_config_index>(),
+   add_table("resource_limits_config", db.get_index<chain::resource_limits::resource_limits_config_index>(),
                  pack_row);
 
+   std::vector<std::future<std::optional<table_delta>>> results;
+   if (thread_pool) {
+      for (auto& task : tasks)
+         results.push_back(chain::async_thread_pool(*thread_pool, task));
+   } else {
+      for (auto& task : tasks) {
+         std::promise<std::optional<table_delta>> result;
+         try {
+            result.set_value(task());
+         } catch (...) {
+            result.set_exception(std::current_exception());
+         }
+         results.push_back(result.get_future());
+      }
+   }
+
+   // the tasks refer to this stack frame, wait for all of them before anything can be thrown
+   std::exception_ptr error;
+   try {
+      while_processing();
+   } catch (...) {
+      error = std::current_exception();
+   }
+   for (auto& result : results)
+      result.wait();
+   if (error)
+      std::rethrow_exception(error);
+
+   std::vector<table_delta> deltas;
+   for (auto& result : results) {
+      if (auto delta = result.get())
+         deltas.push_back(std::move(*delta));
+   }
    return deltas;
 }
 
@@ -195,17 +241,21 @@ std::vector<table_delta> create_deltas_rocksdb(const chainbase::database& db, co
    return deltas;
 }
 
-std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot){
+std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot,
+                                       boost::asio::io_context* thread_pool){
    auto &chainbase_db = db.get_db();
    auto &kv_undo_stack = db.get_kv_undo_stack();
 
-   std::vector<table_delta> deltas = create_deltas(chainbase_db, full_snapshot);
-
-   if(kv_undo_stack && chainbase_db.get<chain::kv_db_config_object>().backing_store == chain::backing_store_type::ROCKSDB) {
-      auto deltas_rocksdb = create_deltas_rocksdb(chainbase_db, kv_undo_stack, full_snapshot);
-      deltas.insert( deltas.end(), deltas_rocksdb.begin(), deltas_rocksdb.end() );
-   }
+   // the rocksdb session is not safe to share, its deltas are created on this thread while the chainbase tables
+   // are processed on the thread pool
+   std::vector<table_delta> deltas_rocksdb;
+   std::vector<table_delta> deltas = create_deltas(chainbase_db, full_snapshot, thread_pool, [&]() {
+      if(kv_undo_stack && chainbase_db.get<chain::kv_db_config_object>().backing_store == chain::backing_store_type::ROCKSDB) {
+         deltas_rocksdb = create_deltas_rocksdb(chainbase_db, kv_undo_stack, full_snapshot);
+      }
+   });
 
+   deltas.insert( deltas.end(), deltas_rocksdb.begin(), deltas_rocksdb.end() );
    return deltas;
 }
 
@@ -8,6 +8,8 @@
 #include <fc/io/datastream.hpp>
 #include <fc/io/bio_device_adaptor.hpp>
 
+#include <memory>
+
 
 namespace eosio {
 namespace state_history {
@@ -82,5 +84,103 @@ std::vector<char> zlib_decompress(STREAM& strm) {
    return {};
 }
 
+/**
+ * zstd compression of state history log entries. A dictionary, once set, is used to compress every following
+ * entry; frames record the id of their dictionary so entries compressed before it was set stay readable.
+ * compress() and set_dictionary() are not thread safe, the logs serialize them. decompress() uses a context per
+ * thread and may be called from any thread, so that readers decode entries without holding the log mutex.
+ */
+class zstd_codec {
+ public:
+   explicit zstd_codec(int level = 3);
+   ~zstd_codec();
+
+   void     set_dictionary(const std::vector<char>& dict);
+   uint32_t dictionary_id() const;
+
+   std::vector<char> compress(const std::vector<char>& data);
+   std::vector<char> decompress(const char* data, size_t size) const;
+
+   /// @returns the id of the dictionary the frame was compressed with, 0 if none
+   static uint32_t frame_dictionary_id(const char* data, size_t size);
+
+   /// trains a dictionary from samples concatenated in `samples`, @returns an empty vector on failure
+   static std::vector<char> train_dictionary(const std::vector<char>& samples, const std::vector<size_t>& sample_sizes,
+                                             size_t dict_capacity);
+
+ private:
+   struct dictionary;
+   struct impl;
+   std::unique_ptr<impl> my;
+   int                   level = 3;
+};
+
+template <typename STREAM, typename T>
+void zstd_pack(STREAM& strm, const T& obj, zstd_codec& codec) {
+   if (is_empty(obj)) {
+      fc::raw::pack(strm, uint32_t(0));
+   }
+   else {
+      auto compressed = codec.compress(fc::raw::pack(obj));
+      fc::raw::pack(strm, uint32_t(compressed.size()));
+      strm.write(compressed.data(), compressed.size());
+   }
+}
+
+template <typename STREAM>
+std::vector<char> zstd_decompress(STREAM& strm, zstd_codec& codec) {
+   uint32_t len;
+   fc::raw::unpack(strm, len);
+   if (len > 0) {
+      std::vector<char> compressed(len);
+      strm.read(compressed.data(), len);
+      return codec.decompress(compressed.data(), compressed.size());
+   }
+   return {};
+}
+
+template <typename STREAM, typename T>
+void zstd_unpack(STREAM& strm, T& obj, zstd_codec& codec) {
+   auto data = zstd_decompress(strm, codec);
+   if (data.size()) {
+      fc::datastream<const char*> ds(data.data(), data.size());
+      fc::raw::unpack(ds, obj);
+   }
+}
+
+// The functions below use zstd when a codec is given and zlib otherwise; the codec of an entry follows its version.
+
+template <typename STREAM, typename T>
+void pack_compressed(STREAM& strm, const T& obj, zstd_codec* zstd) {
+   if (zstd)
+      zstd_pack(strm, obj, *zstd);
+   else
+      zlib_pack(strm, obj);
+}
+
+template <typename STREAM, typename T>
+void unpack_compressed(STREAM& strm, T& obj, zstd_codec* zstd) {
+   if (zstd)
+      zstd_unpack(strm, obj, *zstd);
+   else
+      zlib_unpack(strm, obj);
+}
+
+template <typename STREAM>
+std::vector<char> decompress(STREAM& strm, zstd_codec* zstd) {
+   return zstd ? zstd_decompress(strm, *zstd) : zlib_decompress(strm);
+}
+
+/// reads the compressed bytes written by zlib_pack() or zstd_pack() without decompressing them
+template <typename STREAM>
+std::vector<char> read_compressed(STREAM& strm) {
+   uint32_t          len;
+   fc::raw::unpack(strm, len);
+   std::vector<char> result(len);
+   if (len > 0)
+      strm.read(result.data(), len);
+   return result;
+}
+
 } // namespace state_history
 } // namespace eosio
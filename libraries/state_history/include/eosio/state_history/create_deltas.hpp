@@ -3,10 +3,17 @@
 #include <eosio/state_history/types.hpp>
 #include <eosio/chain/combined_database.hpp>
 
+#include <boost/asio/io_context.hpp>
+
 namespace eosio {
 namespace state_history {
 
-std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot);
+/**
+ *  @param thread_pool when given, the chainbase tables are processed concurrently on it. The result is the same
+ *                     either way.
+ **/
+std::vector<table_delta> create_deltas(const chain::combined_database& db, bool full_snapshot,
+                                       boost::asio::io_context* thread_pool = nullptr);
 
 } // namespace state_history
 } // namespace eosio
@@ -2,6 +2,8 @@
 
 #include <boost/filesystem.hpp>
 #include <fstream>
+#include <future>
+#include <mutex>
 #include <stdint.h>
 
 #include <cstddef>
@@ -11,7 +13,9 @@
 #include <eosio/chain/log_catalog.hpp>
 #include <eosio/chain/log_data_base.hpp>
 #include <eosio/chain/log_index.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/chain/types.hpp>
+#include <eosio/state_history/compression.hpp>
 #include <eosio/state_history/transaction_trace_cache.hpp>
 #include <fc/bitutil.hpp>
 #include <fc/io/cfile.hpp>
@@ -36,6 +40,9 @@ namespace bfs = boost::filesystem;
  * each entry:
  *    state_history_log_header
  *    payload
+ *
+ * The header version describes the payload: version 0 is the original trace format, version 1 keeps the prunable
+ * data of traces separate and version 2 is version 1 with zstd instead of zlib compression.
  */
 
 inline uint64_t       ship_magic(uint32_t version) {
@@ -47,8 +54,9 @@ inline bool           is_ship(uint64_t magic) {
    return (magic & 0xffff'ffff'0000'0000) == "ship"_n.to_uint64_t();
 }
 inline uint32_t       get_ship_version(uint64_t magic) { return magic; }
-inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) <= 1; }
 static const uint32_t ship_current_version = 1;
+static const uint32_t ship_zstd_version    = 2;
+inline bool           is_ship_supported_version(uint64_t magic) { return get_ship_version(magic) <= ship_zstd_version; }
 
 struct state_history_log_header {
    uint64_t             magic        = ship_magic(ship_current_version);
@@ -107,14 +115,25 @@ class state_history_log_data : public chain::log_data_base<state_history_log_dat
    void     construct_index(const fc::path& index_file_name) const;
 };
 
+enum class state_history_compression { zlib, zstd };
+
 struct state_history_config {
-   bfs::path log_dir;
-   bfs::path retained_dir;
-   bfs::path archive_dir;
-   uint32_t  stride             = UINT32_MAX;
-   uint32_t  max_retained_files = 10;
+   bfs::path                 log_dir;
+   bfs::path                 retained_dir;
+   bfs::path                 archive_dir;
+   uint32_t                  stride             = UINT32_MAX;
+   uint32_t                  max_retained_files = 10;
+   state_history_compression compression        = state_history_compression::zlib;
+   int                       zstd_level         = 3;
+   uint32_t                  zstd_dict_training_blocks = 0; ///< 0 disables training a dictionary
+   uint16_t                  delta_threads      = 0; ///< threads creating chain state deltas, 0 creates them serially
 };
 
+/**
+ * Reads and writes of a state_history_log are serialized by an internal mutex, so that entries can be
+ * served to state history clients on other threads while the main thread appends new blocks. Readers only
+ * copy an entry under the mutex and decompress it after releasing it.
+ */
 class state_history_log {
  private:
    using cfile_stream        = fc::datastream<fc::cfile>;
@@ -125,14 +144,26 @@ class state_history_log {
    chain::block_id_type last_block_id;
    uint32_t             version = ship_current_version;
    uint32_t             stride;
+   bfs::path            dict_path;
+   uint32_t             dict_training_blocks = 0;
+   std::vector<char>    dict_samples;
+   std::vector<size_t>  dict_sample_sizes;
+   std::future<void>    dict_training;
 
  protected:
-   cfile_stream write_log;
-   cfile_stream read_log;
+   mutable std::mutex        mx;
+   cfile_stream              write_log;
+   cfile_stream              read_log;
+   uint32_t                  entry_version; ///< version of the entries written
+   state_history::zstd_codec zstd;
 
    using catalog_t = chain::log_catalog<state_history_log_data, chain::log_index<chain::state_history_exception>>;
    catalog_t catalog;
 
+ private:
+   // declared last so that a dictionary still being trained finishes before the members it uses are destroyed
+   std::optional<chain::named_thread_pool> dict_thread_pool;
+
  public:
    // The type aliases below help to make it obvious about the meanings of member function return values.
    using block_num_type     = uint32_t;
@@ -143,10 +174,13 @@ class state_history_log {
    state_history_log(const char* const name, const state_history_config& conf);
 
    block_num_type begin_block() const {
-      block_num_type result = catalog.first_block_num();
-      return result != 0 ? result : _begin_block;
+      std::lock_guard<std::mutex> lock(mx);
+      return begin_block_unlocked();
+   }
+   block_num_type end_block() const {
+      std::lock_guard<std::mutex> lock(mx);
+      return _end_block;
    }
-   block_num_type end_block() const { return _end_block; }
 
    template <typename F>
    void write_entry(state_history_log_header& header, const chain::block_id_type& prev_id, F write_payload) {
@@ -165,9 +199,33 @@ class state_history_log {
 
    std::optional<chain::block_id_type> get_block_id(block_num_type block_num);
 
+   /// blocks until a zstd dictionary being trained in the background is in use
+   void wait_for_dictionary();
+
  protected:
+   /// copies the payload of the entry of block_num while holding mx, @returns an empty payload if there is no entry
+   std::pair<std::vector<char>, version_type> read_payload(block_num_type block_num);
+
+   // the functions below require mx to be held by the caller
+   block_num_type begin_block_unlocked() const {
+      block_num_type result = catalog.first_block_num();
+      return result != 0 ? result : _begin_block;
+   }
+   bool has_block_unlocked(block_num_type block_num) const {
+      return block_num >= begin_block_unlocked() && block_num < _end_block;
+   }
    void get_entry_header(block_num_type block_num, state_history_log_header& header);
 
+   /// @returns the codec of the zstd compressed sections of entries of the given version, nullptr for zlib
+   state_history::zstd_codec* codec_for_version(version_type ver) { return ver >= ship_zstd_version ? &zstd : nullptr; }
+
+   bool training_dictionary() const { return dict_training_blocks && !zstd.dictionary_id(); }
+
+   /// collects the serialized deltas of a block and starts training a zstd dictionary in the background once there
+   /// are enough of them, the dictionary is used for the entries stored after it is ready. Called on the main thread
+   /// only, mx is not required.
+   void add_dictionary_sample(const std::vector<char>& sample);
+
  private:
    void               read_header(state_history_log_header& header, bool assert_version = true);
    void               write_header(const state_history_log_header& header);
@@ -178,6 +236,7 @@ class state_history_log {
    file_position_type get_pos(block_num_type block_num);
    void               truncate(block_num_type block_num);
    void               split_log();
+   void               load_dictionary();
 
    /**
     *  @returns the block num and the file position
@@ -203,6 +262,11 @@ class state_history_traces_log : public state_history_log {
 
    chain::bytes get_log_entry(block_num_type block_num);
 
+   /**
+    *  @returns the entry as stored when it is zlib compressed, otherwise the result of get_log_entry()
+    **/
+   state_history::log_entry get_stored_log_entry(block_num_type block_num);
+
    void block_start(uint32_t block_num) { cache.clear(); }
 
    void store(const chainbase::database& db, const chain::block_state_ptr& block_state);
@@ -219,7 +283,15 @@ class state_history_chain_state_log : public state_history_log {
 
    chain::bytes get_log_entry(block_num_type block_num);
 
+   /**
+    *  @returns the zlib compressed entry as stored, without decompressing it
+    **/
+   state_history::log_entry get_stored_log_entry(block_num_type block_num);
+
    void store(const chain::combined_database& db, const chain::block_state_ptr& block_state);
+
+ private:
+   std::optional<chain::named_thread_pool> delta_thread_pool;
 };
 
 } // namespace eosio
@@ -773,4 +773,38 @@ ST& operator<<(ST& ds, const eosio::state_history::get_blocks_result_v2& obj) {
    return ds;
 }
 
+// everything of get_blocks_result_v3 which precedes the traces
+template <typename ST>
+void pack_blocks_result_v3_header(ST& ds, const eosio::state_history::get_blocks_result_v3& obj) {
+   fc::raw::pack(ds, obj.head);
+   fc::raw::pack(ds, obj.last_irreversible);
+   fc::raw::pack(ds, obj.this_block);
+   fc::raw::pack(ds, obj.prev_block);
+   pack_for_blocks_result_v2(ds, obj.block);
+   fc::raw::pack(ds, obj.block_header);
+}
+
+// everything of a log_entry which precedes its data
+template <typename ST>
+void pack_log_entry_header(ST& ds, const eosio::state_history::log_entry& obj) {
+   fc::raw::pack(ds, obj.compression);
+   eosio::state_history::pack_varuint64(ds, obj.data.size());
+}
+
+template <typename ST>
+ST& operator<<(ST& ds, const eosio::state_history::log_entry& obj) {
+   pack_log_entry_header(ds, obj);
+   if (obj.data.size())
+      ds.write(obj.data.data(), obj.data.size());
+   return ds;
+}
+
+template <typename ST>
+ST& operator<<(ST& ds, const eosio::state_history::get_blocks_result_v3& obj) {
+   pack_blocks_result_v3_header(ds, obj);
+   ds << obj.traces;
+   ds << obj.deltas;
+   return ds;
+}
+
 } // namespace fc
@@ -181,14 +181,17 @@ struct trace_pruner {
 
 template <typename OSTREAM>
 void pack(OSTREAM&& strm, const chainbase::database& db, bool trace_debug_mode,
-          const std::vector<augmented_transaction_trace>& traces, compression_type compression) {
+          const std::vector<augmented_transaction_trace>& traces, compression_type compression,
+          zstd_codec* zstd = nullptr) {
 
    // In version 1 of SHiP traces log disk format, it log entry consists of 3 parts.
    //  1. a zlib compressed unprunable section contains the serialization of the vector of traces excluding
    //     the prunable_data data (i.e. signatures and context free data)
    //  2. an uint8_t tag indicating the compression mechanism for the context free data inside the prunable section.
    //  3. a prunable section contains the serialization of the vector of ondisk_prunable_data_t.
-   zlib_pack(strm, make_history_context_wrapper(db, trace_receipt_context{.debug_mode = trace_debug_mode}, traces));
+   // Version 2 is identical except that the unprunable section is zstd compressed.
+   pack_compressed(strm, make_history_context_wrapper(db, trace_receipt_context{.debug_mode = trace_debug_mode}, traces),
+                   zstd);
    fc::raw::pack(strm, static_cast<uint8_t>(compression));
    const auto pos               = strm.tellp();
    size_t     size_with_padding = 0;
@@ -199,8 +202,8 @@ void pack(OSTREAM&& strm, const chainbase::database& db, bool trace_debug_mode,
 }
 
 template <typename ISTREAM>
-void unpack(ISTREAM&& strm, std::vector<transaction_trace>& traces) {
-   zlib_unpack(strm, traces);
+void unpack(ISTREAM&& strm, std::vector<transaction_trace>& traces, zstd_codec* zstd = nullptr) {
+   unpack_compressed(strm, traces, zstd);
    uint8_t compression;
    fc::raw::unpack(strm, compression);
    for (auto& trace : traces) {
@@ -213,10 +216,11 @@ void unpack(ISTREAM&& strm, std::vector<transaction_trace>& traces) {
 }
 
 template <typename IOSTREAM>
-void prune_traces(IOSTREAM&& strm, uint32_t entry_len, std::vector<transaction_id_type>& ids) {
+void prune_traces(IOSTREAM&& strm, uint32_t entry_len, std::vector<transaction_id_type>& ids,
+                  zstd_codec* zstd = nullptr) {
    std::vector<transaction_trace> traces;
    size_t                         unprunable_section_pos = strm.tellp();
-   zlib_unpack(strm, traces);
+   unpack_compressed(strm, traces, zstd);
    size_t            prunable_section_pos = strm.tellp();
    std::vector<char> buffer(unprunable_section_pos + entry_len - prunable_section_pos);
    strm.read(buffer.data(), buffer.size());
@@ -117,6 +117,7 @@ struct get_status_result_v0 {
 
 struct get_blocks_result_v1;
 struct get_blocks_result_v2;
+struct get_blocks_result_v3;
 struct get_blocks_request_v0 {
    uint32_t                    start_block_num        = 0;
    uint32_t                    end_block_num          = 0;
@@ -139,6 +140,13 @@ struct get_blocks_request_v1 : get_blocks_request_v0 {
    using response_type = get_blocks_result_v2;
 };
 
+struct get_blocks_request_v2 : get_blocks_request_v1 {
+   // send traces and deltas as they are stored in the logs instead of decompressing them, see log_entry
+   bool fetch_compressed_entries = false;
+
+   using response_type = get_blocks_result_v3;
+};
+
 struct get_blocks_ack_request_v0 {
    uint32_t num_messages = 0;
 };
@@ -153,7 +161,7 @@ struct get_blocks_result_v0 {
    std::optional<bytes>          deltas;
 };
 
-using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1>;
+using state_request = std::variant<get_status_request_v0, get_blocks_request_v0, get_blocks_ack_request_v0, get_blocks_request_v1, get_blocks_request_v2>;
 
 struct account_auth_sequence {
    uint64_t account  = {};
@@ -304,8 +312,32 @@ struct get_blocks_result_v2 {
    }
 };
 
+/// compression of log_entry::data, extends compression_type
+enum class log_entry_compression : uint8_t { none = 0, zlib = 1, zstd = 2 };
+
+/// traces or deltas of a block; data is either the serialized vector or its compressed form as stored in the log
+struct log_entry {
+   uint8_t compression = static_cast<uint8_t>(log_entry_compression::none);
+   bytes   data;
+
+   bool has_value() const { return data.size(); }
+};
+
+struct get_blocks_result_v3 {
+   block_position                head;
+   block_position                last_irreversible;
+   std::optional<block_position> this_block;
+   std::optional<block_position> prev_block;
+   signed_block_ptr_variant           block; // packed as opaque<fc::variant<signed_block_v0, signed_block>>
+   opaque<chain::signed_block_header> block_header;
+   log_entry                          traces;
+   log_entry                          deltas;
+   bool has_value() const {
+      return std::visit([](auto b) -> bool { return b.get(); }, block) || traces.has_value() || deltas.has_value() || block_header.has_value();
+   }
+};
 
-using state_result = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_blocks_result_v2>;
+using state_result = std::variant<get_status_result_v0, get_blocks_result_v0, get_blocks_result_v1, get_blocks_result_v2, get_blocks_result_v3>;
 
 } // namespace state_history
 } // namespace eosio
@@ -317,6 +349,7 @@ FC_REFLECT_EMPTY(eosio::state_history::get_status_request_v0);
 FC_REFLECT(eosio::state_history::get_status_result_v0, (head)(last_irreversible)(trace_begin_block)(trace_end_block)(chain_state_begin_block)(chain_state_end_block)(chain_id));
 FC_REFLECT(eosio::state_history::get_blocks_request_v0, (start_block_num)(end_block_num)(max_messages_in_flight)(have_positions)(irreversible_only)(fetch_block)(fetch_traces)(fetch_deltas));
 FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v1, (eosio::state_history::get_blocks_request_v0), (fetch_block_header));
+FC_REFLECT_DERIVED(eosio::state_history::get_blocks_request_v2, (eosio::state_history::get_blocks_request_v1), (fetch_compressed_entries));
 FC_REFLECT(eosio::state_history::get_blocks_ack_request_v0, (num_messages));
 
 FC_REFLECT(eosio::state_history::account_auth_sequence, (account)(sequence));
@@ -37,12 +37,80 @@ void state_history_log_data::construct_index(const fc::path& index_file_name) co
 }
 
 state_history_log::state_history_log(const char* const name, const state_history_config& config)
-    : name(name) {
+    : name(name)
+    , entry_version(config.compression == state_history_compression::zstd ? ship_zstd_version : ship_current_version)
+    , zstd(config.zstd_level) {
    catalog.open(config.log_dir, config.retained_dir, config.archive_dir, name);
    catalog.max_retained_files = config.max_retained_files;
    this->stride               = config.stride;
    open_log(config.log_dir / (std::string(name) + ".log"));
    open_index(config.log_dir / (std::string(name) + ".index"));
+   dict_path            = config.log_dir / (std::string(name) + ".dict");
+   dict_training_blocks = config.zstd_dict_training_blocks;
+   load_dictionary();
+}
+
+void state_history_log::load_dictionary() {
+   if (!bfs::exists(dict_path))
+      return;
+   std::vector<char> dict(bfs::file_size(dict_path));
+   fc::cfile         file;
+   file.set_file_path(dict_path);
+   file.open("rb");
+   file.read(dict.data(), dict.size());
+   zstd.set_dictionary(dict);
+   ilog("loaded zstd dictionary ${id} for ${name}.log", ("id", zstd.dictionary_id())("name", name));
+}
+
+void state_history_log::add_dictionary_sample(const std::vector<char>& sample) {
+   // zstd recommends about 100 times the dictionary size of samples, more only slows down training
+   const size_t dict_capacity    = 110 * 1024;
+   const size_t max_samples_size = 100 * dict_capacity;
+   if (!training_dictionary())
+      return;
+
+   dict_samples.insert(dict_samples.end(), sample.begin(), sample.end());
+   dict_sample_sizes.push_back(sample.size());
+   if (dict_sample_sizes.size() < dict_training_blocks && dict_samples.size() < max_samples_size)
+      return;
+
+   // training takes seconds, the entries are compressed without a dictionary until it is ready
+   dict_training_blocks = 0;
+   dict_thread_pool.emplace("shipz", 1);
+   dict_training = chain::async_thread_pool(
+       dict_thread_pool->get_executor(),
+       [this, samples = std::move(dict_samples), sample_sizes = std::move(dict_sample_sizes), dict_capacity]() {
+          try {
+             auto dict = state_history::zstd_codec::train_dictionary(samples, sample_sizes, dict_capacity);
+             if (dict.empty()) {
+                wlog("unable to train a zstd dictionary for ${name}.log, continuing without one", ("name", name));
+                return;
+             }
+
+             // the dictionary has to be durable before any entry depends on it
+             auto      tmp_path = dict_path;
+             tmp_path += ".tmp";
+             fc::cfile file;
+             file.set_file_path(tmp_path);
+             file.open("wb");
+             file.write(dict.data(), dict.size());
+             file.flush();
+             file.close();
+             bfs::rename(tmp_path, dict_path);
+
+             std::lock_guard<std::mutex> lock(mx);
+             zstd.set_dictionary(dict);
+             ilog("trained zstd dictionary ${id} of ${size} bytes for ${name}.log",
+                  ("id", zstd.dictionary_id())("size", dict.size())("name", name));
+          } FC_LOG_AND_DROP();
+       });
+   dict_samples      = {};
+   dict_sample_sizes = {};
+}
+
+void state_history_log::wait_for_dictionary() {
+   if (dict_training.valid())
+      dict_training.get();
 }
 
 void state_history_log::read_header(state_history_log_header& header, bool assert_version) {
@@ -69,6 +137,7 @@ void state_history_log::get_entry_header(state_history_log::block_num_type block
 }
 
 std::optional<chain::block_id_type> state_history_log::get_block_id(state_history_log::block_num_type block_num) {
+   std::lock_guard<std::mutex> lock(mx);
    auto result = catalog.id_for_block(block_num);
    if (!result && block_num >= _begin_block && block_num < _end_block) {
       state_history_log_header header;
@@ -78,6 +147,25 @@ std::optional<chain::block_id_type> state_history_log::get_block_id(state_histor
    return result;
 }
 
+std::pair<std::vector<char>, state_history_log::version_type>
+state_history_log::read_payload(state_history_log::block_num_type block_num) {
+   std::lock_guard<std::mutex> lock(mx);
+   auto [ds, version] = catalog.ro_stream_for_block(block_num);
+   if (ds.remaining()) {
+      std::vector<char> payload(ds.remaining());
+      ds.read(payload.data(), payload.size());
+      return std::make_pair(std::move(payload), version);
+   }
+
+   if (!has_block_unlocked(block_num))
+      return {};
+   state_history_log_header header;
+   get_entry_header(block_num, header);
+   std::vector<char> payload(header.payload_size);
+   read_log.read(payload.data(), payload.size());
+   return std::make_pair(std::move(payload), get_ship_version(header.magic));
+}
+
 bool state_history_log::get_last_block(uint64_t size) {
    state_history_log_header header;
    uint64_t                 suffix;
@@ -291,81 +379,114 @@ void state_history_log::split_log() {
 state_history_traces_log::state_history_traces_log(const state_history_config& config)
     : state_history_log("trace_history", config) {}
 
-chain::bytes state_history_traces_log::get_log_entry(block_num_type block_num) {
-
-   auto get_traces_bin = [block_num](auto& ds, uint32_t version, std::size_t size) {
-      auto start_pos = ds.tellp();
-      try {
-         if (version == 0) {
-            return state_history::zlib_decompress(ds);
-         }
-         else {
-            std::vector<state_history::transaction_trace> traces;
-            state_history::trace_converter::unpack(ds, traces);
-            return fc::raw::pack(traces);
-         }
-      } catch (fc::exception& ex) {
-         std::vector<char> trace_data(size);
-         ds.seekp(start_pos);
-         ds.read(trace_data.data(), size);
-
-         fc::cfile output;
-         char      filename[PATH_MAX];
-         snprintf(filename, PATH_MAX, "invalid_trace_%u_v%u.bin", block_num, version);
-         output.set_file_path(filename);
-         output.open("w");
-         output.write(trace_data.data(), size);
-
-         ex.append_log(FC_LOG_MESSAGE(error,
-                                      "trace data for block ${block_num} has been written to ${filename} for debugging",
-                                      ("block_num", block_num)("filename", filename)));
-
-         throw ex;
+namespace {
+template <typename STREAM>
+chain::bytes get_traces_bin(STREAM& ds, uint32_t block_num, uint32_t version, std::size_t size,
+                            state_history::zstd_codec* zstd) {
+   auto start_pos = ds.tellp();
+   try {
+      if (version == 0) {
+         return state_history::zlib_decompress(ds);
+      }
+      else {
+         std::vector<state_history::transaction_trace> traces;
+         state_history::trace_converter::unpack(ds, traces, zstd);
+         return fc::raw::pack(traces);
       }
-   };
+   } catch (fc::exception& ex) {
+      std::vector<char> trace_data(size);
+      ds.seekp(start_pos);
+      ds.read(trace_data.data(), size);
+
+      fc::cfile output;
+      char      filename[PATH_MAX];
+      snprintf(filename, PATH_MAX, "invalid_trace_%u_v%u.bin", block_num, version);
+      output.set_file_path(filename);
+      output.open("w");
+      output.write(trace_data.data(), size);
+
+      ex.append_log(FC_LOG_MESSAGE(error,
+                                   "trace data for block ${block_num} has been written to ${filename} for debugging",
+                                   ("block_num", block_num)("filename", filename)));
+
+      throw ex;
+   }
+}
 
-   auto [ds, version] = catalog.ro_stream_for_block(block_num);
-   if (ds.remaining()) {
-      return get_traces_bin(ds, version, ds.remaining());
+template <typename STREAM>
+state_history::log_entry read_stored_log_entry(STREAM& ds, state_history::zstd_codec* zstd) {
+   using state_history::log_entry_compression;
+   state_history::log_entry result;
+   result.data = state_history::read_compressed(ds);
+   if (result.data.empty())
+      return result;
+   if (!zstd) {
+      result.compression = static_cast<uint8_t>(log_entry_compression::zlib);
+   } else if (state_history::zstd_codec::frame_dictionary_id(result.data.data(), result.data.size()) == 0) {
+      result.compression = static_cast<uint8_t>(log_entry_compression::zstd);
+   } else {
+      // clients do not have the dictionary
+      result.data = zstd->decompress(result.data.data(), result.data.size());
    }
+   return result;
+}
+} // namespace
 
-   if (block_num < begin_block() || block_num >= end_block())
+chain::bytes state_history_traces_log::get_log_entry(block_num_type block_num) {
+   auto [payload, version] = read_payload(block_num);
+   if (payload.empty())
       return {};
-   state_history_log_header header;
-   get_entry_header(block_num, header);
-   return get_traces_bin(read_log, get_ship_version(header.magic), header.payload_size);
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   return get_traces_bin(ds, block_num, version, payload.size(), codec_for_version(version));
 }
 
+state_history::log_entry state_history_traces_log::get_stored_log_entry(block_num_type block_num) {
+   auto [payload, version] = read_payload(block_num);
+   if (payload.empty())
+      return {};
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   if (version == 0)
+      return read_stored_log_entry(ds, nullptr);
+
+   // version 1 entries keep the prunable data outside of the compressed section, so they are always converted
+   state_history::log_entry result;
+   result.data = get_traces_bin(ds, block_num, version, payload.size(), codec_for_version(version));
+   return result;
+}
 
 void state_history_traces_log::prune_transactions(state_history_log::block_num_type        block_num,
                                                   std::vector<chain::transaction_id_type>& ids) {
+   std::lock_guard<std::mutex> lock(mx);
    auto [ds, version] = catalog.rw_stream_for_block(block_num);
 
    if (ds.remaining()) {
       EOS_ASSERT(version > 0, chain::state_history_exception,
               "The trace log version 0 does not support transaction pruning.");
-      state_history::trace_converter::prune_traces(ds, ds.remaining(), ids);
+      state_history::trace_converter::prune_traces(ds, ds.remaining(), ids, codec_for_version(version));
       return;
    }
 
-   if (block_num < begin_block() || block_num >= end_block())
+   if (!has_block_unlocked(block_num))
       return;
    state_history_log_header header;
    get_entry_header(block_num, header);
-   EOS_ASSERT(get_ship_version(header.magic) > 0, chain::state_history_exception,
+   auto ver = get_ship_version(header.magic);
+   EOS_ASSERT(ver > 0, chain::state_history_exception,
               "The trace log version 0 does not support transaction pruning.");
    write_log.seek(read_log.tellp());
-   state_history::trace_converter::prune_traces(write_log, header.payload_size, ids);
+   state_history::trace_converter::prune_traces(write_log, header.payload_size, ids, codec_for_version(ver));
    write_log.flush();
 }
 
 void state_history_traces_log::store(const chainbase::database& db, const chain::block_state_ptr& block_state) {
 
-   state_history_log_header header{.magic = ship_magic(ship_current_version), .block_id = block_state->id};
+   state_history_log_header header{.magic = ship_magic(entry_version), .block_id = block_state->id};
    auto                     trace = cache.prepare_traces(block_state);
 
+   std::lock_guard<std::mutex> lock(mx);
    this->write_entry(header, block_state->block->previous, [&](auto& stream) {
-      state_history::trace_converter::pack(stream, db, trace_debug_mode, trace, compression);
+      state_history::trace_converter::pack(stream, db, trace_debug_mode, trace, compression,
+                                           codec_for_version(entry_version));
    });
 }
 
@@ -375,20 +496,25 @@ bool state_history_traces_log::exists(bfs::path state_history_dir) {
 }
 
 state_history_chain_state_log::state_history_chain_state_log(const state_history_config& config)
-    : state_history_log("chain_state_history", config) {}
+    : state_history_log("chain_state_history", config) {
+   if (config.delta_threads > 0)
+      delta_thread_pool.emplace("shipd", config.delta_threads);
+}
 
 chain::bytes state_history_chain_state_log::get_log_entry(block_num_type block_num) {
+   auto [payload, version] = read_payload(block_num);
+   if (payload.empty())
+      return {};
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   return state_history::decompress(ds, codec_for_version(version));
+}
 
-   auto [ds, _] = catalog.ro_stream_for_block(block_num);
-   if (ds.remaining()) {
-      return state_history::zlib_decompress(ds);
-   }
-
-   if (block_num < begin_block() || block_num >= end_block())
+state_history::log_entry state_history_chain_state_log::get_stored_log_entry(block_num_type block_num) {
+   auto [payload, version] = read_payload(block_num);
+   if (payload.empty())
       return {};
-   state_history_log_header header;
-   get_entry_header(block_num, header);
-   return state_history::zlib_decompress(read_log);
+   fc::datastream<const char*> ds(payload.data(), payload.size());
+   return read_stored_log_entry(ds, codec_for_version(version));
 }
 
 void state_history_chain_state_log::store(const chain::combined_database& db,
@@ -398,10 +524,17 @@ void state_history_chain_state_log::store(const chain::combined_database& db,
       ilog("Placing initial state in block ${n}", ("n", block_state->block->block_num()));
 
    using namespace state_history;
-   std::vector<table_delta> deltas = create_deltas(db, fresh);
-   state_history_log_header header{.magic = ship_magic(ship_current_version), .block_id = block_state->id};
+   std::vector<table_delta> deltas =
+       create_deltas(db, fresh, delta_thread_pool ? &delta_thread_pool->get_executor() : nullptr);
+   state_history_log_header header{.magic = ship_magic(entry_version), .block_id = block_state->id};
+
+   auto zstd = codec_for_version(entry_version);
+   if (zstd && !fresh && training_dictionary())
+      add_dictionary_sample(fc::raw::pack(deltas));
 
-   this->write_entry(header, block_state->block->previous, [&deltas](auto& stream) { zlib_pack(stream, deltas); });
+   std::lock_guard<std::mutex> lock(mx);
+   this->write_entry(header, block_state->block->previous,
+                     [&deltas, zstd](auto& stream) { pack_compressed(stream, deltas, zstd); });
 }
 
 } // namespace eosio
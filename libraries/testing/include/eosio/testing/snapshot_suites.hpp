@@ -106,5 +106,134 @@ struct buffered_snapshot_suite {
    }
 };
 
-using snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite>;
+struct parallel_snapshot_suite {
+   using writer_t = parallel_ostream_snapshot_writer;
+   using reader_t = parallel_istream_snapshot_reader;
+   using write_storage_t = std::ostringstream;
+   using snapshot_t = std::string;
+
+   static constexpr uint32_t threads = 4;
+
+   struct writer : public writer_t {
+      writer( const std::shared_ptr<write_storage_t>& storage, const std::shared_ptr<fc::temp_directory>& chunk_dir )
+      :writer_t(*storage, chunk_dir->path() / "chunks", threads)
+      ,storage(storage)
+      ,chunk_dir(chunk_dir)
+      {
+
+      }
+
+      std::shared_ptr<write_storage_t> storage;
+      std::shared_ptr<fc::temp_directory> chunk_dir;
+   };
+
+   struct reader : public reader_t {
+      explicit reader(const std::shared_ptr<fc::temp_directory>& dir)
+      :reader_t(dir->path() / "snapshot.bin", threads)
+      ,dir(dir)
+      {}
+
+      std::shared_ptr<fc::temp_directory> dir;
+   };
+
+
+   static auto get_writer() {
+      return std::make_shared<writer>(std::make_shared<write_storage_t>(), std::make_shared<fc::temp_directory>());
+   }
+
+   static auto finalize(const std::shared_ptr<writer>& w) {
+      w->finalize();
+      return w->storage->str();
+   }
+
+   static auto get_reader( const snapshot_t& buffer) {
+      auto dir = std::make_shared<fc::temp_directory>();
+      std::ofstream out((dir->path() / "snapshot.bin").generic_string(), (std::ios::out | std::ios::binary));
+      out.write(buffer.data(), buffer.size());
+      out.close();
+      return std::make_shared<reader>(dir);
+   }
+
+   static snapshot_t load_from_file(const std::string& filename) {
+      snapshot_input_file<snapshot::binary> file(filename);
+      return file.read_as_string();
+   }
+
+   static void write_to_file( const std::string& basename, const snapshot_t& snapshot ) {
+      snapshot_output_file<snapshot::binary> file(basename);
+      file.write<snapshot_t>(snapshot);
+   }
+};
+
+struct zstd_snapshot_suite {
+   using writer_t = zstd_ostream_snapshot_writer;
+   using reader_t = zstd_istream_snapshot_reader;
+   using write_storage_t = std::ostringstream;
+   using snapshot_t = std::string;
+
+   // reads the snapshot the way a pipe is read, without seeking
+   struct pipe_buffer : public std::streambuf {
+      explicit pipe_buffer(const snapshot_t& buffer)
+      :data(buffer)
+      {
+         setg(data.data(), data.data(), data.data() + data.size());
+      }
+
+      snapshot_t data;
+   };
+
+   struct read_storage_t {
+      explicit read_storage_t(const snapshot_t& buffer)
+      :buf(buffer)
+      ,stream(&buf)
+      {}
+
+      pipe_buffer  buf;
+      std::istream stream;
+   };
+
+   struct writer : public writer_t {
+      writer( const std::shared_ptr<write_storage_t>& storage )
+      :writer_t(*storage)
+      ,storage(storage)
+      {
+
+      }
+
+      std::shared_ptr<write_storage_t> storage;
+   };
+
+   struct storage_holder {
+      std::shared_ptr<read_storage_t> storage;
+   };
+
+   // the storage is held by a base so that it outlives the thread of the reader reading it
+   struct reader : private storage_holder, public reader_t {
+      reader(const std::shared_ptr<read_storage_t>& storage, bool two_pass)
+      :storage_holder{storage}
+      ,reader_t(storage->stream, two_pass)
+      {}
+   };
+
+
+   static auto get_writer() {
+      return std::make_shared<writer>(std::make_shared<write_storage_t>());
+   }
+
+   static auto finalize(const std::shared_ptr<writer>& w) {
+      w->finalize();
+      return w->storage->str();
+   }
+
+   // the testers return to the header after reading the chain id
+   static auto get_reader( const snapshot_t& buffer, bool two_pass = true) {
+      return std::make_shared<reader>(std::make_shared<read_storage_t>(buffer), two_pass);
+   }
+};
+
+using snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite, parallel_snapshot_suite,
+                                         zstd_snapshot_suite>;
+
+// the suites reading the snapshots stored with the tests
+using stored_snapshot_suites = boost::mpl::list<variant_snapshot_suite, buffered_snapshot_suite, parallel_snapshot_suite>;
 
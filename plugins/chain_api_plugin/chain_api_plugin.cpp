@@ -124,6 +124,7 @@ void chain_api_plugin::plugin_startup() {
       CHAIN_RO_CALL(get_currency_stats, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_producers, 200, http_params_types::params_required),
       CHAIN_RO_CALL(get_producer_schedule, 200, http_params_types::no_params_required),
+      CHAIN_RO_CALL(get_persistent_storage_stats, 200, http_params_types::no_params_required),
       CHAIN_RO_CALL(get_scheduled_transactions, 200, http_params_types::params_required),
       CHAIN_RO_CALL(abi_json_to_bin, 200, http_params_types::params_required),
       CHAIN_RO_CALL(abi_bin_to_json, 200, http_params_types::params_required),
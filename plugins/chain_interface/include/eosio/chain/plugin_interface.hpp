@@ -5,6 +5,7 @@
 
 #include <eosio/chain/block.hpp>
 #include <eosio/chain/block_state.hpp>
+#include <eosio/chain/controller.hpp>
 #include <eosio/chain/transaction_metadata.hpp>
 #include <eosio/chain/trace.hpp>
 
@@ -43,8 +44,9 @@ namespace eosio { namespace chain { namespace plugin_interface {
       }
 
       namespace methods {
-         // synchronously push a block/trx to a single provider
-         using block_sync            = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, const std::optional<block_id_type>&), first_provider_policy>;
+         // synchronously push a block/trx to a single provider, the trx_meta_cache_lookup may provide transaction
+         // metadata of the block with already recovered keys
+         using block_sync            = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, const std::optional<block_id_type>&, const trx_meta_cache_lookup&), first_provider_policy>;
          using blockvault_sync       = method_decl<chain_plugin_interface, bool(const signed_block_ptr&, bool), first_provider_policy>;
          using transaction_async     = method_decl<chain_plugin_interface, void(const packed_transaction_ptr&, bool, next_function<transaction_trace_ptr>), first_provider_policy>;
       }
@@ -196,6 +196,10 @@ public:
    std::optional<vm_type>            wasm_runtime;
    fc::microseconds                  abi_serializer_max_time_us;
    std::optional<bfs::path>          snapshot_path;
+   uint16_t                          snapshot_read_threads = config::default_snapshot_thread_pool_size;
+   // compressed snapshots are read once from the start, the stream is kept open from plugin_initialize to startup
+   std::optional<std::ifstream>      snapshot_stream;
+   std::shared_ptr<zstd_istream_snapshot_reader> zstd_snapshot_reader;
 
 
    // retained references to channels for easy publication
@@ -325,6 +329,18 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Rocksdb write rate of flushes and compactions.")
          ("persistent-storage-mbytes-snapshot-batch", bpo::value<uint32_t>()->default_value(config::default_persistent_storage_mbytes_batch),
           "Rocksdb batch size threshold before writing read in snapshot data to database.")
+         ("persistent-storage-async-commit", bpo::value<bool>()->default_value(true),
+          "Write irreversible state changes into rocksdb on a background thread, grouping the changes of several blocks into one write.")
+         ("persistent-storage-block-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_persistent_storage_block_cache_size / (1024  * 1024)),
+          "Size of the rocksdb block cache shared by data, index and filter blocks (in MiB)")
+         ("persistent-storage-block-cache-type", bpo::value<string>()->default_value("lru"),
+          "Replacement policy of the rocksdb block cache, \"lru\" or \"clock\"")
+         ("persistent-storage-row-cache-size-mb", bpo::value<uint64_t>()->default_value(config::default_persistent_storage_row_cache_size / (1024  * 1024)),
+          "Size of the rocksdb cache of key/value pairs read by point lookups (in MiB), 0 disables it")
+         ("persistent-storage-partitioned-index", bpo::value<bool>()->default_value(true),
+          "Partition the rocksdb index and filter blocks so that only the partitions a read needs are loaded into the block cache")
+         ("persistent-storage-prefix-bloom", bpo::value<bool>()->default_value(false),
+          "Add the contract, scope and table prefix of keys to the rocksdb bloom filters")
 
          ("reversible-blocks-db-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_cache_size / (1024  * 1024)), "Maximum size (in MiB) of the reversible blocks database")
          ("reversible-blocks-db-guard-size-mb", bpo::value<uint64_t>()->default_value(config::default_reversible_guard_size / (1024  * 1024)), "Safely shut down node when free space remaining in the reverseible blocks database drops below this size (in MiB).")
@@ -332,6 +348,8 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "Percentage of actual signature recovery cpu to bill. Whole number percentages, e.g. 50 for 50%")
          ("chain-threads", bpo::value<uint16_t>()->default_value(config::default_controller_thread_pool_size),
           "Number of worker threads in controller thread pool")
+         ("snapshot-read-threads", bpo::value<uint16_t>()->default_value(config::default_snapshot_thread_pool_size),
+          "Number of threads loading the sections of a snapshot concurrently")
          ("contracts-console", bpo::bool_switch()->default_value(false),
           "print contract's output to console")
          ("deep-mind", bpo::bool_switch()->default_value(false),
@@ -441,7 +459,7 @@ void chain_plugin::set_program_options(options_description& cli, options_descrip
           "replace reversible block database with blocks imported from specified file and then exit")
          ("export-reversible-blocks", bpo::value<bfs::path>(),
            "export reversible block database in portable format into specified file and then exit")
-         ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from")
+         ("snapshot", bpo::value<bfs::path>(), "File to read Snapshot State from, compressed snapshots can also be read from a pipe")
          ;
 
 }
@@ -485,6 +503,17 @@ void clear_directory_contents( const fc::path& p ) {
    }
 }
 
+// snapshots that are not regular files, such as pipes, can only be compressed snapshots
+bool is_zstd_snapshot( const fc::path& p ) {
+   if( !fc::is_regular_file( p ) )
+      return true;
+
+   std::ifstream infile( p.generic_string(), (std::ios::in | std::ios::binary) );
+   uint32_t magic = 0;
+   infile.read( reinterpret_cast<char*>(&magic), sizeof(magic) );
+   return infile && magic == zstd_ostream_snapshot_writer::magic_number;
+}
+
 std::optional<builtin_protocol_feature> read_builtin_protocol_feature( const fc::path& p  ) {
    try {
       return fc::json::from_file<builtin_protocol_feature>( p );
@@ -865,6 +894,21 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
       EOS_ASSERT( my->chain_config->persistent_storage_mbytes_batch > 0, plugin_config_exception,
                   "persistent-storage-mbytes-snapshot-batch ${num} must be greater than 0", ("num", my->chain_config->persistent_storage_mbytes_batch) );
 
+      my->chain_config->persistent_storage_async_commit = options.at( "persistent-storage-async-commit" ).as<bool>();
+
+      my->chain_config->persistent_storage_block_cache_size = options.at( "persistent-storage-block-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+      EOS_ASSERT( my->chain_config->persistent_storage_block_cache_size > 0, plugin_config_exception,
+                  "persistent-storage-block-cache-size-mb must be greater than 0" );
+
+      const auto block_cache_type = options.at( "persistent-storage-block-cache-type" ).as<string>();
+      EOS_ASSERT( block_cache_type == "lru" || block_cache_type == "clock", plugin_config_exception,
+                  "persistent-storage-block-cache-type ${t} must be \"lru\" or \"clock\"", ("t", block_cache_type) );
+      my->chain_config->persistent_storage_clock_cache = block_cache_type == "clock";
+
+      my->chain_config->persistent_storage_row_cache_size = options.at( "persistent-storage-row-cache-size-mb" ).as<uint64_t>() * 1024 * 1024;
+      my->chain_config->persistent_storage_partitioned_index = options.at( "persistent-storage-partitioned-index" ).as<bool>();
+      my->chain_config->persistent_storage_prefix_bloom = options.at( "persistent-storage-prefix-bloom" ).as<bool>();
+
       if( options.count( "reversible-blocks-db-size-mb" ))
          my->chain_config->reversible_cache_size =
                options.at( "reversible-blocks-db-size-mb" ).as<uint64_t>() * 1024 * 1024;
@@ -881,6 +925,10 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
                      "chain-threads ${num} must be greater than 0", ("num", my->chain_config->thread_pool_size) );
       }
 
+      my->snapshot_read_threads = options.at( "snapshot-read-threads" ).as<uint16_t>();
+      EOS_ASSERT( my->snapshot_read_threads > 0, plugin_config_exception,
+                  "snapshot-read-threads ${num} must be greater than 0", ("num", my->snapshot_read_threads) );
+
       my->chain_config->sig_cpu_bill_pct = options.at("signature-cpu-billable-pct").as<uint32_t>();
       EOS_ASSERT( my->chain_config->sig_cpu_bill_pct >= 0 && my->chain_config->sig_cpu_bill_pct <= 100, plugin_config_exception,
                   "signature-cpu-billable-pct must be 0 - 100, ${pct}", ("pct", my->chain_config->sig_cpu_bill_pct) );
@@ -1011,11 +1059,22 @@ void chain_plugin::plugin_initialize(const variables_map& options) {
 
          // recover genesis information from the snapshot
          // used for validation code below
-         auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         istream_snapshot_reader reader(infile);
-         reader.validate();
-         chain_id = controller::extract_chain_id(reader);
-         infile.close();
+         if( is_zstd_snapshot( *my->snapshot_path ) ) {
+            my->snapshot_stream.emplace( my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary) );
+            EOS_ASSERT( my->snapshot_stream->is_open(), plugin_config_exception,
+                        "Cannot open snapshot ${name}", ("name", my->snapshot_path->generic_string()) );
+            // read twice, for the chain id here and for the state on startup
+            my->zstd_snapshot_reader = std::make_shared<zstd_istream_snapshot_reader>(*my->snapshot_stream, true);
+            my->zstd_snapshot_reader->validate();
+            chain_id = controller::extract_chain_id(*my->zstd_snapshot_reader);
+            my->zstd_snapshot_reader->return_to_header();
+         } else {
+            auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
+            istream_snapshot_reader reader(infile);
+            reader.validate();
+            chain_id = controller::extract_chain_id(reader);
+            infile.close();
+         }
 
          EOS_ASSERT( options.count( "genesis-timestamp" ) == 0,
                  plugin_config_exception,
@@ -1336,11 +1395,13 @@ void chain_plugin::plugin_startup()
       if (nullptr != blockvault_instance) {
           eosio::blockvault::blockvault_sync_strategy<chain_plugin_impl> bss(blockvault_instance, *my, shutdown, check_shutdown);
           bss.do_sync();
+      } else if (my->zstd_snapshot_reader) {
+         my->chain->startup(shutdown, check_shutdown, my->zstd_snapshot_reader);
+         my->zstd_snapshot_reader.reset();
+         my->snapshot_stream.reset();
       } else if (my->snapshot_path) {
-         auto infile = std::ifstream(my->snapshot_path->generic_string(), (std::ios::in | std::ios::binary));
-         auto reader = std::make_shared<istream_snapshot_reader>(infile);
+         auto reader = std::make_shared<parallel_istream_snapshot_reader>(*my->snapshot_path, my->snapshot_read_threads);
          my->chain->startup(shutdown, check_shutdown, reader);
-         infile.close();
       } else {
          my->do_non_snapshot_startup(shutdown, check_shutdown);
       }
@@ -1411,8 +1472,8 @@ chain_apis::read_only chain_plugin::get_read_only_api() const {
 }
 
   
-bool chain_plugin::accept_block(const signed_block_ptr& block, const block_id_type& id ) {
-   return my->incoming_block_sync_method(block, id);
+bool chain_plugin::accept_block(const signed_block_ptr& block, const block_id_type& id, const trx_meta_cache_lookup& trx_lookup ) {
+   return my->incoming_block_sync_method(block, id, trx_lookup);
 }
 
 void chain_plugin::accept_transaction(const chain::packed_transaction_ptr& trx, next_function<chain::transaction_trace_ptr> next) {
@@ -2805,6 +2866,10 @@ read_only::get_producer_schedule_result read_only::get_producer_schedule( const
    return result;
 }
 
+read_only::get_persistent_storage_stats_results read_only::get_persistent_storage_stats( const read_only::get_persistent_storage_stats_params& ) const {
+   return db.kv_db().get_persistent_storage_stats();
+}
+
 template<typename Api>
 struct resolver_factory {
    static auto make(const Api* api, abi_serializer::yield_function_t yield) {
@@ -2992,7 +3057,7 @@ fc::variant read_only::get_block_header_state(const get_block_header_state_param
 
 void read_write::push_block(read_write::push_block_params&& params, next_function<read_write::push_block_results> next) {
    try {
-      app().get_method<incoming::methods::block_sync>()(std::make_shared<signed_block>( std::move( params ), true), {});
+      app().get_method<incoming::methods::block_sync>()(std::make_shared<signed_block>( std::move( params ), true), {}, {});
       next(read_write::push_block_results{});
    } catch ( boost::interprocess::bad_alloc& ) {
       chain_plugin::handle_db_exhaustion();
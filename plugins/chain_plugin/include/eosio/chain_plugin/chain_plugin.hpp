@@ -441,6 +441,11 @@ public:
 
    get_producer_schedule_result get_producer_schedule( const get_producer_schedule_params& params )const;
 
+   using get_persistent_storage_stats_params = empty;
+   using get_persistent_storage_stats_results = chain::persistent_storage_stats;
+
+   get_persistent_storage_stats_results get_persistent_storage_stats( const get_persistent_storage_stats_params& params )const;
+
    struct get_scheduled_transactions_params {
       bool        json = false;
       string      lower_bound;  /// timestamp OR transaction ID
@@ -1032,7 +1037,8 @@ public:
    chain_apis::read_write get_read_write_api() { return chain_apis::read_write(chain(), get_abi_serializer_max_time(), api_accept_transactions()); }
    chain_apis::read_only get_read_only_api() const;
    
-   bool accept_block( const chain::signed_block_ptr& block, const chain::block_id_type& id );
+   bool accept_block( const chain::signed_block_ptr& block, const chain::block_id_type& id,
+                      const chain::trx_meta_cache_lookup& trx_lookup = {} );
    void accept_transaction(const chain::packed_transaction_ptr& trx, chain::plugin_interface::next_function<chain::transaction_trace_ptr> next);
 
    static bool recover_reversible_blocks( const fc::path& db_dir,
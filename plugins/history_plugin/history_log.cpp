@@ -0,0 +1,348 @@
+#include <eosio/history_plugin/history_log.hpp>
+#include <eosio/chain/exceptions.hpp>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+
+namespace eosio {
+   namespace bfs = boost::filesystem;
+   using namespace chain;
+
+   namespace {
+      // returns the number of bytes appended
+      template<typename T>
+      uint64_t append_entry(const T& entry, fc::cfile& file) {
+         const auto data = fc::raw::pack(entry);
+         file.write(data.data(), data.size());
+         return data.size();
+      }
+
+      // the packed size of a trx_index_entry
+      constexpr uint64_t trx_entry_size = sizeof(transaction_id_type) + sizeof(uint64_t);
+
+      template<typename T>
+      T extract_entry(fc::cfile& file) {
+         T entry;
+         auto ds = file.create_datastream();
+         fc::raw::unpack(ds, entry);
+         return entry;
+      }
+
+      // a resized file is rewritten through another handle, the reader must not keep its stale read buffer
+      void reopen_reader(fc::cfile& reader) {
+         reader.close();
+         reader.open("rb");
+      }
+   }
+
+   history_log::history_log(const bfs::path& dir)
+   : _action_log_path(dir / "actions.log")
+   , _index_log_path(dir / "index.log") {
+      if (!bfs::exists(dir))
+         bfs::create_directories(dir);
+
+      _action_log.set_file_path(_action_log_path);
+      _action_log.open(fc::cfile::create_or_update_rw_mode);
+      _index_log.set_file_path(_index_log_path);
+      _index_log.open(fc::cfile::create_or_update_rw_mode);
+      _action_reader.set_file_path(_action_log_path);
+      _action_reader.open("rb");
+      _index_reader.set_file_path(_index_log_path);
+      _index_reader.open("rb");
+
+      load_index();
+      load_actions();
+   }
+
+   void history_log::load_index() {
+      const uint64_t size = bfs::file_size(_index_log_path);
+      std::map<account_name, std::vector<index_block_ref>> blocks;
+      std::vector<trx_block_ref> trx_blocks;
+      _index_reader.seek(0);
+      try {
+         while (_index_reader.tellp() < size) {
+            const auto entry = extract_entry<history_index_entry>(_index_reader);
+            const uint64_t end = _index_reader.tellp();
+            if (std::holds_alternative<account_index_block>(entry)) {
+               const auto& block = std::get<account_index_block>(entry);
+               const uint32_t count = block.action_offsets.size();
+               // the offsets are the last field, read in place by for_each_account_action
+               blocks[block.account].push_back({ block.first_account_sequence_num, count, end - sizeof(uint64_t) * count });
+            } else if (std::holds_alternative<trx_index_block>(entry)) {
+               const uint32_t count = std::get<trx_index_block>(entry).entries.size();
+               // the entries are the last field, read in place by lower_bound_trx
+               trx_blocks.push_back({ count, end - trx_entry_size * count });
+            } else {
+               for (auto& b : blocks) {
+                  auto& account_blocks = _account_blocks[b.first];
+                  account_blocks.insert(account_blocks.end(), b.second.begin(), b.second.end());
+               }
+               _trx_blocks.insert(_trx_blocks.end(), trx_blocks.begin(), trx_blocks.end());
+               blocks.clear();
+               trx_blocks.clear();
+               _checkpoint = std::get<index_checkpoint>(entry);
+               _index_log_size = end;
+            }
+         }
+      } catch (const fc::exception& e) {
+         wlog("Incomplete record in ${p}: ${e}", ("p", _index_log_path.generic_string())("e", e.to_detail_string()));
+      } catch (const std::exception& e) {
+         // cfile reports a record cut short by the end of the file as std::ios_base::failure
+         wlog("Incomplete record in ${p}: ${e}", ("p", _index_log_path.generic_string())("e", e.what()));
+      }
+
+      if (_index_log_size < size) {
+         ilog("Discarding ${n} bytes of ${p} written after its last checkpoint",
+              ("n", size - _index_log_size)("p", _index_log_path.generic_string()));
+         bfs::resize_file(_index_log_path, _index_log_size);
+         reopen_reader(_index_reader);
+      }
+   }
+
+   void history_log::load_actions() {
+      const uint64_t size = bfs::file_size(_action_log_path);
+      EOS_ASSERT(size >= _checkpoint.action_log_size, plugin_exception,
+                 "${p} is shorter than indexed by ${i}, remove the history directory to rebuild the history",
+                 ("p", _action_log_path.generic_string())("i", _index_log_path.generic_string()));
+
+      uint64_t offset = _checkpoint.action_log_size;
+      _action_reader.seek(offset);
+      try {
+         while (offset < size) {
+            const auto action = extract_entry<action_history_entry>(_action_reader);
+            const uint64_t end = _action_reader.tellp();
+            if (end > size)
+               break;
+            _block_offsets.emplace(action.block_num, offset);
+            index_action(offset, action);
+            offset = end;
+         }
+      } catch (const fc::exception& e) {
+         wlog("Incomplete record in ${p}: ${e}", ("p", _action_log_path.generic_string())("e", e.to_detail_string()));
+      } catch (const std::exception& e) {
+         wlog("Incomplete record in ${p}: ${e}", ("p", _action_log_path.generic_string())("e", e.what()));
+      }
+
+      if (offset < size) {
+         wlog("Truncating ${n} bytes of incomplete records at the end of ${p}",
+              ("n", size - offset)("p", _action_log_path.generic_string()));
+         bfs::resize_file(_action_log_path, offset);
+         reopen_reader(_action_reader);
+      }
+      _action_log_size = offset;
+   }
+
+   void history_log::index_action(uint64_t offset, const action_history_entry& action) {
+      for (const auto& account : action.accounts) {
+         _pending_account_actions[account].push_back(offset);
+      }
+      // the actions of a transaction are recorded consecutively, only its first action is indexed
+      _pending_trxs.emplace(action.trx_id, offset);
+   }
+
+   void history_log::truncate_actions(uint64_t size) {
+      _action_log.flush();
+      bfs::resize_file(_action_log_path, size);
+      reopen_reader(_action_reader);
+      _action_log_size = size;
+
+      for (auto itr = _pending_account_actions.begin(); itr != _pending_account_actions.end();) {
+         auto& offsets = itr->second;
+         while (!offsets.empty() && offsets.back() >= size) {
+            offsets.pop_back();
+         }
+         itr = offsets.empty() ? _pending_account_actions.erase(itr) : std::next(itr);
+      }
+      for (auto itr = _pending_trxs.begin(); itr != _pending_trxs.end();) {
+         itr = itr->second >= size ? _pending_trxs.erase(itr) : std::next(itr);
+      }
+   }
+
+   void history_log::append_block(uint32_t block_num, const std::vector<action_history_entry>& actions, uint32_t lib) {
+      // a replay or a restart from an earlier snapshot applies blocks which are already recorded
+      if (block_num <= _checkpoint.lib)
+         return;
+
+      // a fork switch replaces the blocks from this one on
+      auto replaced = _block_offsets.lower_bound(block_num);
+      if (replaced != _block_offsets.end()) {
+         truncate_actions(replaced->second);
+         _block_offsets.erase(replaced, _block_offsets.end());
+      }
+
+      if (!actions.empty()) {
+         _block_offsets.emplace(block_num, _action_log_size);
+         for (const auto& action : actions) {
+            const uint64_t offset = _action_log_size;
+            _action_log_size += append_entry(action, _action_log);
+            index_action(offset, action);
+         }
+         _action_log.flush();
+      }
+
+      if (_action_log_size - _checkpoint.action_log_size >= checkpoint_interval) {
+         checkpoint(lib);
+      }
+   }
+
+   void history_log::checkpoint(uint32_t lib) {
+      const auto reversible = _block_offsets.upper_bound(lib);
+      const uint64_t boundary = reversible == _block_offsets.end() ? _action_log_size : reversible->second;
+      if (boundary == _checkpoint.action_log_size) {
+         return;
+      }
+
+      // the index never refers to actions which could be lost
+      _action_log.flush();
+      _action_log.sync();
+
+      for (auto itr = _pending_account_actions.begin(); itr != _pending_account_actions.end();) {
+         auto& offsets = itr->second;
+         const auto split = std::lower_bound(offsets.begin(), offsets.end(), boundary);
+         if (split != offsets.begin()) {
+            auto& blocks = _account_blocks[itr->first];
+            const int32_t first = blocks.empty() ? 0 : blocks.back().first_account_sequence_num + blocks.back().count;
+            const uint32_t count = split - offsets.begin();
+            account_index_block block{ itr->first, first, std::vector<uint64_t>(offsets.begin(), split) };
+            _index_log_size += append_entry(history_index_entry{ std::move(block) }, _index_log);
+            blocks.push_back({ first, count, _index_log_size - sizeof(uint64_t) * count });
+            offsets.erase(offsets.begin(), split);
+         }
+         itr = offsets.empty() ? _pending_account_actions.erase(itr) : std::next(itr);
+      }
+
+      trx_index_block trx_block;
+      for (auto itr = _pending_trxs.begin(); itr != _pending_trxs.end();) {
+         if (itr->second < boundary) {
+            trx_block.entries.push_back({ itr->first, itr->second });
+            itr = _pending_trxs.erase(itr);
+         } else {
+            ++itr;
+         }
+      }
+      if (!trx_block.entries.empty()) {
+         const uint32_t count = trx_block.entries.size();
+         _index_log_size += append_entry(history_index_entry{ std::move(trx_block) }, _index_log);
+         _trx_blocks.push_back({ count, _index_log_size - trx_entry_size * count });
+      }
+
+      _checkpoint = index_checkpoint{ boundary, lib };
+      _index_log_size += append_entry(history_index_entry{ _checkpoint }, _index_log);
+      _index_log.flush();
+      _index_log.sync();
+
+      _block_offsets.erase(_block_offsets.begin(), reversible);
+   }
+
+   int32_t history_log::account_action_count(account_name account) const {
+      int32_t count = 0;
+      auto blocks = _account_blocks.find(account);
+      if (blocks != _account_blocks.end() && !blocks->second.empty()) {
+         count = blocks->second.back().first_account_sequence_num + blocks->second.back().count;
+      }
+      auto pending = _pending_account_actions.find(account);
+      if (pending != _pending_account_actions.end()) {
+         count += pending->second.size();
+      }
+      return count;
+   }
+
+   void history_log::for_each_account_action(account_name account, int32_t start, int32_t end,
+                                             const std::function<bool(int32_t, const action_history_entry&)>& f) const {
+      const int32_t count = account_action_count(account);
+      start = std::max(start, 0);
+      end = std::min(end, count - 1);
+
+      static const std::vector<index_block_ref> no_blocks;
+      auto account_blocks = _account_blocks.find(account);
+      const auto& blocks = account_blocks != _account_blocks.end() ? account_blocks->second : no_blocks;
+      const int32_t indexed = blocks.empty() ? 0 : blocks.back().first_account_sequence_num + blocks.back().count;
+
+      std::vector<uint64_t> offsets;
+      for (int32_t seq = start; seq <= end;) {
+         if (seq < indexed) {
+            // the block holding seq, and as many of the following sequence numbers as it holds
+            auto block = std::upper_bound(blocks.begin(), blocks.end(), seq, [](int32_t s, const index_block_ref& b) {
+               return s < b.first_account_sequence_num;
+            }) - 1;
+            const uint32_t first = seq - block->first_account_sequence_num;
+            offsets.resize(std::min<int64_t>(block->count - first, int64_t(end) - seq + 1));
+            _index_reader.seek(block->offsets_position + sizeof(uint64_t) * first);
+            _index_reader.read(reinterpret_cast<char*>(offsets.data()), sizeof(uint64_t) * offsets.size());
+         } else {
+            const auto& pending = _pending_account_actions.at(account);
+            const auto first = pending.begin() + (seq - indexed);
+            offsets.assign(first, first + (end - seq + 1));
+         }
+         for (const auto offset : offsets) {
+            if (!f(seq++, read_action(offset)))
+               return;
+         }
+      }
+   }
+
+   trx_index_entry history_log::read_trx_entry(const trx_block_ref& block, uint32_t i) const {
+      _index_reader.seek(block.entries_position + trx_entry_size * i);
+      return extract_entry<trx_index_entry>(_index_reader);
+   }
+
+   std::optional<trx_index_entry> history_log::lower_bound_trx(const transaction_id_type& id) const {
+      std::optional<trx_index_entry> result;
+      auto pending = _pending_trxs.lower_bound(id);
+      if (pending != _pending_trxs.end())
+         result = trx_index_entry{ pending->first, pending->second };
+
+      for (const auto& block : _trx_blocks) {
+         uint32_t first = 0;
+         uint32_t count = block.count;
+         while (count > 0) {
+            const uint32_t step = count / 2;
+            if (read_trx_entry(block, first + step).trx_id < id) {
+               first += step + 1;
+               count -= step + 1;
+            } else {
+               count = step;
+            }
+         }
+         if (first < block.count) {
+            auto entry = read_trx_entry(block, first);
+            if (!result || entry.trx_id < result->trx_id)
+               result = std::move(entry);
+         }
+      }
+      return result;
+   }
+
+   std::optional<transaction_id_type> history_log::lower_bound_transaction(const transaction_id_type& id) const {
+      auto entry = lower_bound_trx(id);
+      if (!entry)
+         return {};
+      return entry->trx_id;
+   }
+
+   std::vector<action_history_entry> history_log::transaction_actions(const transaction_id_type& id) const {
+      std::vector<action_history_entry> result;
+      auto entry = lower_bound_trx(id);
+      if (!entry || entry->trx_id != id)
+         return result;
+
+      _action_reader.seek(entry->action_offset);
+      while (_action_reader.tellp() < _action_log_size) {
+         auto action = extract_entry<action_history_entry>(_action_reader);
+         if (action.trx_id != id)
+            break;
+         result.emplace_back(std::move(action));
+      }
+      return result;
+   }
+
+   action_history_entry history_log::read_action(uint64_t offset) const {
+      _action_reader.seek(offset);
+      return extract_entry<action_history_entry>(_action_reader);
+   }
+
+}
@@ -1,6 +1,8 @@
 #include <eosio/history_plugin/history_plugin.hpp>
+#include <eosio/history_plugin/history_log.hpp>
 #include <eosio/history_plugin/account_control_history_object.hpp>
 #include <eosio/history_plugin/public_key_history_object.hpp>
+#include <eosio/chain/block_state.hpp>
 #include <eosio/chain/controller.hpp>
 #include <eosio/chain/trace.hpp>
 #include <eosio/chain_plugin/chain_plugin.hpp>
@@ -13,6 +15,7 @@
 namespace eosio {
    using namespace chain;
    using boost::signals2::scoped_connection;
+   namespace bfs = boost::filesystem;
 
    static appbase::abstract_plugin& _history_plugin = app().register_plugin<history_plugin>();
 
@@ -142,6 +145,13 @@ namespace eosio {
          std::set<filter_entry> filter_out;
          chain_plugin*          chain_plug = nullptr;
          std::optional<scoped_connection> applied_transaction_connection;
+         std::optional<scoped_connection> block_start_connection;
+         std::optional<scoped_connection> accepted_block_connection;
+
+         /// set when the action history is stored on disk rather than in the chain state database
+         std::optional<history_log>        log;
+         /// actions of the block being built, recorded in the log once the block is accepted
+         vector<action_history_entry>      pending_actions;
 
           bool filter(const action_trace& act) {
             bool pass_on = false;
@@ -251,7 +261,19 @@ namespace eosio {
          }
 
          void on_action_trace( const action_trace& at ) {
-            if( filter( at ) ) {
+            const bool tracked = filter( at );
+            if( tracked && log ) {
+               auto& chain = chain_plug->chain();
+               auto aset = account_set( at );
+               pending_actions.emplace_back( action_history_entry{
+                  .action_sequence_num = at.receipt->global_sequence,
+                  .block_num           = chain.head_block_num() + 1,
+                  .block_time          = chain.pending_block_time(),
+                  .trx_id              = at.trx_id,
+                  .accounts            = vector<account_name>( aset.begin(), aset.end() ),
+                  .packed_action_trace = fc::raw::pack( at )
+               });
+            } else if( tracked ) {
                //idump((fc::json::to_pretty_string(at)));
                auto& chain = chain_plug->chain();
                chainbase::database& db = const_cast<chainbase::database&>( chain.db() ); // Override read-only access to state DB (highly unrecommended practice!)
@@ -286,6 +308,20 @@ namespace eosio {
                on_action_trace( atrace );
             }
          }
+
+         void on_block_start( uint32_t block_num ) {
+            pending_actions.clear();
+         }
+
+         void on_accepted_block( const block_state_ptr& bsp ) {
+            try {
+               log->append_block( bsp->block_num, pending_actions, chain_plug->chain().last_irreversible_block_num() );
+            } catch( const fc::exception& e ) {
+               EOS_THROW( chain::controller_emit_signal_exception, "history_plugin failed to record block ${n}: ${e}",
+                          ("n", bsp->block_num)("e", e.to_detail_string()) );
+            }
+            pending_actions.clear();
+         }
    };
 
    history_plugin::history_plugin()
@@ -306,6 +342,15 @@ namespace eosio {
             ("filter-out,F", bpo::value<vector<string>>()->composing(),
              "Do not track actions which match receiver:action:actor. Action and Actor both blank excludes all from Reciever. Actor blank excludes all from reciever:action. Receiver may not be blank.")
             ;
+      cfg.add_options()
+            ("history-storage", bpo::value<string>()->default_value("chainbase"),
+             "Where the tracked actions are stored.\n"
+             "\"chainbase\" stores them in the chain state database.\n"
+             "\"disk\" stores them in append-only files in history-dir, outside of the chain state database. "
+             "Only the actions of accepted blocks are recorded, not those of the block being built.")
+            ("history-dir", bpo::value<bfs::path>()->default_value("history"),
+             "the location of the history directory when history-storage is \"disk\" (absolute path or relative to application data dir)")
+            ;
    }
 
    void history_plugin::plugin_initialize(const variables_map& options) {
@@ -315,7 +360,8 @@ namespace eosio {
             for( auto& s : fo ) {
                if( s == "*" || s == "\"*\"" ) {
                   my->bypass_filter = true;
-                  wlog( "--filter-on * enabled. This can fill shared_mem, causing nodeos to stop." );
+                  if( options.at( "history-storage" ).as<string>() == "chainbase" )
+                     wlog( "--filter-on * enabled. This can fill shared_mem, causing nodeos to stop." );
                   break;
                }
                std::vector<std::string> v;
@@ -351,6 +397,25 @@ namespace eosio {
          db.add_index<account_control_history_multi_index>();
          db.add_index<public_key_history_multi_index>();
 
+         const auto storage = options.at( "history-storage" ).as<string>();
+         EOS_ASSERT( storage == "chainbase" || storage == "disk", chain::plugin_config_exception,
+                     "Unknown history-storage \"${s}\", expected \"chainbase\" or \"disk\"", ("s", storage) );
+         if( storage == "disk" ) {
+            auto dir = options.at( "history-dir" ).as<bfs::path>();
+            if( dir.is_relative() )
+               dir = app().data_dir() / dir;
+            my->log.emplace( dir );
+
+            my->block_start_connection.emplace(
+                  chain.block_start.connect( [&]( uint32_t block_num ) {
+                     my->on_block_start( block_num );
+                  } ));
+            my->accepted_block_connection.emplace(
+                  chain.accepted_block.connect( [&]( const block_state_ptr& bsp ) {
+                     my->on_accepted_block( bsp );
+                  } ));
+         }
+
          my->applied_transaction_connection.emplace(
                chain.applied_transaction.connect( [&]( std::tuple<const transaction_trace_ptr&, const packed_transaction_ptr&> t ) {
                   my->on_applied_transaction( std::get<0>(t) );
@@ -363,6 +428,13 @@ namespace eosio {
 
    void history_plugin::plugin_shutdown() {
       my->applied_transaction_connection.reset();
+      my->block_start_connection.reset();
+      my->accepted_block_connection.reset();
+      if( my->log ) {
+         try {
+            my->log->checkpoint( my->chain_plug->chain().last_irreversible_block_num() );
+         } FC_LOG_AND_DROP()
+      }
    }
 
 
@@ -383,7 +455,11 @@ namespace eosio {
         int32_t offset = params.offset ? *params.offset : -20;
         auto n = params.account_name;
         idump((pos));
-        if( pos == -1 ) {
+        if( pos == -1 && history->log ) {
+            const int32_t count = history->log->account_action_count( n );
+            if( count > 0 )
+               pos = count;
+        } else if( pos == -1 ) {
             auto itr = idx.lower_bound( boost::make_tuple( name(n.to_uint64_t()+1), 0 ) );
             if( itr == idx.begin() ) {
                if( itr->account == n )
@@ -408,31 +484,46 @@ namespace eosio {
 
         idump((start)(end));
 
-        auto start_itr = idx.lower_bound( boost::make_tuple( n, start ) );
-        auto end_itr = idx.upper_bound( boost::make_tuple( n, end) );
-
         auto start_time = fc::time_point::now();
         auto end_time = start_time;
 
         get_actions_result result;
         result.last_irreversible_block = chain.last_irreversible_block_num();
-        while( start_itr != end_itr ) {
-           const auto& a = db.get<action_history_object, by_action_sequence_num>( start_itr->action_sequence_num );
-           fc::datastream<const char*> ds( a.packed_action_trace.data(), a.packed_action_trace.size() );
+        auto add_action = [&]( uint64_t action_sequence_num, int32_t account_sequence_num, uint32_t block_num,
+                               block_timestamp_type block_time, const char* packed_action_trace, size_t size ) -> bool {
+           fc::datastream<const char*> ds( packed_action_trace, size );
            action_trace t;
            fc::raw::unpack( ds, t );
            result.actions.emplace_back( ordered_action_result{
-                                 start_itr->action_sequence_num,
-                                 start_itr->account_sequence_num,
-                                 a.block_num, a.block_time,
+                                 action_sequence_num,
+                                 account_sequence_num,
+                                 block_num, block_time,
                                  chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time ))
                                  });
 
            end_time = fc::time_point::now();
            if( end_time - start_time > fc::microseconds(100000) ) {
               result.time_limit_exceeded_error = true;
-              break;
+              return false;
            }
+           return true;
+        };
+
+        if( history->log ) {
+           history->log->for_each_account_action( n, start, end, [&]( int32_t account_sequence_num, const action_history_entry& a ) {
+              return add_action( a.action_sequence_num, account_sequence_num, a.block_num, a.block_time,
+                                 a.packed_action_trace.data(), a.packed_action_trace.size() );
+           });
+           return result;
+        }
+
+        auto start_itr = idx.lower_bound( boost::make_tuple( n, start ) );
+        auto end_itr = idx.upper_bound( boost::make_tuple( n, end) );
+        while( start_itr != end_itr ) {
+           const auto& a = db.get<action_history_object, by_action_sequence_num>( start_itr->action_sequence_num );
+           if( !add_action( start_itr->action_sequence_num, start_itr->account_sequence_num, a.block_num, a.block_time,
+                            a.packed_action_trace.data(), a.packed_action_trace.size() ) )
+              break;
            ++start_itr;
         }
         return result;
@@ -466,7 +557,11 @@ namespace eosio {
          const auto& idx = db.get_index<action_history_index, by_trx_id_act_seq>();
          auto itr = idx.lower_bound( boost::make_tuple( input_id ) );
 
-         bool in_history = (itr != idx.end() && txn_id_matched(itr->trx_id) );
+         std::optional<transaction_id_type> log_id;
+         if( history->log )
+            log_id = history->log->lower_bound_transaction( input_id );
+
+         bool in_history = history->log ? (log_id && txn_id_matched(*log_id)) : (itr != idx.end() && txn_id_matched(itr->trx_id) );
 
          if( !in_history && !p.block_num_hint ) {
             EOS_THROW(tx_not_found, "Transaction ${id} not found in history and no block hint was given", ("id",p.id));
@@ -474,22 +569,35 @@ namespace eosio {
 
          get_transaction_result result;
 
-         if( in_history ) {
+         auto add_trace = [&]( const char* packed_action_trace, size_t size ) {
+            fc::datastream<const char*> ds( packed_action_trace, size );
+            action_trace t;
+            fc::raw::unpack( ds, t );
+            result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time )) );
+         };
+
+         if( in_history && history->log ) {
+            const auto actions = history->log->transaction_actions( *log_id );
+            EOS_ASSERT( !actions.empty(), chain::plugin_exception, "Transaction ${id} has no recorded actions", ("id", *log_id) );
+            result.id         = *log_id;
+            result.last_irreversible_block = chain.last_irreversible_block_num();
+            result.block_num  = actions.front().block_num;
+            result.block_time = actions.front().block_time;
+            for( const auto& a : actions )
+               add_trace( a.packed_action_trace.data(), a.packed_action_trace.size() );
+         } else if( in_history ) {
             result.id         = itr->trx_id;
             result.last_irreversible_block = chain.last_irreversible_block_num();
             result.block_num  = itr->block_num;
             result.block_time = itr->block_time;
 
             while( itr != idx.end() && itr->trx_id == result.id ) {
-
-              fc::datastream<const char*> ds( itr->packed_action_trace.data(), itr->packed_action_trace.size() );
-              action_trace t;
-              fc::raw::unpack( ds, t );
-              result.traces.emplace_back( chain.to_variant_with_abi(t, abi_serializer::create_yield_function( abi_serializer_max_time )) );
-
+              add_trace( itr->packed_action_trace.data(), itr->packed_action_trace.size() );
               ++itr;
             }
+         }
 
+         if( in_history ) {
             auto blk = chain.fetch_block_by_number( result.block_num );
             if( blk || chain.is_building_block() ) {
                const auto& receipts = blk ? blk->transactions : chain.get_pending_trx_receipts();
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <eosio/chain/block_timestamp.hpp>
+#include <eosio/chain/types.hpp>
+
+#include <fc/io/cfile.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <boost/filesystem/path.hpp>
+
+#include <functional>
+#include <map>
+#include <optional>
+#include <variant>
+#include <vector>
+
+namespace eosio {
+
+   /**
+    * An action trace in the history of one or more accounts
+    */
+   struct action_history_entry {
+      uint64_t                          action_sequence_num = 0;
+      uint32_t                          block_num = 0;
+      chain::block_timestamp_type       block_time;
+      chain::transaction_id_type        trx_id;
+      std::vector<chain::account_name>  accounts; ///< the accounts which have this action in their history
+      std::vector<char>                 packed_action_trace;
+   };
+
+   /**
+    * Action log offsets of the consecutive account sequence numbers of an account starting at first_account_sequence_num
+    */
+   struct account_index_block {
+      chain::account_name    account;
+      int32_t                first_account_sequence_num = 0;
+      std::vector<uint64_t>  action_offsets;
+   };
+
+   struct trx_index_entry {
+      chain::transaction_id_type  trx_id;
+      uint64_t                    action_offset = 0; ///< action log offset of the first action of the transaction
+   };
+
+   /**
+    * Transactions sorted by id.  The entries have a fixed size so that they are binary searched in place
+    */
+   struct trx_index_block {
+      std::vector<trx_index_entry> entries;
+   };
+
+   /**
+    * Completes the index blocks written before it
+    */
+   struct index_checkpoint {
+      uint64_t action_log_size = 0; ///< the index blocks cover the actions before this offset
+      uint32_t lib = 0;             ///< the action log holds every recorded action up to this block before that offset
+   };
+
+   using history_index_entry = std::variant<account_index_block, trx_index_block, index_checkpoint>;
+
+   /**
+    * Action history stored on disk, outside of the chain state database.
+    *
+    *  actions.log : append-only action_history_entry records of the accepted blocks.  Records of blocks replaced by a
+    *                fork switch are truncated before the replacing block is appended.
+    *  index.log   : append-only history_index_entry records.  At every checkpoint the irreversible actions recorded
+    *                since the previous checkpoint are indexed by account, in blocks sorted by account sequence number,
+    *                and by transaction id, in a block sorted by transaction id.  The index blocks are read in place,
+    *                only their positions are kept in memory.  Actions after the last checkpoint are indexed in memory,
+    *                records after the last checkpoint record are discarded on startup and indexed again from the
+    *                action log.
+    *
+    * Not thread safe.
+    */
+   class history_log {
+   public:
+      /// action log growth which triggers a checkpoint
+      static constexpr uint64_t checkpoint_interval = 64 * 1024 * 1024;
+
+      explicit history_log(const boost::filesystem::path& dir);
+
+      /**
+       * records the actions of an accepted block, replacing the recorded actions of this block and of later blocks.
+       * Blocks up to the last checkpoint are already recorded, as happens on a replay, and are skipped.
+       */
+      void append_block(uint32_t block_num, const std::vector<action_history_entry>& actions, uint32_t lib);
+
+      /// indexes the actions recorded up to lib on disk
+      void checkpoint(uint32_t lib);
+
+      /// the last irreversible block of the last checkpoint, blocks up to it are not recorded again
+      uint32_t checkpoint_lib() const { return _checkpoint.lib; }
+
+      /// the number of actions in the history of an account
+      int32_t account_action_count(chain::account_name account) const;
+
+      /**
+       * calls f with the account sequence number and the action of account sequence numbers [start, end] of an account
+       * in ascending order, until f returns false
+       */
+      void for_each_account_action(chain::account_name account, int32_t start, int32_t end,
+                                   const std::function<bool(int32_t, const action_history_entry&)>& f) const;
+
+      /// the first recorded transaction id which is not less than id
+      std::optional<chain::transaction_id_type> lower_bound_transaction(const chain::transaction_id_type& id) const;
+
+      /// the recorded actions of a transaction, in order of execution
+      std::vector<action_history_entry> transaction_actions(const chain::transaction_id_type& id) const;
+
+   private:
+      struct index_block_ref {
+         int32_t  first_account_sequence_num = 0;
+         uint32_t count = 0;
+         uint64_t offsets_position = 0; ///< index log position of the first action offset of the block
+      };
+
+      struct trx_block_ref {
+         uint32_t count = 0;
+         uint64_t entries_position = 0; ///< index log position of the first entry of the block
+      };
+
+      void load_index();
+      void load_actions();
+      void index_action(uint64_t offset, const action_history_entry& action);
+      void truncate_actions(uint64_t size);
+      action_history_entry read_action(uint64_t offset) const;
+      trx_index_entry read_trx_entry(const trx_block_ref& block, uint32_t i) const;
+      /// the first indexed or pending transaction whose id is not less than id
+      std::optional<trx_index_entry> lower_bound_trx(const chain::transaction_id_type& id) const;
+
+      boost::filesystem::path                                      _action_log_path;
+      boost::filesystem::path                                      _index_log_path;
+      fc::cfile                                                    _action_log;
+      fc::cfile                                                    _index_log;
+      mutable fc::cfile                                            _action_reader;
+      mutable fc::cfile                                            _index_reader;
+      uint64_t                                                     _action_log_size = 0;
+      uint64_t                                                     _index_log_size = 0;
+      index_checkpoint                                             _checkpoint;
+
+      std::map<chain::account_name, std::vector<index_block_ref>>  _account_blocks;
+      std::vector<trx_block_ref>                                   _trx_blocks;
+
+      // actions recorded after the last checkpoint
+      std::map<chain::account_name, std::vector<uint64_t>>         _pending_account_actions;
+      std::map<chain::transaction_id_type, uint64_t>               _pending_trxs; ///< to the offset of the first action
+      std::map<uint32_t, uint64_t>                                 _block_offsets; ///< block number to the offset of its first action
+   };
+
+}
+
+FC_REFLECT( eosio::action_history_entry, (action_sequence_num)(block_num)(block_time)(trx_id)(accounts)(packed_action_trace) )
+FC_REFLECT( eosio::account_index_block, (account)(first_account_sequence_num)(action_offsets) )
+FC_REFLECT( eosio::trx_index_entry, (trx_id)(action_offset) )
+FC_REFLECT( eosio::trx_index_block, (entries) )
+FC_REFLECT( eosio::index_checkpoint, (action_log_size)(lib) )
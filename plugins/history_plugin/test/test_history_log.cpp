@@ -0,0 +1,223 @@
+#define BOOST_TEST_MODULE history_log
+#include <boost/test/included/unit_test.hpp>
+#include <eosio/history_plugin/history_log.hpp>
+#include <eosio/chain/exceptions.hpp>
+#include <fc/filesystem.hpp>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <limits>
+
+using namespace eosio;
+using namespace eosio::chain::literals;
+namespace bfs = boost::filesystem;
+
+namespace {
+   chain::transaction_id_type make_trx_id(uint8_t first_byte, uint8_t last_byte) {
+      chain::transaction_id_type id;
+      id.data()[0] = first_byte;
+      id.data()[id.data_size() - 1] = last_byte;
+      return id;
+   }
+
+   action_history_entry make_action(uint64_t seq, uint32_t block_num, const chain::transaction_id_type& trx_id,
+                                    std::vector<chain::account_name> accounts) {
+      return { seq, block_num, chain::block_timestamp_type(block_num), trx_id, std::move(accounts),
+               std::vector<char>(seq % 7 + 1, char(seq)) };
+   }
+
+   std::vector<uint64_t> account_actions(const history_log& log, chain::account_name account,
+                                         int32_t start = 0, int32_t end = std::numeric_limits<int32_t>::max()) {
+      std::vector<uint64_t> result;
+      log.for_each_account_action(account, start, end, [&](int32_t seq, const action_history_entry& a) {
+         BOOST_REQUIRE_EQUAL(seq, start + int32_t(result.size()));
+         result.push_back(a.action_sequence_num);
+         return true;
+      });
+      return result;
+   }
+
+   std::vector<uint64_t> trx_actions(const history_log& log, const chain::transaction_id_type& id) {
+      std::vector<uint64_t> result;
+      for (const auto& a : log.transaction_actions(id))
+         result.push_back(a.action_sequence_num);
+      return result;
+   }
+
+   struct test_fixture {
+      fc::temp_directory tempdir;
+      bfs::path          dir = tempdir.path() / "history";
+
+      // three actions in two transactions per block, the first action of each block is also in bob's history
+      void append_blocks(history_log& log, uint32_t first, uint32_t last, uint32_t lib) {
+         for (uint32_t b = first; b <= last; ++b) {
+            const uint64_t seq = b * 10;
+            log.append_block(b, { make_action(seq, b, make_trx_id(b, 1), { "alice"_n, "bob"_n }),
+                                  make_action(seq + 1, b, make_trx_id(b, 1), { "alice"_n }),
+                                  make_action(seq + 2, b, make_trx_id(b, 2), { "alice"_n }) }, lib);
+         }
+      }
+   };
+}
+
+BOOST_AUTO_TEST_SUITE(history_log_tests)
+
+   BOOST_FIXTURE_TEST_CASE(append_and_query, test_fixture)
+   {
+      history_log log(dir);
+      append_blocks(log, 1, 2, 0);
+      log.checkpoint(2);
+      append_blocks(log, 3, 4, 2);
+
+      // indexed up to block 2, pending after
+      BOOST_REQUIRE_EQUAL(log.checkpoint_lib(), 2u);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("alice"_n), 12);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("bob"_n), 4);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("carol"_n), 0);
+
+      const std::vector<uint64_t> alice = { 10, 11, 12, 20, 21, 22, 30, 31, 32, 40, 41, 42 };
+      BOOST_REQUIRE(account_actions(log, "alice"_n) == alice);
+      BOOST_REQUIRE(account_actions(log, "alice"_n, 4, 7) == std::vector<uint64_t>({ 21, 22, 30, 31 }));
+      BOOST_REQUIRE(account_actions(log, "bob"_n) == std::vector<uint64_t>({ 10, 20, 30, 40 }));
+      BOOST_REQUIRE(account_actions(log, "carol"_n).empty());
+
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(1, 1)) == std::vector<uint64_t>({ 10, 11 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(2, 2)) == std::vector<uint64_t>({ 22 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(3, 1)) == std::vector<uint64_t>({ 30, 31 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(5, 1)).empty());
+
+      // the lower bound is found among the indexed and the pending transactions
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(1, 0)) == make_trx_id(1, 1));
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(1, 3)) == make_trx_id(2, 1));
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(2, 3)) == make_trx_id(3, 1));
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(4, 2)) == make_trx_id(4, 2));
+      BOOST_REQUIRE(!log.lower_bound_transaction(make_trx_id(4, 3)));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(lower_bound_across_checkpoints, test_fixture)
+   {
+      history_log log(dir);
+      // the transaction ids of later blocks sort before the ones of earlier blocks
+      for (uint32_t b = 1; b <= 6; ++b) {
+         log.append_block(b, { make_action(b, b, make_trx_id(100 - b, 0), { "alice"_n }),
+                               make_action(b + 100, b, make_trx_id(100 + b, 0), { "alice"_n }) }, b - 1);
+         log.checkpoint(b);
+      }
+      for (uint32_t b = 1; b <= 6; ++b) {
+         BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(100 - b, 0)) == make_trx_id(100 - b, 0));
+         BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(100 + b - 1, 1)) == make_trx_id(100 + b, 0));
+         BOOST_REQUIRE(trx_actions(log, make_trx_id(100 + b, 0)) == std::vector<uint64_t>({ b + 100 }));
+      }
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(0, 0)) == make_trx_id(94, 0));
+      BOOST_REQUIRE(!log.lower_bound_transaction(make_trx_id(106, 1)));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(fork_truncation, test_fixture)
+   {
+      history_log log(dir);
+      append_blocks(log, 1, 4, 0);
+      log.checkpoint(1);
+
+      // block 3 is replaced, block 4 is gone
+      log.append_block(3, { make_action(35, 3, make_trx_id(3, 5), { "carol"_n }) }, 1);
+      BOOST_REQUIRE(account_actions(log, "alice"_n) == std::vector<uint64_t>({ 10, 11, 12, 20, 21, 22 }));
+      BOOST_REQUIRE(account_actions(log, "bob"_n) == std::vector<uint64_t>({ 10, 20 }));
+      BOOST_REQUIRE(account_actions(log, "carol"_n) == std::vector<uint64_t>({ 35 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(3, 1)).empty());
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(4, 2)).empty());
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(3, 5)) == std::vector<uint64_t>({ 35 }));
+      BOOST_REQUIRE(log.lower_bound_transaction(make_trx_id(3, 2)) == make_trx_id(3, 5));
+
+      // a block without actions replaces the later blocks too
+      log.append_block(2, {}, 1);
+      BOOST_REQUIRE(account_actions(log, "alice"_n) == std::vector<uint64_t>({ 10, 11, 12 }));
+      BOOST_REQUIRE(account_actions(log, "carol"_n).empty());
+      BOOST_REQUIRE(!log.lower_bound_transaction(make_trx_id(1, 3)));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(replayed_blocks_are_skipped, test_fixture)
+   {
+      history_log log(dir);
+      append_blocks(log, 1, 4, 0);
+      log.checkpoint(3);
+      BOOST_REQUIRE_EQUAL(log.checkpoint_lib(), 3u);
+
+      // a replay applies the irreversible blocks again
+      append_blocks(log, 1, 3, 0);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("alice"_n), 12);
+
+      // reversible blocks are recorded again
+      append_blocks(log, 4, 5, 3);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("alice"_n), 15);
+      BOOST_REQUIRE(account_actions(log, "bob"_n) == std::vector<uint64_t>({ 10, 20, 30, 40, 50 }));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(reopen, test_fixture)
+   {
+      {
+         history_log log(dir);
+         append_blocks(log, 1, 2, 0);
+         log.checkpoint(2);
+         append_blocks(log, 3, 4, 2);
+      }
+
+      // the actions after the checkpoint are indexed again
+      history_log log(dir);
+      BOOST_REQUIRE_EQUAL(log.checkpoint_lib(), 2u);
+      BOOST_REQUIRE_EQUAL(log.account_action_count("alice"_n), 12);
+      BOOST_REQUIRE(account_actions(log, "bob"_n) == std::vector<uint64_t>({ 10, 20, 30, 40 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(2, 1)) == std::vector<uint64_t>({ 20, 21 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(4, 1)) == std::vector<uint64_t>({ 40, 41 }));
+
+      // and can still be replaced by a fork
+      log.append_block(4, { make_action(45, 4, make_trx_id(4, 5), { "bob"_n }) }, 2);
+      BOOST_REQUIRE(account_actions(log, "bob"_n) == std::vector<uint64_t>({ 10, 20, 30, 45 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(4, 1)).empty());
+   }
+
+   BOOST_FIXTURE_TEST_CASE(crash_recovery, test_fixture)
+   {
+      uint64_t index_size = 0;
+      {
+         history_log log(dir);
+         append_blocks(log, 1, 2, 0);
+         log.checkpoint(2);
+         index_size = bfs::file_size(dir / "index.log");
+         append_blocks(log, 3, 4, 2);
+      }
+
+      // a record cut short in the action log and index records without a checkpoint
+      const auto action_log_size = bfs::file_size(dir / "actions.log");
+      bfs::resize_file(dir / "actions.log", action_log_size - 3);
+      {
+         std::ofstream index(( dir / "index.log" ).generic_string(), std::ios::app | std::ios::binary);
+         const std::string garbage(50, '\x01');
+         index.write(garbage.data(), garbage.size());
+      }
+
+      history_log log(dir);
+      BOOST_REQUIRE_EQUAL(bfs::file_size(dir / "index.log"), index_size);
+      BOOST_REQUIRE_LT(bfs::file_size(dir / "actions.log"), action_log_size - 3);
+      BOOST_REQUIRE(account_actions(log, "alice"_n) == std::vector<uint64_t>({ 10, 11, 12, 20, 21, 22, 30, 31, 32, 40, 41 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(4, 1)) == std::vector<uint64_t>({ 40, 41 }));
+      BOOST_REQUIRE(trx_actions(log, make_trx_id(4, 2)).empty());
+
+      // recording goes on after the last complete record
+      log.append_block(5, { make_action(50, 5, make_trx_id(5, 1), { "alice"_n }) }, 4);
+      log.checkpoint(5);
+      history_log reopened(dir);
+      BOOST_REQUIRE(account_actions(reopened, "alice"_n, 9) == std::vector<uint64_t>({ 40, 41, 50 }));
+      BOOST_REQUIRE(trx_actions(reopened, make_trx_id(5, 1)) == std::vector<uint64_t>({ 50 }));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(truncated_action_log_is_refused, test_fixture)
+   {
+      {
+         history_log log(dir);
+         append_blocks(log, 1, 2, 0);
+         log.checkpoint(2);
+      }
+      bfs::resize_file(dir / "actions.log", bfs::file_size(dir / "actions.log") - 1);
+      BOOST_REQUIRE_THROW(history_log log(dir), chain::plugin_exception);
+   }
+
+BOOST_AUTO_TEST_SUITE_END()
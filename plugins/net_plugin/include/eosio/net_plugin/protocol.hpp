@@ -140,6 +140,55 @@ namespace eosio {
       std::shared_ptr<packed_transaction> trx;
    };
 
+   /// packed transaction short id, the last 8 bytes of its transaction id
+   using short_trx_id = uint64_t;
+
+   struct compact_block_receipt {
+      transaction_receipt_header                      header;
+      std::variant<transaction_id_type, short_trx_id> trx; ///< deferred transaction id or packed transaction short id
+   };
+
+   /**
+    * A block without the contents of its packed transactions, for peers which likely received them already.
+    * Only sent to peers which asked for compact blocks with an empty compact_block_request_message.
+    */
+   struct compact_block_message {
+      signed_block_header                     header;
+      fc::enum_type<uint8_t,signed_block::prune_state_type> prune_state{signed_block::prune_state_type::complete_legacy};
+      std::vector<compact_block_receipt>      transactions;
+      extensions_type                         block_extensions;
+   };
+
+   /**
+    * Requests the packed transactions of a compact block at the given receipt indexes.  An empty request (default id)
+    * instead asks the peer to relay new blocks as compact blocks.
+    */
+   struct compact_block_request_message {
+      block_id_type          id;
+      std::vector<uint32_t>  trx_indexes;
+   };
+
+   struct compact_block_trxs_message {
+      block_id_type                                     id;
+      std::vector<std::shared_ptr<packed_transaction>>  trxs; ///< in the order of the requested indexes
+   };
+
+   enum class compression_type : uint8_t {
+      none,
+      zstd
+   };
+
+   /// asks the peer to compress the blocks it sends in response to sync requests, none turns compression off again
+   struct sync_compression_message {
+      fc::enum_type<uint8_t,compression_type> codec{compression_type::none};
+   };
+
+   /// a block sent in response to a sync request to a peer which asked for compression
+   struct compressed_block_message {
+      fc::enum_type<uint8_t,compression_type> codec{compression_type::none};
+      std::vector<char>                       data; ///< the compressed packed signed_block
+   };
+
    using net_message = std::variant<handshake_message,
                                     chain_size_message,
                                     go_away_message,
@@ -150,7 +199,12 @@ namespace eosio {
                                     signed_block_v0,         // which = 7
                                     packed_transaction_v0,   // which = 8
                                     signed_block,            // which = 9
-                                    trx_message_v1>;         // which = 10
+                                    trx_message_v1,          // which = 10
+                                    compact_block_message,           // which = 11
+                                    compact_block_request_message,   // which = 12
+                                    compact_block_trxs_message,      // which = 13
+                                    sync_compression_message,        // which = 14
+                                    compressed_block_message>;       // which = 15
 
 } // namespace eosio
 
@@ -170,6 +224,13 @@ FC_REFLECT( eosio::notice_message, (known_trx)(known_blocks) )
 FC_REFLECT( eosio::request_message, (req_trx)(req_blocks) )
 FC_REFLECT( eosio::sync_request_message, (start_block)(end_block) )
 FC_REFLECT( eosio::trx_message_v1, (trx_id)(trx) )
+FC_REFLECT( eosio::compact_block_receipt, (header)(trx) )
+FC_REFLECT( eosio::compact_block_message, (header)(prune_state)(transactions)(block_extensions) )
+FC_REFLECT( eosio::compact_block_request_message, (id)(trx_indexes) )
+FC_REFLECT( eosio::compact_block_trxs_message, (id)(trxs) )
+FC_REFLECT_ENUM( eosio::compression_type, (none)(zstd) )
+FC_REFLECT( eosio::sync_compression_message, (codec) )
+FC_REFLECT( eosio::compressed_block_message, (codec)(data) )
 
 
 /**
@@ -9,6 +9,7 @@
 #include <eosio/chain/thread_utils.hpp>
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/chain/contract_types.hpp>
+#include <eosio/chain/merkle.hpp>
 
 #include <fc/network/message_buffer.hpp>
 #include <fc/network/ip.hpp>
@@ -25,8 +26,14 @@
 #include <boost/asio/ip/host_name.hpp>
 #include <boost/asio/steady_timer.hpp>
 
+#include <zstd.h>
+
+#include <array>
 #include <atomic>
+#include <deque>
+#include <map>
 #include <shared_mutex>
+#include <unordered_map>
 
 using namespace eosio::chain::plugin_interface;
 
@@ -38,7 +45,6 @@ namespace eosio {
    using boost::asio::ip::tcp;
    using boost::asio::ip::address_v4;
    using boost::asio::ip::host_name;
-   using boost::multi_index_container;
 
    using fc::time_point;
    using fc::time_point_sec;
@@ -67,67 +73,116 @@ namespace eosio {
       uint32_t        connection_id = 0;
    };
 
-   struct by_expiry;
-   struct by_block_num;
-
-   typedef multi_index_container<
-      node_transaction_state,
-      indexed_by<
-         ordered_unique<
-            tag<by_id>,
-            composite_key< node_transaction_state,
-               member<node_transaction_state, transaction_id_type, &node_transaction_state::id>,
-               member<node_transaction_state, uint32_t, &node_transaction_state::connection_id>
-            >,
-            composite_key_compare< sha256_less, std::less<uint32_t> >
-         >,
-         ordered_non_unique<
-            tag< by_expiry >,
-            member< node_transaction_state, fc::time_point_sec, &node_transaction_state::expires > >,
-         ordered_non_unique<
-            tag<by_block_num>,
-            member< node_transaction_state, uint32_t, &node_transaction_state::block_num > >
-         >
-      >
-   node_transaction_index;
-
-   struct peer_block_state {
-      block_id_type id;
-      uint32_t      block_num = 0;
-      uint32_t      connection_id = 0;
-      bool          have_block = false; // true if we have received the block, false if only received id notification
+   /**
+    * Transactions known to this node and the connections known to have them, thread safe.
+    *
+    * Sharded by transaction id, so net threads handling different transactions rarely contend for the same mutex.
+    * Every shard expires its transactions through a wheel of expiration seconds and through buckets of the block
+    * numbers the transactions were included in.  Buckets may refer to transactions which were removed or moved to
+    * another bucket since, such references are skipped when the bucket is drained.
+    */
+   class node_transaction_index {
+   public:
+      static constexpr uint32_t shard_count = 32;
+      static constexpr uint32_t wheel_slots = 4096; ///< seconds, more than the maximum transaction lifetime
+
+      node_transaction_index();
+
+      /// @return false if nts.connection_id is already known to have nts.id
+      bool add_peer_txn( const node_transaction_state& nts );
+      /// adds connection_id to an already known transaction, @return false if tid is not known
+      bool add_peer_txn_if_known( const transaction_id_type& tid, uint32_t connection_id );
+      void update_block_num( const transaction_id_type& tid, uint32_t blk_num );
+      bool peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const;
+      bool have_txn( const transaction_id_type& tid ) const;
+      /// removes the transactions expired at now or included in blocks up to lib_num, @return the number removed
+      size_t expire( time_point_sec now, uint32_t lib_num );
+      size_t size() const;
+
+   private:
+      struct txn_state {
+         time_point_sec   expires;
+         uint32_t         block_num = 0;
+         vector<uint32_t> connection_ids;
+      };
+
+      struct shard {
+         mutable std::mutex                                        mtx;
+         std::unordered_map<transaction_id_type, txn_state>        txns;
+         vector<vector<transaction_id_type>>                       expiry_wheel = vector<vector<transaction_id_type>>( wheel_slots );
+         uint32_t                                                  next_expiry_sec = 0; ///< first second not expired yet
+         std::map<uint32_t, vector<transaction_id_type>>           by_block_num;
+
+         void add_to_wheel( const transaction_id_type& tid, time_point_sec expires );
+      };
+
+      shard& shard_of( const transaction_id_type& tid ) { return shards[tid._hash[3] % shard_count]; }
+      const shard& shard_of( const transaction_id_type& tid ) const { return shards[tid._hash[3] % shard_count]; }
+
+      std::array<shard, shard_count> shards;
    };
 
-   struct by_peer_block_id;
-
-   typedef multi_index_container<
-      eosio::peer_block_state,
-      indexed_by<
-         ordered_unique< tag<by_id>,
-               composite_key< peer_block_state,
-                     member<peer_block_state, uint32_t, &eosio::peer_block_state::connection_id>,
-                     member<peer_block_state, block_id_type, &eosio::peer_block_state::id>
-               >,
-               composite_key_compare< std::less<uint32_t>, sha256_less >
-         >,
-         ordered_non_unique< tag<by_peer_block_id>,
-               composite_key< peer_block_state,
-                     member<peer_block_state, block_id_type, &eosio::peer_block_state::id>,
-                     member<peer_block_state, bool, &eosio::peer_block_state::have_block>
-               >,
-               composite_key_compare< sha256_less, std::greater<bool> >
-         >,
-         ordered_non_unique< tag<by_block_num>, member<eosio::peer_block_state, uint32_t, &eosio::peer_block_state::block_num > >
-      >
-      > peer_block_state_index;
-
-
-   struct update_block_num {
-      uint32_t new_bnum;
-      update_block_num(uint32_t bnum) : new_bnum(bnum) {}
-      void operator() (node_transaction_state& nts) {
-         nts.block_num = new_bnum;
-      }
+   /**
+    * Blocks known to this node and the connections known to have them, thread safe.  Sharded by block id.
+    */
+   class peer_block_state_index {
+   public:
+      static constexpr uint32_t shard_count = 16;
+
+      /// @return false if connection_id is already known to have blkid
+      bool add_peer_block( const block_id_type& blkid, uint32_t connection_id );
+      bool peer_has_block( const block_id_type& blkid, uint32_t connection_id ) const;
+      bool have_block( const block_id_type& blkid ) const;
+      /// removes the blocks up to lib_num
+      void expire( uint32_t lib_num );
+
+   private:
+      struct shard {
+         mutable std::mutex                                          mtx;
+         std::unordered_map<block_id_type, vector<uint32_t>>         blocks; ///< block id to connections having it
+         std::map<uint32_t, vector<block_id_type>>                   by_block_num;
+      };
+
+      // the first bytes of a block id hold its block number
+      shard& shard_of( const block_id_type& blkid ) { return shards[blkid._hash[3] % shard_count]; }
+      const shard& shard_of( const block_id_type& blkid ) const { return shards[blkid._hash[3] % shard_count]; }
+
+      std::array<shard, shard_count> shards;
+   };
+
+   /**
+    * Contents of the transactions received from peers or relayed by this node, by short id, for rebuilding compact
+    * blocks.  Transactions are removed once a block including them is accepted or once they expire.  When a shard is
+    * full the transaction expiring first is evicted to make room.  Of two transactions with the same short id the
+    * first one is kept, a block rebuilt with the wrong one fails the transaction merkle root check.  Thread safe,
+    * sharded by short id.
+    */
+   class compact_trx_pool {
+   public:
+      static constexpr uint32_t shard_count = 16;
+
+      static short_trx_id short_id( const transaction_id_type& id ) { return id._hash[3]; }
+
+      void add( const packed_transaction_ptr& trx );
+      /// @return null if not known
+      packed_transaction_ptr find( short_trx_id id ) const;
+      void remove_block_trxs( const signed_block& b );
+      /// removes the transactions expired at now, @return the number removed
+      size_t expire( time_point_sec now );
+
+   private:
+      struct shard {
+         mutable std::mutex                                         mtx;
+         std::unordered_map<short_trx_id, packed_transaction_ptr>   trxs;
+         std::multimap<time_point_sec, short_trx_id>                by_expiry;
+
+         void erase( std::unordered_map<short_trx_id, packed_transaction_ptr>::iterator itr );
+      };
+
+      shard& shard_of( short_trx_id id ) { return shards[id % shard_count]; }
+      const shard& shard_of( short_trx_id id ) const { return shards[id % shard_count]; }
+
+      std::array<shard, shard_count> shards;
    };
 
    class sync_manager {
@@ -138,14 +193,36 @@ namespace eosio {
          in_sync
       };
 
+      /// a chunk of blocks requested from one peer during pipelined lib catchup
+      struct sync_span {
+         uint32_t       start = 0;
+         uint32_t       end = 0;
+         connection_ptr source;
+         bool           received = false; ///< the source sent the last block of the span
+      };
+
+      struct sync_block {
+         block_id_type         id;
+         signed_block_ptr      block; ///< null for a block which was already known, nothing to pass on to the controller
+         connection_ptr        source;
+         trx_meta_cache_lookup trx_lookup;
+      };
+
       mutable std::mutex sync_mtx;
       uint32_t       sync_known_lib_num{0};
       uint32_t       sync_last_requested_num{0};
-      uint32_t       sync_next_expected_num{0};
+      uint32_t       sync_next_expected_num{0}; ///< when pipelined, the next block to pass on to the controller
       uint32_t       sync_req_span{0};
+      uint32_t       sync_spans_in_flight{1};
       connection_ptr sync_source;
       std::atomic<stages> sync_state{in_sync};
 
+      // pipelined lib catchup only
+      std::deque<sync_span>          sync_spans;  ///< in ascending order, until their blocks are passed on to the controller
+      std::map<uint32_t, sync_block> sync_window; ///< blocks received ahead of sync_next_expected_num
+      std::chrono::steady_clock::time_point sync_last_progress; ///< when sync_next_expected_num last advanced
+      uint32_t                       sync_restart_num{0}; ///< rejected block of the last restart, 0 once a later block is applied
+
    private:
       constexpr static auto stage_str( stages s );
       bool set_state( stages s );
@@ -154,13 +231,24 @@ namespace eosio {
       void start_sync( const connection_ptr& c, uint32_t target );
       bool verify_catchup( const connection_ptr& c, uint32_t num, const block_id_type& id );
 
+      bool pipelined() const { return sync_spans_in_flight > 1; }
+      void request_spans( std::unique_lock<std::mutex> g_sync );
+      connection_ptr select_span_source( uint32_t end, const connection_ptr& exclude ) const;
+      void reassign_spans( const connection_ptr& c );
+      bool span_received( const connection_ptr& c, uint32_t blk_num );
+      void release_sync_blocks();
+      void reset_pipeline();
+
    public:
-      explicit sync_manager( uint32_t span );
+      sync_manager( uint32_t span, uint32_t spans_in_flight );
       static void send_handshakes();
       bool syncing_with_peer() const { return sync_state == lib_catchup; }
       void sync_reset_lib_num( const connection_ptr& conn );
       void sync_reassign_fetch( const connection_ptr& c, go_away_reason reason );
       void rejected_block( const connection_ptr& c, uint32_t blk_num );
+      void check_stalled_span();
+      bool sync_reorder_block( const connection_ptr& c, const block_id_type& blk_id, const signed_block_ptr& b,
+                               const trx_meta_cache_lookup& trx_lookup );
       void sync_recv_block( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void sync_update_expected( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied );
       void recv_handshake( const connection_ptr& c, const handshake_message& msg );
@@ -168,10 +256,17 @@ namespace eosio {
    };
 
    class dispatch_manager {
-      mutable std::mutex      blk_state_mtx;
       peer_block_state_index  blk_state;
-      mutable std::mutex      local_txns_mtx;
       node_transaction_index  local_txns;
+      compact_trx_pool        trx_pool; // only used with p2p-compact-blocks
+
+      struct compressed_block {
+         block_id_type                        id;
+         std::shared_ptr<std::vector<char>>   buffer;
+      };
+      static constexpr size_t max_compressed_blocks = 128;
+      std::mutex                    compressed_blocks_mtx;
+      std::deque<compressed_block>  compressed_blocks; ///< sync buffers compressed last, oldest first
 
    public:
       boost::asio::io_context::strand  strand;
@@ -201,6 +296,13 @@ namespace eosio {
       bool peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const;
       bool have_txn( const transaction_id_type& tid ) const;
       void expire_txns( uint32_t lib_num );
+
+      void add_pool_trx( const packed_transaction_ptr& trx );
+      packed_transaction_ptr find_pool_trx( short_trx_id id ) const;
+      void remove_pool_trxs( const signed_block& b );
+
+      /// @return the sync buffer of the block compressed with codec, compressed once for all the peers syncing from it
+      std::shared_ptr<std::vector<char>> get_compressed_block_buffer( const signed_block_ptr& sb, compression_type codec );
    };
 
    class net_plugin_impl : public std::enable_shared_from_this<net_plugin_impl> {
@@ -241,6 +343,9 @@ namespace eosio {
       uint32_t                              max_nodes_per_host = 1;
       bool                                  p2p_accept_transactions = true;
       bool                                  p2p_reject_incomplete_blocks = true;
+      std::chrono::microseconds             trx_flush_window{0};
+      bool                                  p2p_compact_blocks = false;
+      compression_type                      sync_compression = compression_type::none;
 
       /// Peer clock may be no more than 1 second skewed from our clock, including network latency.
       const std::chrono::system_clock::duration peer_authentication_interval{std::chrono::seconds{1}};
@@ -288,6 +393,8 @@ namespace eosio {
       //         lib_num, head_block_num, fork_head_blk_num, lib_id, head_blk_id, fork_head_blk_id
       std::tuple<uint32_t, uint32_t, uint32_t, block_id_type, block_id_type, block_id_type> get_chain_info() const;
 
+      trx_meta_cache_lookup start_recover_keys( const signed_block_ptr& b );
+
       void start_listen_loop();
 
       void on_accepted_block( const block_state_ptr& bs );
@@ -391,12 +498,17 @@ namespace eosio {
    constexpr auto     def_resp_expected_wait = std::chrono::seconds(5);
    constexpr auto     def_sync_fetch_span = 100;
    constexpr auto     def_keepalive_interval = 32000;
+   constexpr auto     def_sync_compression_level = 3; // zstd
+   constexpr auto     def_compact_trx_pool_size = 128*1024; // transactions kept for rebuilding compact blocks
+   constexpr auto     def_max_pending_compact_blocks = 4; // compact blocks waiting for the transactions of a peer
 
    constexpr auto     message_header_size = 4;
    constexpr uint32_t signed_block_v0_which       = fc::get_index<net_message, signed_block_v0>();       // see protocol net_message
    constexpr uint32_t packed_transaction_v0_which = fc::get_index<net_message, packed_transaction_v0>(); // see protocol net_message
    constexpr uint32_t signed_block_which          = fc::get_index<net_message, signed_block>();          // see protocol net_message
    constexpr uint32_t trx_message_v1_which        = fc::get_index<net_message, trx_message_v1>();        // see protocol net_message
+   constexpr uint32_t compact_block_which         = fc::get_index<net_message, compact_block_message>(); // see protocol net_message
+   constexpr uint32_t compressed_block_which      = fc::get_index<net_message, compressed_block_message>(); // see protocol net_message
 
    /**
     *  For a while, network version was a 16 bit value equal to the second set of 16 bits
@@ -422,8 +534,10 @@ namespace eosio {
    constexpr uint16_t proto_pruned_types = 3;        // supports new signed_block & packed_transaction types
    constexpr uint16_t heartbeat_interval = 4;        // supports configurable heartbeat interval
    constexpr uint16_t dup_goaway_resolution = 5;     // support peer address based duplicate connection resolution
+   constexpr uint16_t proto_compact_blocks = 6;      // supports compact block relay
+   constexpr uint16_t proto_sync_compression = 7;    // supports compressed blocks in response to sync requests
 
-   constexpr uint16_t net_version = dup_goaway_resolution;
+   constexpr uint16_t net_version = proto_sync_compression;
 
    /**
     * Index by start_block_num
@@ -478,9 +592,9 @@ namespace eosio {
                             bool to_sync_queue ) {
          std::lock_guard<std::mutex> g( _mtx );
          if( to_sync_queue ) {
-            _sync_write_queue.push_back( {buff, callback} );
+            _sync_write_queue.push_back( {buff, std::move(callback)} );
          } else {
-            _write_queue.push_back( {buff, callback} );
+            _write_queue.push_back( {buff, std::move(callback)} );
          }
          _write_queue_size += buff->size();
          if( _write_queue_size > 2 * def_max_write_queue_size ) {
@@ -502,7 +616,7 @@ namespace eosio {
       void out_callback( boost::system::error_code ec, std::size_t w ) {
          std::lock_guard<std::mutex> g( _mtx );
          for( auto& m : _out_queue ) {
-            m.callback( ec, w );
+            if( m.callback ) m.callback( ec, w );
          }
       }
 
@@ -514,15 +628,15 @@ namespace eosio {
             auto& m = w_queue.front();
             bufs.push_back( boost::asio::buffer( *m.buff ));
             _write_queue_size -= m.buff->size();
-            _out_queue.emplace_back( m );
+            _out_queue.emplace_back( std::move(m) );
             w_queue.pop_front();
          }
       }
 
    private:
       struct queued_write {
-         std::shared_ptr<vector<char>> buff;
-         std::function<void( boost::system::error_code, std::size_t )> callback;
+         std::shared_ptr<vector<char>> buff; ///< shared by all connections the message is sent to
+         std::function<void( boost::system::error_code, std::size_t )> callback; ///< optional
       };
 
       mutable std::mutex  _mtx;
@@ -634,6 +748,21 @@ namespace eosio {
       std::mutex                            response_expected_timer_mtx;
       boost::asio::steady_timer             response_expected_timer;
 
+      boost::asio::steady_timer             flush_timer; // only accessed through strand
+      bool                                  flush_timer_armed = false;
+
+      std::atomic<bool>                     compact_blocks_requested{false}; ///< peer asked for compact blocks
+      bool                                  compact_blocks_subscribed = false; // only accessed through strand
+      std::atomic<compression_type>         peer_sync_compression{compression_type::none}; ///< codec the peer asked for
+      bool                                  sync_compression_sent = false; // only accessed through strand
+
+      /// compact block waiting for the packed transactions requested from the peer
+      struct pending_compact_block {
+         signed_block_ptr       block;
+         std::vector<uint32_t>  missing; ///< indexes of the receipts without their packed transaction
+      };
+      std::map<block_id_type, pending_compact_block> pending_compacts; // only accessed through strand
+
       std::atomic<go_away_reason>           no_retry{no_reason};
 
       mutable std::mutex               conn_mtx; //< mtx for last_req .. local_endpoint_port
@@ -743,9 +872,10 @@ namespace eosio {
       void sync_timeout(boost::system::error_code ec);
       void fetch_timeout(boost::system::error_code ec);
 
+      void enqueue_trx_buffer( const std::shared_ptr<std::vector<char>>& send_buffer );
       void queue_write(const std::shared_ptr<vector<char>>& buff,
                        std::function<void(boost::system::error_code, std::size_t)> callback,
-                       bool to_sync_queue = false);
+                       bool to_sync_queue = false, bool delay_write = false);
       void do_queue_write();
 
       static bool is_valid( const handshake_message& msg );
@@ -773,10 +903,18 @@ namespace eosio {
       void handle_message( const sync_request_message& msg );
       void handle_message( const signed_block& msg ) = delete; // signed_block_ptr overload used instead
       void handle_message( const block_id_type& id, signed_block_ptr msg );
+      void handle_message( const compact_block_message& msg );
+      void handle_message( const compact_block_request_message& msg );
+      void handle_message( const compact_block_trxs_message& msg );
+      void process_compact_block( const block_id_type& id, signed_block_ptr b );
+      bool is_block_wanted( const block_id_type& id, const block_header& bh );
+      bool accept_signed_block( const block_id_type& id, signed_block_ptr ptr );
+      void handle_message( const sync_compression_message& msg );
+      void handle_message( const compressed_block_message& msg );
       void handle_message( const packed_transaction& msg ) = delete; // packed_transaction_ptr overload used instead
       void handle_message( packed_transaction_ptr msg );
 
-      void process_signed_block( const block_id_type& id, signed_block_ptr msg );
+      void process_signed_block( const block_id_type& id, signed_block_ptr msg, const trx_meta_cache_lookup& trx_lookup = {} );
 
       fc::variant_object get_logger_variant()  {
          fc::mutable_variant_object mvo;
@@ -845,6 +983,36 @@ namespace eosio {
          fc_dlog( logger, "handle sync_request_message" );
          c->handle_message( msg );
       }
+
+      void operator()( const compact_block_message& msg ) const {
+         // continue call to handle_message on connection strand
+         fc_dlog( logger, "handle compact_block_message" );
+         c->handle_message( msg );
+      }
+
+      void operator()( const compact_block_request_message& msg ) const {
+         // continue call to handle_message on connection strand
+         fc_dlog( logger, "handle compact_block_request_message" );
+         c->handle_message( msg );
+      }
+
+      void operator()( const compact_block_trxs_message& msg ) const {
+         // continue call to handle_message on connection strand
+         fc_dlog( logger, "handle compact_block_trxs_message" );
+         c->handle_message( msg );
+      }
+
+      void operator()( const sync_compression_message& msg ) const {
+         // continue call to handle_message on connection strand
+         fc_dlog( logger, "handle sync_compression_message" );
+         c->handle_message( msg );
+      }
+
+      void operator()( const compressed_block_message& msg ) const {
+         // continue call to handle_message on connection strand
+         fc_dlog( logger, "handle compressed_block_message" );
+         c->handle_message( msg );
+      }
    };
 
    template<typename Function>
@@ -872,6 +1040,7 @@ namespace eosio {
         socket( new tcp::socket( my_impl->thread_pool->get_executor() ) ),
         connection_id( ++my_impl->current_connection_id ),
         response_expected_timer( my_impl->thread_pool->get_executor() ),
+        flush_timer( my_impl->thread_pool->get_executor() ),
         last_handshake_recv(),
         last_handshake_sent()
    {
@@ -884,6 +1053,7 @@ namespace eosio {
         socket( new tcp::socket( my_impl->thread_pool->get_executor() ) ),
         connection_id( ++my_impl->current_connection_id ),
         response_expected_timer( my_impl->thread_pool->get_executor() ),
+        flush_timer( my_impl->thread_pool->get_executor() ),
         last_handshake_recv(),
         last_handshake_sent()
    {
@@ -1001,6 +1171,11 @@ namespace eosio {
       }
       self->peer_requested.reset();
       self->sent_handshake_count = 0;
+      self->compact_blocks_requested = false;
+      self->compact_blocks_subscribed = false;
+      self->peer_sync_compression = compression_type::none;
+      self->sync_compression_sent = false;
+      self->pending_compacts.clear();
       if( !shutdown) my_impl->sync_master->sync_reset_lib_num( self->shared_from_this() );
       fc_ilog( logger, "closing '${a}', ${p}", ("a", self->peer_address())("p", self->peer_name()) );
       fc_dlog( logger, "canceling wait on ${p}", ("p", self->peer_name()) ); // peer_name(), do not hold conn_mtx
@@ -1176,13 +1351,26 @@ namespace eosio {
 
    void connection::queue_write(const std::shared_ptr<vector<char>>& buff,
                                 std::function<void(boost::system::error_code, std::size_t)> callback,
-                                bool to_sync_queue) {
-      if( !buffer_queue.add_write_queue( buff, callback, to_sync_queue )) {
+                                bool to_sync_queue, bool delay_write) {
+      if( !buffer_queue.add_write_queue( buff, std::move(callback), to_sync_queue )) {
          fc_wlog( logger, "write_queue full ${s} bytes, giving up on connection ${p}",
                   ("s", buffer_queue.write_queue_size())("p", peer_name()) );
          close();
          return;
       }
+      if( delay_write && my_impl->trx_flush_window.count() > 0 ) {
+         verify_strand_in_this_thread( strand, __func__, __LINE__ );
+         // messages queued while a write is in progress go out together with the next write anyway
+         if( !flush_timer_armed && buffer_queue.ready_to_send() ) {
+            flush_timer_armed = true;
+            flush_timer.expires_from_now( my_impl->trx_flush_window );
+            flush_timer.async_wait( boost::asio::bind_executor( strand, [c = shared_from_this()]( boost::system::error_code ) {
+               c->flush_timer_armed = false;
+               c->do_queue_write();
+            } ) );
+         }
+         return;
+      }
       do_queue_write();
    }
 
@@ -1387,6 +1575,62 @@ namespace eosio {
       }
    };
 
+   struct compact_block_buffer_factory : public buffer_factory {
+
+      /// caches result for subsequent calls, only provide same signed_block_ptr instance for each invocation
+      const send_buffer_type& get_send_buffer( const signed_block_ptr& sb ) {
+         if( !send_buffer ) {
+            send_buffer = create_send_buffer( sb );
+         }
+         return send_buffer;
+      }
+
+   private:
+
+      static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_ptr& sb ) {
+         static_assert( compact_block_which == fc::get_index<net_message, compact_block_message>() );
+         compact_block_message cb{ static_cast<const signed_block_header&>( *sb ), sb->prune_state };
+         cb.transactions.reserve( sb->transactions.size() );
+         for( const auto& receipt : sb->transactions ) {
+            if( std::holds_alternative<packed_transaction>( receipt.trx ) ) {
+               const auto& id = std::get<packed_transaction>( receipt.trx ).id();
+               cb.transactions.push_back( { receipt, compact_trx_pool::short_id( id ) } );
+            } else {
+               cb.transactions.push_back( { receipt, std::get<transaction_id_type>( receipt.trx ) } );
+            }
+         }
+         cb.block_extensions = sb->block_extensions;
+         fc_dlog( logger, "sending compact block ${bn}", ("bn", sb->block_num()) );
+         return buffer_factory::create_send_buffer( compact_block_which, cb );
+      }
+   };
+
+   struct compressed_block_buffer_factory : public buffer_factory {
+
+      /// caches result for subsequent calls, only provide same signed_block_ptr instance and codec for each invocation
+      const send_buffer_type& get_send_buffer( const signed_block_ptr& sb, compression_type codec ) {
+         if( !send_buffer ) {
+            send_buffer = create_send_buffer( sb, codec );
+         }
+         return send_buffer;
+      }
+
+   private:
+
+      static std::shared_ptr<std::vector<char>> create_send_buffer( const signed_block_ptr& sb, compression_type codec ) {
+         static_assert( compressed_block_which == fc::get_index<net_message, compressed_block_message>() );
+         EOS_ASSERT( codec == compression_type::zstd, plugin_exception, "unsupported compression ${c}", ("c", static_cast<uint8_t>(codec)) );
+         const auto packed = fc::raw::pack( *sb );
+         compressed_block_message cb{ codec };
+         cb.data.resize( ZSTD_compressBound( packed.size() ) );
+         const size_t size = ZSTD_compress( cb.data.data(), cb.data.size(), packed.data(), packed.size(), def_sync_compression_level );
+         EOS_ASSERT( !ZSTD_isError( size ), plugin_exception, "zstd compression failed: ${e}", ("e", ZSTD_getErrorName( size )) );
+         cb.data.resize( size );
+         fc_dlog( logger, "sending compressed block ${bn}, ${s} of ${p} bytes", ("bn", sb->block_num())("s", size)("p", packed.size()) );
+         return buffer_factory::create_send_buffer( compressed_block_which, cb );
+      }
+   };
+
    struct trx_buffer_factory : public buffer_factory {
 
       /// caches result for subsequent calls, only provide same packed_transaction_ptr instance for each invocation.
@@ -1450,6 +1694,12 @@ namespace eosio {
       fc_dlog( logger, "enqueue block ${num}", ("num", b->block_num()) );
       verify_strand_in_this_thread( strand, __func__, __LINE__ );
 
+      const compression_type codec = peer_sync_compression;
+      if( to_sync_queue && codec != compression_type::none ) {
+         enqueue_buffer( my_impl->dispatcher->get_compressed_block_buffer( b, codec ), no_reason, to_sync_queue );
+         return;
+      }
+
       block_buffer_factory buff_factory;
       auto sb = buff_factory.get_send_buffer( b, protocol_version.load() );
       if( !sb ) {
@@ -1466,18 +1716,22 @@ namespace eosio {
                                     go_away_reason close_after_send,
                                     bool to_sync_queue)
    {
-      connection_ptr self = shared_from_this();
-      queue_write(send_buffer,
-            [conn{std::move(self)}, close_after_send](boost::system::error_code ec, std::size_t ) {
+      std::function<void(boost::system::error_code, std::size_t)> callback;
+      if (close_after_send != no_reason) {
+         callback = [conn{shared_from_this()}, close_after_send](boost::system::error_code ec, std::size_t ) {
                         if (ec) return;
-                        if (close_after_send != no_reason) {
-                           fc_ilog( logger, "sent a go away message: ${r}, closing connection to ${p}",
-                                    ("r", reason_str(close_after_send))("p", conn->peer_name()) );
-                           conn->close();
-                           return;
-                        }
-                  },
-                  to_sync_queue);
+                        fc_ilog( logger, "sent a go away message: ${r}, closing connection to ${p}",
+                                 ("r", reason_str(close_after_send))("p", conn->peer_name()) );
+                        conn->close();
+                  };
+      }
+      queue_write(send_buffer, std::move(callback), to_sync_queue);
+   }
+
+   // called from connection strand
+   void connection::enqueue_trx_buffer( const std::shared_ptr<std::vector<char>>& send_buffer ) {
+      // transactions may wait up to p2p-trx-flush-window-us to be sent with the ones following them in one write
+      queue_write( send_buffer, {}, false, true );
    }
 
    // thread safe
@@ -1578,11 +1832,12 @@ namespace eosio {
    }
    //-----------------------------------------------------------
 
-    sync_manager::sync_manager( uint32_t req_span )
+    sync_manager::sync_manager( uint32_t req_span, uint32_t spans_in_flight )
       :sync_known_lib_num( 0 )
       ,sync_last_requested_num( 0 )
       ,sync_next_expected_num( 1 )
       ,sync_req_span( req_span )
+      ,sync_spans_in_flight( std::max<uint32_t>( spans_in_flight, 1 ) )
       ,sync_source()
       ,sync_state(in_sync)
    {
@@ -1617,6 +1872,8 @@ namespace eosio {
          if( c->last_handshake_recv.last_irreversible_block_num > sync_known_lib_num ) {
             sync_known_lib_num = c->last_handshake_recv.last_irreversible_block_num;
          }
+      } else if( pipelined() ) {
+         reassign_spans( c );
       } else if( c == sync_source ) {
          sync_last_requested_num = 0;
          request_next_chunk( std::move(g) );
@@ -1726,6 +1983,178 @@ namespace eosio {
       }
    }
 
+   // call with g_sync locked
+   void sync_manager::request_spans( std::unique_lock<std::mutex> g_sync ) {
+      if( sync_spans.empty() ) {
+         sync_last_requested_num = sync_next_expected_num - 1;
+      }
+
+      fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, spans: ${n}",
+               ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("n", sync_spans.size()) );
+
+      std::vector<sync_span> requests;
+      while( sync_spans.size() < sync_spans_in_flight && sync_last_requested_num < sync_known_lib_num ) {
+         const uint32_t start = sync_last_requested_num + 1;
+         const uint32_t end = std::min( start + sync_req_span - 1, sync_known_lib_num );
+         connection_ptr c = select_span_source( end, connection_ptr() );
+         if( !c ) break;
+         sync_spans.push_back( { start, end, c } );
+         requests.push_back( sync_spans.back() );
+         sync_last_requested_num = end;
+      }
+
+      if( sync_spans.empty() && sync_last_requested_num < sync_known_lib_num ) {
+         fc_elog( logger, "Unable to continue syncing at this time");
+         uint32_t lib_block_num = 0;
+         std::tie( lib_block_num, std::ignore, std::ignore,
+                   std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
+         sync_known_lib_num = lib_block_num;
+         sync_last_requested_num = 0;
+         reset_pipeline();
+         set_state( in_sync ); // probably not, but we can't do anything else
+         return;
+      }
+      g_sync.unlock();
+
+      for( const auto& r : requests ) {
+         r.source->strand.post( [c = r.source, start = r.start, end = r.end]() {
+            fc_ilog( logger, "requesting range ${s} to ${e}, from ${n}", ("n", c->peer_name())( "s", start )( "e", end ) );
+            c->request_sync_blocks( start, end );
+         } );
+      }
+   }
+
+   // call with sync_mtx locked, a current peer with the blocks up to end which is not sending a span yet
+   connection_ptr sync_manager::select_span_source( uint32_t end, const connection_ptr& exclude ) const {
+      std::shared_lock<std::shared_mutex> g( my_impl->connections_mtx );
+      for( const auto& c : my_impl->connections ) {
+         if( c == exclude || c->is_transactions_only_connection() || !c->current() ) continue;
+         auto busy = std::find_if( sync_spans.begin(), sync_spans.end(), [&c]( const sync_span& s ) {
+            return s.source == c && !s.received;
+         } );
+         if( busy != sync_spans.end() ) continue;
+         std::lock_guard<std::mutex> g_conn( c->conn_mtx );
+         if( c->last_handshake_recv.last_irreversible_block_num >= end ) {
+            return c;
+         }
+      }
+      return connection_ptr();
+   }
+
+   // call with sync_mtx locked, requests the missing blocks of the spans c did not finish from other peers
+   void sync_manager::reassign_spans( const connection_ptr& c ) {
+      for( auto& s : sync_spans ) {
+         if( s.source != c || s.received ) continue;
+         connection_ptr next = select_span_source( s.end, c );
+         if( !next && c->current() ) {
+            next = c; // no other peer has the blocks, give the source another chance
+         }
+         if( !next ) {
+            fc_elog( logger, "Unable to continue syncing at this time");
+            sync_last_requested_num = 0;
+            reset_pipeline();
+            set_state( in_sync );
+            return;
+         }
+         s.source = next;
+         const uint32_t start = std::max( s.start, sync_next_expected_num );
+         next->strand.post( [next, start, end = s.end]() {
+            fc_ilog( logger, "reassigned range ${s} to ${e} to ${n}", ("n", next->peer_name())( "s", start )( "e", end ) );
+            next->request_sync_blocks( start, end );
+         } );
+      }
+   }
+
+   // call with sync_mtx locked, passes the consecutive blocks from sync_next_expected_num on to the controller
+   void sync_manager::release_sync_blocks() {
+      const uint32_t start_num = sync_next_expected_num;
+      for( auto itr = sync_window.begin(); itr != sync_window.end() && itr->first <= sync_next_expected_num; itr = sync_window.erase( itr ) ) {
+         if( itr->first < sync_next_expected_num ) continue;
+         if( itr->second.block ) {
+            // posted under sync_mtx so blocks released by different threads stay in order
+            app().post( priority::medium, [b = std::move( itr->second )]() mutable {
+               b.source->process_signed_block( b.id, std::move( b.block ), b.trx_lookup );
+            } );
+         }
+         ++sync_next_expected_num;
+      }
+      if( sync_next_expected_num != start_num ) {
+         sync_last_progress = std::chrono::steady_clock::now();
+      }
+      while( !sync_spans.empty() && sync_spans.front().end < sync_next_expected_num ) {
+         sync_spans.pop_front();
+      }
+   }
+
+   // call with sync_mtx locked
+   void sync_manager::reset_pipeline() {
+      sync_spans.clear();
+      sync_window.clear();
+      sync_last_progress = std::chrono::steady_clock::now();
+   }
+
+   // call with sync_mtx locked, @return true if blk_num is the last block of a span c is sending
+   bool sync_manager::span_received( const connection_ptr& c, uint32_t blk_num ) {
+      bool last_of_span = false;
+      for( auto& s : sync_spans ) {
+         if( s.source == c && !s.received && blk_num == s.end ) {
+            s.received = true;
+            last_of_span = true;
+         }
+      }
+      return last_of_span;
+   }
+
+   // called from the expire timer, requests the span holding sync_next_expected_num again when no block was passed on
+   // to the controller for a response period, its source may have finished the span with blocks missing from the window
+   void sync_manager::check_stalled_span() {
+      if( !pipelined() || sync_state != lib_catchup ) return;
+      std::lock_guard<std::mutex> g( sync_mtx );
+      const auto now = std::chrono::steady_clock::now();
+      if( sync_spans.empty() || now - sync_last_progress < my_impl->resp_expected_period ) {
+         return;
+      }
+      sync_last_progress = now;
+
+      auto s = std::find_if( sync_spans.begin(), sync_spans.end(), [this]( const sync_span& span ) {
+         return span.end >= sync_next_expected_num;
+      } );
+      if( s == sync_spans.end() ) return;
+      connection_ptr next = select_span_source( s->end, connection_ptr() );
+      if( !next && s->source->current() ) {
+         next = s->source;
+      }
+      if( !next ) return;
+      s->source = next;
+      s->received = false;
+      const uint32_t start = std::max( s->start, sync_next_expected_num );
+      fc_ilog( logger, "sync stalled at block ${n}, requesting range ${s} to ${e} again", ("n", sync_next_expected_num)("s", start)("e", s->end) );
+      next->strand.post( [next, start, end = s->end]() {
+         next->request_sync_blocks( start, end );
+      } );
+   }
+
+   // called from connection strand, returns true if the block is passed on to the controller in order by the sync_manager
+   bool sync_manager::sync_reorder_block( const connection_ptr& c, const block_id_type& blk_id, const signed_block_ptr& b,
+                                          const trx_meta_cache_lookup& trx_lookup ) {
+      if( !pipelined() || sync_state != lib_catchup ) return false;
+      const uint32_t blk_num = b->block_num();
+      std::lock_guard<std::mutex> g( sync_mtx );
+      if( sync_spans.empty() || blk_num < sync_next_expected_num || blk_num > sync_last_requested_num ) {
+         return false;
+      }
+
+      if( span_received( c, blk_num ) ) {
+         c->cancel_wait();
+      } else {
+         c->sync_wait();
+      }
+
+      sync_window.emplace( blk_num, sync_block{ blk_id, b, c, trx_lookup } );
+      release_sync_blocks();
+      return true;
+   }
+
    // static, thread safe
    void sync_manager::send_handshakes() {
       for_each_connection( []( auto& ci ) {
@@ -1764,13 +2193,19 @@ namespace eosio {
 
       if( sync_state == in_sync ) {
          set_state( lib_catchup );
+         reset_pipeline();
+         sync_restart_num = 0;
       }
       sync_next_expected_num = std::max( lib_num + 1, sync_next_expected_num );
 
       fc_ilog( logger, "Catching up with chain, our last req is ${cc}, theirs is ${t} peer ${p}",
                ("cc", sync_last_requested_num)( "t", target )( "p", c->peer_name() ) );
 
-      request_next_chunk( std::move( g_sync ), c );
+      if( pipelined() ) {
+         request_spans( std::move( g_sync ) );
+      } else {
+         request_next_chunk( std::move( g_sync ), c );
+      }
    }
 
    // called from connection strand
@@ -1779,7 +2214,15 @@ namespace eosio {
       fc_ilog( logger, "reassign_fetch, our last req is ${cc}, next expected is ${ne} peer ${p}",
                ("cc", sync_last_requested_num)( "ne", sync_next_expected_num )( "p", c->peer_name() ) );
 
-      if( c == sync_source ) {
+      if( pipelined() ) {
+         auto stalled = std::find_if( sync_spans.begin(), sync_spans.end(), [&c]( const sync_span& s ) {
+            return s.source == c && !s.received;
+         } );
+         if( stalled != sync_spans.end() ) {
+            c->cancel_sync(reason);
+            reassign_spans( c );
+         }
+      } else if( c == sync_source ) {
          c->cancel_sync(reason);
          sync_last_requested_num = 0;
          request_next_chunk( std::move(g) );
@@ -1968,18 +2411,47 @@ namespace eosio {
       if( c->block_status_monitor_.max_events_violated()) {
          fc_wlog( logger, "block ${bn} not accepted from ${p}, closing connection", ("bn", blk_num)("p", c->peer_name()) );
          std::unique_lock<std::mutex> g( sync_mtx );
-         sync_last_requested_num = 0;
+         if( !pipelined() ) {
+            sync_last_requested_num = 0;
+         }
          sync_source.reset();
          g.unlock();
          c->close();
       } else {
          c->send_handshake( true );
       }
+
+      std::unique_lock<std::mutex> g( sync_mtx );
+      // blocks released before the restart are rejected as well, they are above the block that caused the restart
+      if( pipelined() && sync_state == lib_catchup && blk_num < sync_next_expected_num &&
+          ( sync_restart_num == 0 || blk_num < sync_restart_num ) ) {
+         // the blocks after it cannot link either, request them again from the first one missing from the fork database
+         uint32_t fork_head_num = 0;
+         std::tie( std::ignore, std::ignore, fork_head_num,
+                   std::ignore, std::ignore, std::ignore ) = my_impl->get_chain_info();
+         fc_ilog( logger, "restarting sync pipeline at block ${n} after rejected block ${bn}",
+                  ("n", std::min( blk_num, fork_head_num + 1 ))("bn", blk_num) );
+         reset_pipeline();
+         sync_restart_num = blk_num;
+         sync_next_expected_num = std::min( blk_num, fork_head_num + 1 );
+         request_spans( std::move( g ) );
+      }
    }
 
    // called from connection strand
    void sync_manager::sync_update_expected( const connection_ptr& c, const block_id_type& blk_id, uint32_t blk_num, bool blk_applied ) {
       std::unique_lock<std::mutex> g_sync( sync_mtx );
+      if( pipelined() ) {
+         if( blk_applied ) {
+            if( blk_num >= sync_restart_num ) sync_restart_num = 0;
+         } else if( !sync_spans.empty() && blk_num >= sync_next_expected_num && blk_num <= sync_last_requested_num ) {
+            // a block which does not enter the window because it is already known, hold its place so the blocks after it are released
+            span_received( c, blk_num );
+            sync_window.emplace( blk_num, sync_block{ blk_id, signed_block_ptr(), c, trx_meta_cache_lookup() } );
+            release_sync_blocks();
+         }
+         return;
+      }
       if( blk_num <= sync_last_requested_num ) {
          fc_dlog( logger, "sync_last_requested_num: ${r}, sync_next_expected_num: ${e}, sync_known_lib_num: ${k}, sync_req_span: ${s}",
                   ("r", sync_last_requested_num)("e", sync_next_expected_num)("k", sync_known_lib_num)("s", sync_req_span) );
@@ -2042,8 +2514,11 @@ namespace eosio {
          if( blk_num == sync_known_lib_num ) {
             fc_dlog( logger, "All caught up with last known last irreversible block resending handshake" );
             set_state( in_sync );
+            reset_pipeline();
             g_sync.unlock();
             send_handshakes();
+         } else if( pipelined() ) {
+            request_spans( std::move( g_sync ) );
          } else if( blk_num == sync_last_requested_num ) {
             request_next_chunk( std::move( g_sync) );
          } else {
@@ -2054,125 +2529,321 @@ namespace eosio {
       }
    }
 
+   node_transaction_index::node_transaction_index() {
+      const uint32_t now = time_point_sec( time_point::now() ).sec_since_epoch();
+      for( auto& s : shards ) {
+         s.next_expiry_sec = now;
+      }
+   }
+
+   void node_transaction_index::shard::add_to_wheel( const transaction_id_type& tid, time_point_sec expires ) {
+      // already expired transactions go to the slot drained next
+      const uint32_t sec = std::max( expires.sec_since_epoch(), next_expiry_sec );
+      expiry_wheel[sec % wheel_slots].push_back( tid );
+   }
+
+   bool node_transaction_index::add_peer_txn( const node_transaction_state& nts ) {
+      auto& s = shard_of( nts.id );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto [itr, inserted] = s.txns.try_emplace( nts.id );
+      auto& state = itr->second;
+      if( inserted ) {
+         state.expires = nts.expires;
+         s.add_to_wheel( nts.id, nts.expires );
+         if( nts.block_num ) {
+            state.block_num = nts.block_num;
+            s.by_block_num[nts.block_num].push_back( nts.id );
+         }
+      } else if( std::find( state.connection_ids.begin(), state.connection_ids.end(), nts.connection_id ) != state.connection_ids.end() ) {
+         return false;
+      }
+      state.connection_ids.push_back( nts.connection_id );
+      return true;
+   }
+
+   bool node_transaction_index::add_peer_txn_if_known( const transaction_id_type& tid, uint32_t connection_id ) {
+      auto& s = shard_of( tid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.txns.find( tid );
+      if( itr == s.txns.end() ) return false;
+      auto& ids = itr->second.connection_ids;
+      if( std::find( ids.begin(), ids.end(), connection_id ) == ids.end() ) {
+         ids.push_back( connection_id );
+      }
+      return true;
+   }
+
+   void node_transaction_index::update_block_num( const transaction_id_type& tid, uint32_t blk_num ) {
+      auto& s = shard_of( tid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.txns.find( tid );
+      if( itr == s.txns.end() || itr->second.block_num == blk_num ) return;
+      itr->second.block_num = blk_num;
+      if( blk_num ) {
+         s.by_block_num[blk_num].push_back( tid );
+      }
+   }
+
+   bool node_transaction_index::peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const {
+      const auto& s = shard_of( tid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.txns.find( tid );
+      if( itr == s.txns.end() ) return false;
+      const auto& ids = itr->second.connection_ids;
+      return std::find( ids.begin(), ids.end(), connection_id ) != ids.end();
+   }
+
+   bool node_transaction_index::have_txn( const transaction_id_type& tid ) const {
+      const auto& s = shard_of( tid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      return s.txns.find( tid ) != s.txns.end();
+   }
+
+   size_t node_transaction_index::expire( time_point_sec now, uint32_t lib_num ) {
+      const uint32_t now_sec = now.sec_since_epoch();
+      size_t removed = 0;
+      vector<transaction_id_type> not_expired;
+      // one shard at a time, allowing other threads to use the remaining shards
+      for( auto& s : shards ) {
+         std::lock_guard<std::mutex> g( s.mtx );
+         const size_t start_size = s.txns.size();
+
+         if( s.next_expiry_sec <= now_sec ) {
+            // a slot is drained at most once per call, even if the wheel was not turned for more than a revolution
+            const uint32_t last_sec = std::min<uint64_t>( now_sec, uint64_t(s.next_expiry_sec) + wheel_slots - 1 );
+            for( uint32_t sec = s.next_expiry_sec; sec <= last_sec; ++sec ) {
+               auto& slot = s.expiry_wheel[sec % wheel_slots];
+               for( const auto& tid : slot ) {
+                  auto itr = s.txns.find( tid );
+                  if( itr == s.txns.end() ) continue;
+                  const uint32_t expires = itr->second.expires.sec_since_epoch();
+                  if( expires <= now_sec ) {
+                     s.txns.erase( itr );
+                  } else if( expires % wheel_slots == sec % wheel_slots ) {
+                     not_expired.push_back( tid ); // more than a revolution ahead
+                  }
+               }
+               slot.swap( not_expired );
+               not_expired.clear();
+            }
+            s.next_expiry_sec = now_sec + 1;
+         }
+
+         auto end = s.by_block_num.upper_bound( lib_num );
+         for( auto itr = s.by_block_num.begin(); itr != end; ++itr ) {
+            for( const auto& tid : itr->second ) {
+               auto t = s.txns.find( tid );
+               if( t != s.txns.end() && t->second.block_num == itr->first ) {
+                  s.txns.erase( t );
+               }
+            }
+         }
+         s.by_block_num.erase( s.by_block_num.begin(), end );
+
+         removed += start_size - s.txns.size();
+      }
+      return removed;
+   }
+
+   size_t node_transaction_index::size() const {
+      size_t result = 0;
+      for( const auto& s : shards ) {
+         std::lock_guard<std::mutex> g( s.mtx );
+         result += s.txns.size();
+      }
+      return result;
+   }
+
+   bool peer_block_state_index::add_peer_block( const block_id_type& blkid, uint32_t connection_id ) {
+      auto& s = shard_of( blkid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto [itr, inserted] = s.blocks.try_emplace( blkid );
+      if( inserted ) {
+         s.by_block_num[block_header::num_from_id( blkid )].push_back( blkid );
+      } else if( std::find( itr->second.begin(), itr->second.end(), connection_id ) != itr->second.end() ) {
+         return false;
+      }
+      itr->second.push_back( connection_id );
+      return true;
+   }
+
+   bool peer_block_state_index::peer_has_block( const block_id_type& blkid, uint32_t connection_id ) const {
+      const auto& s = shard_of( blkid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.blocks.find( blkid );
+      return itr != s.blocks.end() && std::find( itr->second.begin(), itr->second.end(), connection_id ) != itr->second.end();
+   }
+
+   bool peer_block_state_index::have_block( const block_id_type& blkid ) const {
+      const auto& s = shard_of( blkid );
+      std::lock_guard<std::mutex> g( s.mtx );
+      return s.blocks.find( blkid ) != s.blocks.end();
+   }
+
+   void peer_block_state_index::expire( uint32_t lib_num ) {
+      for( auto& s : shards ) {
+         std::lock_guard<std::mutex> g( s.mtx );
+         auto end = s.by_block_num.upper_bound( lib_num );
+         for( auto itr = s.by_block_num.begin(); itr != end; ++itr ) {
+            for( const auto& blkid : itr->second ) {
+               s.blocks.erase( blkid );
+            }
+         }
+         s.by_block_num.erase( s.by_block_num.begin(), end );
+      }
+   }
+
+   void compact_trx_pool::shard::erase( std::unordered_map<short_trx_id, packed_transaction_ptr>::iterator itr ) {
+      auto range = by_expiry.equal_range( itr->second->expiration() );
+      for( auto e = range.first; e != range.second; ++e ) {
+         if( e->second == itr->first ) {
+            by_expiry.erase( e );
+            break;
+         }
+      }
+      trxs.erase( itr );
+   }
+
+   void compact_trx_pool::add( const packed_transaction_ptr& trx ) {
+      const short_trx_id id = short_id( trx->id() );
+      auto& s = shard_of( id );
+      std::lock_guard<std::mutex> g( s.mtx );
+      if( s.trxs.count( id ) ) return;
+      if( s.trxs.size() >= def_compact_trx_pool_size / shard_count ) {
+         s.erase( s.trxs.find( s.by_expiry.begin()->second ) );
+      }
+      s.trxs.emplace( id, trx );
+      s.by_expiry.emplace( trx->expiration(), id );
+   }
+
+   packed_transaction_ptr compact_trx_pool::find( short_trx_id id ) const {
+      const auto& s = shard_of( id );
+      std::lock_guard<std::mutex> g( s.mtx );
+      auto itr = s.trxs.find( id );
+      return itr != s.trxs.end() ? itr->second : packed_transaction_ptr();
+   }
+
+   void compact_trx_pool::remove_block_trxs( const signed_block& b ) {
+      for( const auto& receipt : b.transactions ) {
+         if( !std::holds_alternative<packed_transaction>( receipt.trx ) ) continue;
+         const auto& tid = std::get<packed_transaction>( receipt.trx ).id();
+         auto& s = shard_of( short_id( tid ) );
+         std::lock_guard<std::mutex> g( s.mtx );
+         auto itr = s.trxs.find( short_id( tid ) );
+         if( itr != s.trxs.end() && itr->second->id() == tid ) {
+            s.erase( itr );
+         }
+      }
+   }
+
+   size_t compact_trx_pool::expire( time_point_sec now ) {
+      size_t removed = 0;
+      for( auto& s : shards ) {
+         std::lock_guard<std::mutex> g( s.mtx );
+         auto end = s.by_expiry.upper_bound( now );
+         for( auto itr = s.by_expiry.begin(); itr != end; ++itr ) {
+            s.trxs.erase( itr->second );
+            ++removed;
+         }
+         s.by_expiry.erase( s.by_expiry.begin(), end );
+      }
+      return removed;
+   }
+
    //------------------------------------------------------------------------
 
    // thread safe
    bool dispatch_manager::add_peer_block( const block_id_type& blkid, uint32_t connection_id) {
-      std::lock_guard<std::mutex> g( blk_state_mtx );
-      auto bptr = blk_state.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
-      bool added = (bptr == blk_state.end());
-      if( added ) {
-         blk_state.insert( {blkid, block_header::num_from_id( blkid ), connection_id, true} );
-      } else if( !bptr->have_block ) {
-         blk_state.modify( bptr, []( auto& pb ) {
-            pb.have_block = true;
-         });
-      }
-      return added;
+      return blk_state.add_peer_block( blkid, connection_id );
    }
 
    bool dispatch_manager::peer_has_block( const block_id_type& blkid, uint32_t connection_id ) const {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
-      const auto blk_itr = blk_state.get<by_id>().find( std::make_tuple( connection_id, std::ref( blkid )));
-      return blk_itr != blk_state.end();
+      return blk_state.peer_has_block( blkid, connection_id );
    }
 
    bool dispatch_manager::have_block( const block_id_type& blkid ) const {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
-      // by_peer_block_id sorts have_block by greater so have_block == true will be the first one found
-      const auto& index = blk_state.get<by_peer_block_id>();
-      auto blk_itr = index.find( blkid );
-      if( blk_itr != index.end() ) {
-         return blk_itr->have_block;
-      }
-      return false;
+      return blk_state.have_block( blkid );
    }
 
    bool dispatch_manager::add_peer_txn( const node_transaction_state& nts ) {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( nts.id ), nts.connection_id ) );
-      bool added = (tptr == local_txns.end());
-      if( added ) {
-         local_txns.insert( nts );
-      }
-      return added;
+      return local_txns.add_peer_txn( nts );
    }
 
    // only adds if tid already exists, returns have_txn( tid )
    bool dispatch_manager::add_peer_txn( const transaction_id_type& tid, uint32_t connection_id ) {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto tptr = local_txns.get<by_id>().find( tid );
-      if( tptr == local_txns.end() ) return false;
-      const auto expiration = tptr->expires;
-
-      tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
-      if( tptr == local_txns.end() ) {
-         local_txns.insert( node_transaction_state{tid, expiration, 0, connection_id} );
-      }
-      return true;
+      return local_txns.add_peer_txn_if_known( tid, connection_id );
    }
 
 
    // thread safe
    void dispatch_manager::update_txns_block_num( const signed_block_ptr& sb ) {
-      update_block_num ubn( sb->block_num() );
-      std::lock_guard<std::mutex> g( local_txns_mtx );
+      const auto blk_num = sb->block_num();
       for( const auto& recpt : sb->transactions ) {
          const transaction_id_type& id = (recpt.trx.index() == 0) ? std::get<transaction_id_type>(recpt.trx)
                                                                   : std::get<packed_transaction>(recpt.trx).id();
-         auto range = local_txns.get<by_id>().equal_range( id );
-         for( auto itr = range.first; itr != range.second; ++itr ) {
-            local_txns.modify( itr, ubn );
-         }
+         local_txns.update_block_num( id, blk_num );
       }
    }
 
    // thread safe
    void dispatch_manager::update_txns_block_num( const transaction_id_type& id, uint32_t blk_num ) {
-      update_block_num ubn( blk_num );
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      auto range = local_txns.get<by_id>().equal_range( id );
-      for( auto itr = range.first; itr != range.second; ++itr ) {
-         local_txns.modify( itr, ubn );
-      }
+      local_txns.update_block_num( id, blk_num );
    }
 
    bool dispatch_manager::peer_has_txn( const transaction_id_type& tid, uint32_t connection_id ) const {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( std::make_tuple( std::ref( tid ), connection_id ) );
-      return tptr != local_txns.end();
+      return local_txns.peer_has_txn( tid, connection_id );
    }
 
    bool dispatch_manager::have_txn( const transaction_id_type& tid ) const {
-      std::lock_guard<std::mutex> g( local_txns_mtx );
-      const auto tptr = local_txns.get<by_id>().find( tid );
-      return tptr != local_txns.end();
+      return local_txns.have_txn( tid );
    }
 
    void dispatch_manager::expire_txns( uint32_t lib_num ) {
-      size_t start_size = 0, end_size = 0;
-
-      std::unique_lock<std::mutex> g( local_txns_mtx );
-      start_size = local_txns.size();
-      auto& old = local_txns.get<by_expiry>();
-      auto ex_lo = old.lower_bound( fc::time_point_sec( 0 ) );
-      auto ex_up = old.upper_bound( time_point::now() );
-      old.erase( ex_lo, ex_up );
-      g.unlock(); // allow other threads opportunity to use local_txns
-
-      g.lock();
-      auto& stale = local_txns.get<by_block_num>();
-      stale.erase( stale.lower_bound( 1 ), stale.upper_bound( lib_num ) );
-      end_size = local_txns.size();
-      g.unlock();
+      const size_t removed = local_txns.expire( time_point::now(), lib_num );
+      fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", local_txns.size() + removed)( "r", removed ) );
+      if( my_impl->p2p_compact_blocks ) {
+         const size_t removed_pool = trx_pool.expire( time_point::now() );
+         fc_dlog( logger, "expire compact block trx pool removed ${r}", ("r", removed_pool) );
+      }
+   }
 
-      fc_dlog( logger, "expire_local_txns size ${s} removed ${r}", ("s", start_size)( "r", start_size - end_size ) );
+   // thread safe
+   void dispatch_manager::add_pool_trx( const packed_transaction_ptr& trx ) {
+      trx_pool.add( trx );
+   }
+
+   // thread safe
+   packed_transaction_ptr dispatch_manager::find_pool_trx( short_trx_id id ) const {
+      return trx_pool.find( id );
+   }
+
+   // thread safe
+   void dispatch_manager::remove_pool_trxs( const signed_block& b ) {
+      trx_pool.remove_block_trxs( b );
+   }
+
+   // thread safe
+   std::shared_ptr<std::vector<char>> dispatch_manager::get_compressed_block_buffer( const signed_block_ptr& sb, compression_type codec ) {
+      const block_id_type id = sb->calculate_id();
+      {
+         std::lock_guard<std::mutex> g( compressed_blocks_mtx );
+         auto i = std::find_if( compressed_blocks.begin(), compressed_blocks.end(), [&id]( const auto& cb ) { return cb.id == id; } );
+         if( i != compressed_blocks.end() ) return i->buffer;
+      }
+
+      // compressed without the lock, a block asked for by two peers at once may be compressed by both
+      compressed_block_buffer_factory buff_factory;
+      auto buffer = buff_factory.get_send_buffer( sb, codec );
+      std::lock_guard<std::mutex> g( compressed_blocks_mtx );
+      if( compressed_blocks.size() >= max_compressed_blocks ) {
+         compressed_blocks.pop_front();
+      }
+      compressed_blocks.push_back( { id, buffer } );
+      return buffer;
    }
 
    void dispatch_manager::expire_blocks( uint32_t lib_num ) {
-      std::lock_guard<std::mutex> g(blk_state_mtx);
-      auto& stale_blk = blk_state.get<by_block_num>();
-      stale_blk.erase( stale_blk.lower_bound(1), stale_blk.upper_bound(lib_num) );
+      blk_state.expire( lib_num );
    }
 
    // thread safe
@@ -2182,12 +2853,16 @@ namespace eosio {
       if( my_impl->sync_master->syncing_with_peer() ) return;
 
       block_buffer_factory buff_factory;
+      compact_block_buffer_factory compact_buff_factory;
+      // the packed transactions of a pruned block cannot be rebuilt from the transactions relayed to peers
+      const bool compact = b->prune_state != signed_block::prune_state_type::incomplete;
       const auto bnum = b->block_num();
-      for_each_block_connection( [this, &id, &bnum, &b, &buff_factory]( auto& cp ) {
+      for_each_block_connection( [this, &id, &bnum, &b, &buff_factory, &compact_buff_factory, compact]( auto& cp ) {
          peer_dlog( cp, "socket_is_open ${s}, connecting ${c}, syncing ${ss}",
                     ("s", cp->socket_is_open())("c", cp->connecting.load())("ss", cp->syncing.load()) );
          if( !cp->current() ) return true;
-         send_buffer_type sb = buff_factory.get_send_buffer( b, cp->protocol_version.load() );
+         send_buffer_type sb = compact && cp->compact_blocks_requested ? compact_buff_factory.get_send_buffer( b )
+                                                                        : buff_factory.get_send_buffer( b, cp->protocol_version.load() );
          if( !sb ) {
             peer_wlog( cp, "Sending go away for incomplete block #${n} ${id}...",
                        ("n", b->block_num())("id", b->calculate_id().str().substr(8,16)) );
@@ -2239,6 +2914,10 @@ namespace eosio {
       time_point_sec trx_expiration = trx->expiration();
       node_transaction_state nts = {id, trx_expiration, 0, 0};
 
+      if( my_impl->p2p_compact_blocks ) {
+         add_pool_trx( trx );
+      }
+
       trx_buffer_factory buff_factory;
       for_each_connection( [this, &trx, &nts, &buff_factory]( auto& cp ) {
          if( cp->is_blocks_only_connection() || !cp->current() ) {
@@ -2253,7 +2932,7 @@ namespace eosio {
          if( !sb ) return true;
          cp->strand.post( [cp, sb{std::move(sb)}]() {
             fc_dlog( logger, "sending trx to ${n}", ("n", cp->peer_name()) );
-            cp->enqueue_buffer( sb, no_reason );
+            cp->enqueue_trx_buffer( sb );
          } );
          return true;
       } );
@@ -2661,18 +3340,38 @@ namespace eosio {
       fc::raw::unpack( peek_ds, bh );
 
       const block_id_type blk_id = bh.calculate_id();
+      if( !is_block_wanted( blk_id, bh ) ) {
+         pending_message_buffer.advance_read_ptr( message_length );
+         return true;
+      }
+
+      auto ds = pending_message_buffer.create_datastream();
+      fc::raw::unpack( ds, which );
+      shared_ptr<signed_block> ptr;
+      if( which == signed_block_which ) {
+         ptr = std::make_shared<signed_block>();
+         fc::raw::unpack( ds, *ptr );
+      } else {
+         signed_block_v0 sb_v0;
+         fc::raw::unpack( ds, sb_v0 );
+         ptr = std::make_shared<signed_block>( std::move( sb_v0 ), true );
+      }
+
+      return accept_signed_block( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand, @return false if the block is skipped
+   bool connection::is_block_wanted( const block_id_type& blk_id, const block_header& bh ) {
       const uint32_t blk_num = bh.block_num();
       if( my_impl->dispatcher->have_block( blk_id ) ) {
          fc_dlog( logger, "canceling wait on ${p}, already received block ${num}, id ${id}...",
                   ("p", peer_name())("num", blk_num)("id", blk_id.str().substr(8,16)) );
          my_impl->sync_master->sync_recv_block( shared_from_this(), blk_id, blk_num, false );
          cancel_wait();
-
-         pending_message_buffer.advance_read_ptr( message_length );
-         return true;
+         return false;
       }
       fc_dlog( logger, "${p} received block ${num}, id ${id}..., latency: ${latency}",
-               ("p", peer_name())("num", bh.block_num())("id", blk_id.str().substr(8,16))
+               ("p", peer_name())("num", blk_num)("id", blk_id.str().substr(8,16))
                      ("latency", (fc::time_point::now() - bh.timestamp).count()/1000) );
       if( !my_impl->sync_master->syncing_with_peer() ) { // guard against peer thinking it needs to send us old blocks
          uint32_t lib = 0;
@@ -2690,24 +3389,14 @@ namespace eosio {
                send_handshake();
                cancel_wait();
             }
-
-            pending_message_buffer.advance_read_ptr( message_length );
-            return true;
+            return false;
          }
       }
+      return true;
+   }
 
-      auto ds = pending_message_buffer.create_datastream();
-      fc::raw::unpack( ds, which );
-      shared_ptr<signed_block> ptr;
-      if( which == signed_block_which ) {
-         ptr = std::make_shared<signed_block>();
-         fc::raw::unpack( ds, *ptr );
-      } else {
-         signed_block_v0 sb_v0;
-         fc::raw::unpack( ds, sb_v0 );
-         ptr = std::make_shared<signed_block>( std::move( sb_v0 ), true );
-      }
-
+   // called from connection strand
+   bool connection::accept_signed_block( const block_id_type& blk_id, signed_block_ptr ptr ) {
       auto is_webauthn_sig = []( const fc::crypto::signature& s ) {
          return s.which() == fc::get_index<fc::crypto::signature::storage_type, fc::crypto::webauthn::signature>();
       };
@@ -2808,6 +3497,9 @@ namespace eosio {
          return true;
       }
 
+      if( my_impl->p2p_compact_blocks ) {
+         my_impl->dispatcher->add_pool_trx( ptr );
+      }
       handle_message( std::move( ptr ) );
       return true;
    }
@@ -2835,6 +3527,29 @@ namespace eosio {
             chain_lib_id, chain_head_blk_id, chain_fork_head_blk_id );
    }
 
+   // thread safe, starts recovering the keys of the transactions of a block on the net thread pool
+   trx_meta_cache_lookup net_plugin_impl::start_recover_keys( const signed_block_ptr& b ) {
+      auto trxs = std::make_shared<std::unordered_map<transaction_id_type, std::shared_future<transaction_metadata_ptr>>>();
+      trxs->reserve( b->transactions.size() );
+      for( const auto& receipt : b->transactions ) {
+         if( std::holds_alternative<packed_transaction>( receipt.trx ) ) {
+            const auto& pt = std::get<packed_transaction>( receipt.trx );
+            packed_transaction_ptr ptrx( b, &pt ); // alias signed_block_ptr
+            trxs->emplace( pt.id(), transaction_metadata::start_recover_keys(
+                  std::move( ptrx ), thread_pool->get_executor(), chain_id, fc::microseconds::maximum() ).share() );
+         }
+      }
+      return [trxs]( const transaction_id_type& id ) -> transaction_metadata_ptr {
+         auto itr = trxs->find( id );
+         if( itr == trxs->end() ) return {};
+         try {
+            return itr->second.get();
+         } catch( ... ) {
+            return {}; // recovered again by the controller, which reports the failure
+         }
+      };
+   }
+
    bool connection::is_valid( const handshake_message& msg ) {
       // Do some basic validation of an incoming handshake_message, so things
       // that really aren't handshake messages can be quickly discarded without
@@ -2968,6 +3683,15 @@ namespace eosio {
             return;
          }
 
+         if( my_impl->p2p_compact_blocks && protocol_version >= proto_compact_blocks && !compact_blocks_subscribed ) {
+            compact_blocks_subscribed = true;
+            enqueue( compact_block_request_message{} );
+         }
+         if( my_impl->sync_compression != compression_type::none && protocol_version >= proto_sync_compression && !sync_compression_sent ) {
+            sync_compression_sent = true;
+            enqueue( sync_compression_message{ my_impl->sync_compression } );
+         }
+
          uint32_t peer_lib = msg.last_irreversible_block_num;
          connection_wptr weak = shared_from_this();
          app().post( priority::medium, [peer_lib, chain_plug = my_impl->chain_plug, weak{std::move(weak)},
@@ -3234,13 +3958,182 @@ namespace eosio {
             return;
          }
       }
-      app().post(priority::medium, [ptr{std::move(ptr)}, id, c = shared_from_this()]() mutable {
-         c->process_signed_block( id, std::move( ptr ) );
+      trx_meta_cache_lookup trx_lookup;
+      if( my_impl->sync_master->syncing_with_peer() ) {
+         // overlap key recovery with the application of the blocks queued ahead of this one
+         trx_lookup = my_impl->start_recover_keys( ptr );
+      }
+      if( my_impl->sync_master->sync_reorder_block( shared_from_this(), id, ptr, trx_lookup ) ) {
+         return;
+      }
+      app().post(priority::medium, [ptr{std::move(ptr)}, id, c = shared_from_this(), trx_lookup{std::move(trx_lookup)}]() mutable {
+         c->process_signed_block( id, std::move( ptr ), trx_lookup );
       });
    }
 
+   // called from connection strand
+   void connection::handle_message( const compact_block_message& msg ) {
+      const block_id_type blk_id = msg.header.calculate_id();
+      const uint32_t blk_num = msg.header.block_num();
+      if( !is_block_wanted( blk_id, msg.header ) ) {
+         return;
+      }
+
+      auto b = std::make_shared<signed_block>( msg.header );
+      b->prune_state = msg.prune_state;
+      b->block_extensions = msg.block_extensions;
+      std::vector<uint32_t> missing;
+      for( uint32_t i = 0; i < msg.transactions.size(); ++i ) {
+         const auto& r = msg.transactions[i];
+         b->transactions.emplace_back();
+         auto& receipt = b->transactions.back();
+         static_cast<transaction_receipt_header&>( receipt ) = r.header;
+         if( std::holds_alternative<transaction_id_type>( r.trx ) ) {
+            receipt.trx = std::get<transaction_id_type>( r.trx );
+         } else if( auto trx = my_impl->dispatcher->find_pool_trx( std::get<short_trx_id>( r.trx ) ) ) {
+            receipt.trx.emplace<packed_transaction>( *trx );
+         } else {
+            missing.push_back( i );
+         }
+      }
+
+      if( missing.empty() ) {
+         process_compact_block( blk_id, std::move( b ) );
+         return;
+      }
+      if( pending_compacts.count( blk_id ) ) {
+         return;
+      }
+      if( pending_compacts.size() >= def_max_pending_compact_blocks ) {
+         // the peer is not answering, give up on the lowest block
+         auto oldest = std::min_element( pending_compacts.begin(), pending_compacts.end(), []( const auto& a, const auto& b ) {
+            return block_header::num_from_id( a.first ) < block_header::num_from_id( b.first );
+         } );
+         peer_dlog( this, "dropping compact block #${b} ${id}... still waiting for its transactions",
+                    ("b", block_header::num_from_id( oldest->first ))("id", oldest->first.str().substr(8,16)) );
+         pending_compacts.erase( oldest );
+      }
+      peer_dlog( this, "requesting ${n} of ${t} transactions of compact block #${b} ${id}...",
+                 ("n", missing.size())("t", msg.transactions.size())("b", blk_num)("id", blk_id.str().substr(8,16)) );
+      enqueue( compact_block_request_message{ blk_id, missing } );
+      pending_compacts.emplace( blk_id, pending_compact_block{ std::move( b ), std::move( missing ) } );
+   }
+
+   // called from connection strand
+   void connection::handle_message( const compact_block_request_message& msg ) {
+      if( msg.id == block_id_type() ) {
+         peer_ilog( this, "relaying compact blocks" );
+         compact_blocks_requested = true;
+         return;
+      }
+      connection_wptr weak = shared_from_this();
+      app().post( priority::medium, [msg, weak{std::move(weak)}]() {
+         connection_ptr c = weak.lock();
+         if( !c ) return;
+         signed_block_ptr b;
+         try {
+            b = my_impl->chain_plug->chain().fetch_block_by_id( msg.id );
+         } catch( ... ) {
+            fc_elog( logger, "caught exception fetching compact block id ${id} for ${p}", ("id", msg.id)( "p", c->peer_address() ) );
+         }
+         if( !b ) {
+            fc_ilog( logger, "unable to send transactions of unknown compact block ${id} to ${p}", ("id", msg.id)( "p", c->peer_address() ) );
+            return;
+         }
+         c->strand.post( [c, b{std::move(b)}, msg]() {
+            compact_block_trxs_message trxs{ msg.id };
+            trxs.trxs.reserve( msg.trx_indexes.size() );
+            for( auto i : msg.trx_indexes ) {
+               if( i >= b->transactions.size() || !std::holds_alternative<packed_transaction>( b->transactions[i].trx ) ) {
+                  peer_wlog( c, "invalid transaction index ${i} requested of compact block #${b}", ("i", i)("b", b->block_num()) );
+                  return;
+               }
+               // alias signed_block_ptr
+               trxs.trxs.emplace_back( b, &std::get<packed_transaction>( b->transactions[i].trx ) );
+            }
+            c->enqueue( trxs );
+         } );
+      } );
+   }
+
+   // called from connection strand
+   void connection::handle_message( const compact_block_trxs_message& msg ) {
+      auto itr = pending_compacts.find( msg.id );
+      if( itr == pending_compacts.end() ) {
+         peer_dlog( this, "dropping transactions of compact block ${id}... not waited for", ("id", msg.id.str().substr(8,16)) );
+         return;
+      }
+      auto pending = std::move( itr->second );
+      pending_compacts.erase( itr );
+      if( msg.trxs.size() != pending.missing.size() ) {
+         peer_wlog( this, "received ${n} transactions of compact block ${id}..., requested ${r}",
+                    ("n", msg.trxs.size())("id", msg.id.str().substr(8,16))("r", pending.missing.size()) );
+         close();
+         return;
+      }
+      for( size_t i = 0; i < msg.trxs.size(); ++i ) {
+         EOS_ASSERT( msg.trxs[i], plugin_exception, "null transaction of compact block ${id}", ("id", msg.id) );
+         pending.block->transactions[pending.missing[i]].trx.emplace<packed_transaction>( std::move( *msg.trxs[i] ) );
+      }
+      process_compact_block( msg.id, std::move( pending.block ) );
+   }
+
+   // called from connection strand
+   void connection::handle_message( const sync_compression_message& msg ) {
+      if( msg.codec != compression_type::none && msg.codec != compression_type::zstd ) {
+         peer_wlog( this, "unsupported sync compression ${c} requested", ("c", static_cast<uint8_t>(msg.codec.value)) );
+         return;
+      }
+      peer_ilog( this, "compressing sync blocks ${c}", ("c", msg.codec == compression_type::zstd ? "with zstd" : "off") );
+      peer_sync_compression = msg.codec;
+   }
+
+   // called from connection strand
+   void connection::handle_message( const compressed_block_message& msg ) {
+      EOS_ASSERT( msg.codec == compression_type::zstd, plugin_exception,
+                  "unsupported block compression ${c}", ("c", static_cast<uint8_t>(msg.codec.value)) );
+      const auto size = ZSTD_getFrameContentSize( msg.data.data(), msg.data.size() );
+      EOS_ASSERT( size != ZSTD_CONTENTSIZE_ERROR && size != ZSTD_CONTENTSIZE_UNKNOWN && size <= def_send_buffer_size*2,
+                  plugin_exception, "invalid compressed block of ${s} bytes", ("s", size) );
+      std::vector<char> packed( size );
+      const size_t decompressed = ZSTD_decompress( packed.data(), packed.size(), msg.data.data(), msg.data.size() );
+      EOS_ASSERT( decompressed == size, plugin_exception, "error decompressing block" );
+
+      fc::datastream<const char*> peek_ds( packed.data(), packed.size() );
+      block_header bh;
+      fc::raw::unpack( peek_ds, bh );
+      const block_id_type blk_id = bh.calculate_id();
+      if( !is_block_wanted( blk_id, bh ) ) {
+         return;
+      }
+
+      auto ptr = std::make_shared<signed_block>();
+      fc::datastream<const char*> ds( packed.data(), packed.size() );
+      fc::raw::unpack( ds, *ptr );
+      accept_signed_block( blk_id, std::move( ptr ) );
+   }
+
+   // called from connection strand
+   void connection::process_compact_block( const block_id_type& id, signed_block_ptr b ) {
+      deque<digest_type> trx_digests;
+      for( const auto& receipt : b->transactions ) {
+         trx_digests.emplace_back( receipt.digest() );
+      }
+      if( merkle( std::move( trx_digests ) ) != b->transaction_mroot ) {
+         // a transaction with the same short id or with other signatures than the ones in the block
+         peer_dlog( this, "rebuilt compact block #${b} ${id}... does not match, requesting the block",
+                    ("b", b->block_num())("id", id.str().substr(8,16)) );
+         request_message req;
+         req.req_blocks.mode = normal;
+         req.req_blocks.ids.push_back( id );
+         enqueue( req );
+         return;
+      }
+      accept_signed_block( id, std::move( b ) );
+   }
+
    // called from application thread
-   void connection::process_signed_block( const block_id_type& blk_id, signed_block_ptr msg ) {
+   void connection::process_signed_block( const block_id_type& blk_id, signed_block_ptr msg, const trx_meta_cache_lookup& trx_lookup ) {
       controller& cc = my_impl->chain_plug->chain();
       uint32_t blk_num = msg->block_num();
       // use c in this method instead of this to highlight that all methods called on c-> must be thread safe
@@ -3270,7 +4163,7 @@ namespace eosio {
 
       go_away_reason reason = fatal_other;
       try {
-         bool accepted = my_impl->chain_plug->accept_block(msg, blk_id);
+         bool accepted = my_impl->chain_plug->accept_block(msg, blk_id, trx_lookup);
          my_impl->update_chain_info();
          if( !accepted ) return;
          reason = no_reason;
@@ -3387,6 +4280,7 @@ namespace eosio {
       std::tie( lib, std::ignore, std::ignore, std::ignore, std::ignore, std::ignore ) = get_chain_info();
       dispatcher->expire_blocks( lib );
       dispatcher->expire_txns( lib );
+      sync_master->check_stalled_span();
       fc_dlog( logger, "expire_txns ${n}us", ("n", time_point::now() - now) );
 
       start_expire_timer();
@@ -3451,6 +4345,9 @@ namespace eosio {
          fc_add_tag( blk_span, "block_time", bs->block->timestamp.to_time_point() );
 
          dispatcher->bcast_block( bs->block, bs->id );
+         if( p2p_compact_blocks ) {
+            dispatcher->remove_pool_trxs( *bs->block );
+         }
       });
    }
 
@@ -3639,6 +4536,16 @@ namespace eosio {
          ( "p2p-max-nodes-per-host", bpo::value<int>()->default_value(def_max_nodes_per_host), "Maximum number of client nodes from any single IP address")
          ( "p2p-accept-transactions", bpo::value<bool>()->default_value(true), "Allow transactions received over p2p network to be evaluated and relayed if valid.")
          ( "p2p-reject-incomplete-blocks", bpo::value<bool>()->default_value(true), "Reject pruned signed_blocks even in light validation")
+         ( "p2p-compact-blocks", bpo::value<bool>()->default_value(false),
+           "Ask peers to relay new blocks as compact blocks, which carry short ids in place of the transactions already relayed to this node. "
+           "The transactions received are kept until they expire or are included in a block to rebuild the compact blocks, "
+           "up to 131072 of them, beyond which the ones expiring first are evicted.")
+         ( "p2p-sync-compression", bpo::value<string>()->default_value("none"),
+           "Ask peers to compress the blocks they send while this node is syncing from them, 'none' or 'zstd'. "
+           "Worthwhile on links with less bandwidth than the peers have CPU to compress the blocks.")
+         ( "p2p-trx-flush-window-us", bpo::value<uint32_t>()->default_value(0),
+           "Maximum time in microseconds a relayed transaction waits on an idle connection for further messages to be sent with it in one write. "
+           "0 sends every transaction right away")
          ( "agent-name", bpo::value<string>()->default_value("EOS Test Agent"), "The name supplied to identify this node amongst the peers.")
          ( "allowed-connection", bpo::value<vector<string>>()->multitoken()->default_value({"any"}, "any"), "Can be 'any' or 'producers' or 'specified' or 'none'. If 'specified', peer-key must be specified at least once. If only 'producers', peer-key is not required. 'producers' and 'specified' may be combined.")
          ( "peer-key", bpo::value<vector<string>>()->composing()->multitoken(), "Optional public key of peer allowed to connect.  May be used multiple times.")
@@ -3650,6 +4557,10 @@ namespace eosio {
          ( "net-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
            "Number of worker threads in net_plugin thread pool" )
          ( "sync-fetch-span", bpo::value<uint32_t>()->default_value(def_sync_fetch_span), "number of blocks to retrieve in a chunk from any individual peer during synchronization")
+         ( "sync-fetch-spans-in-flight", bpo::value<uint32_t>()->default_value(1),
+           "number of sync-fetch-span chunks requested from different peers at once while catching up to the last irreversible block. "
+           "Blocks arriving ahead of the next block are held back, so up to this many chunks of blocks are kept in memory. "
+           "1 requests one chunk at a time")
          ( "use-socket-read-watermark", bpo::value<bool>()->default_value(false), "Enable experimental socket read watermark optimization")
          ( "peer-log-format", bpo::value<string>()->default_value( "[\"${_name}\" ${_ip}:${_port}]" ),
            "The string used to format peers when logging messages about them.  Variables are escaped with ${<variable name>}.\n"
@@ -3676,7 +4587,8 @@ namespace eosio {
       try {
          peer_log_format = options.at( "peer-log-format" ).as<string>();
 
-         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>()));
+         my->sync_master.reset( new sync_manager( options.at( "sync-fetch-span" ).as<uint32_t>(),
+                                                  options.at( "sync-fetch-spans-in-flight" ).as<uint32_t>() ));
 
          my->connector_period = std::chrono::seconds( options.at( "connection-cleanup-period" ).as<int>());
          my->max_cleanup_time_ms = options.at("max-cleanup-time-msec").as<int>();
@@ -3686,6 +4598,15 @@ namespace eosio {
          my->max_nodes_per_host = options.at( "p2p-max-nodes-per-host" ).as<int>();
          my->p2p_accept_transactions = options.at( "p2p-accept-transactions" ).as<bool>();
          my->p2p_reject_incomplete_blocks = options.at("p2p-reject-incomplete-blocks").as<bool>();
+         my->trx_flush_window = std::chrono::microseconds( options.at( "p2p-trx-flush-window-us" ).as<uint32_t>() );
+         my->p2p_compact_blocks = options.at( "p2p-compact-blocks" ).as<bool>();
+         const auto& sync_compression = options.at( "p2p-sync-compression" ).as<string>();
+         if( sync_compression == "zstd" ) {
+            my->sync_compression = compression_type::zstd;
+         } else {
+            EOS_ASSERT( sync_compression == "none", chain::plugin_config_exception,
+                        "p2p-sync-compression must be 'none' or 'zstd', not ${c}", ("c", sync_compression) );
+         }
 
          my->use_socket_read_watermark = options.at( "use-socket-read-watermark" ).as<bool>();
          my->keepalive_interval = std::chrono::milliseconds( options.at( "p2p-keepalive-interval-ms" ).as<int>() );
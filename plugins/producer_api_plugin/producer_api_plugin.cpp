@@ -109,6 +109,10 @@ void producer_api_plugin::plugin_startup() {
             INVOKE_R_V(producer, get_whitelist_blacklist), 201),
        CALL_WITH_400(producer, producer, set_whitelist_blacklist,
             INVOKE_V_R(producer, set_whitelist_blacklist, producer_plugin::whitelist_blacklist), 201),
+       CALL_WITH_400(producer, producer, get_admission_queue_stats,
+            INVOKE_R_V(producer, get_admission_queue_stats), 201),
+       CALL_WITH_400(producer, producer, get_rsa_key_cache_stats,
+            INVOKE_R_V(producer, get_rsa_key_cache_stats), 201),
        CALL_WITH_400(producer, producer, get_integrity_hash,
             INVOKE_R_V(producer, get_integrity_hash), 201),
        CALL_ASYNC(producer, producer, create_snapshot, producer_plugin::snapshot_information,
@@ -122,6 +126,8 @@ void producer_api_plugin::plugin_startup() {
                                  producer_plugin::get_supported_protocol_features_params), 201),
        CALL_WITH_400(producer, producer, get_account_ram_corrections,
             INVOKE_R_R(producer, get_account_ram_corrections, producer_plugin::get_account_ram_corrections_params), 201),
+       CALL_WITH_400(producer, producer, get_unapplied_account_depths,
+            INVOKE_R_R(producer, get_unapplied_account_depths, producer_plugin::get_unapplied_account_depths_params), 201),
    }, appbase::priority::medium_high);
 }
 
@@ -0,0 +1,226 @@
+#pragma once
+
+#include <eosio/chain/types.hpp>
+
+#include <fc/time.hpp>
+#include <fc/reflect/reflect.hpp>
+
+#include <algorithm>
+#include <array>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <vector>
+
+namespace eosio {
+
+using chain::account_name;
+
+enum class admission_class : uint8_t {
+   api,
+   p2p
+};
+
+enum class admission_drop_policy : uint8_t {
+   newest,          ///< a transaction which does not fit is dropped
+   heaviest_account ///< the newest transactions of the account with the most queued bytes are dropped to make room
+};
+
+struct admission_class_stats {
+   uint64_t  depth = 0;          ///< queued transactions
+   uint64_t  bytes = 0;          ///< queued bytes
+   uint32_t  accounts = 0;       ///< accounts with queued transactions
+   uint64_t  admitted = 0;       ///< transactions queued since startup
+   uint64_t  dropped = 0;        ///< transactions dropped since startup
+   uint64_t  taken = 0;          ///< transactions taken since the previous stats
+   int64_t   avg_latency_us = 0; ///< average time in the queue of the transactions taken since the previous stats
+   int64_t   max_latency_us = 0; ///< longest time in the queue of the transactions taken since the previous stats
+};
+
+/**
+ * Queue of incoming transactions waiting for the main thread, in classes of API and P2P transactions.
+ *
+ * Each class is bounded in bytes and shared fairly between the first authorizers of its transactions: transactions
+ * are taken from the accounts of a class in turn, so a burst of one account only delays the transactions of that
+ * account. Classes are taken from in turn as well, api_weight API transactions for every P2P transaction.
+ *
+ * Thread safe.
+ */
+template<typename Payload>
+class admission_queue {
+public:
+   struct entry {
+      account_name    account;
+      uint32_t        size = 0;
+      fc::time_point  queued;
+      Payload         payload;
+   };
+
+   admission_queue() = default;
+
+   void configure( uint64_t max_class_bytes, admission_drop_policy policy, uint32_t api_weight ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      _max_class_bytes = max_class_bytes;
+      _policy = policy;
+      _api_weight = api_weight;
+      _api_credit = api_weight;
+   }
+
+   /**
+    * @param dropped : receives the transactions dropped to stay within the class bound, possibly the pushed one
+    * @return true if the queue was empty before the push
+    */
+   bool push( admission_class cls, account_name account, uint32_t size, const fc::time_point& now, Payload payload,
+              std::vector<Payload>& dropped ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      const bool was_empty = _depth == 0;
+      auto& c = _classes[static_cast<size_t>( cls )];
+      while( c.bytes + size > _max_class_bytes ) {
+         if( _policy == admission_drop_policy::newest || c.by_bytes.empty() ) {
+            ++c.dropped;
+            dropped.emplace_back( std::move( payload ) );
+            return was_empty;
+         }
+         auto heaviest = std::prev( c.by_bytes.end() );
+         auto acct_itr = c.accounts.find( account );
+         const uint64_t account_bytes = (acct_itr == c.accounts.end() ? 0 : acct_itr->second.bytes) + size;
+         if( account_bytes >= heaviest->first ) {
+            ++c.dropped;
+            dropped.emplace_back( std::move( payload ) );
+            return was_empty;
+         }
+         auto& victim = c.accounts.at( heaviest->second );
+         ++c.dropped;
+         dropped.emplace_back( std::move( victim.entries.back().payload ) );
+         remove_back( c, heaviest->second, victim );
+      }
+
+      auto itr = c.accounts.find( account );
+      if( itr == c.accounts.end() ) {
+         itr = c.accounts.emplace( account, account_queue{} ).first;
+         c.turns.push_back( account );
+      } else {
+         c.by_bytes.erase( { itr->second.bytes, account } );
+      }
+      itr->second.entries.push_back( entry{ account, size, now, std::move( payload ) } );
+      itr->second.bytes += size;
+      c.by_bytes.emplace( itr->second.bytes, account );
+      c.bytes += size;
+      ++c.admitted;
+      ++_depth;
+      return was_empty;
+   }
+
+   /// @return the next transaction, none if the queue is empty
+   std::optional<entry> pop( const fc::time_point& now ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      if( _depth == 0 )
+         return {};
+      auto& api = _classes[static_cast<size_t>( admission_class::api )];
+      auto& p2p = _classes[static_cast<size_t>( admission_class::p2p )];
+      class_queue* c = &p2p;
+      if( !api.turns.empty() && ( p2p.turns.empty() || _api_credit > 0 ) ) {
+         c = &api;
+         if( _api_credit > 0 ) --_api_credit;
+      } else {
+         _api_credit = _api_weight;
+      }
+
+      const account_name account = c->turns.front();
+      c->turns.pop_front();
+      auto itr = c->accounts.find( account );
+      auto& aq = itr->second;
+      std::optional<entry> result( std::move( aq.entries.front() ) );
+      aq.entries.pop_front();
+      c->by_bytes.erase( { aq.bytes, account } );
+      aq.bytes -= result->size;
+      c->bytes -= result->size;
+      if( aq.entries.empty() ) {
+         c->accounts.erase( itr );
+      } else {
+         c->by_bytes.emplace( aq.bytes, account );
+         c->turns.push_back( account );
+      }
+      --_depth;
+
+      const int64_t latency = ( now - result->queued ).count();
+      ++c->taken;
+      c->total_latency_us += latency;
+      c->max_latency_us = std::max( c->max_latency_us, latency );
+      return result;
+   }
+
+   size_t size() const {
+      std::lock_guard<std::mutex> g( _mtx );
+      return _depth;
+   }
+
+   bool empty() const { return size() == 0; }
+
+   /// latency statistics are reset by every call
+   admission_class_stats stats( admission_class cls ) {
+      std::lock_guard<std::mutex> g( _mtx );
+      auto& c = _classes[static_cast<size_t>( cls )];
+      admission_class_stats s;
+      for( const auto& a : c.accounts )
+         s.depth += a.second.entries.size();
+      s.bytes = c.bytes;
+      s.accounts = c.accounts.size();
+      s.admitted = c.admitted;
+      s.dropped = c.dropped;
+      s.taken = c.taken;
+      s.avg_latency_us = c.taken ? c.total_latency_us / static_cast<int64_t>( c.taken ) : 0;
+      s.max_latency_us = c.max_latency_us;
+      c.taken = 0;
+      c.total_latency_us = 0;
+      c.max_latency_us = 0;
+      return s;
+   }
+
+private:
+   struct account_queue {
+      std::deque<entry> entries;
+      uint64_t          bytes = 0;
+   };
+
+   struct class_queue {
+      std::map<account_name, account_queue>          accounts;
+      std::deque<account_name>                       turns;    ///< accounts with queued transactions in order of their turn
+      std::set<std::pair<uint64_t, account_name>>    by_bytes; ///< accounts by queued bytes
+      uint64_t                                       bytes = 0;
+      uint64_t                                       admitted = 0;
+      uint64_t                                       dropped = 0;
+      uint64_t                                       taken = 0;
+      int64_t                                        total_latency_us = 0;
+      int64_t                                        max_latency_us = 0;
+   };
+
+   void remove_back( class_queue& c, account_name account, account_queue& aq ) {
+      const uint32_t size = aq.entries.back().size;
+      aq.entries.pop_back();
+      c.by_bytes.erase( { aq.bytes, account } );
+      aq.bytes -= size;
+      c.bytes -= size;
+      --_depth;
+      if( aq.entries.empty() ) {
+         c.accounts.erase( account );
+         c.turns.erase( std::find( c.turns.begin(), c.turns.end(), account ) );
+      } else {
+         c.by_bytes.emplace( aq.bytes, account );
+      }
+   }
+
+   mutable std::mutex           _mtx;
+   std::array<class_queue, 2>   _classes;
+   size_t                       _depth = 0;
+   uint64_t                     _max_class_bytes = 256*1024*1024;
+   admission_drop_policy        _policy = admission_drop_policy::heaviest_account;
+   uint32_t                     _api_weight = 1;
+   uint32_t                     _api_credit = 1;
+};
+
+} // namespace eosio
+
+FC_REFLECT( eosio::admission_class_stats, (depth)(bytes)(accounts)(admitted)(dropped)(taken)(avg_latency_us)(max_latency_us) )
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <eosio/chain/exceptions.hpp>
+#include <eosio/chain/transaction.hpp>
+
+#include <fc/time.hpp>
+
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace eosio {
+
+using chain::account_name;
+using chain::transaction_id_type;
+
+inline fc::exception_ptr account_failure_limit_exception( const transaction_id_type& id, const account_name& first_auth ) {
+   return std::static_pointer_cast<fc::exception>( std::make_shared<chain::tx_resource_exhaustion>(
+         FC_LOG_MESSAGE( error, "transaction ${id} dropped, account ${a} exceeded subjective-account-max-failures in this block",
+                         ("id", id)("a", first_auth) ) ) );
+}
+
+/**
+ * Rejects incoming transactions on the producer thread pool, before they wait for the main thread, when they would be
+ * rejected on the main thread before execution. What they are checked against is published by the main thread.
+ */
+class incoming_precheck {
+public:
+   void set_enabled( bool enabled ) { _enabled = enabled; }
+   bool is_enabled() const { return _enabled; }
+
+   /// called on the main thread
+   /// @param block_time time of the pending block, transactions expired by then are rejected
+   /// @param limited_accounts first authorizers whose transactions are rejected
+   void publish( const fc::time_point& block_time, std::set<account_name> limited_accounts ) {
+      if( !_enabled )
+         return;
+      auto s = std::make_shared<state>();
+      s->block_time = block_time;
+      s->limited_accounts = std::move( limited_accounts );
+      std::lock_guard<std::mutex> g( _mtx );
+      _state = std::move( s );
+   }
+
+   /// called from the producer thread pool
+   /// @return the exception to reject trx with, empty if it is passed to the main thread
+   fc::exception_ptr check( const chain::packed_transaction& trx ) const {
+      if( !_enabled )
+         return {};
+      std::shared_ptr<const state> s;
+      {
+         std::lock_guard<std::mutex> g( _mtx );
+         s = _state;
+      }
+      if( !s )
+         return {};
+      const fc::time_point expire = trx.expiration();
+      if( expire < s->block_time ) {
+         return std::static_pointer_cast<fc::exception>( std::make_shared<chain::expired_tx_exception>(
+               FC_LOG_MESSAGE( error, "expired transaction ${id}, expiration ${e}, block time ${bt}",
+                               ("id", trx.id())("e", expire)("bt", s->block_time) ) ) );
+      }
+      const auto first_auth = trx.get_transaction().first_authorizer();
+      if( s->limited_accounts.count( first_auth ) ) {
+         return account_failure_limit_exception( trx.id(), first_auth );
+      }
+      return {};
+   }
+
+private:
+   struct state {
+      fc::time_point         block_time;
+      std::set<account_name> limited_accounts;
+   };
+
+   bool                         _enabled = true;
+   mutable std::mutex           _mtx;
+   std::shared_ptr<const state> _state; // protected by _mtx
+};
+
+} // namespace eosio
@@ -2,6 +2,7 @@
 
 #include <eosio/chain_plugin/chain_plugin.hpp>
 #include <eosio/signature_provider_plugin/signature_provider_plugin.hpp>
+#include <eosio/producer_plugin/admission_queue.hpp>
 
 #include <appbase/application.hpp>
 
@@ -37,6 +38,17 @@ public:
       std::vector<account_name> accounts;
    };
 
+   struct admission_queue_stats {
+      admission_class_stats api;
+      admission_class_stats p2p;
+   };
+
+   struct rsa_key_cache_stats {
+      uint64_t hits   = 0;
+      uint64_t misses = 0;
+      uint64_t size   = 0;
+   };
+
    struct integrity_hash_information {
       chain::block_id_type head_block_id;
       chain::digest_type   integrity_hash;
@@ -71,6 +83,21 @@ public:
       std::optional<account_name>  more;
    };
 
+   struct get_unapplied_account_depths_params {
+      std::optional<account_name>  lower_bound;
+      uint32_t                     limit = 10;
+   };
+
+   struct unapplied_account_depth {
+      account_name                 account;
+      uint32_t                     depth = 0; ///< queued unapplied transactions with this first authorizer
+   };
+
+   struct get_unapplied_account_depths_result {
+      std::vector<unapplied_account_depth>  rows;
+      std::optional<account_name>           more;
+   };
+
    template<typename T>
    using next_function = std::function<void(const std::variant<fc::exception_ptr, T>&)>;
 
@@ -103,6 +130,9 @@ public:
    whitelist_blacklist get_whitelist_blacklist() const;
    void set_whitelist_blacklist(const whitelist_blacklist& params);
 
+   admission_queue_stats get_admission_queue_stats() const;
+   rsa_key_cache_stats get_rsa_key_cache_stats() const;
+
    integrity_hash_information get_integrity_hash() const;
    void create_snapshot(next_function<snapshot_information> next);
 
@@ -113,6 +143,8 @@ public:
 
    get_account_ram_corrections_result  get_account_ram_corrections( const get_account_ram_corrections_params& params ) const;
 
+   get_unapplied_account_depths_result get_unapplied_account_depths( const get_unapplied_account_depths_params& params ) const;
+
    void log_failed_transaction(const transaction_id_type& trx_id, const char* reason) const;
 
  private:
@@ -124,9 +156,14 @@ public:
 FC_REFLECT(eosio::producer_plugin::runtime_options, (max_transaction_time)(max_irreversible_block_age)(produce_time_offset_us)(last_block_time_offset_us)(max_scheduled_transaction_time_per_block_ms)(subjective_cpu_leeway_us)(incoming_defer_ratio)(greylist_limit));
 FC_REFLECT(eosio::producer_plugin::greylist_params, (accounts));
 FC_REFLECT(eosio::producer_plugin::whitelist_blacklist, (actor_whitelist)(actor_blacklist)(contract_whitelist)(contract_blacklist)(action_blacklist)(key_blacklist) )
+FC_REFLECT(eosio::producer_plugin::admission_queue_stats, (api)(p2p))
+FC_REFLECT(eosio::producer_plugin::rsa_key_cache_stats, (hits)(misses)(size))
 FC_REFLECT(eosio::producer_plugin::integrity_hash_information, (head_block_id)(integrity_hash))
 FC_REFLECT(eosio::producer_plugin::snapshot_information, (head_block_id)(head_block_num)(head_block_time)(version)(snapshot_name))
 FC_REFLECT(eosio::producer_plugin::scheduled_protocol_feature_activations, (protocol_features_to_activate))
 FC_REFLECT(eosio::producer_plugin::get_supported_protocol_features_params, (exclude_disabled)(exclude_unactivatable))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_params, (lower_bound)(upper_bound)(limit)(reverse))
 FC_REFLECT(eosio::producer_plugin::get_account_ram_corrections_result, (rows)(more))
+FC_REFLECT(eosio::producer_plugin::get_unapplied_account_depths_params, (lower_bound)(limit))
+FC_REFLECT(eosio::producer_plugin::unapplied_account_depth, (account)(depth))
+FC_REFLECT(eosio::producer_plugin::get_unapplied_account_depths_result, (rows)(more))
@@ -12,8 +12,9 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/container/flat_map.hpp>
 
-#include <unordered_map>
+#include <algorithm>
 
 namespace eosio {
 
@@ -55,8 +56,9 @@ private:
       }
    };
 
-   using account_subjective_bill_cache = std::unordered_map<account_name, subjective_billing_info>;
-   using block_subjective_bill_cache = std::unordered_map<account_name, uint64_t>;
+   // sorted vectors, looked up far more often than accounts are added; accounts are removed in batches by prune_accounts
+   using account_subjective_bill_cache = boost::container::flat_map<account_name, subjective_billing_info>;
+   using block_subjective_bill_cache = boost::container::flat_map<account_name, uint64_t>;
 
    bool                                      _disabled = false;
    trx_cache_index                           _trx_cache_index;
@@ -77,10 +79,18 @@ private:
          aitr->second.pending_cpu_us -= entry.subjective_cpu_bill;
          EOS_ASSERT( aitr->second.pending_cpu_us >= 0, chain::tx_resource_exhaustion,
                      "Logic error in subjective account billing ${a}", ("a", entry.account) );
-         if( aitr->second.empty(time_ordinal) ) _account_subjective_bill_cache.erase( aitr );
       }
    }
 
+   // removes the accounts without a bill in one pass, erasing them one at a time would move the table for each
+   void prune_accounts( uint32_t time_ordinal ) {
+      auto accounts = _account_subjective_bill_cache.extract_sequence();
+      accounts.erase( std::remove_if( accounts.begin(), accounts.end(), [time_ordinal]( auto& a ) {
+                         return a.second.empty( time_ordinal );
+                      } ), accounts.end() );
+      _account_subjective_bill_cache.adopt_sequence( boost::container::ordered_unique_range, std::move( accounts ) );
+   }
+
    void transition_to_expired( const trx_cache_entry& entry, uint32_t time_ordinal ) {
       auto aitr = _account_subjective_bill_cache.find( entry.account );
       if( aitr != _account_subjective_bill_cache.end() ) {
@@ -170,6 +180,13 @@ public:
       }
    }
 
+   // true if the subjective bill of first_auth uses up available_cpu_us, the cpu the account can be billed, -1 if unlimited
+   bool exceeds_budget( const account_name& first_auth, int64_t available_cpu_us, const fc::time_point& now ) const {
+      if( available_cpu_us < 0 ) return false;
+      const uint32_t sub_bill = get_subjective_bill( first_auth, now );
+      return sub_bill > 0 && sub_bill >= available_cpu_us;
+   }
+
    void abort_block() {
       _block_subjective_bill_cache.clear();
    }
@@ -180,11 +197,13 @@ public:
       remove_subjective_billing( bsp, time_ordinal );
    }
 
+   /// @return false if deadline was reached before all transactions expired by pending_block_time were removed
    bool remove_expired( fc::logger& log, const fc::time_point& pending_block_time, const fc::time_point& now, const fc::time_point& deadline ) {
+      const auto start = fc::time_point::now();
       bool exhausted = false;
       auto& idx = _trx_cache_index.get<by_expiry>();
+      const auto time_ordinal = time_ordinal_for(now);
       if( !idx.empty() ) {
-         const auto time_ordinal = time_ordinal_for(now);
          const auto orig_count = _trx_cache_index.size();
          uint32_t num_expired = 0;
 
@@ -200,8 +219,13 @@ public:
             num_expired++;
          }
 
-         fc_dlog( log, "Processed ${n} subjective billed transactions, Expired ${expired}",
-                  ("n", orig_count)( "expired", num_expired ) );
+         fc_dlog( log, "Processed ${n} subjective billed transactions, Expired ${expired} in ${t}us",
+                  ("n", orig_count)( "expired", num_expired )("t", (fc::time_point::now() - start).count()) );
+      }
+      if( !exhausted ) {
+         const auto orig_accounts = _account_subjective_bill_cache.size();
+         prune_accounts( time_ordinal );
+         fc_dlog( log, "Pruned ${n} of ${a} subjective billed accounts", ("n", orig_accounts - _account_subjective_bill_cache.size())("a", orig_accounts) );
       }
       return !exhausted;
    }
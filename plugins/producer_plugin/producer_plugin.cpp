@@ -1,9 +1,12 @@
 #include <eosio/producer_plugin/producer_plugin.hpp>
 #include <eosio/producer_plugin/pending_snapshot.hpp>
 #include <eosio/producer_plugin/subjective_billing.hpp>
+#include <eosio/producer_plugin/admission_queue.hpp>
+#include <eosio/producer_plugin/incoming_precheck.hpp>
 #include <eosio/chain/plugin_interface.hpp>
 #include <eosio/chain/global_property_object.hpp>
 #include <eosio/chain/generated_transaction_object.hpp>
+#include <eosio/chain/rsa.hpp>
 #include <eosio/chain/snapshot.hpp>
 #include <eosio/chain/transaction_object.hpp>
 #include <eosio/chain/thread_utils.hpp>
@@ -116,6 +119,124 @@ using pending_snapshot_index = multi_index_container<
    >
 >;
 
+namespace {
+// track multiple failures of the transactions of an account in a block
+class account_failures {
+public:
+   void set_max_failures_per_account( uint32_t max_failures ) {
+      max_failures_per_account = max_failures;
+   }
+
+   // return true if the account reached max_failures_per_account with this failure
+   bool add( const account_name& n, int64_t exception_code ) {
+      auto& fa = failed_accounts[n];
+      ++fa.num_failures;
+      fa.add( n, exception_code );
+      return fa.num_failures == max_failures_per_account;
+   }
+
+   // return true if exceeds max_failures_per_account and should be dropped
+   bool failure_limit( const account_name& n ) {
+      auto fitr = failed_accounts.find( n );
+      if( max_failures_per_account > 0 && fitr != failed_accounts.end() && fitr->second.num_failures >= max_failures_per_account ) {
+         ++fitr->second.num_failures;
+         return true;
+      }
+      return false;
+   }
+
+   // account of n dropped transactions without trying them
+   void dropped( const account_name& n, uint32_t count ) {
+      auto fitr = failed_accounts.find( n );
+      if( fitr != failed_accounts.end() )
+         fitr->second.num_failures += count;
+   }
+
+   // return true if the account reached max_failures_per_account
+   bool is_limited( const account_name& n ) const {
+      auto fitr = failed_accounts.find( n );
+      return max_failures_per_account > 0 && fitr != failed_accounts.end() && fitr->second.num_failures >= max_failures_per_account;
+   }
+
+   // accounts which reached max_failures_per_account
+   std::set<account_name> limited_accounts() const {
+      std::set<account_name> result;
+      for( const auto& e : failed_accounts ) {
+         if( max_failures_per_account > 0 && e.second.num_failures >= max_failures_per_account )
+            result.insert( e.first );
+      }
+      return result;
+   }
+
+   void clear() {
+      failed_accounts.clear();
+   }
+
+   void report() const {
+      if( _log.is_enabled( fc::log_level::debug ) ) {
+         for( const auto& e : failed_accounts ) {
+            std::string reason;
+            if( max_failures_per_account > 0 && e.second.num_failures > max_failures_per_account ) {
+               reason.clear();
+               if( e.second.is_deadline() ) reason += "deadline";
+               if( e.second.is_tx_cpu_usage() ) {
+                  if( !reason.empty() ) reason += ", ";
+                  reason += "tx_cpu_usage";
+               }
+               if( e.second.is_eosio_assert() ) {
+                  if( !reason.empty() ) reason += ", ";
+                  reason += "assert";
+               }
+               if( e.second.is_other() ) {
+                  if( !reason.empty() ) reason += ", ";
+                  reason += "other";
+               }
+               fc_dlog( _log, "Dropped ${n} trxs, account: ${a}, reason: ${r} exceeded",
+                        ("n", e.second.num_failures - max_failures_per_account)("a", e.first)("r", reason) );
+            }
+         }
+      }
+   }
+
+private:
+   struct account_failure {
+      enum class ex_fields : uint8_t {
+         ex_deadline_exception = 1,
+         ex_tx_cpu_usage_exceeded = 2,
+         ex_eosio_assert_exception = 4,
+         ex_other_exception = 8
+      };
+
+      void add( const account_name& n, int64_t exception_code ) {
+         if( exception_code == tx_cpu_usage_exceeded::code_value ) {
+            ex_flags = set_field( ex_flags, ex_fields::ex_tx_cpu_usage_exceeded );
+         } else if( exception_code == deadline_exception::code_value ) {
+            ex_flags = set_field( ex_flags, ex_fields::ex_deadline_exception );
+         } else if( exception_code == eosio_assert_message_exception::code_value ||
+                    exception_code == eosio_assert_code_exception::code_value ) {
+            ex_flags = set_field( ex_flags, ex_fields::ex_eosio_assert_exception );
+         } else {
+            ex_flags = set_field( ex_flags, ex_fields::ex_other_exception );
+            fc_dlog( _log, "Failed trx, account: ${a}, reason: ${r}",
+                     ("a", n)("r", exception_code) );
+         }
+      }
+
+      bool is_deadline() const { return has_field( ex_flags, ex_fields::ex_deadline_exception ); }
+      bool is_tx_cpu_usage() const { return has_field( ex_flags, ex_fields::ex_tx_cpu_usage_exceeded ); }
+      bool is_eosio_assert() const { return has_field( ex_flags, ex_fields::ex_eosio_assert_exception ); }
+      bool is_other() const { return has_field( ex_flags, ex_fields::ex_other_exception ); }
+
+      uint32_t num_failures = 0;
+      uint8_t ex_flags = 0;
+   };
+
+   uint32_t                                max_failures_per_account = 3;
+   std::map<account_name, account_failure> failed_accounts;
+};
+
+} // anonymous namespace
+
 enum class pending_block_mode {
    producing,
    speculating
@@ -158,6 +279,14 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       bool process_unapplied_trxs( const fc::time_point& deadline );
       void process_scheduled_and_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit );
       bool process_incoming_trxs( const fc::time_point& deadline, size_t& pending_incoming_process_limit );
+      size_t drop_account_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                const unapplied_transaction_queue::iterator& end, trx_enum_type first, trx_enum_type last );
+      size_t drop_over_budget_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                    const unapplied_transaction_queue::iterator& end );
+      template<typename Func>
+      size_t erase_account_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                 const unapplied_transaction_queue::iterator& end, trx_enum_type first, trx_enum_type last,
+                                 Func&& reject );
 
       boost::program_options::variables_map _options;
       bool     _production_enabled                 = false;
@@ -172,6 +301,17 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       std::map<chain::account_name, producer_watermark>         _producer_watermarks;
       pending_block_mode                                        _pending_block_mode = pending_block_mode::speculating;
       unapplied_transaction_queue                               _unapplied_transactions;
+
+      struct incoming_trx {
+         packed_transaction_ptr                  trx;
+         recover_keys_future                     future;
+         bool                                    persist_until_expired = false;
+         next_function<transaction_trace_ptr>    next;
+      };
+      static constexpr int64_t                                  admission_slice_us = 10000; ///< main thread time per pass over the admission queue
+      admission_queue<incoming_trx>                             _admission_queue;
+      std::atomic<bool>                                         _admission_drain_scheduled{false}; ///< a process_admission_queue is posted
+      uint16_t                                                  _admission_queue_size_mb = 0;
       std::optional<named_thread_pool>                          _thread_pool;
 
       std::atomic<int32_t>                                      _max_transaction_time_ms; // modified by app thread, read by net_plugin thread pool
@@ -205,6 +345,11 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
       transaction_id_with_expiry_index                          _blacklisted_transactions;
       pending_snapshot_index                                    _pending_snapshot_index;
       subjective_billing                                        _subjective_billing;
+      fc::microseconds                                          _subjective_expire_budget;
+      bool                                                      _subjective_expiry_scheduled = false;
+      account_failures                                          _account_fails;
+
+      incoming_precheck                                         _incoming_precheck;
 
       std::optional<scoped_connection>                          _accepted_block_connection;
       std::optional<scoped_connection>                          _accepted_block_header_connection;
@@ -227,6 +372,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
 
       // path to write the snapshots to
       bfs::path _snapshots_dir;
+      uint16_t _snapshot_write_threads = config::default_snapshot_thread_pool_size;
+      bool _zstd_snapshots = false;
 
       void consider_new_watermark( account_name producer, uint32_t block_num, block_timestamp_type timestamp) {
          auto itr = _producer_watermarks.find( producer );
@@ -254,6 +401,33 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   ("before", before)("after", _unapplied_transactions.size()) );
       }
 
+      // expires subjective bills for at most the expire budget, the rest is expired while the main thread is idle
+      bool remove_expired_subjective_bills( const fc::time_point& deadline ) {
+         chain::controller& chain = chain_plug->chain();
+         const auto now = fc::time_point::now();
+         const auto budget_deadline = std::min( deadline, now + _subjective_expire_budget );
+         if( _subjective_billing.remove_expired( _log, chain.pending_block_time(), now, budget_deadline ) )
+            return true;
+         if( deadline <= fc::time_point::now() )
+            return false;
+         schedule_subjective_expiry();
+         return true;
+      }
+
+      void schedule_subjective_expiry() {
+         if( _subjective_expiry_scheduled )
+            return;
+         _subjective_expiry_scheduled = true;
+         app().post( priority::lowest, [this]() {
+            _subjective_expiry_scheduled = false;
+            const chain::controller& chain = chain_plug->chain();
+            const auto block_time = chain.is_building_block() ? chain.pending_block_time() : chain.head_block_time();
+            const auto now = fc::time_point::now();
+            if( !_subjective_billing.remove_expired( _log, block_time, now, now + _subjective_expire_budget ) )
+               schedule_subjective_expiry();
+         } );
+      }
+
       void on_block_header( const block_state_ptr& bsp ) {
          consider_new_watermark( bsp->header.producer, bsp->block_num, bsp->block->timestamp );
       }
@@ -340,7 +514,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          return true;
       }
 
-      bool on_incoming_block(const signed_block_ptr& block, const std::optional<block_id_type>& block_id) {
+      bool on_incoming_block(const signed_block_ptr& block, const std::optional<block_id_type>& block_id,
+                             const trx_meta_cache_lookup& trx_lookup = {}) {
          auto& chain = chain_plug->chain();
          if ( _pending_block_mode == pending_block_mode::producing) {
             fc_wlog( _log, "dropped incoming block #${num} id: ${id}",
@@ -382,7 +557,10 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
          try {
             block_state_ptr blk_state = chain.push_block( bsf, [this]( const branch_type& forked_branch ) {
                _unapplied_transactions.add_forked( forked_branch );
-            }, [this]( const transaction_id_type& id ) {
+            }, [this, &trx_lookup]( const transaction_id_type& id ) {
+               if( trx_lookup ) {
+                  if( auto trx = trx_lookup( id ) ) return trx;
+               }
                return _unapplied_transactions.get_trx( id );
             } );
 
@@ -450,27 +628,111 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                                                           next{std::move(next)}, trx]() mutable {
             if( future.valid() ) {
                future.wait();
-               app().post( priority::low, [self, future{std::move(future)}, persist_until_expired, next{std::move( next )}, trx{std::move(trx)}]() mutable {
-                  auto exception_handler = [&next, trx{std::move(trx)}](fc::exception_ptr ex) {
-                     fc_dlog(_trx_failed_trace_log, "[TRX_TRACE] Speculative execution is REJECTING tx: ${txid}, auth: ${a} : ${why} ",
+               if( auto ex = self->_incoming_precheck.check( *trx ) ) {
+                  app().post( priority::low, [ex{std::move(ex)}, next{std::move(next)}, trx{std::move(trx)}]() {
+                     fc_dlog(_trx_failed_trace_log, "[TRX_TRACE] Precheck is REJECTING tx: ${txid}, auth: ${a} : ${why} ",
                             ("txid", trx->id())("a",trx->get_transaction().first_authorizer())("why",ex->what()));
-                     next(ex);
-                  };
-                  try {
-                     auto result = future.get();
-                     if( !self->process_incoming_transaction_async( result, persist_until_expired, next ) ) {
-                        if( self->_pending_block_mode == pending_block_mode::producing ) {
-                           self->schedule_maybe_produce_block( true );
-                        } else {
-                           self->restart_speculative_block();
-                        }
-                     }
-                  } CATCH_AND_CALL(exception_handler);
-               } );
+                     next( ex );
+                  } );
+                  return;
+               }
+               const auto cls = persist_until_expired ? admission_class::api : admission_class::p2p;
+               const auto account = trx->get_transaction().first_authorizer();
+               const auto size = trx->get_estimated_size();
+               std::vector<incoming_trx> dropped;
+               bool start_drain = self->_admission_queue.push( cls, account, size, fc::time_point::now(),
+                     incoming_trx{ std::move(trx), std::move(future), persist_until_expired, std::move(next) }, dropped );
+               if( !dropped.empty() ) {
+                  app().post( priority::low, [self, dropped{std::move(dropped)}]() mutable {
+                     self->reject_dropped_trxs( dropped );
+                  } );
+               }
+               if( start_drain ) {
+                  self->schedule_admission_drain();
+               }
             }
          });
       }
 
+      static fc::exception_ptr subjective_budget_exception( const transaction_id_type& id, const account_name& first_auth ) {
+         return std::static_pointer_cast<fc::exception>( std::make_shared<tx_cpu_usage_exceeded>(
+               FC_LOG_MESSAGE( error, "transaction ${id} dropped, subjective cpu bill of account ${a} exceeds its available cpu",
+                               ("id", id)("a", first_auth) ) ) );
+      }
+
+      // cpu the account can be billed at the pending block time, -1 if unlimited
+      int64_t available_cpu_us( const account_name& a ) const {
+         const chain::controller& chain = chain_plug->chain();
+         return chain.get_resource_limits_manager().get_account_cpu_limit_ex(
+               a, config::maximum_elastic_resource_multiplier, block_timestamp_type( chain.pending_block_time() ) ).first.available;
+      }
+
+      // called on the main thread
+      void publish_incoming_precheck() {
+         if( !_incoming_precheck.is_enabled() )
+            return;
+         const chain::controller& chain = chain_plug->chain();
+         // only a producing node rejects the transactions of accounts over the failure limit early, a speculating node
+         // does not know whether the producer of the block will fail them too
+         std::set<account_name> limited_accounts;
+         if( _pending_block_mode == pending_block_mode::producing )
+            limited_accounts = _account_fails.limited_accounts();
+         _incoming_precheck.publish( chain.is_building_block() ? chain.pending_block_time() : chain.head_block_time(),
+                                     std::move( limited_accounts ) );
+      }
+
+      // thread safe, posts process_admission_queue unless it is already posted
+      void schedule_admission_drain() {
+         if( _admission_drain_scheduled.exchange( true ) )
+            return;
+         app().post( priority::low, [this]() {
+            _admission_drain_scheduled = false;
+            process_admission_queue();
+         } );
+      }
+
+      // called on the main thread, processes queued incoming transactions for up to admission_slice_us and then yields
+      void process_admission_queue() {
+         const auto start = fc::time_point::now();
+         const auto deadline = start + fc::microseconds( admission_slice_us );
+         auto now = start;
+         while( now < deadline ) {
+            auto e = _admission_queue.pop( now );
+            if( !e )
+               return;
+            auto& in = e->payload;
+            auto exception_handler = [&in](fc::exception_ptr ex) {
+               fc_dlog(_trx_failed_trace_log, "[TRX_TRACE] Speculative execution is REJECTING tx: ${txid}, auth: ${a} : ${why} ",
+                      ("txid", in.trx->id())("a",in.trx->get_transaction().first_authorizer())("why",ex->what()));
+               in.next(ex);
+            };
+            try {
+               auto result = in.future.get();
+               if( !process_incoming_transaction_async( result, in.persist_until_expired, in.next ) ) {
+                  if( _pending_block_mode == pending_block_mode::producing ) {
+                     schedule_maybe_produce_block( true );
+                  } else {
+                     restart_speculative_block();
+                  }
+               }
+            } CATCH_AND_CALL(exception_handler);
+            now = fc::time_point::now();
+         }
+         schedule_admission_drain();
+      }
+
+      void reject_dropped_trxs( std::vector<incoming_trx>& dropped ) {
+         for( auto& in : dropped ) {
+            auto ex = std::static_pointer_cast<fc::exception>( std::make_shared<tx_resource_exhaustion>(
+                  FC_LOG_MESSAGE( error, "transaction ${id} dropped from the full incoming admission queue, "
+                                         "incoming-admission-queue-size-mb ${qs}",
+                                  ("id", in.trx->id())("qs", _admission_queue_size_mb) ) ) );
+            fc_dlog(_trx_failed_trace_log, "[TRX_TRACE] Admission is REJECTING tx: ${txid}, auth: ${a} : ${why} ",
+                   ("txid", in.trx->id())("a",in.trx->get_transaction().first_authorizer())("why",ex->what()));
+            in.next( ex );
+         }
+      }
+
       bool process_incoming_transaction_async(const transaction_metadata_ptr& trx, bool persist_until_expired, next_function<transaction_trace_ptr> next) {
          bool exhausted = false;
          chain::controller& chain = chain_plug->chain();
@@ -546,9 +808,19 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                                               || ( !persist_until_expired && _disable_subjective_p2p_billing );
 
             auto first_auth = trx->packed_trx()->get_transaction().first_authorizer();
+            if( _pending_block_mode == pending_block_mode::producing && _account_fails.failure_limit( first_auth ) ) {
+               send_response( account_failure_limit_exception( id, first_auth ) );
+               return true;
+            }
             uint32_t sub_bill = 0;
-            if( !disable_subjective_billing )
-               sub_bill = _subjective_billing.get_subjective_bill( first_auth, fc::time_point::now() );
+            if( !disable_subjective_billing ) {
+               const auto now = fc::time_point::now();
+               sub_bill = _subjective_billing.get_subjective_bill( first_auth, now );
+               if( sub_bill > 0 && _subjective_billing.exceeds_budget( first_auth, available_cpu_us( first_auth ), now ) ) {
+                  send_response( subjective_budget_exception( id, first_auth ) );
+                  return true;
+               }
+            }
 
             auto trace = chain.push_transaction( trx, deadline, trx->billed_cpu_time_us, false, sub_bill );
             fc_dlog( _trx_failed_trace_log, "Subjective bill for ${a}: ${b} elapsed ${t}us", ("a",first_auth)("b",sub_bill)("t",trace->elapsed));
@@ -567,6 +839,8 @@ class producer_plugin_impl : public std::enable_shared_from_this<producer_plugin
                   exhausted = block_is_exhausted();
                } else {
                   _subjective_billing.subjective_bill_failure( first_auth, trace->elapsed, fc::time_point::now() );
+                  if( trace->except->code() != tx_duplicate::code_value && _account_fails.add( first_auth, trace->except->code() ) )
+                     publish_incoming_precheck();
                   auto e_ptr = trace->except->dynamic_copy_exception();
                   send_response( e_ptr );
                }
@@ -711,6 +985,23 @@ void producer_plugin::set_program_options(
           "ratio between incoming transactions and deferred transactions when both are queued for execution")
          ("incoming-transaction-queue-size-mb", bpo::value<uint16_t>()->default_value( 1024 ),
           "Maximum size (in MiB) of the incoming transaction queue. Exceeding this value will subjectively drop transaction with resource exhaustion.")
+         ("incoming-admission-queue-size-mb", bpo::value<uint16_t>()->default_value( 256 ),
+          "Maximum size (in MiB) of the API and of the P2P transactions waiting for the main thread to process them. "
+          "Transactions are taken in turn from the first authorizers waiting, so that a burst of one account only delays that account.")
+         ("incoming-admission-drop-policy", bpo::value<string>()->default_value( "heaviest-account" ),
+          "Transactions dropped when incoming-admission-queue-size-mb is exceeded: 'heaviest-account' drops the newest transactions "
+          "of the account with the most waiting, 'newest' drops the arriving transaction.")
+         ("incoming-admission-api-weight", bpo::value<uint32_t>()->default_value( 1 ),
+          "Number of waiting API transactions processed for every waiting P2P transaction.")
+         ("subjective-account-max-failures", bpo::value<uint32_t>()->default_value( 3 ),
+          "Maximum number of failed transactions of an account in a block, further transactions of the account are dropped "
+          "without being executed until the next block. 0 for no limit.")
+         ("subjective-billing-expire-budget-us", bpo::value<uint32_t>()->default_value( 2000 ),
+          "Maximum time in microseconds spent expiring subjective bills of transactions in one pass. "
+          "What is left at the start of a block is expired while the producer is idle.")
+         ("incoming-precheck", bpo::value<bool>()->default_value( true ),
+          "Reject incoming transactions on the producer threads, before they wait for the main thread, when they are expired "
+          "or, while producing, their first authorizer exceeded subjective-account-max-failures in the current block.")
          ("disable-api-persisted-trx", bpo::bool_switch()->default_value(false),
           "Disable the re-apply of API transactions.")
          ("disable-subjective-billing", bpo::value<bool>()->default_value(true),
@@ -725,6 +1016,12 @@ void producer_plugin::set_program_options(
           "Number of worker threads in producer thread pool")
          ("snapshots-dir", bpo::value<bfs::path>()->default_value("snapshots"),
           "the location of the snapshots directory (absolute path or relative to application data dir)")
+         ("snapshot-write-threads", bpo::value<uint16_t>()->default_value(config::default_snapshot_thread_pool_size),
+          "Number of threads writing the sections of a snapshot concurrently")
+         ("snapshot-compression", bpo::value<string>()->default_value("none"),
+          "Format of the snapshots written.\n"
+          "\"none\" writes uncompressed snapshots whose sections are written concurrently.\n"
+          "\"zstd\" compresses the snapshots as they are written, they can be read from a pipe.")
          ;
    config_file_options.add(producer_options);
 }
@@ -855,6 +1152,22 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
 
    my->_incoming_defer_ratio = options.at("incoming-defer-ratio").as<double>();
 
+   my->_account_fails.set_max_failures_per_account( options.at("subjective-account-max-failures").as<uint32_t>() );
+   my->_incoming_precheck.set_enabled( options.at("incoming-precheck").as<bool>() );
+   my->_subjective_expire_budget = fc::microseconds( options.at("subjective-billing-expire-budget-us").as<uint32_t>() );
+   EOS_ASSERT( my->_subjective_expire_budget.count() > 0, plugin_config_exception,
+               "subjective-billing-expire-budget-us must be greater than 0" );
+
+   my->_admission_queue_size_mb = options.at("incoming-admission-queue-size-mb").as<uint16_t>();
+   EOS_ASSERT( my->_admission_queue_size_mb > 0, plugin_config_exception,
+               "incoming-admission-queue-size-mb ${mb} must be greater than 0", ("mb", my->_admission_queue_size_mb) );
+   const auto& drop_policy = options.at("incoming-admission-drop-policy").as<string>();
+   EOS_ASSERT( drop_policy == "heaviest-account" || drop_policy == "newest", plugin_config_exception,
+               "incoming-admission-drop-policy must be 'heaviest-account' or 'newest', not ${p}", ("p", drop_policy) );
+   my->_admission_queue.configure( uint64_t(my->_admission_queue_size_mb) * 1024*1024,
+                                   drop_policy == "newest" ? admission_drop_policy::newest : admission_drop_policy::heaviest_account,
+                                   options.at("incoming-admission-api-weight").as<uint32_t>() );
+
    my->_disable_persist_until_expired = options.at("disable-api-persisted-trx").as<bool>();
    bool disable_subjective_billing = options.at("disable-subjective-billing").as<bool>();
    my->_disable_subjective_p2p_billing = options.at("disable-subjective-p2p-billing").as<bool>();
@@ -881,6 +1194,15 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
                "producer-threads ${num} must be greater than 0", ("num", thread_pool_size));
    my->_thread_pool.emplace( "prod", thread_pool_size );
 
+   my->_snapshot_write_threads = options.at( "snapshot-write-threads" ).as<uint16_t>();
+   EOS_ASSERT( my->_snapshot_write_threads > 0, plugin_config_exception,
+               "snapshot-write-threads ${num} must be greater than 0", ("num", my->_snapshot_write_threads));
+
+   const auto snapshot_compression = options.at( "snapshot-compression" ).as<string>();
+   EOS_ASSERT( snapshot_compression == "none" || snapshot_compression == "zstd", plugin_config_exception,
+               "\"snapshot-compression\" must be either \"none\" or \"zstd\"." );
+   my->_zstd_snapshots = snapshot_compression == "zstd";
+
    if( options.count( "snapshots-dir" )) {
       auto sd = options.at( "snapshots-dir" ).as<bfs::path>();
       if( sd.is_relative()) {
@@ -915,8 +1237,8 @@ void producer_plugin::plugin_initialize(const boost::program_options::variables_
    });
 
    my->_incoming_block_sync_provider = app().get_method<incoming::methods::block_sync>().register_provider(
-         [this](const signed_block_ptr& block, const std::optional<block_id_type>& block_id) {
-      return my->on_incoming_block(block, block_id);
+         [this](const signed_block_ptr& block, const std::optional<block_id_type>& block_id, const trx_meta_cache_lookup& trx_lookup) {
+      return my->on_incoming_block(block, block_id, trx_lookup);
    });
 
    my->_incoming_blockvault_sync_provider = app().get_method<incoming::methods::blockvault_sync>().register_provider(
@@ -1156,6 +1478,15 @@ void producer_plugin::set_whitelist_blacklist(const producer_plugin::whitelist_b
    if(params.key_blacklist) chain.set_key_blacklist(*params.key_blacklist);
 }
 
+producer_plugin::admission_queue_stats producer_plugin::get_admission_queue_stats() const {
+   return { my->_admission_queue.stats( admission_class::api ), my->_admission_queue.stats( admission_class::p2p ) };
+}
+
+producer_plugin::rsa_key_cache_stats producer_plugin::get_rsa_key_cache_stats() const {
+   const auto stats = chain::rsa::intrinsic_key_cache().get_stats();
+   return { stats.hits, stats.misses, stats.size };
+}
+
 producer_plugin::integrity_hash_information producer_plugin::get_integrity_hash() const {
    chain::controller& chain = my->chain_plug->chain();
 
@@ -1205,9 +1536,17 @@ void producer_plugin::create_snapshot(producer_plugin::next_function<producer_pl
 
       // create the snapshot
       auto snap_out = std::ofstream(p.generic_string(), (std::ios::out | std::ios::binary));
-      auto writer = std::make_shared<ostream_snapshot_writer>(snap_out);
-      chain.write_snapshot(writer);
-      writer->finalize();
+      if (my->_zstd_snapshots) {
+         auto writer = std::make_shared<zstd_ostream_snapshot_writer>(snap_out);
+         chain.write_snapshot(writer);
+         writer->finalize();
+         ilog("Snapshot ${p} written with integrity hash ${h}", ("p", p.generic_string())("h", writer->get_integrity_hash()));
+      } else {
+         auto writer = std::make_shared<parallel_ostream_snapshot_writer>(snap_out, p.generic_string() + ".chunks",
+                                                                          my->_snapshot_write_threads);
+         chain.write_snapshot(writer);
+         writer->finalize();
+      }
       snap_out.flush();
       snap_out.close();
    };
@@ -1370,6 +1709,21 @@ producer_plugin::get_account_ram_corrections( const get_account_ram_corrections_
    return result;
 }
 
+producer_plugin::get_unapplied_account_depths_result
+producer_plugin::get_unapplied_account_depths( const get_unapplied_account_depths_params& params ) const {
+   get_unapplied_account_depths_result result;
+   const account_name lower_bound = params.lower_bound ? *params.lower_bound : account_name();
+   my->_unapplied_transactions.for_each_account( lower_bound, [&]( const account_name& a, size_t depth ) {
+      if( result.rows.size() == params.limit ) {
+         result.more = a;
+         return false;
+      }
+      result.rows.push_back( { a, static_cast<uint32_t>( depth ) } );
+      return true;
+   } );
+   return result;
+}
+
 std::optional<fc::time_point> producer_plugin_impl::calculate_next_block_time(const account_name& producer_name, const block_timestamp_type& current_block_time) const {
    chain::controller& chain = chain_plug->chain();
    const auto& hbs = chain.head_block_state();
@@ -1625,12 +1979,16 @@ producer_plugin_impl::start_block_result producer_plugin_impl::start_block() {
          _pending_block_mode = pending_block_mode::speculating;
       }
 
+      _account_fails.report();
+      _account_fails.clear();
+      publish_incoming_precheck();
+
       try {
          if( !remove_expired_trxs( preprocess_deadline ) )
             return start_block_result::exhausted;
          if( !remove_expired_blacklisted_trxs( preprocess_deadline ) )
             return start_block_result::exhausted;
-         if( !_subjective_billing.remove_expired( _log, chain.pending_block_time(), fc::time_point::now(), preprocess_deadline ) )
+         if( !remove_expired_subjective_bills( preprocess_deadline ) )
             return start_block_result::exhausted;
 
          // limit execution of pending incoming to once per block
@@ -1747,97 +2105,10 @@ bool producer_plugin_impl::remove_expired_blacklisted_trxs( const fc::time_point
    return !exhausted;
 }
 
-namespace {
-// track multiple failures on unapplied transactions
-class account_failures {
-public:
-   constexpr static uint32_t max_failures_per_account = 3;
-
-   void add( const account_name& n, int64_t exception_code ) {
-      auto& fa = failed_accounts[n];
-      ++fa.num_failures;
-      fa.add( n, exception_code );
-   }
-
-   // return true if exceeds max_failures_per_account and should be dropped
-   bool failure_limit( const account_name& n ) {
-      auto fitr = failed_accounts.find( n );
-      if( fitr != failed_accounts.end() && fitr->second.num_failures >= max_failures_per_account ) {
-         ++fitr->second.num_failures;
-         return true;
-      }
-      return false;
-   }
-
-   void report() const {
-      if( _log.is_enabled( fc::log_level::debug ) ) {
-         for( const auto& e : failed_accounts ) {
-            std::string reason;
-            if( e.second.num_failures > max_failures_per_account ) {
-               reason.clear();
-               if( e.second.is_deadline() ) reason += "deadline";
-               if( e.second.is_tx_cpu_usage() ) {
-                  if( !reason.empty() ) reason += ", ";
-                  reason += "tx_cpu_usage";
-               }
-               if( e.second.is_eosio_assert() ) {
-                  if( !reason.empty() ) reason += ", ";
-                  reason += "assert";
-               }
-               if( e.second.is_other() ) {
-                  if( !reason.empty() ) reason += ", ";
-                  reason += "other";
-               }
-               fc_dlog( _log, "Dropped ${n} trxs, account: ${a}, reason: ${r} exceeded",
-                        ("n", e.second.num_failures - max_failures_per_account)("a", e.first)("r", reason) );
-            }
-         }
-      }
-   }
-
-private:
-   struct account_failure {
-      enum class ex_fields : uint8_t {
-         ex_deadline_exception = 1,
-         ex_tx_cpu_usage_exceeded = 2,
-         ex_eosio_assert_exception = 4,
-         ex_other_exception = 8
-      };
-
-      void add( const account_name& n, int64_t exception_code ) {
-         if( exception_code == tx_cpu_usage_exceeded::code_value ) {
-            ex_flags = set_field( ex_flags, ex_fields::ex_tx_cpu_usage_exceeded );
-         } else if( exception_code == deadline_exception::code_value ) {
-            ex_flags = set_field( ex_flags, ex_fields::ex_deadline_exception );
-         } else if( exception_code == eosio_assert_message_exception::code_value ||
-                    exception_code == eosio_assert_code_exception::code_value ) {
-            ex_flags = set_field( ex_flags, ex_fields::ex_eosio_assert_exception );
-         } else {
-            ex_flags = set_field( ex_flags, ex_fields::ex_other_exception );
-            fc_dlog( _log, "Failed trx, account: ${a}, reason: ${r}",
-                     ("a", n)("r", exception_code) );
-         }
-      }
-
-      bool is_deadline() const { return has_field( ex_flags, ex_fields::ex_deadline_exception ); }
-      bool is_tx_cpu_usage() const { return has_field( ex_flags, ex_fields::ex_tx_cpu_usage_exceeded ); }
-      bool is_eosio_assert() const { return has_field( ex_flags, ex_fields::ex_eosio_assert_exception ); }
-      bool is_other() const { return has_field( ex_flags, ex_fields::ex_other_exception ); }
-
-      uint32_t num_failures = 0;
-      uint8_t ex_flags = 0;
-   };
-
-   std::map<account_name, account_failure> failed_accounts;
-};
-
-} // anonymous namespace
-
 bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadline )
 {
    bool exhausted = false;
    if( !_unapplied_transactions.empty() ) {
-      account_failures account_fails;
       chain::controller& chain = chain_plug->chain();
       const auto& rl = chain.get_resource_limits_manager();
       int num_applied = 0, num_failed = 0, num_processed = 0;
@@ -1847,6 +2118,8 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
                      _unapplied_transactions.unapplied_begin() : _unapplied_transactions.persisted_begin();
       auto end_itr = (_pending_block_mode == pending_block_mode::producing) ?
                      _unapplied_transactions.unapplied_end()   : _unapplied_transactions.persisted_end();
+      // persisted transactions stay queued for later blocks, only the others of a failing account are dropped at once
+      const bool drop_account_in_bulk = _pending_block_mode == pending_block_mode::producing;
       while( itr != end_itr ) {
          if( deadline <= fc::time_point::now() ) {
             exhausted = true;
@@ -1860,11 +2133,15 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
             auto trx_deadline = start + fc::milliseconds( _max_transaction_time_ms );
 
             auto first_auth = trx->packed_trx()->get_transaction().first_authorizer();
-            if( account_fails.failure_limit( first_auth ) ) {
+            if( _account_fails.failure_limit( first_auth ) ) {
                ++num_failed;
+               if( itr->next ) itr->next( account_failure_limit_exception( trx->id(), first_auth ) );
                itr = _unapplied_transactions.erase( itr );
+               if( drop_account_in_bulk )
+                  num_failed += drop_account_trxs( first_auth, itr, end_itr, trx_enum_type::forked, trx_enum_type::aborted );
                continue;
             }
+            bool reached_failure_limit = false;
 
             auto prev_billed_cpu_time_us = trx->billed_cpu_time_us;
             if(!_subjective_billing.is_disabled() && prev_billed_cpu_time_us > 0 && !rl.is_unlimited_cpu( first_auth )) {
@@ -1899,12 +2176,18 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
                      fc_dlog( _log, "Failed ${c} trx, prev billed: ${p}us, ran: ${r}us, id: ${id}",
                               ("c", trace->except->code())("p", prev_billed_cpu_time_us)
                               ("r", fc::time_point::now() - start)("id", trx->id()) );
-                     account_fails.add( first_auth, failure_code );
+                     reached_failure_limit = _account_fails.add( first_auth, failure_code );
+                     if( reached_failure_limit )
+                        publish_incoming_precheck();
                      _subjective_billing.subjective_bill_failure( first_auth, trace->elapsed, fc::time_point::now() );
                   }
                   ++num_failed;
                   if( itr->next ) itr->next( trace );
                   itr = _unapplied_transactions.erase( itr );
+                  if( reached_failure_limit && drop_account_in_bulk ) {
+                     // the rest of the account's transactions are dropped at once rather than each when it is reached
+                     num_failed += drop_account_trxs( first_auth, itr, end_itr, trx_enum_type::forked, trx_enum_type::aborted );
+                  }
                   continue;
                }
             } else {
@@ -1925,7 +2208,6 @@ bool producer_plugin_impl::process_unapplied_trxs( const fc::time_point& deadlin
 
       fc_dlog( _log, "Processed ${m} of ${n} previously applied transactions, Applied ${applied}, Failed/Dropped ${failed}",
                ("m", num_processed)( "n", unapplied_trxs_size )("applied", num_applied)("failed", num_failed) );
-      account_fails.report();
    }
    return !exhausted;
 }
@@ -2060,12 +2342,74 @@ bool producer_plugin_impl::process_incoming_trxs( const fc::time_point& deadline
             exhausted = true;
             break;
          }
+         const auto first_auth = trx_meta->packed_trx()->get_transaction().first_authorizer();
+         size_t dropped = 0;
+         if( _pending_block_mode == pending_block_mode::producing && _account_fails.is_limited( first_auth ) ) {
+            dropped = drop_account_trxs( first_auth, itr, end, trx_enum_type::incoming_persisted, trx_enum_type::incoming );
+         } else {
+            dropped = drop_over_budget_trxs( first_auth, itr, end );
+         }
+         pending_incoming_process_limit -= std::min( pending_incoming_process_limit, dropped );
+         processed += dropped;
       }
       fc_dlog( _log, "Processed ${n} pending transactions, ${p} left", ("n", processed)("p", _unapplied_transactions.incoming_size()) );
    }
    return !exhausted;
 }
 
+template<typename Func>
+size_t producer_plugin_impl::erase_account_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                                 const unapplied_transaction_queue::iterator& end, trx_enum_type first, trx_enum_type last,
+                                                 Func&& reject ) {
+   // itr must not refer to a dropped transaction
+   while( itr != end && itr->trx_type >= first && itr->trx_type <= last && itr->first_authorizer() == first_auth ) {
+      ++itr;
+   }
+   return _unapplied_transactions.erase_account( first_auth, first, last, [&]( const unapplied_transaction& un ) {
+      if( un.next ) un.next( reject( un.id() ) );
+   } );
+}
+
+size_t producer_plugin_impl::drop_account_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                                const unapplied_transaction_queue::iterator& end, trx_enum_type first, trx_enum_type last ) {
+   const size_t queued = _unapplied_transactions.account_size( first_auth );
+   const size_t dropped = erase_account_trxs( first_auth, itr, end, first, last, [&]( const transaction_id_type& id ) {
+      return account_failure_limit_exception( id, first_auth );
+   } );
+   _account_fails.dropped( first_auth, dropped );
+   if( dropped ) {
+      fc_dlog( _log, "Dropped ${n} of ${q} queued trxs of account ${a}, which exceeded subjective-account-max-failures",
+               ("n", dropped)("q", queued)("a", first_auth) );
+   }
+   return dropped;
+}
+
+// the queued incoming transactions of an account whose subjective bill uses up its available cpu would each be
+// rejected when reached, they are dropped at once
+size_t producer_plugin_impl::drop_over_budget_trxs( const account_name& first_auth, unapplied_transaction_queue::iterator& itr,
+                                                    const unapplied_transaction_queue::iterator& end ) {
+   if( _pending_block_mode == pending_block_mode::producing || _subjective_billing.is_disabled() )
+      return 0;
+   // only the subjectively billed ones, the API transactions are incoming_persisted and the P2P ones incoming
+   const trx_enum_type first = _disable_subjective_api_billing ? trx_enum_type::incoming : trx_enum_type::incoming_persisted;
+   const trx_enum_type last = _disable_subjective_p2p_billing ? trx_enum_type::incoming_persisted : trx_enum_type::incoming;
+   if( first > last )
+      return 0;
+   const auto now = fc::time_point::now();
+   if( _subjective_billing.get_subjective_bill( first_auth, now ) == 0 ||
+       !_subjective_billing.exceeds_budget( first_auth, available_cpu_us( first_auth ), now ) )
+      return 0;
+   const size_t queued = _unapplied_transactions.account_size( first_auth );
+   const size_t dropped = erase_account_trxs( first_auth, itr, end, first, last, [&]( const transaction_id_type& id ) {
+      return subjective_budget_exception( id, first_auth );
+   } );
+   if( dropped ) {
+      fc_dlog( _log, "Dropped ${n} of ${q} queued trxs of account ${a}, whose subjective cpu bill exceeds its available cpu",
+               ("n", dropped)("q", queued)("a", first_auth) );
+   }
+   return dropped;
+}
+
 bool producer_plugin_impl::block_is_exhausted() const {
    const chain::controller& chain = chain_plug->chain();
    const auto& rl = chain.get_resource_limits_manager();
@@ -0,0 +1,139 @@
+#define BOOST_TEST_MODULE admission_queue
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/producer_plugin/admission_queue.hpp>
+
+#include <eosio/testing/tester.hpp>
+
+namespace {
+
+using namespace eosio;
+using namespace eosio::chain;
+
+BOOST_AUTO_TEST_SUITE( admission_queue_test )
+
+BOOST_AUTO_TEST_CASE( fairness_test ) {
+   admission_queue<int> q;
+   std::vector<int> dropped;
+   const auto now = fc::time_point::now();
+   account_name a = "a"_n;
+   account_name b = "b"_n;
+   account_name c = "c"_n;
+
+   BOOST_CHECK( q.push( admission_class::p2p, a, 10, now, 1, dropped ) );
+   BOOST_CHECK( !q.push( admission_class::p2p, a, 10, now, 2, dropped ) );
+   q.push( admission_class::p2p, a, 10, now, 3, dropped );
+   q.push( admission_class::p2p, b, 10, now, 4, dropped );
+   q.push( admission_class::p2p, c, 10, now, 5, dropped );
+   q.push( admission_class::p2p, b, 10, now, 6, dropped );
+   BOOST_CHECK( dropped.empty() );
+   BOOST_CHECK_EQUAL( 6u, q.size() );
+
+   // accounts take turns, a's burst does not delay b and c
+   std::vector<int> order;
+   while( auto e = q.pop( now ) )
+      order.push_back( e->payload );
+   BOOST_CHECK( order == std::vector<int>({1, 4, 5, 2, 6, 3}) );
+   BOOST_CHECK( q.empty() );
+}
+
+BOOST_AUTO_TEST_CASE( class_weight_test ) {
+   admission_queue<int> q;
+   q.configure( 1024, admission_drop_policy::newest, 2 );
+   std::vector<int> dropped;
+   const auto now = fc::time_point::now();
+   account_name a = "a"_n;
+
+   for( int i = 0; i < 4; ++i ) {
+      q.push( admission_class::p2p, a, 1, now, 100 + i, dropped );
+      q.push( admission_class::api, a, 1, now, i, dropped );
+   }
+
+   std::vector<int> order;
+   while( auto e = q.pop( now ) )
+      order.push_back( e->payload );
+   BOOST_CHECK( order == std::vector<int>({0, 1, 100, 2, 3, 101, 102, 103}) );
+}
+
+BOOST_AUTO_TEST_CASE( drop_newest_test ) {
+   admission_queue<int> q;
+   q.configure( 30, admission_drop_policy::newest, 1 );
+   std::vector<int> dropped;
+   const auto now = fc::time_point::now();
+   account_name a = "a"_n;
+   account_name b = "b"_n;
+
+   q.push( admission_class::p2p, a, 10, now, 1, dropped );
+   q.push( admission_class::p2p, a, 10, now, 2, dropped );
+   q.push( admission_class::p2p, a, 10, now, 3, dropped );
+   q.push( admission_class::p2p, b, 10, now, 4, dropped );
+   BOOST_CHECK( dropped == std::vector<int>({4}) );
+
+   // classes are bounded separately
+   q.push( admission_class::api, b, 10, now, 5, dropped );
+   BOOST_CHECK_EQUAL( 1u, dropped.size() );
+   BOOST_CHECK_EQUAL( 4u, q.size() );
+
+   auto stats = q.stats( admission_class::p2p );
+   BOOST_CHECK_EQUAL( 3u, stats.depth );
+   BOOST_CHECK_EQUAL( 30u, stats.bytes );
+   BOOST_CHECK_EQUAL( 1u, stats.accounts );
+   BOOST_CHECK_EQUAL( 3u, stats.admitted );
+   BOOST_CHECK_EQUAL( 1u, stats.dropped );
+}
+
+BOOST_AUTO_TEST_CASE( drop_heaviest_account_test ) {
+   admission_queue<int> q;
+   q.configure( 40, admission_drop_policy::heaviest_account, 1 );
+   std::vector<int> dropped;
+   const auto now = fc::time_point::now();
+   account_name a = "a"_n;
+   account_name b = "b"_n;
+
+   q.push( admission_class::p2p, a, 10, now, 1, dropped );
+   q.push( admission_class::p2p, a, 10, now, 2, dropped );
+   q.push( admission_class::p2p, a, 10, now, 3, dropped );
+   q.push( admission_class::p2p, b, 10, now, 4, dropped );
+   BOOST_CHECK( dropped.empty() );
+
+   // b makes room by dropping the newest of a
+   q.push( admission_class::p2p, b, 10, now, 5, dropped );
+   BOOST_CHECK( dropped == std::vector<int>({3}) );
+
+   // a is not heavier than b would be, so the arriving transaction is dropped
+   dropped.clear();
+   q.push( admission_class::p2p, a, 10, now, 6, dropped );
+   BOOST_CHECK( dropped == std::vector<int>({6}) );
+
+   std::vector<int> order;
+   while( auto e = q.pop( now ) )
+      order.push_back( e->payload );
+   BOOST_CHECK( order == std::vector<int>({1, 4, 2, 5}) );
+}
+
+BOOST_AUTO_TEST_CASE( latency_test ) {
+   admission_queue<int> q;
+   std::vector<int> dropped;
+   const auto now = fc::time_point::now();
+   account_name a = "a"_n;
+
+   q.push( admission_class::api, a, 10, now, 1, dropped );
+   q.push( admission_class::api, a, 10, now + fc::microseconds( 100 ), 2, dropped );
+   q.pop( now + fc::microseconds( 200 ) );
+   q.pop( now + fc::microseconds( 200 ) );
+
+   auto stats = q.stats( admission_class::api );
+   BOOST_CHECK_EQUAL( 2u, stats.taken );
+   BOOST_CHECK_EQUAL( 150, stats.avg_latency_us );
+   BOOST_CHECK_EQUAL( 200, stats.max_latency_us );
+
+   // reset by the previous call
+   stats = q.stats( admission_class::api );
+   BOOST_CHECK_EQUAL( 0u, stats.taken );
+   BOOST_CHECK_EQUAL( 0, stats.max_latency_us );
+   BOOST_CHECK_EQUAL( 2u, stats.admitted );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
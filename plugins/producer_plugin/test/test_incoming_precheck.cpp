@@ -0,0 +1,95 @@
+#define BOOST_TEST_MODULE incoming_precheck
+#include <boost/test/included/unit_test.hpp>
+
+#include <eosio/producer_plugin/incoming_precheck.hpp>
+
+#include <eosio/testing/tester.hpp>
+
+#include <atomic>
+#include <thread>
+
+namespace {
+
+using namespace eosio;
+using namespace eosio::chain;
+
+packed_transaction make_trx( const account_name& first_auth, const fc::time_point_sec& expiration ) {
+   signed_transaction trx;
+   trx.expiration = expiration;
+   trx.actions.emplace_back( vector<permission_level>{{first_auth, config::active_name}}, "eosio"_n, "noop"_n, bytes{} );
+   return packed_transaction( std::move( trx ), true );
+}
+
+BOOST_AUTO_TEST_SUITE( incoming_precheck_test )
+
+BOOST_AUTO_TEST_CASE( precheck_test ) {
+   incoming_precheck precheck;
+   account_name a = "a"_n;
+   account_name b = "b"_n;
+   const fc::time_point_sec block_time( 1000 );
+   const auto trx_a = make_trx( a, fc::time_point_sec( 1060 ) );
+   const auto trx_b = make_trx( b, fc::time_point_sec( 1060 ) );
+   const auto expired_b = make_trx( b, fc::time_point_sec( 999 ) );
+
+   // nothing published yet, everything goes to the main thread
+   BOOST_CHECK( !precheck.check( trx_a ) );
+   BOOST_CHECK( !precheck.check( expired_b ) );
+
+   precheck.publish( block_time, { a } );
+   auto ex = precheck.check( trx_a );
+   BOOST_REQUIRE( ex );
+   BOOST_CHECK_EQUAL( tx_resource_exhaustion::code_value, ex->code() );
+   BOOST_CHECK( !precheck.check( trx_b ) );
+   ex = precheck.check( expired_b );
+   BOOST_REQUIRE( ex );
+   BOOST_CHECK_EQUAL( expired_tx_exception::code_value, ex->code() );
+   // expiring with the block time is not expired yet
+   BOOST_CHECK( !precheck.check( make_trx( b, block_time ) ) );
+
+   // what a speculating node publishes, no account is limited
+   precheck.publish( block_time, {} );
+   BOOST_CHECK( !precheck.check( trx_a ) );
+   BOOST_CHECK( precheck.check( expired_b ) );
+}
+
+BOOST_AUTO_TEST_CASE( disabled_test ) {
+   incoming_precheck precheck;
+   precheck.set_enabled( false );
+   BOOST_CHECK( !precheck.is_enabled() );
+   const fc::time_point_sec block_time( 1000 );
+
+   precheck.publish( block_time, { "a"_n } );
+   BOOST_CHECK( !precheck.check( make_trx( "a"_n, fc::time_point_sec( 1060 ) ) ) );
+   BOOST_CHECK( !precheck.check( make_trx( "b"_n, fc::time_point_sec( 999 ) ) ) );
+}
+
+BOOST_AUTO_TEST_CASE( concurrent_publish_test ) {
+   incoming_precheck precheck;
+   account_name a = "a"_n;
+   const fc::time_point_sec block_time( 1000 );
+   const auto trx_a = make_trx( a, fc::time_point_sec( 1060 ) );
+
+   // the producer threads check while the main thread publishes
+   std::atomic<bool> done = false;
+   std::atomic<uint32_t> unexpected = 0;
+   std::thread checker( [&]() {
+      while( !done ) {
+         auto ex = precheck.check( trx_a );
+         if( ex && ex->code() != tx_resource_exhaustion::code_value )
+            ++unexpected;
+      }
+   } );
+   for( int i = 0; i < 10000; ++i ) {
+      std::set<account_name> limited;
+      if( i % 2 )
+         limited.insert( a );
+      precheck.publish( block_time, std::move( limited ) );
+   }
+   done = true;
+   checker.join();
+   BOOST_CHECK_EQUAL( 0u, unexpected.load() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
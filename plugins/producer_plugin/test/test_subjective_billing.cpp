@@ -47,8 +47,12 @@ BOOST_AUTO_TEST_CASE( subjective_bill_test ) {
       BOOST_CHECK_EQUAL( 13+11, sub_bill.get_subjective_bill(a, now) );
       BOOST_CHECK_EQUAL( 9, sub_bill.get_subjective_bill(b, now) );
 
+      // nothing expires once the deadline has passed, the rest is left for the next call
+      BOOST_CHECK( !sub_bill.remove_expired( log, now + fc::microseconds(1), now, fc::time_point() ) );
+      BOOST_CHECK_EQUAL( 13+11, sub_bill.get_subjective_bill(a, now) );
+
       // expires transactions but leaves them in the decay at full value
-      sub_bill.remove_expired( log, now + fc::microseconds(1), now, fc::time_point::maximum() );
+      BOOST_CHECK( sub_bill.remove_expired( log, now + fc::microseconds(1), now, fc::time_point::maximum() ) );
 
       BOOST_CHECK_EQUAL( 13+11, sub_bill.get_subjective_bill(a, now) );
       BOOST_CHECK_EQUAL( 9, sub_bill.get_subjective_bill(b, now) );
@@ -126,6 +130,20 @@ BOOST_AUTO_TEST_CASE( subjective_bill_test ) {
       BOOST_CHECK_EQUAL( 256 + 512 + 1024, sub_bill.get_subjective_bill(a, endtime) );
       BOOST_CHECK_EQUAL( 0, sub_bill.get_subjective_bill(b, endtime) );
    }
+   { // budget, the subjective bill against the cpu available to the account
+      subjective_billing sub_bill;
+
+      sub_bill.subjective_bill_failure(a, fc::microseconds(1024), now);
+      BOOST_CHECK( sub_bill.exceeds_budget(a, 1000, now) );
+      BOOST_CHECK( sub_bill.exceeds_budget(a, 1024, now) );
+      BOOST_CHECK( !sub_bill.exceeds_budget(a, 1025, now) );
+      BOOST_CHECK( !sub_bill.exceeds_budget(a, 1000, endtime) ); // decayed
+      BOOST_CHECK( !sub_bill.exceeds_budget(a, -1, now) ); // unlimited
+      BOOST_CHECK( !sub_bill.exceeds_budget(b, 0, now) ); // nothing billed
+
+      sub_bill.disable_account(a);
+      BOOST_CHECK( !sub_bill.exceeds_budget(a, 1000, now) );
+   }
 
    { // expired handling logic, full billing until expiration then failed/decay logic
       subjective_billing sub_bill;
@@ -1,4 +1,5 @@
 #include <eosio/chain/config.hpp>
+#include <eosio/chain/thread_utils.hpp>
 #include <eosio/resource_monitor_plugin/resource_monitor_plugin.hpp>
 #include <eosio/state_history/log.hpp>
 #include <eosio/state_history/serialization.hpp>
@@ -46,15 +47,37 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
    chain_plugin*                                              chain_plug = nullptr;
    std::optional<state_history_traces_log>                    trace_log;
    std::optional<state_history_chain_state_log>               chain_state_log;
-   bool                                                       stopping = false;
+   std::atomic<bool>                                          stopping = false;
    std::optional<scoped_connection>                           applied_transaction_connection;
    std::optional<scoped_connection>                           block_start_connection;
    std::optional<scoped_connection>                           accepted_block_connection;
    string                                                     endpoint_address = "0.0.0.0";
    uint16_t                                                   endpoint_port    = 8080;
+   uint16_t                                                   thread_pool_size = 2;
+   std::optional<named_thread_pool>                           thread_pool;
    std::unique_ptr<tcp::acceptor>                             acceptor;
 
-   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+   // chain positions published by the main thread for the sessions running on the thread pool
+   std::mutex                                                 head_mtx;
+   block_state_ptr                                            head_block_state;
+   block_position                                             last_irreversible;
+   fc::sha256                                                 chain_id;
+
+   std::pair<block_state_ptr, block_position> get_head_and_lib() {
+      std::lock_guard<std::mutex> g(head_mtx);
+      return {head_block_state, last_irreversible};
+   }
+
+   // must be called on the main thread
+   void update_head_and_lib(const block_state_ptr& block_state) {
+      auto&                       chain = chain_plug->chain();
+      std::lock_guard<std::mutex> g(head_mtx);
+      head_block_state  = block_state;
+      last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+   }
+
+   // thread safe, only consults the state history logs
+   std::optional<chain::block_id_type> get_log_block_id(uint32_t block_num) {
       std::optional<chain::block_id_type> result;
 
       if (trace_log)
@@ -63,6 +86,12 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       if (!result && chain_state_log)
          result = chain_state_log->get_block_id(block_num);
 
+      return result;
+   }
+
+   // must be called on the main thread
+   std::optional<chain::block_id_type> get_block_id(uint32_t block_num) {
+      auto result = get_log_block_id(block_num);
       if (result)
          return result;
 
@@ -73,19 +102,68 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
    }
 
-   using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1>;
+   using get_blocks_request = std::variant<get_blocks_request_v0, get_blocks_request_v1, get_blocks_request_v2>;
+
+   // must be called on the main thread
+   template <typename T>
+   void resolve_have_positions(T& req) {
+      for (auto& cp : req.have_positions) {
+         if (req.start_block_num <= cp.block_num)
+            continue;
+         auto id = get_block_id(cp.block_num);
+         if (!id || *id != cp.block_id)
+            req.start_block_num = std::min(req.start_block_num, cp.block_num);
+
+         if (!id) {
+            fc_dlog(_log, "block ${block_num} is not available", ("block_num", cp.block_num));
+         } else if (*id != cp.block_id) {
+            fc_dlog(_log, "the id for block ${block_num} in block request have_positions does not match the existing", ("block_num", cp.block_num));
+         }
+      }
+      req.have_positions.clear();
+   }
+
+   struct block_data {
+      std::optional<chain::block_id_type> id;
+      std::optional<chain::block_id_type> prev_id;
+      signed_block_ptr                    block;
+   };
 
+   // must be called on the main thread, fills in whatever could not be found in the state history logs
+   void fetch_block_data(uint32_t block_num, bool need_block, block_data& data) {
+      if (!data.id)
+         data.id = get_block_id(block_num);
+      if (!data.prev_id)
+         data.prev_id = get_block_id(block_num - 1);
+      if (need_block && !data.block) {
+         try {
+            data.block = chain_plug->chain().fetch_block_by_number(block_num);
+         } catch (...) {
+         }
+      }
+   }
+
+   /**
+    * A session runs on the state history thread pool, all of its members are only accessed through its strand.
+    * The chain itself may only be accessed on the main thread, so lookups which cannot be served from the
+    * state history logs are posted to the main thread by on_main_thread().
+    */
    struct session : std::enable_shared_from_this<session> {
       std::shared_ptr<state_history_plugin_impl> plugin;
+      boost::asio::io_context::strand            strand;
       std::unique_ptr<ws::stream<tcp::socket>>   socket_stream;
       bool                                       sending  = false;
       bool                                       sent_abi = false;
-      std::vector<std::vector<char>>             send_queue;
+      bool                                       fetching = false; // waiting for block data from the main thread
+      bool                                       resolving_request = false; // reads resume once the request is resolved
+      std::vector<std::vector<std::vector<char>>> send_queue; // each message is written from one or more buffers
       std::optional<get_blocks_request>          current_request;
+      uint32_t                                   request_seq = 0;
       bool                                       need_to_send_update = false;
 
       session(std::shared_ptr<state_history_plugin_impl> plugin)
-          : plugin(std::move(plugin)) {}
+          : plugin(std::move(plugin))
+          , strand(this->plugin->thread_pool->get_executor()) {}
 
       void start(tcp::socket socket) {
          fc_ilog(_log, "incoming connection");
@@ -94,18 +172,18 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          socket_stream->next_layer().set_option(boost::asio::ip::tcp::no_delay(true));
          socket_stream->next_layer().set_option(boost::asio::socket_base::send_buffer_size(1024 * 1024));
          socket_stream->next_layer().set_option(boost::asio::socket_base::receive_buffer_size(1024 * 1024));
-         socket_stream->async_accept([self = shared_from_this()](boost::system::error_code ec) {
+         socket_stream->async_accept(boost::asio::bind_executor(strand, [self = shared_from_this()](boost::system::error_code ec) {
             self->callback(ec, "async_accept", [self] {
                self->start_read();
                self->send(state_history_plugin_abi);
             });
-         });
+         }));
       }
 
       void start_read() {
          auto in_buffer = std::make_shared<boost::beast::flat_buffer>();
          socket_stream->async_read(
-             *in_buffer, [self = shared_from_this(), in_buffer](boost::system::error_code ec, size_t) {
+             *in_buffer, boost::asio::bind_executor(strand, [self = shared_from_this(), in_buffer](boost::system::error_code ec, size_t) {
                 self->callback(ec, "async_read", [self, in_buffer] {
                    auto d = boost::asio::buffer_cast<char const*>(boost::beast::buffers_front(in_buffer->data()));
                    auto s = boost::asio::buffer_size(in_buffer->data());
@@ -113,19 +191,33 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
                    state_request               req;
                    fc::raw::unpack(ds, req);
                    std::visit(*self, req);
-                   self->start_read();
+                   if (!self->resolving_request)
+                      self->start_read();
                 });
-             });
+             }));
       }
 
       void send(const char* s) {
-         send_queue.push_back({s, s + strlen(s)});
+         send_queue.push_back({{s, s + strlen(s)}});
          send();
       }
 
       template <typename T>
       void send(T obj) {
-         send_queue.push_back(fc::raw::pack(state_result{std::move(obj)}));
+         send_queue.push_back({fc::raw::pack(state_result{std::move(obj)})});
+         send();
+      }
+
+      // the log entries are not copied into the serialized result, they are gathered into the same websocket write
+      void send(get_blocks_result_v3 obj) {
+         fc::datastream<std::vector<char>> traces_header;
+         fc::datastream<std::vector<char>> deltas_header;
+         fc::raw::pack(traces_header, fc::unsigned_int(fc::get_index<state_result, get_blocks_result_v3>()));
+         fc::pack_blocks_result_v3_header(traces_header, obj);
+         fc::pack_log_entry_header(traces_header, obj.traces);
+         fc::pack_log_entry_header(deltas_header, obj.deltas);
+         send_queue.push_back({std::move(traces_header.storage()), std::move(obj.traces.data),
+                               std::move(deltas_header.storage()), std::move(obj.deltas.data)});
          send();
       }
 
@@ -137,25 +229,51 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          sending = true;
          socket_stream->binary(sent_abi);
          sent_abi = true;
+         auto buffers = std::make_shared<std::vector<boost::asio::const_buffer>>();
+         for (const auto& part : send_queue[0]) {
+            if (part.size())
+               buffers->push_back(boost::asio::buffer(part));
+         }
          socket_stream->async_write( //
-             boost::asio::buffer(send_queue[0]),
-             [self = shared_from_this()](boost::system::error_code ec, size_t) {
+             *buffers,
+             boost::asio::bind_executor(strand, [self = shared_from_this(), buffers](boost::system::error_code ec, size_t) {
                 self->callback(ec, "async_write", [self] {
                    self->send_queue.erase(self->send_queue.begin());
                    self->sending = false;
                    self->send();
                 });
-             });
+             }));
+      }
+
+      /**
+       * Runs f() on the main thread and passes its result to then() back on the session strand.
+       * The session is closed if f() throws.
+       */
+      template <typename F, typename Then>
+      void on_main_thread(F f, Then then) {
+         app().post(priority::medium, [self = shared_from_this(), f = std::move(f), then = std::move(then)]() mutable {
+            if (self->plugin->stopping)
+               return;
+            std::optional<decltype(f())> result;
+            catch_and_log([&] { result.emplace(f()); });
+            boost::asio::post(self->strand, [self, result = std::move(result), then = std::move(then)]() mutable {
+               if (self->plugin->stopping)
+                  return;
+               if (!result)
+                  return self->close();
+               self->catch_and_close([&] { then(std::move(*result)); });
+            });
+         });
       }
 
       using result_type = void;
       void operator()(get_status_request_v0&) {
          fc_ilog(_log, "got get_status_request_v0");
-         auto&                chain = plugin->chain_plug->chain();
+         auto [head, lib] = plugin->get_head_and_lib();
          get_status_result_v0 result;
-         result.head              = {chain.head_block_num(), chain.head_block_id()};
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
-         result.chain_id          = chain.get_chain_id();
+         result.head              = {head->block_num, head->id};
+         result.last_irreversible = lib;
+         result.chain_id          = plugin->chain_id;
          if (plugin->trace_log) {
             result.trace_begin_block = plugin->trace_log->begin_block();
             result.trace_end_block   = plugin->trace_log->end_block();
@@ -172,25 +290,20 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       std::enable_if_t<std::is_base_of_v<get_blocks_request_v0,T>>
       operator()(T& req) {
          fc_ilog(_log, "received get_blocks_request = ${req}", ("req",req) );
-         for (auto& cp : req.have_positions) {
-            if (req.start_block_num <= cp.block_num)
-               continue;
-            auto id = plugin->get_block_id(cp.block_num);
-            if (!id || *id != cp.block_id)
-               req.start_block_num = std::min(req.start_block_num, cp.block_num);
-
-            if (!id) {
-               fc_dlog(_log, "block ${block_num} is not available", ("block_num", cp.block_num));
-            } else if (*id != cp.block_id) {
-               fc_dlog(_log, "the id for block ${block_num} in block request have_positions does not match the existing", ("block_num", cp.block_num));
-            }         
-         }
-         req.have_positions.clear();
-         fc_dlog(_log, "  get_blocks_request start_block_num set to ${num}", ("num", req.start_block_num));
-
-         current_request = req;
-         
-         send_update(true);
+         resolving_request = true;
+         on_main_thread(
+             [plugin = plugin, req]() mutable {
+                plugin->resolve_have_positions(req);
+                return req;
+             },
+             [this](T req) {
+                fc_dlog(_log, "  get_blocks_request start_block_num set to ${num}", ("num", req.start_block_num));
+                current_request = std::move(req);
+                ++request_seq;
+                resolving_request = false;
+                start_read();
+                send_update(true);
+             });
       }
 
       void operator()(get_blocks_ack_request_v0& ack_req) {
@@ -205,74 +318,130 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          send_update();
       }
 
+      bool fetch_block_header() const {
+         return std::visit(
+             [](const auto& req) {
+                if constexpr (std::is_base_of_v<get_blocks_request_v1, std::decay_t<decltype(req)>>)
+                   return req.fetch_block_header;
+                else
+                   return false;
+             },
+             *current_request);
+      }
+
+      bool fetch_compressed_entries() const {
+         auto req = std::get_if<get_blocks_request_v2>(&*current_request);
+         return req && req->fetch_compressed_entries;
+      }
+
       void set_result_block_header(get_blocks_result_v1&, const signed_block_ptr& block) {}
-      void set_result_block_header(get_blocks_result_v2& result, const signed_block_ptr& block) {
-         bool fetch_block_header = std::get<get_blocks_request_v1>(*current_request).fetch_block_header;
-         if (fetch_block_header && block) {
+      template <typename T>
+      std::enable_if_t<std::is_same_v<get_blocks_result_v2,T> || std::is_same_v<get_blocks_result_v3,T>>
+      set_result_block_header(T& result, const signed_block_ptr& block) {
+         if (fetch_block_header() && block) {
             result.block_header = static_cast<const signed_block_header&>(*block); 
          }
       }
 
+      template <typename T>
+      void set_result_log_entries(T& result, uint32_t block_num, const get_blocks_request_v0& block_req) {
+         if (block_req.fetch_traces && plugin->trace_log) {
+            result.traces = plugin->trace_log->get_log_entry(block_num);
+         }
+         if (block_req.fetch_deltas && plugin->chain_state_log) {
+            result.deltas = plugin->chain_state_log->get_log_entry(block_num);
+         }
+      }
+
+      void set_result_log_entries(get_blocks_result_v3& result, uint32_t block_num, const get_blocks_request_v0& block_req) {
+         bool compressed = fetch_compressed_entries();
+         if (block_req.fetch_traces && plugin->trace_log) {
+            if (compressed)
+               result.traces = plugin->trace_log->get_stored_log_entry(block_num);
+            else
+               result.traces.data = plugin->trace_log->get_log_entry(block_num);
+         }
+         if (block_req.fetch_deltas && plugin->chain_state_log) {
+            if (compressed)
+               result.deltas = plugin->chain_state_log->get_stored_log_entry(block_num);
+            else
+               result.deltas.data = plugin->chain_state_log->get_log_entry(block_num);
+         }
+      }
+
       uint32_t max_messages_in_flight() const {
          if (current_request)
             return std::visit( [](const auto& x){ return x.max_messages_in_flight; }, *current_request);
          return 0;
       }
 
+      get_blocks_request_v0& get_block_request() {
+         return std::visit([](auto& x) -> get_blocks_request_v0& { return x; }, *current_request);
+      }
+
       template <typename T>
-      std::enable_if_t<std::is_same_v<get_blocks_result_v1,T> || std::is_same_v<get_blocks_result_v2,T>>
+      std::enable_if_t<std::is_same_v<get_blocks_result_v1,T> || std::is_same_v<get_blocks_result_v2,T> ||
+                       std::is_same_v<get_blocks_result_v3,T>>
       send_update(const block_state_ptr& head_block_state, T&& result) {
          need_to_send_update = true;
-         if (!send_queue.empty() || !max_messages_in_flight() )
+         if (fetching || !send_queue.empty() || !max_messages_in_flight() )
             return;
-         get_blocks_request_v0& block_req = std::visit([](auto& x) ->get_blocks_request_v0&{  return x; }, *current_request);
-         
-         auto& chain              = plugin->chain_plug->chain();
-         result.last_irreversible = {chain.last_irreversible_block_num(), chain.last_irreversible_block_id()};
+         get_blocks_request_v0& block_req = get_block_request();
+
+         result.last_irreversible = plugin->get_head_and_lib().second;
          uint32_t current =
                block_req.irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
-         if (block_req.start_block_num <= current &&
-             block_req.start_block_num < block_req.end_block_num) {
-
-            auto& block_num = block_req.start_block_num;
-            auto block_id  = plugin->get_block_id(block_num);
-
-            auto get_block = [&chain, block_num, head_block_state]() -> signed_block_ptr {
-               try {
-                  if (head_block_state->block_num == block_num)
-                     return head_block_state->block;
-                  return chain.fetch_block_by_number(block_num);
-               } catch (...) {
-                  return {};
-               }
-            };
-
-            if (block_id) {
-               result.this_block  = block_position{block_num, *block_id};
-               auto prev_block_id = plugin->get_block_id(block_num - 1);
-               if (prev_block_id) 
-                  result.prev_block = block_position{block_num - 1, *prev_block_id};
-               if (block_req.fetch_block) {
-                  result.block = signed_block_ptr_variant{get_block()};
-               }
-               if (block_req.fetch_traces && plugin->trace_log) {
-                  result.traces = plugin->trace_log->get_log_entry(block_num);
-               }
-               if (block_req.fetch_deltas && plugin->chain_state_log) {
-                  result.deltas = plugin->chain_state_log->get_log_entry(block_num);
-               }
-               set_result_block_header(result, get_block());
+         if (block_req.start_block_num > current || block_req.start_block_num >= block_req.end_block_num)
+            return;
+
+         uint32_t   block_num  = block_req.start_block_num++;
+         bool       need_block = block_req.fetch_block || fetch_block_header();
+         block_data data{plugin->get_log_block_id(block_num), plugin->get_log_block_id(block_num - 1)};
+         if (need_block && head_block_state->block_num == block_num)
+            data.block = head_block_state->block;
+
+         if (data.id && data.prev_id && (!need_block || data.block))
+            return send_block_result(std::move(result), block_num, data);
+
+         fetching = true;
+         on_main_thread(
+             [plugin = plugin, block_num, need_block, data]() mutable {
+                plugin->fetch_block_data(block_num, need_block, data);
+                return data;
+             },
+             [this, result = std::move(result), block_num, seq = request_seq](block_data data) mutable {
+                fetching = false;
+                if (seq != request_seq)
+                   return send_update();
+                send_block_result(std::move(result), block_num, data);
+             });
+      }
+
+      // reads and decodes the log entries of block_num and queues the result
+      template <typename T>
+      void send_block_result(T&& result, uint32_t block_num, const block_data& data) {
+         get_blocks_request_v0& block_req = get_block_request();
+         if (data.id) {
+            result.this_block = block_position{block_num, *data.id};
+            if (data.prev_id)
+               result.prev_block = block_position{block_num - 1, *data.prev_id};
+            if (block_req.fetch_block) {
+               result.block = signed_block_ptr_variant{data.block};
             }
-            ++block_num;
+            set_result_log_entries(result, block_num, block_req);
+            set_result_block_header(result, data.block);
          }
          if (!result.has_value())
             return;
+         uint32_t current =
+               block_req.irreversible_only ? result.last_irreversible.block_num : result.head.block_num;
          fc_ilog(_log,
                  "pushing result "
                  "{\"head\":{\"block_num\":${head}},\"last_irreversible\":{\"block_num\":${last_irr}},\"this_block\":{"
                  "\"block_num\":${this_block}}} to send queue",
                  ("head", result.head.block_num)("last_irr", result.last_irreversible.block_num)(
                      "this_block", result.this_block ? result.this_block->block_num : fc::variant()));
+         auto block = result.block;
          send(std::move(result));
          --block_req.max_messages_in_flight;
          need_to_send_update = block_req.start_block_num <= current &&
@@ -289,14 +458,15 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
                   fc_add_tag( blk_span, "block_time", ptr->timestamp.to_time_point() );
                }
             }
-         }, result.block );
+         }, block );
       }
 
       void send_update_for_block(const block_state_ptr& head_block_state) {
          std::visit(
              [&head_block_state, this](const auto& req) {
-                // send get_blocks_result_v1 when the request is get_blocks_request_v0 and
-                // send send_block_result_v2 when the request is get_blocks_request_v1. 
+                // send get_blocks_result_v1 when the request is get_blocks_request_v0,
+                // send get_blocks_result_v2 when the request is get_blocks_request_v1 and
+                // send get_blocks_result_v3 when the request is get_blocks_request_v2.
                 if (head_block_state->block) {
                   typename std::decay_t<decltype(req)>::response_type result;
                   result.head = { head_block_state->block_num, head_block_state->id };
@@ -308,7 +478,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       void send_update(const block_state_ptr& block_state) {
          need_to_send_update = true;
-         if (!send_queue.empty() || !max_messages_in_flight())
+         if (fetching || !send_queue.empty() || !max_messages_in_flight())
             return;
 
          send_update_for_block(block_state);
@@ -317,11 +487,21 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       void send_update(bool changed = false) {
          if (changed)
             need_to_send_update = true;
-         if (!send_queue.empty() || !need_to_send_update || 
+         if (fetching || !send_queue.empty() || !need_to_send_update || 
              !max_messages_in_flight())
             return;
-         auto& chain = plugin->chain_plug->chain();
-         send_update_for_block(chain.head_block_state());
+         send_update_for_block(plugin->get_head_and_lib().first);
+      }
+
+      void on_accepted_block(const block_state_ptr& block_state) {
+         if (current_request) {
+            uint32_t& req_start_block_num =
+                std::visit([](auto& req) -> uint32_t& { return req.start_block_num; }, *current_request);
+            if (block_state->block_num < req_start_block_num) {
+               req_start_block_num = block_state->block_num;
+            }
+         }
+         send_update(block_state);
       }
 
       template <typename F>
@@ -340,15 +520,14 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
          }
       }
 
+      // called on the session strand, the handlers of the socket are bound to it
       template <typename F>
       void callback(boost::system::error_code ec, const char* what, F f) {
-         app().post( priority::medium, [=]() {
-            if( plugin->stopping )
-               return;
-            if( ec )
-               return on_fail( ec, what );
-            catch_and_close( f );
-         } );
+         if( plugin->stopping )
+            return;
+         if( ec )
+            return on_fail( ec, what );
+         catch_and_close( f );
       }
 
       void on_fail(boost::system::error_code ec, const char* what) {
@@ -361,10 +540,15 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       }
 
       void close() {
-         socket_stream->next_layer().close();
+         if (socket_stream) {
+            boost::system::error_code ec;
+            socket_stream->next_layer().close(ec);
+         }
+         std::lock_guard<std::mutex> g(plugin->sessions_mtx);
          plugin->sessions.erase(this);
       }
    };
+   std::mutex                                    sessions_mtx; // sessions are added and closed on the thread pool
    std::map<session*, std::shared_ptr<session>> sessions;
 
    void listen() {
@@ -372,7 +556,7 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
 
       auto address  = boost::asio::ip::make_address(endpoint_address);
       auto endpoint = tcp::endpoint{address, endpoint_port};
-      acceptor      = std::make_unique<tcp::acceptor>(app().get_io_service());
+      acceptor      = std::make_unique<tcp::acceptor>(thread_pool->get_executor());
 
       auto check_ec = [&](const char* what) {
          if (!ec)
@@ -391,8 +575,9 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       do_accept();
    }
 
+   // only one accept is outstanding at a time, so its handler never runs concurrently with itself
    void do_accept() {
-      auto socket = std::make_shared<tcp::socket>(app().get_io_service());
+      auto socket = std::make_shared<tcp::socket>(thread_pool->get_executor());
       acceptor->async_accept(*socket, [self = shared_from_this(), socket, this](const boost::system::error_code& ec) {
          if (stopping)
             return;
@@ -402,9 +587,12 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
             return;
          }
          catch_and_log([&] {
-            auto s            = std::make_shared<session>(self);
-            sessions[s.get()] = s;
-            s->start(std::move(*socket));
+            auto s = std::make_shared<session>(self);
+            {
+               std::lock_guard<std::mutex> g(sessions_mtx);
+               sessions[s.get()] = s;
+            }
+            boost::asio::post(s->strand, [s, socket]() { s->catch_and_close([&] { s->start(std::move(*socket)); }); });
          });
          catch_and_log([&] { do_accept(); });
       });
@@ -442,17 +630,18 @@ struct state_history_plugin_impl : std::enable_shared_from_this<state_history_pl
       fc_add_tag(blk_span, "block_num", block_state->block_num);
       fc_add_tag(blk_span, "block_time", block_state->block->timestamp.to_time_point());
       this->store(block_state);
+      update_head_and_lib(block_state);
+
+      // sessions read, decode and send the new entries on the thread pool
+      std::lock_guard<std::mutex> g(sessions_mtx);
       for (auto& s : sessions) {
          auto& p = s.second;
          if (p) {
-            if (p->current_request) {
-               uint32_t& req_start_block_num =
-                   std::visit([](auto& req) -> uint32_t& { return req.start_block_num; }, *p->current_request);
-               if (block_state->block_num < req_start_block_num) {
-                  req_start_block_num = block_state->block_num;
-               }
-            }
-            p->send_update(block_state);
+            boost::asio::post(p->strand, [p, block_state]() {
+               if (p->plugin->stopping)
+                  return;
+               p->catch_and_close([&] { p->on_accepted_block(block_state); });
+            });
          }
       }
    }
@@ -495,6 +684,20 @@ void state_history_plugin::set_program_options(options_description& cli, options
    options("state-history-endpoint", bpo::value<string>()->default_value("127.0.0.1:8080"),
            "the endpoint upon which to listen for incoming connections. Caution: only expose this port to "
            "your internal network.");
+   options("state-history-threads", bpo::value<uint16_t>()->default_value(my->thread_pool_size),
+           "number of worker threads serving state history connections, which read, decode and send log entries "
+           "off the main thread");
+   options("state-history-log-compression", bpo::value<string>()->default_value("zlib"),
+           "compression of new state history log entries. Supported options are \"zlib\" and \"zstd\". "
+           "Existing entries stay readable either way");
+   options("state-history-zstd-level", bpo::value<int>()->default_value(3),
+           "zstd compression level of new state history log entries");
+   options("chain-state-history-zstd-dict-blocks", bpo::value<uint32_t>()->default_value(0),
+           "number of blocks whose deltas train a zstd dictionary for the chain state history log, 0 to disable.\n"
+           "The dictionary is stored in chain_state_history.dict and must be kept as long as entries use it.");
+   options("chain-state-history-threads", bpo::value<uint16_t>()->default_value(2),
+           "number of threads creating the chain state deltas of a block, one table per thread, 0 to create them "
+           "on the main thread only");
    options("trace-history-debug-mode", bpo::bool_switch()->default_value(false),
            "enable debug mode for trace history");
    options("context-free-data-compression", bpo::value<string>()->default_value("zlib"), 
@@ -533,6 +736,18 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       config.archive_dir        = options.at("state-history-archive-dir").as<bfs::path>();
       config.stride             = options.at("state-history-stride").as<uint32_t>();
       config.max_retained_files = options.at("max-retained-history-files").as<uint32_t>();
+      config.zstd_level         = options.at("state-history-zstd-level").as<int>();
+      config.zstd_dict_training_blocks = options.at("chain-state-history-zstd-dict-blocks").as<uint32_t>();
+      config.delta_threads      = options.at("chain-state-history-threads").as<uint16_t>();
+
+      auto log_compression = options.at("state-history-log-compression").as<string>();
+      if (log_compression == "zlib") {
+         config.compression = state_history_compression::zlib;
+      } else if (log_compression == "zstd") {
+         config.compression = state_history_compression::zstd;
+      } else {
+         throw bpo::validation_error(bpo::validation_error::invalid_option_value);
+      }
 
       auto ip_port         = options.at("state-history-endpoint").as<string>();
       auto port            = ip_port.substr(ip_port.find(':') + 1, ip_port.size());
@@ -541,6 +756,10 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
       my->endpoint_port    = std::stoi(port);
       idump((ip_port)(host)(port));
 
+      my->thread_pool_size = options.at("state-history-threads").as<uint16_t>();
+      EOS_ASSERT(my->thread_pool_size > 0, plugin_config_exception,
+                 "state-history-threads ${num} must be greater than 0", ("num", my->thread_pool_size));
+
       if (options.at("delete-state-history").as<bool>()) {
          fc_ilog(_log, "Deleting state history");
          boost::filesystem::remove_all(config.log_dir);
@@ -570,6 +789,10 @@ void state_history_plugin::plugin_initialize(const variables_map& options) {
 
 void state_history_plugin::plugin_startup() { 
    handle_sighup(); // setup logging
+   auto& chain  = my->chain_plug->chain();
+   my->chain_id = chain.get_chain_id();
+   my->update_head_and_lib(chain.head_block_state());
+   my->thread_pool.emplace("ship", my->thread_pool_size);
    my->listen(); 
 }
 
@@ -577,9 +800,13 @@ void state_history_plugin::plugin_shutdown() {
    my->applied_transaction_connection.reset();
    my->accepted_block_connection.reset();
    my->block_start_connection.reset();
+   my->stopping = true;
+   if (my->thread_pool)
+      my->thread_pool->stop();
+   // no session handlers run once the thread pool is stopped
    while (!my->sessions.empty())
       my->sessions.begin()->second->close();
-   my->stopping = true;
+   my->acceptor.reset();
 }
 
 void state_history_plugin::handle_sighup() {
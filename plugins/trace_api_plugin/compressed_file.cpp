@@ -1,6 +1,7 @@
 #include <eosio/trace_api/compressed_file.hpp>
 
 #include <zlib.h>
+#include <zstd.h>
 
 namespace {
    using seek_point_entry = std::tuple<uint64_t, uint64_t>;
@@ -312,4 +313,28 @@ bool compressed_file::process( const fc::path& input_path, const fc::path& outpu
    return true;
 }
 
-}
\ No newline at end of file
+std::vector<char> zstd_block_file::compress( const char* data, size_t size, int level ) {
+   std::vector<char> result(ZSTD_compressBound(size));
+   const size_t compressed_size = ZSTD_compress(result.data(), result.size(), data, size, level);
+   if (ZSTD_isError(compressed_size)) {
+      throw compressed_file_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(compressed_size));
+   }
+   result.resize(compressed_size);
+   return result;
+}
+
+std::vector<char> zstd_block_file::decompress( const char* frame, size_t size ) {
+   const auto content_size = ZSTD_getFrameContentSize(frame, size);
+   if (content_size == ZSTD_CONTENTSIZE_ERROR || content_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+      throw compressed_file_error("Invalid zstd frame");
+   }
+
+   std::vector<char> result(content_size);
+   const size_t decompressed_size = ZSTD_decompress(result.data(), result.size(), frame, size);
+   if (ZSTD_isError(decompressed_size) || decompressed_size != content_size) {
+      throw compressed_file_error("Error decompressing zstd frame");
+   }
+   return result;
+}
+
+}
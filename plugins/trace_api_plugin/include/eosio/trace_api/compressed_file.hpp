@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ios>
+#include <vector>
 #include <fc/io/cfile.hpp>
 
 namespace eosio::trace_api {
@@ -156,6 +157,25 @@ namespace eosio::trace_api {
       return compressed_file_datastream(*this);
    }
 
+   /**
+    * Helpers for the "zlog" slice format where every block trace is compressed into an independent zstd frame and
+    * the frames are simply concatenated.  The trace index records the offset and size of each frame so reading a block
+    * decompresses exactly that block, no matter where it is in the slice.
+    */
+   struct zstd_block_file {
+      /**
+       * Compress one block trace into a zstd frame
+       * @throws compressed_file_error if compression fails
+       */
+      static std::vector<char> compress( const char* data, size_t size, int level );
+
+      /**
+       * Decompress the block trace of one zstd frame
+       * @throws compressed_file_error if the frame is corrupt
+       */
+      static std::vector<char> decompress( const char* frame, size_t size );
+   };
+
    /**
     * Typed exception to represent errors encountered due to the processing of a compressed file
     * and not the underlying fc::cfile access
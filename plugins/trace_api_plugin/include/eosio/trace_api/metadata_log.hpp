@@ -15,12 +15,33 @@ namespace eosio { namespace trace_api {
       uint32_t               lib;
    };
 
+   /**
+    * block trace compressed into an independent zstd frame of `size` bytes at `offset` of a zlog slice
+    */
+   struct block_entry_v1 {
+      chain::block_id_type   id;
+      uint32_t               number;
+      uint64_t               offset;
+      uint64_t               size;
+   };
+
+   /**
+    * entry of the transaction id index of a slice, a fixed size record so a sorted index can be binary searched in place
+    */
+   struct trx_id_entry {
+      chain::transaction_id_type id;
+      uint32_t                   block_num;
+   };
+
    using metadata_log_entry = std::variant<
       block_entry_v0,
-      lib_entry_v0
+      lib_entry_v0,
+      block_entry_v1
    >;
 
 }}
 
 FC_REFLECT(eosio::trace_api::block_entry_v0, (id)(number)(offset));
 FC_REFLECT(eosio::trace_api::lib_entry_v0, (lib));
+FC_REFLECT(eosio::trace_api::block_entry_v1, (id)(number)(offset)(size));
+FC_REFLECT(eosio::trace_api::trx_id_entry, (id)(block_num));
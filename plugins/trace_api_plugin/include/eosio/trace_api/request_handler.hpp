@@ -12,6 +12,7 @@ namespace eosio::trace_api {
       class response_formatter {
       public:
          static fc::variant process_block( const data_log_entry& trace, bool irreversible, const data_handler_function& data_handler, const yield_function& yield );
+         static fc::variant process_transaction( const data_log_entry& trace, const chain::transaction_id_type& trx_id, bool irreversible, const data_handler_function& data_handler, const yield_function& yield );
       };
    }
 
@@ -43,16 +44,40 @@ namespace eosio::trace_api {
 
          yield();
 
-         auto data_handler = [this](const auto& action, const yield_function& yield) -> std::tuple<fc::variant, std::optional<fc::variant>> {
+         return detail::response_formatter::process_block(std::get<0>(*data), std::get<1>(*data), data_handler(), yield);
+      }
+
+      /**
+       * Fetch the trace of a transaction by its id and convert it to a fc::variant for conversion to a final format
+       * (eg JSON)
+       *
+       * @param trx_id - the id of the transaction whose trace is requested
+       * @param yield - a yield function to allow cooperation during long running tasks
+       * @return a properly formatted variant representing the trace of the transaction along with the number, id and
+       * status of its block if it exists, an empty variant otherwise.
+       * @throws yield_exception if a call to `yield` throws.
+       * @throws bad_data_exception when there are issues with the underlying data preventing processing.
+       */
+      fc::variant get_transaction_trace( const chain::transaction_id_type& trx_id, const yield_function& yield = {}) {
+         auto data = logfile_provider.get_transaction_block(trx_id, yield);
+         if (!data) {
+            return {};
+         }
+
+         yield();
+
+         return detail::response_formatter::process_transaction(std::get<0>(*data), trx_id, std::get<1>(*data), data_handler(), yield);
+      }
+
+   private:
+      data_handler_function data_handler() {
+         return [this](const auto& action, const yield_function& yield) -> std::tuple<fc::variant, std::optional<fc::variant>> {
             return std::visit([&](const auto& action_trace_t) {
                return data_handler_provider.serialize_to_variant(action_trace_t, yield);
             }, action);
          };
-
-         return detail::response_formatter::process_block(std::get<0>(*data), std::get<1>(*data), data_handler, yield);
       }
 
-   private:
       LogfileProvider logfile_provider;
       DataHandlerProvider data_handler_provider;
    };
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace eosio::trace_api {
+
+   /**
+    * Read-only memory mapping of a slice file as it was when it was mapped.
+    *
+    * Slice files are only appended to, and maintenance replaces or removes them rather than modifying them, so a
+    * mapping remains a consistent snapshot of the file for as long as it is held.
+    */
+   class mapped_slice_file {
+   public:
+      /**
+       * @throws boost::interprocess::interprocess_exception if the file cannot be mapped
+       */
+      explicit mapped_slice_file(const boost::filesystem::path& path);
+
+      const char* data() const { return static_cast<const char*>(_region.get_address()); }
+      uint64_t size() const { return _size; }
+
+   private:
+      boost::interprocess::mapped_region _region;
+      uint64_t _size = 0;
+   };
+
+   /**
+    * Bounded cache of mapped slice files shared by concurrent readers, the least recently used mapping is dropped
+    * once the cache is full.
+    *
+    * Whoever appends to, replaces or removes a slice file invalidates its path afterwards.  Readers holding a
+    * mapping obtained before that keep reading the previous contents.  Thread safe.
+    */
+   class slice_cache {
+   public:
+      using file_ptr = std::shared_ptr<const mapped_slice_file>;
+
+      explicit slice_cache(size_t capacity);
+
+      /**
+       * @param path : slice file to map
+       * @param min_size : a cached mapping smaller than this is replaced by a new mapping of the file
+       * @return the cached or new mapping of the file, null if the file does not exist
+       */
+      file_ptr get(const boost::filesystem::path& path, uint64_t min_size = 0);
+
+      /**
+       * Map a file without caching it, for files read once per request that would only evict the shared mappings
+       *
+       * @return the mapping of the file, null if the file does not exist
+       */
+      static file_ptr map(const boost::filesystem::path& path);
+
+      void invalidate(const boost::filesystem::path& path);
+      void clear();
+
+   private:
+      struct entry {
+         file_ptr file; ///< null while the file is being mapped or after it was invalidated
+         uint64_t last_used = 0;
+         uint64_t generation = 0; ///< incremented by every invalidation of the path
+      };
+
+      const size_t                           _capacity;
+      std::mutex                             _mtx;
+      std::unordered_map<std::string, entry> _entries;
+      uint64_t                               _tick = 0;
+   };
+
+}
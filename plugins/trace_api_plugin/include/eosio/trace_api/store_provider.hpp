@@ -4,6 +4,7 @@
 #include <thread>
 #include <mutex>
 #include <condition_variable>
+#include <set>
 #include <fc/io/cfile.hpp>
 #include <boost/filesystem.hpp>
 #include <fc/variant.hpp>
@@ -11,6 +12,7 @@
 #include <eosio/trace_api/metadata_log.hpp>
 #include <eosio/trace_api/data_log.hpp>
 #include <eosio/trace_api/compressed_file.hpp>
+#include <eosio/trace_api/slice_cache.hpp>
 
 namespace eosio::trace_api {
    using namespace boost::filesystem;
@@ -87,6 +89,34 @@ namespace eosio::trace_api {
    }
 
 
+   /**
+    * Format of the slices compressed by maintenance
+    */
+   enum class slice_compression {
+      zlib, ///< seekable raw deflate stream of the whole trace slice, "clog"
+      zstd  ///< independent zstd frame per block trace located through the trace index, "zlog"
+   };
+
+   /**
+    * Compress a trace slice into the "zlog" format.  Every block trace of the index is written to `output_trace_path`
+    * as an independent zstd frame and the index is rewritten with block_entry_v1 entries locating the frames.  Both
+    * files are written under a temporary name and renamed once complete, the index last, so the rewritten index can
+    * replace the original one in place.
+    *
+    * @param trace_path : uncompressed trace slice
+    * @param index_path : trace index of the slice
+    * @param output_trace_path : path of the zlog to write
+    * @param output_index_path : path of the rewritten trace index
+    * @param zstd_level : zstd compression level
+    * @return false if the index already locates zstd frames, in which case nothing is written
+    * @throws std::ios_base::failure if a file cannot be read or written
+    * @throws old_slice_version if the index is not of the current version
+    * @throws compressed_file_error if compression fails
+    */
+   bool compress_slice_blocks(const boost::filesystem::path& trace_path, const boost::filesystem::path& index_path,
+                              const boost::filesystem::path& output_trace_path, const boost::filesystem::path& output_index_path,
+                              int zstd_level);
+
    class store_provider;
 
    /**
@@ -98,10 +128,19 @@ namespace eosio::trace_api {
       struct index_header {
          uint32_t version;
       };
+      static constexpr uint64_t index_header_size = sizeof(uint32_t); ///< serialized size of index_header
+
+      struct trx_id_index_header {
+         uint32_t version;
+         uint32_t sorted_entries; ///< number of leading entries sorted by transaction id
+      };
+      static constexpr uint64_t trx_id_index_header_size = 2 * sizeof(uint32_t); ///< serialized size of trx_id_index_header
+      static constexpr uint64_t trx_id_entry_size = sizeof(chain::transaction_id_type) + sizeof(uint32_t); ///< serialized size of trx_id_entry
 
       enum class open_state { read /*read from front to back*/, write /*write to end of file*/ };
       slice_directory(const boost::filesystem::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+                      std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+                      slice_compression compression = slice_compression::zlib);
 
       /**
        * Return the slice number that would include the passed in block_height
@@ -172,6 +211,79 @@ namespace eosio::trace_api {
        */
       std::optional<compressed_file> find_compressed_trace_slice(uint32_t slice_number, bool open_file = true) const;
 
+      /**
+       * Find the zstd compressed trace file ("zlog") associated with the indicated slice_number
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param trace_file : the cfile that will be set to the appropriate slice filename (always)
+       *                     and opened read-only to that file (if it was found)
+       * @param open_file : indicate if the file should be opened (if found) or not
+       * @return the true if file was found
+       */
+      bool find_zstd_trace_slice(uint32_t slice_number, fc::cfile& trace_file, bool open_file = true) const;
+
+      /**
+       * Find or create the transaction id index file associated with the indicated slice_number, opened to append
+       * entries to it
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param trx_id_file : the cfile that will be set to the appropriate slice filename and opened to that file
+       * @return the true if file was found (i.e. already existed)
+       */
+      bool find_or_create_trx_id_slice(uint32_t slice_number, fc::cfile& trx_id_file);
+
+      /**
+       * @return the slice numbers of all transaction id index files, the most recent slice first, kept in memory
+       *         since the directory was opened
+       */
+      std::vector<uint32_t> find_trx_id_slices() const;
+
+      /**
+       * Map the transaction id index file associated with the indicated slice_number for reading. A lookup scans
+       * the index of every slice once, so the mapping is not kept in the shared cache of mapped slices.
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param header : receives the header of the index
+       * @return the mapped index file, null if it does not exist
+       * @throws old_slice_version if the index is not of the current version
+       */
+      slice_cache::file_ptr map_trx_id_slice(uint32_t slice_number, trx_id_index_header& header);
+
+      /**
+       * Map the index file associated with the indicated slice_number for reading, sharing the mapping with other
+       * readers of the slice
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @return the mapped index file, null if it does not exist
+       * @throws old_slice_version if the index is not of the current version
+       */
+      slice_cache::file_ptr map_index_slice(uint32_t slice_number);
+
+      /**
+       * Map the trace file associated with the indicated slice_number for reading, sharing the mapping with other
+       * readers of the slice
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param min_size : size the mapping needs to cover, a smaller mapping is replaced by a new one
+       * @return the mapped trace file, null if it does not exist
+       */
+      slice_cache::file_ptr map_trace_slice(uint32_t slice_number, uint64_t min_size);
+
+      /**
+       * Map the zstd compressed trace file ("zlog") associated with the indicated slice_number for reading, sharing
+       * the mapping with other readers of the slice
+       *
+       * @param slice_number : slice number of the requested slice file
+       * @param min_size : size the mapping needs to cover, a smaller mapping is replaced by a new one
+       * @return the mapped zlog, null if it does not exist
+       */
+      slice_cache::file_ptr map_zstd_trace_slice(uint32_t slice_number, uint64_t min_size);
+
+      /**
+       * Drop the shared mapping of a slice file after it was appended to, replaced or removed
+       */
+      void invalidate_mapped_slice(const boost::filesystem::path& slice_path);
+
       /**
        * Find or create a trace and index file pair
        *
@@ -211,6 +323,9 @@ namespace eosio::trace_api {
       // the slice_prefix and slice_number, but will only be opened if found
       bool find_slice(const char* slice_prefix, uint32_t slice_number, fc::cfile& slice_file, bool open_file) const;
 
+      // sort the entries of an irreversible transaction id index so it can be binary searched
+      void sort_trx_id_slice(uint32_t slice_number, const log_handler& log);
+
       // take an index file that is initialized to a file and open it and write its header
       void create_new_index_slice_file(fc::cfile& index_file) const;
 
@@ -227,7 +342,12 @@ namespace eosio::trace_api {
       std::optional<uint32_t> _last_cleaned_up_slice;
       const std::optional<uint32_t> _minimum_uncompressed_irreversible_history_blocks;
       std::optional<uint32_t> _last_compressed_slice;
+      std::optional<uint32_t> _last_sorted_trx_id_slice;
       const size_t _compression_seek_point_stride;
+      const slice_compression _compression;
+      slice_cache _mapped_slices;
+      mutable std::mutex _trx_id_slices_mtx;
+      std::set<uint32_t> _trx_id_slices; ///< slice numbers of the transaction id index files
 
       std::atomic<uint32_t> _best_known_lib{0};
       std::mutex _maintenance_mtx;
@@ -244,7 +364,8 @@ namespace eosio::trace_api {
       using open_state = slice_directory::open_state;
 
       store_provider(const boost::filesystem::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks,
-            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride);
+            std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride,
+            slice_compression compression = slice_compression::zlib);
 
       template<typename BlockTrace>
       void append(const BlockTrace& bt);
@@ -258,6 +379,14 @@ namespace eosio::trace_api {
        */
       get_block_t get_block(uint32_t block_height, const yield_function& yield= {});
 
+      /**
+       * Read the trace of the block including a given transaction, using the transaction id index of the slices
+       * @param trx_id : the id of the transaction
+       * @return empty optional if no block including the transaction can be read OTHERWISE
+       *         optional containing a 2-tuple of the block_trace and a flag indicating irreversibility
+       */
+      get_block_t get_transaction_block(const chain::transaction_id_type& trx_id, const yield_function& yield= {});
+
       void start_maintenance_thread( log_handler log ) {
          _slice_directory.start_maintenance_thread( std::move(log) );
       }
@@ -280,23 +409,26 @@ namespace eosio::trace_api {
       uint64_t scan_metadata_log_from( uint32_t block_height, uint64_t offset, Fn&& fn, const yield_function& yield ) {
          // ignoring offset
          offset = 0;
-         fc::cfile index;
          const uint32_t slice_number = _slice_directory.slice_number(block_height);
-         const bool found = _slice_directory.find_index_slice(slice_number, open_state::read, index);
-         if( !found ) {
+         const auto index = _slice_directory.map_index_slice(slice_number);
+         if( !index ) {
             return 0;
          }
-         const uint64_t end = file_size(index.get_file_path());
-         offset = index.tellp();
+         // the header was validated when mapping the index
+         fc::datastream<const char*> ds(index->data(), index->size());
+         ds.skip(slice_directory::index_header_size);
+         const uint64_t end = index->size();
+         offset = ds.tellp();
          uint64_t last_read_offset = offset;
          while (offset < end) {
             yield();
-            const auto metadata = extract_store<metadata_log_entry>(index);
+            metadata_log_entry metadata;
+            fc::raw::unpack(ds, metadata);
             if(! fn(metadata)) {
                break;
             }
             last_read_offset = offset;
-            offset = index.tellp();
+            offset = ds.tellp();
          }
          return last_read_offset;
       }
@@ -305,15 +437,16 @@ namespace eosio::trace_api {
        * Read from the data log
        * @param block_height : the block_height of the data being read
        * @param offset : the offset in the datalog to read
-       * @return empty optional if the data log does not exist, data otherwise
+       * @return empty optional if the data log does not exist or was compressed into a zlog since its index was read,
+       *         data otherwise
        * @throws std::exception : when the data is not the correct type or if the log is corrupt in some way
        *
        */
       std::optional<data_log_entry> read_data_log( uint32_t block_height, uint64_t offset ) {
          const uint32_t slice_number = _slice_directory.slice_number(block_height);
 
-         fc::cfile trace;
-         if( !_slice_directory.find_trace_slice(slice_number, open_state::read, trace) ) {
+         const auto trace = _slice_directory.map_trace_slice(slice_number, offset + 1);
+         if( !trace ) {
             // attempt to read a compressed trace if one exists
             std::optional<compressed_file> ctrace = _slice_directory.find_compressed_trace_slice(slice_number);
             if (ctrace) {
@@ -321,19 +454,50 @@ namespace eosio::trace_api {
                return extract_store<data_log_entry>(*ctrace);
             }
 
+            // the offset refers to the uncompressed trace, which maintenance replaced along with the index
+            fc::cfile ztrace;
+            if (_slice_directory.find_zstd_trace_slice(slice_number, ztrace, false)) {
+               return {};
+            }
+
             const std::string offset_str = boost::lexical_cast<std::string>(offset);
             const std::string bh_str = boost::lexical_cast<std::string>(block_height);
             throw malformed_slice_file("Requested offset: " + offset_str + " to retrieve block number: " + bh_str + " but this trace file is new, so there are no traces present.");
          }
-         const uint64_t end = file_size(trace.get_file_path());
+         const uint64_t end = trace->size();
          if( offset >= end ) {
             const std::string offset_str = boost::lexical_cast<std::string>(offset);
             const std::string bh_str = boost::lexical_cast<std::string>(block_height);
             const std::string end_str = boost::lexical_cast<std::string>(end);
             throw malformed_slice_file("Requested offset: " + offset_str + " to retrieve block number: " + bh_str + " but this trace file only goes to offset: " + end_str);
          }
-         trace.seek(offset);
-         return extract_store<data_log_entry>(trace);
+         fc::datastream<const char*> ds(trace->data() + offset, end - offset);
+         data_log_entry entry;
+         fc::raw::unpack(ds, entry);
+         return entry;
+      }
+
+      /**
+       * Read a block trace from the zstd compressed data log
+       * @param block_height : the block_height of the data being read
+       * @param offset : the offset of the block's zstd frame
+       * @param size : the size of the block's zstd frame
+       * @return empty optional if the zstd data log does not exist, data otherwise
+       * @throws std::exception : when the data is not the correct type or if the log is corrupt in some way
+       */
+      std::optional<data_log_entry> read_zstd_data_log( uint32_t block_height, uint64_t offset, uint64_t size ) {
+         const auto trace = _slice_directory.map_zstd_trace_slice(_slice_directory.slice_number(block_height), offset + size);
+         if( !trace ) {
+            return {};
+         }
+         if( offset + size > trace->size() ) {
+            const std::string offset_str = boost::lexical_cast<std::string>(offset);
+            const std::string bh_str = boost::lexical_cast<std::string>(block_height);
+            const std::string end_str = boost::lexical_cast<std::string>(trace->size());
+            throw malformed_slice_file("Requested offset: " + offset_str + " to retrieve block number: " + bh_str + " but this trace file only goes to offset: " + end_str);
+         }
+         const auto data = zstd_block_file::decompress(trace->data() + offset, size);
+         return fc::raw::unpack<data_log_entry>(data);
       }
 
       /**
@@ -357,3 +521,4 @@ namespace eosio::trace_api {
 }
 
 FC_REFLECT(eosio::trace_api::slice_directory::index_header, (version))
+FC_REFLECT(eosio::trace_api::slice_directory::trx_id_index_header, (version)(sorted_entries))
@@ -155,4 +155,32 @@ namespace eosio::trace_api::detail {
           return fc::mutable_variant_object();
        }
     }
+
+    fc::variant response_formatter::process_transaction( const data_log_entry& trace, const chain::transaction_id_type& trx_id, bool irreversible, const data_handler_function& data_handler, const yield_function& yield ) {
+       auto find_transaction = [&](const auto& block_trace, const auto& transactions) -> fc::variant {
+          auto itr = std::find_if(transactions.begin(), transactions.end(), [&trx_id](const auto& t) { return t.id == trx_id; });
+          if (itr == transactions.end()) {
+             return {};
+          }
+          using transaction_trace_t = typename std::decay_t<decltype(transactions)>::value_type;
+          auto result = process_transactions(std::vector<transaction_trace_t>{ *itr }, data_handler, yield);
+          return fc::mutable_variant_object(result.at(0).get_object())
+             ("block_number", block_trace.number)
+             ("block_id", block_trace.id.str())
+             ("block_status", irreversible ? "irreversible" : "pending");
+       };
+
+       if (std::holds_alternative<block_trace_v0>(trace)) {
+          const auto& block_trace = std::get<block_trace_v0>(trace);
+          return find_transaction(block_trace, block_trace.transactions);
+       } else if (std::holds_alternative<block_trace_v1>(trace)) {
+          const auto& block_trace = std::get<block_trace_v1>(trace);
+          return find_transaction(block_trace, block_trace.transactions_v1);
+       } else if (std::holds_alternative<block_trace_v2>(trace)) {
+          const auto& block_trace = std::get<block_trace_v2>(trace);
+          return find_transaction(block_trace, std::get<std::vector<transaction_trace_v2>>(block_trace.transactions));
+       } else {
+          return {};
+       }
+    }
 }
@@ -0,0 +1,95 @@
+#include <eosio/trace_api/slice_cache.hpp>
+
+#include <algorithm>
+#include <boost/interprocess/file_mapping.hpp>
+
+namespace eosio::trace_api {
+   namespace bfs = boost::filesystem;
+   namespace bip = boost::interprocess;
+
+   mapped_slice_file::mapped_slice_file(const bfs::path& path)
+   : _size(bfs::file_size(path)) {
+      // an empty region cannot be mapped
+      if (_size > 0) {
+         bip::file_mapping mapping(path.generic_string().c_str(), bip::read_only);
+         _region = bip::mapped_region(mapping, bip::read_only, 0, _size);
+      }
+   }
+
+   slice_cache::slice_cache(size_t capacity)
+   : _capacity(std::max<size_t>(capacity, 1)) {
+   }
+
+   slice_cache::file_ptr slice_cache::get(const bfs::path& path, uint64_t min_size) {
+      const auto key = path.generic_string();
+      uint64_t generation = 0;
+      {
+         std::lock_guard<std::mutex> lock(_mtx);
+         auto itr = _entries.find(key);
+         if (itr != _entries.end() && itr->second.file && itr->second.file->size() >= min_size) {
+            itr->second.last_used = ++_tick;
+            return itr->second.file;
+         }
+         if (itr == _entries.end()) {
+            // the entry tracks invalidations of the path while it is mapped
+            if (_entries.size() >= _capacity) {
+               auto lru = std::min_element(_entries.begin(), _entries.end(), [](const auto& a, const auto& b) {
+                  return a.second.last_used < b.second.last_used;
+               });
+               _entries.erase(lru);
+            }
+            itr = _entries.emplace(key, entry{ file_ptr(), ++_tick, 0 }).first;
+         }
+         generation = itr->second.generation;
+      }
+
+      // map outside of the lock so that readers of other files are not held up
+      file_ptr file = map(path);
+
+      std::lock_guard<std::mutex> lock(_mtx);
+      auto itr = _entries.find(key);
+      if (itr != _entries.end() && itr->second.generation == generation) {
+         if (file) {
+            // a mapping made while its file was being modified may be missing the modification, only cache mappings
+            // made after the last invalidation of the file
+            itr->second.file = file;
+            itr->second.last_used = ++_tick;
+         } else if (!itr->second.file) {
+            _entries.erase(itr);
+         }
+      }
+      return file;
+   }
+
+   slice_cache::file_ptr slice_cache::map(const bfs::path& path) {
+      try {
+         if (bfs::exists(path)) {
+            return std::make_shared<const mapped_slice_file>(path);
+         }
+      } catch (...) {
+         // removed by maintenance in the meantime
+         if (bfs::exists(path)) {
+            throw;
+         }
+      }
+      return {};
+   }
+
+   void slice_cache::invalidate(const bfs::path& path) {
+      std::lock_guard<std::mutex> lock(_mtx);
+      auto itr = _entries.find(path.generic_string());
+      if (itr != _entries.end()) {
+         ++itr->second.generation;
+         itr->second.file.reset();
+      }
+   }
+
+   void slice_cache::clear() {
+      std::lock_guard<std::mutex> lock(_mtx);
+      for (auto& e : _entries) {
+         ++e.second.generation;
+         e.second.file.reset();
+      }
+   }
+
+}
@@ -3,12 +3,21 @@
 #include <fc/variant_object.hpp>
 #include <fc/log/logger_config.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
 namespace {
       static constexpr uint32_t _current_version = 1;
       static constexpr const char* _trace_prefix = "trace_";
       static constexpr const char* _trace_index_prefix = "trace_index_";
+      static constexpr const char* _trace_trx_id_prefix = "trace_trx_";
       static constexpr const char* _trace_ext = ".log";
       static constexpr const char* _compressed_trace_ext = ".clog";
+      static constexpr const char* _zstd_trace_ext = ".zlog";
+      static constexpr const char* _tmp_ext = ".tmp";
+      static constexpr int _zstd_compression_level = 9;
+      static constexpr size_t _mapped_slice_capacity = 32;
       static constexpr uint _max_filename_size = std::char_traits<char>::length(_trace_index_prefix) + 10 + 1 + 10 + std::char_traits<char>::length(_compressed_trace_ext) + 1; // "trace_index_" + 10-digits + '-' + 10-digits + ".clog" + null-char
 
       std::string make_filename(const char* slice_prefix, const char* slice_ext, uint32_t slice_number, uint32_t slice_width) {
@@ -26,12 +35,129 @@ namespace {
 
          return std::string(filename);
       }
+
+      const auto& block_transactions(const eosio::trace_api::block_trace_v0& bt) {
+         return bt.transactions;
+      }
+
+      const auto& block_transactions(const eosio::trace_api::block_trace_v1& bt) {
+         return bt.transactions_v1;
+      }
+
+      const auto& block_transactions(const eosio::trace_api::block_trace_v2& bt) {
+         return std::get<std::vector<eosio::trace_api::transaction_trace_v2>>(bt.transactions);
+      }
+
+      // block numbers of the entries of a mapped transaction id index that match trx_id, binary searching the sorted
+      // entries and scanning the ones appended since
+      void find_trx_id_entries(const char* entries, uint64_t count, uint64_t sorted_entries,
+                               const eosio::chain::transaction_id_type& trx_id, std::vector<uint32_t>& block_nums) {
+         using eosio::trace_api::slice_directory;
+         constexpr size_t id_size = sizeof(eosio::chain::transaction_id_type);
+         auto id_at = [&](uint64_t i) { return entries + i * slice_directory::trx_id_entry_size; };
+         auto block_num_at = [&](uint64_t i) {
+            uint32_t block_num;
+            memcpy(&block_num, id_at(i) + id_size, sizeof(block_num));
+            return block_num;
+         };
+
+         sorted_entries = std::min(sorted_entries, count);
+         uint64_t low = 0;
+         uint64_t high = sorted_entries;
+         while (low < high) {
+            const uint64_t mid = low + (high - low) / 2;
+            if (memcmp(id_at(mid), trx_id.data(), id_size) < 0) {
+               low = mid + 1;
+            } else {
+               high = mid;
+            }
+         }
+         for (uint64_t i = low; i < sorted_entries && memcmp(id_at(i), trx_id.data(), id_size) == 0; ++i) {
+            block_nums.push_back(block_num_at(i));
+         }
+         for (uint64_t i = sorted_entries; i < count; ++i) {
+            if (memcmp(id_at(i), trx_id.data(), id_size) == 0) {
+               block_nums.push_back(block_num_at(i));
+            }
+         }
+      }
 }
 
 namespace eosio::trace_api {
    namespace bfs = boost::filesystem;
-   store_provider::store_provider(const bfs::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
-   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride) {
+
+   bool compress_slice_blocks(const bfs::path& trace_path, const bfs::path& index_path,
+                              const bfs::path& output_trace_path, const bfs::path& output_index_path, int zstd_level) {
+      fc::cfile index;
+      index.set_file_path(index_path);
+      index.open("rb");
+      const auto header = extract_store<index_header>(index);
+      if (header.version != _current_version) {
+         throw old_slice_version("Old slice file with version: " + std::to_string(header.version) +
+                                 " is in directory, only supporting version: " + std::to_string(_current_version));
+      }
+
+      std::vector<metadata_log_entry> entries;
+      const uint64_t end = file_size(index_path);
+      while (index.tellp() < end) {
+         entries.emplace_back(extract_store<metadata_log_entry>(index));
+         if (std::holds_alternative<block_entry_v1>(entries.back())) {
+            return false;
+         }
+      }
+      index.close();
+
+      fc::cfile trace;
+      trace.set_file_path(trace_path);
+      trace.open("rb");
+
+      bfs::path tmp_trace_path = output_trace_path;
+      tmp_trace_path += _tmp_ext;
+      fc::cfile output_trace;
+      output_trace.set_file_path(tmp_trace_path);
+      output_trace.open("wb");
+
+      bfs::path tmp_index_path = output_index_path;
+      tmp_index_path += _tmp_ext;
+      fc::cfile output_index;
+      output_index.set_file_path(tmp_index_path);
+      output_index.open("wb");
+      auto write = [](const auto& entry, fc::cfile& file) {
+         const auto data = fc::raw::pack(entry);
+         file.write(data.data(), data.size());
+      };
+      write(header, output_index);
+
+      uint64_t offset = 0;
+      for (const auto& e : entries) {
+         if (std::holds_alternative<block_entry_v0>(e)) {
+            const auto& block = std::get<block_entry_v0>(e);
+            trace.seek(block.offset);
+            const auto data = fc::raw::pack(extract_store<data_log_entry>(trace));
+            const auto frame = zstd_block_file::compress(data.data(), data.size(), zstd_level);
+            output_trace.write(frame.data(), frame.size());
+            write(metadata_log_entry{ block_entry_v1{ .id = block.id, .number = block.number, .offset = offset, .size = frame.size() } }, output_index);
+            offset += frame.size();
+         } else {
+            write(e, output_index);
+         }
+      }
+
+      output_trace.flush();
+      output_trace.sync();
+      output_trace.close();
+      output_index.flush();
+      output_index.sync();
+      output_index.close();
+
+      // the index is renamed last, readers only look for frames once the index locates them
+      bfs::rename(tmp_trace_path, output_trace_path);
+      bfs::rename(tmp_index_path, output_index_path);
+      return true;
+   }
+
+   store_provider::store_provider(const bfs::path& slice_dir, uint32_t stride_width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride, slice_compression compression)
+   : _slice_directory(slice_dir, stride_width, minimum_irreversible_history_blocks, minimum_uncompressed_irreversible_history_blocks, compression_seek_point_stride, compression) {
    }
 
    template<typename BlockTrace>
@@ -42,9 +168,28 @@ namespace eosio::trace_api {
       _slice_directory.find_or_create_slice_pair(slice_number, open_state::write, trace, index);
       // storing as static_variant to allow adding other data types to the trace file in the future
       const uint64_t offset = append_store(data_log_entry { bt }, trace);
+      // the trace is complete on disk before the index refers to it, so is any mapping made after this
+      _slice_directory.invalidate_mapped_slice(trace.get_file_path());
 
       auto be = metadata_log_entry { block_entry_v0 { .id = bt.id, .number = bt.number, .offset = offset }};
       append_store(be, index);
+      _slice_directory.invalidate_mapped_slice(index.get_file_path());
+
+      // indexed after the block so a reader finding the transaction also finds its block
+      fc::cfile trx_ids;
+      _slice_directory.find_or_create_trx_id_slice(slice_number, trx_ids);
+      const auto& transactions = block_transactions(bt);
+      if (!transactions.empty()) {
+         std::vector<char> entries;
+         entries.reserve(transactions.size() * slice_directory::trx_id_entry_size);
+         for (const auto& t : transactions) {
+            const auto entry = fc::raw::pack(trx_id_entry{ .id = t.id, .block_num = bt.number });
+            entries.insert(entries.end(), entry.begin(), entry.end());
+         }
+         trx_ids.write(entries.data(), entries.size());
+         trx_ids.flush();
+         trx_ids.sync();
+      }
    }
 
    template void store_provider::append<block_trace_v1>(const block_trace_v1& bt);
@@ -56,47 +201,107 @@ namespace eosio::trace_api {
       _slice_directory.find_or_create_index_slice(slice_number, open_state::write, index);
       auto le = metadata_log_entry { lib_entry_v0 { .lib = lib }};
       append_store(le, index);
+      _slice_directory.invalidate_mapped_slice(index.get_file_path());
       _slice_directory.set_lib(lib);
    }
 
    get_block_t store_provider::get_block(uint32_t block_height, const yield_function& yield) {
-      std::optional<uint64_t> trace_offset;
-      bool irreversible = false;
-      uint64_t offset = scan_metadata_log_from(block_height, 0, [&block_height, &trace_offset, &irreversible](const metadata_log_entry& e) -> bool {
-         if (std::holds_alternative<block_entry_v0>(e)) {
-            const auto& block = std::get<block_entry_v0>(e);
-            if (block.number == block_height) {
-               trace_offset = block.offset;
-            }
-         } else if (std::holds_alternative<lib_entry_v0>(e)) {
-            auto lib = std::get<lib_entry_v0>(e).lib;
-            if (lib >= block_height) {
-               irreversible = true;
-               return false;
+      // maintenance may replace the index of an uncompressed slice by the index of its zlog between scanning the index
+      // and reading the trace, in which case the rewritten index is scanned again
+      for (int attempt = 0; attempt < 2; ++attempt) {
+         std::optional<uint64_t> trace_offset;
+         std::optional<uint64_t> frame_size;
+         bool irreversible = false;
+         scan_metadata_log_from(block_height, 0, [&block_height, &trace_offset, &frame_size, &irreversible](const metadata_log_entry& e) -> bool {
+            if (std::holds_alternative<block_entry_v0>(e)) {
+               const auto& block = std::get<block_entry_v0>(e);
+               if (block.number == block_height) {
+                  trace_offset = block.offset;
+               }
+            } else if (std::holds_alternative<block_entry_v1>(e)) {
+               const auto& block = std::get<block_entry_v1>(e);
+               if (block.number == block_height) {
+                  trace_offset = block.offset;
+                  frame_size = block.size;
+               }
+            } else if (std::holds_alternative<lib_entry_v0>(e)) {
+               auto lib = std::get<lib_entry_v0>(e).lib;
+               if (lib >= block_height) {
+                  irreversible = true;
+                  return false;
+               }
             }
+            return true;
+         }, yield);
+         if (!trace_offset) {
+            return get_block_t{};
+         }
+         std::optional<data_log_entry> entry = frame_size ? read_zstd_data_log(block_height, *trace_offset, *frame_size)
+                                                          : read_data_log(block_height, *trace_offset);
+         if (entry) {
+            return std::make_tuple( entry.value(), irreversible );
+         }
+         if (frame_size) {
+            break;
          }
-         return true;
-      }, yield);
-      if (!trace_offset) {
-         return get_block_t{};
       }
-      std::optional<data_log_entry> entry = read_data_log(block_height, *trace_offset);
-      if (!entry) {
-         return get_block_t{};
+      return get_block_t{};
+   }
+
+   get_block_t store_provider::get_transaction_block(const chain::transaction_id_type& trx_id, const yield_function& yield) {
+      for (uint32_t slice_number : _slice_directory.find_trx_id_slices()) {
+         yield();
+         slice_directory::trx_id_index_header header;
+         const auto trx_ids = _slice_directory.map_trx_id_slice(slice_number, header);
+         if (!trx_ids) {
+            continue;
+         }
+         std::vector<uint32_t> block_nums;
+         const uint64_t count = (trx_ids->size() - slice_directory::trx_id_index_header_size) / slice_directory::trx_id_entry_size;
+         find_trx_id_entries(trx_ids->data() + slice_directory::trx_id_index_header_size, count, header.sorted_entries, trx_id, block_nums);
+
+         // a transaction of a forked out block may be included again, only a block that is still stored under its
+         // number and includes the transaction is returned
+         std::sort(block_nums.begin(), block_nums.end(), std::greater<>());
+         block_nums.erase(std::unique(block_nums.begin(), block_nums.end()), block_nums.end());
+         for (uint32_t block_num : block_nums) {
+            auto block = get_block(block_num, yield);
+            if (!block) {
+               continue;
+            }
+            const bool included = std::visit([&trx_id](const auto& bt) {
+               const auto& transactions = block_transactions(bt);
+               return std::any_of(transactions.begin(), transactions.end(), [&trx_id](const auto& t) { return t.id == trx_id; });
+            }, std::get<0>(*block));
+            if (included) {
+               return block;
+            }
+         }
       }
-      return std::make_tuple( entry.value(), irreversible );
+      return get_block_t{};
    }
 
-   slice_directory::slice_directory(const bfs::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride)
+   slice_directory::slice_directory(const bfs::path& slice_dir, uint32_t width, std::optional<uint32_t> minimum_irreversible_history_blocks, std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks, size_t compression_seek_point_stride, slice_compression compression)
    : _slice_dir(slice_dir)
    , _width(width)
    , _minimum_irreversible_history_blocks(minimum_irreversible_history_blocks)
    , _minimum_uncompressed_irreversible_history_blocks(minimum_uncompressed_irreversible_history_blocks)
    , _compression_seek_point_stride(compression_seek_point_stride)
+   , _compression(compression)
+   , _mapped_slices(_mapped_slice_capacity)
    , _best_known_lib(0) {
       if (!exists(_slice_dir)) {
          bfs::create_directories(slice_dir);
       }
+
+      const std::string prefix = _trace_trx_id_prefix;
+      for (const auto& entry : bfs::directory_iterator(_slice_dir)) {
+         const auto filename = entry.path().filename().generic_string();
+         if (filename.compare(0, prefix.size(), prefix) == 0 && entry.path().extension() == _trace_ext) {
+            const uint32_t slice_start = std::stoul(filename.substr(prefix.size(), 10));
+            _trx_id_slices.insert(slice_start / _width);
+         }
+      }
    }
 
    bool slice_directory::find_or_create_index_slice(uint32_t slice_number, open_state state, fc::cfile& index_file) const {
@@ -178,6 +383,130 @@ namespace eosio::trace_api {
       }
    }
 
+   bool slice_directory::find_zstd_trace_slice(uint32_t slice_number, fc::cfile& trace_file, bool open_file) const {
+      auto filename = make_filename(_trace_prefix, _zstd_trace_ext, slice_number, _width);
+      const path slice_path = _slice_dir / filename;
+      trace_file.set_file_path(slice_path);
+
+      const bool file_exists = exists(slice_path);
+      if( !file_exists || !open_file ) {
+         return file_exists;
+      }
+
+      trace_file.open("rb");
+      return true;
+   }
+
+   bool slice_directory::find_or_create_trx_id_slice(uint32_t slice_number, fc::cfile& trx_id_file) {
+      const bool found = find_slice(_trace_trx_id_prefix, slice_number, trx_id_file, true);
+      if (found) {
+         trx_id_file.seek_end(0);
+      } else {
+         trx_id_file.open(fc::cfile::create_or_update_rw_mode);
+         append_store(trx_id_index_header{ .version = _current_version, .sorted_entries = 0 }, trx_id_file);
+         trx_id_file.flush();
+         std::lock_guard<std::mutex> lock(_trx_id_slices_mtx);
+         _trx_id_slices.insert(slice_number);
+      }
+      return found;
+   }
+
+   std::vector<uint32_t> slice_directory::find_trx_id_slices() const {
+      std::lock_guard<std::mutex> lock(_trx_id_slices_mtx);
+      return std::vector<uint32_t>(_trx_id_slices.rbegin(), _trx_id_slices.rend());
+   }
+
+   slice_cache::file_ptr slice_directory::map_trx_id_slice(uint32_t slice_number, trx_id_index_header& header) {
+      auto trx_ids = slice_cache::map(_slice_dir / make_filename(_trace_trx_id_prefix, _trace_ext, slice_number, _width));
+      if (trx_ids) {
+         fc::datastream<const char*> ds(trx_ids->data(), trx_ids->size());
+         fc::raw::unpack(ds, header);
+         if (header.version != _current_version) {
+            throw old_slice_version("Old slice file with version: " + std::to_string(header.version) +
+                                    " is in directory, only supporting version: " + std::to_string(_current_version));
+         }
+      }
+      return trx_ids;
+   }
+
+   void slice_directory::sort_trx_id_slice(uint32_t slice_number, const log_handler& log) {
+      fc::cfile trx_ids;
+      const bool dont_open_file = false;
+      if (!find_slice(_trace_trx_id_prefix, slice_number, trx_ids, dont_open_file)) {
+         return;
+      }
+
+      const auto trx_ids_path = trx_ids.get_file_path();
+      const uint64_t size = file_size(trx_ids_path);
+      trx_ids.open("rb");
+      auto header = extract_store<trx_id_index_header>(trx_ids);
+      if (header.version != _current_version) {
+         throw old_slice_version("Old slice file with version: " + std::to_string(header.version) +
+                                 " is in directory, only supporting version: " + std::to_string(_current_version));
+      }
+      const uint64_t count = (size - trx_id_index_header_size) / trx_id_entry_size;
+      if (header.sorted_entries == count) {
+         return;
+      }
+
+      log(std::string("Sorting: ") + trx_ids_path.generic_string());
+      std::vector<char> entries(count * trx_id_entry_size);
+      trx_ids.read(entries.data(), entries.size());
+      trx_ids.close();
+
+      constexpr size_t id_size = sizeof(chain::transaction_id_type);
+      std::vector<const char*> order(count);
+      for (uint64_t i = 0; i < count; ++i) {
+         order[i] = entries.data() + i * trx_id_entry_size;
+      }
+      std::stable_sort(order.begin(), order.end(), [](const char* a, const char* b) {
+         return memcmp(a, b, id_size) < 0;
+      });
+
+      bfs::path tmp_path = trx_ids_path;
+      tmp_path += _tmp_ext;
+      fc::cfile sorted;
+      sorted.set_file_path(tmp_path);
+      sorted.open("wb");
+      header.sorted_entries = count;
+      const auto packed_header = fc::raw::pack(header);
+      sorted.write(packed_header.data(), packed_header.size());
+      for (const char* e : order) {
+         sorted.write(e, trx_id_entry_size);
+      }
+      sorted.flush();
+      sorted.sync();
+      sorted.close();
+
+      bfs::rename(tmp_path, trx_ids_path);
+   }
+
+   slice_cache::file_ptr slice_directory::map_index_slice(uint32_t slice_number) {
+      auto index = _mapped_slices.get(_slice_dir / make_filename(_trace_index_prefix, _trace_ext, slice_number, _width));
+      if (index) {
+         fc::datastream<const char*> ds(index->data(), index->size());
+         index_header header;
+         fc::raw::unpack(ds, header);
+         if (header.version != _current_version) {
+            throw old_slice_version("Old slice file with version: " + std::to_string(header.version) +
+                                    " is in directory, only supporting version: " + std::to_string(_current_version));
+         }
+      }
+      return index;
+   }
+
+   slice_cache::file_ptr slice_directory::map_trace_slice(uint32_t slice_number, uint64_t min_size) {
+      return _mapped_slices.get(_slice_dir / make_filename(_trace_prefix, _trace_ext, slice_number, _width), min_size);
+   }
+
+   slice_cache::file_ptr slice_directory::map_zstd_trace_slice(uint32_t slice_number, uint64_t min_size) {
+      return _mapped_slices.get(_slice_dir / make_filename(_trace_prefix, _zstd_trace_ext, slice_number, _width), min_size);
+   }
+
+   void slice_directory::invalidate_mapped_slice(const bfs::path& slice_path) {
+      _mapped_slices.invalidate(slice_path);
+   }
+
    bool slice_directory::find_slice(const char* slice_prefix, uint32_t slice_number, fc::cfile& slice_file, bool open_file) const {
       auto filename = make_filename(slice_prefix, _trace_ext, slice_number, _width);
       const path slice_path = _slice_dir / filename;
@@ -278,11 +607,13 @@ namespace eosio::trace_api {
             if (index_found) {
                log(std::string("Removing: ") + index.get_file_path().generic_string());
                bfs::remove(index.get_file_path());
+               invalidate_mapped_slice(index.get_file_path());
             }
             const bool trace_found = find_trace_slice(slice_to_clean, open_state::read, trace, dont_open_file);
             if (trace_found) {
                log(std::string("Removing: ") + trace.get_file_path().generic_string());
                bfs::remove(trace.get_file_path());
+               invalidate_mapped_slice(trace.get_file_path());
             }
 
             auto ctrace = find_compressed_trace_slice(slice_to_clean, dont_open_file);
@@ -290,6 +621,23 @@ namespace eosio::trace_api {
                log(std::string("Removing: ") + ctrace->get_file_path().generic_string());
                bfs::remove(ctrace->get_file_path());
             }
+
+            fc::cfile ztrace;
+            if (find_zstd_trace_slice(slice_to_clean, ztrace, dont_open_file)) {
+               log(std::string("Removing: ") + ztrace.get_file_path().generic_string());
+               bfs::remove(ztrace.get_file_path());
+               invalidate_mapped_slice(ztrace.get_file_path());
+            }
+
+            fc::cfile trx_ids;
+            if (find_slice(_trace_trx_id_prefix, slice_to_clean, trx_ids, dont_open_file)) {
+               {
+                  std::lock_guard<std::mutex> lock(_trx_id_slices_mtx);
+                  _trx_id_slices.erase(slice_to_clean);
+               }
+               log(std::string("Removing: ") + trx_ids.get_file_path().generic_string());
+               bfs::remove(trx_ids.get_file_path());
+            }
          });
       }
 
@@ -306,17 +654,35 @@ namespace eosio::trace_api {
             log(std::string("Attempting compression of slice: ") + std::to_string(slice_to_compress));
 
             if (trace_found) {
-               auto compressed_path = trace.get_file_path();
-               compressed_path.replace_extension(_compressed_trace_ext);
-
                log(std::string("Compressing: ") + trace.get_file_path().generic_string());
-               compressed_file::process(trace.get_file_path(), compressed_path.generic_string(), _compression_seek_point_stride);
+               if (_compression == slice_compression::zstd) {
+                  fc::cfile index;
+                  find_index_slice(slice_to_compress, open_state::read, index, dont_open_file);
+                  auto compressed_path = trace.get_file_path();
+                  compressed_path.replace_extension(_zstd_trace_ext);
+                  // an index already locating zstd frames means a previous run compressed the slice but was stopped
+                  // before removing the uncompressed file
+                  if (compress_slice_blocks(trace.get_file_path(), index.get_file_path(), compressed_path, index.get_file_path(), _zstd_compression_level)) {
+                     invalidate_mapped_slice(compressed_path);
+                     invalidate_mapped_slice(index.get_file_path());
+                  }
+               } else {
+                  auto compressed_path = trace.get_file_path();
+                  compressed_path.replace_extension(_compressed_trace_ext);
+                  compressed_file::process(trace.get_file_path(), compressed_path.generic_string(), _compression_seek_point_stride);
+               }
 
                // after compression is complete, delete the old uncompressed file
                log(std::string("Removing: ") + trace.get_file_path().generic_string());
                bfs::remove(trace.get_file_path());
+               invalidate_mapped_slice(trace.get_file_path());
             }
          });
       }
+
+      // the transaction id index of a slice no longer changes once all of its blocks are irreversible
+      process_irreversible_slice_range(lib, 0, _last_sorted_trx_id_slice, [this, &log](uint32_t slice_to_sort){
+         sort_trx_id_slice(slice_to_sort, log);
+      });
    }
 }
@@ -29,6 +29,10 @@ struct response_test_fixture {
       get_block_t get_block(uint32_t height, const yield_function& yield= {}) {
          return fixture.mock_get_block(height, yield);
       }
+
+      get_block_t get_transaction_block(const chain::transaction_id_type& trx_id, const yield_function& yield= {}) {
+         return fixture.mock_get_transaction_block(trx_id, yield);
+      }
       response_test_fixture& fixture;
    };
 
@@ -72,8 +76,13 @@ struct response_test_fixture {
       return response_impl.get_block_trace( block_height, yield );
    }
 
+   fc::variant get_transaction_trace( const chain::transaction_id_type& trx_id, const yield_function& yield = {} ) {
+      return response_impl.get_transaction_trace( trx_id, yield );
+   }
+
    // fixture data and methods
    std::function<get_block_t(uint32_t, const yield_function&)> mock_get_block;
+   std::function<get_block_t(const chain::transaction_id_type&, const yield_function&)> mock_get_transaction_block;
    std::function<std::tuple<fc::variant, std::optional<fc::variant>>(const action_trace_v0&, const yield_function&)> mock_data_handler_v0 = default_mock_data_handler_v0;
    std::function<std::tuple<fc::variant, std::optional<fc::variant>>(const action_trace_v1&, const yield_function&)> mock_data_handler_v1 = default_mock_data_handler_v1;
 
@@ -1070,4 +1079,100 @@ BOOST_AUTO_TEST_SUITE(trace_responses)
       BOOST_REQUIRE_THROW(get_block_trace( 1, yield ), yield_exception);
    }
 
+   BOOST_FIXTURE_TEST_CASE(transaction_response, response_test_fixture)
+   {
+      auto action_trace = action_trace_v0 {
+         0,
+         "receiver"_n, "contract"_n, "action"_n,
+         {{ "alice"_n, "active"_n }},
+         { 0x00, 0x01, 0x02, 0x03 }
+      };
+
+      auto transaction_trace = transaction_trace_v1 { {
+         "0000000000000000000000000000000000000000000000000000000000000001"_h,
+         {
+            action_trace
+         }},
+         fc::enum_type<uint8_t, chain::transaction_receipt_header::status_enum>{chain::transaction_receipt_header::status_enum::executed},
+         10,
+         5,
+         std::vector<chain::signature_type>{ chain::signature_type() },
+         { chain::time_point(), 1, 0, 100, 50, 0 }
+      };
+
+      auto other_transaction_trace = transaction_trace;
+      other_transaction_trace.id = "0000000000000000000000000000000000000000000000000000000000000002"_h;
+
+      auto block_trace = block_trace_v1 {
+         {
+            "b000000000000000000000000000000000000000000000000000000000000001"_h,
+            1,
+            "0000000000000000000000000000000000000000000000000000000000000000"_h,
+            chain::block_timestamp_type(0),
+            "bp.one"_n
+         },
+         "0000000000000000000000000000000000000000000000000000000000000000"_h,
+         "0000000000000000000000000000000000000000000000000000000000000000"_h,
+         0,
+         {
+            other_transaction_trace,
+            transaction_trace
+         }
+      };
+
+      fc::variant expected_response = fc::mutable_variant_object()
+         ("id", "0000000000000000000000000000000000000000000000000000000000000001")
+         ("actions", fc::variants({
+            fc::mutable_variant_object()
+               ("global_sequence", 0)
+               ("receiver", "receiver")
+               ("account", "contract")
+               ("action", "action")
+               ("authorization", fc::variants({
+                  fc::mutable_variant_object()
+                     ("account", "alice")
+                     ("permission", "active")
+               }))
+               ("data", "00010203")
+               ("params", fc::mutable_variant_object()
+                     ("hex", "00010203"))
+         }))
+         ("status", "executed")
+         ("cpu_usage_us", 10)
+         ("net_usage_words", 5)
+         ("signatures", fc::variants({"SIG_K1_111111111111111111111111111111111111111111111111111111111111111116uk5ne"}))
+         ("transaction_header", fc::mutable_variant_object()
+            ("expiration", "1970-01-01T00:00:00")
+            ("ref_block_num", 1)
+            ("ref_block_prefix", 0)
+            ("max_net_usage_words", 100)
+            ("max_cpu_usage_ms", 50)
+            ("delay_sec", 0)
+         )
+         ("block_number", 1)
+         ("block_id", "b000000000000000000000000000000000000000000000000000000000000001")
+         ("block_status", "irreversible")
+      ;
+
+      mock_get_transaction_block = [&block_trace, &transaction_trace]( const chain::transaction_id_type& trx_id, const yield_function& ) -> get_block_t {
+         BOOST_TEST(trx_id == transaction_trace.id);
+         return std::make_tuple(data_log_entry(block_trace), true);
+      };
+
+      fc::variant actual_response = get_transaction_trace( transaction_trace.id );
+
+      BOOST_TEST(to_kv(expected_response) == to_kv(actual_response), boost::test_tools::per_element());
+   }
+
+   BOOST_FIXTURE_TEST_CASE(missing_transaction_data, response_test_fixture)
+   {
+      mock_get_transaction_block = []( const chain::transaction_id_type&, const yield_function& ) -> get_block_t {
+         return {};
+      };
+
+      fc::variant null_response = get_transaction_trace( "0000000000000000000000000000000000000000000000000000000000000001"_h );
+
+      BOOST_TEST(null_response.is_null());
+   }
+
 BOOST_AUTO_TEST_SUITE_END()
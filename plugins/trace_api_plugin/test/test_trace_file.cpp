@@ -213,6 +213,10 @@ namespace {
       }
       using store_provider::scan_metadata_log_from;
       using store_provider::read_data_log;
+
+      void run_maintenance_tasks(uint32_t lib) {
+         _slice_directory.run_maintenance_tasks(lib, {});
+      }
    };
 
    class vslice_datastream;
@@ -1071,4 +1075,174 @@ BOOST_AUTO_TEST_SUITE(slice_tests)
    }
 
 
+   BOOST_FIXTURE_TEST_CASE(test_get_block_mapped_slices, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      const uint32_t min_saved_blocks = width + 5;
+      test_store_provider sp(tempdir.path(), width, std::optional<uint32_t>(min_saved_blocks), std::optional<uint32_t>(0));
+      sp.append(block_trace1_v2);
+
+      // the mapped slices are shared by the readers, appending extends them
+      get_block_t block1 = sp.get_block(1);
+      BOOST_REQUIRE(block1);
+      BOOST_REQUIRE(!std::get<1>(*block1));
+      BOOST_REQUIRE(!sp.get_block(5));
+
+      sp.append_lib(1);
+      sp.append(block_trace2_v2);
+      block1 = sp.get_block(1);
+      BOOST_REQUIRE(block1);
+      BOOST_REQUIRE(std::get<1>(*block1));
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block1)), block_trace1_v2);
+      get_block_t block2 = sp.get_block(5);
+      BOOST_REQUIRE(block2);
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block2)), block_trace2_v2);
+
+      // compressing the slice replaces the mapped trace
+      sp.run_maintenance_tasks(width);
+      std::set<bfs::path> files;
+      files.insert("trace_index_0000000000-0000000010.log");
+      files.insert("trace_trx_0000000000-0000000010.log");
+      files.insert("trace_0000000000-0000000010.clog");
+      verify_directory_contents(tempdir.path(), files);
+      block2 = sp.get_block(5);
+      BOOST_REQUIRE(block2);
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block2)), block_trace2_v2);
+
+      // removing the slice drops the mapped index
+      sp.run_maintenance_tasks(width + min_saved_blocks);
+      verify_directory_contents(tempdir.path(), std::set<bfs::path>());
+      BOOST_REQUIRE(!sp.get_block(1));
+      BOOST_REQUIRE(!sp.get_block(5));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(test_slice_cache_invalidate, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const bfs::path old_path = tempdir.path() / "old.log";
+      const bfs::path head_path = tempdir.path() / "head.log";
+      auto append = [](const bfs::path& path, const std::string& data) {
+         fc::cfile file;
+         file.set_file_path(path);
+         file.open(fc::cfile::create_or_update_rw_mode);
+         file.seek_end(0);
+         file.write(data.data(), data.size());
+         file.close();
+      };
+      append(old_path, "old");
+      append(head_path, "head");
+
+      slice_cache cache(4);
+      const auto old_file = cache.get(old_path);
+      const auto head_file = cache.get(head_path);
+      BOOST_REQUIRE(old_file);
+      BOOST_REQUIRE(head_file);
+      BOOST_REQUIRE(cache.get(old_path) == old_file);
+
+      // appending to the head slice only re-maps the head slice
+      append(head_path, "more");
+      cache.invalidate(head_path);
+      BOOST_REQUIRE(cache.get(old_path) == old_file);
+      const auto grown = cache.get(head_path);
+      BOOST_REQUIRE(grown);
+      BOOST_REQUIRE(grown != head_file);
+      BOOST_REQUIRE_EQUAL(grown->size(), 8u);
+      BOOST_REQUIRE_EQUAL(head_file->size(), 4u);
+      BOOST_REQUIRE(cache.get(head_path) == grown);
+
+      BOOST_REQUIRE(!cache.get(tempdir.path() / "missing.log"));
+   }
+
+   BOOST_FIXTURE_TEST_CASE(test_get_transaction_block, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      test_store_provider sp(tempdir.path(), width);
+
+      auto trx_a = transaction_trace;
+      trx_a.id = "000000000000000000000000000000000000000000000000000000000000000a"_h;
+      auto trx_b = transaction_trace;
+      trx_b.id = "000000000000000000000000000000000000000000000000000000000000000b"_h;
+      auto trx_c = transaction_trace;
+      trx_c.id = "000000000000000000000000000000000000000000000000000000000000000c"_h;
+
+      auto block1 = block_trace1_v2;
+      block1.transactions = std::vector<transaction_trace_v2>{ trx_a, trx_b };
+      auto block12 = block_trace2_v2;
+      block12.number = 12;
+      block12.transactions = std::vector<transaction_trace_v2>{ trx_b };
+      sp.append(block1);
+      sp.append(block12);
+
+      auto block_number = [&sp](const chain::transaction_id_type& id) -> std::optional<uint32_t> {
+         auto block = sp.get_transaction_block(id);
+         if (!block) {
+            return {};
+         }
+         return std::get<block_trace_v2>(std::get<0>(*block)).number;
+      };
+
+      // appended, unsorted indices
+      BOOST_REQUIRE_EQUAL(*block_number(trx_a.id), 1);
+      BOOST_REQUIRE_EQUAL(*block_number(trx_b.id), 12);
+      BOOST_REQUIRE(!block_number(trx_c.id));
+
+      // sorted indices of irreversible slices
+      sp.run_maintenance_tasks(2 * width);
+      BOOST_REQUIRE_EQUAL(*block_number(trx_a.id), 1);
+      BOOST_REQUIRE_EQUAL(*block_number(trx_b.id), 12);
+      BOOST_REQUIRE(!block_number(trx_c.id));
+
+      // entries appended after sorting
+      auto block13 = block_trace2_v2;
+      block13.number = 13;
+      block13.transactions = std::vector<transaction_trace_v2>{ trx_c };
+      sp.append(block13);
+      BOOST_REQUIRE_EQUAL(*block_number(trx_c.id), 13);
+
+      // forking out block 12 leaves the earlier block including trx_b
+      auto forked_block12 = block12;
+      forked_block12.id = "b000000000000000000000000000000000000000000000000000000000000012"_h;
+      forked_block12.transactions = std::vector<transaction_trace_v2>{};
+      sp.append(forked_block12);
+      BOOST_REQUIRE_EQUAL(*block_number(trx_b.id), 1);
+   }
+
+   BOOST_FIXTURE_TEST_CASE(test_get_block_zstd, test_fixture)
+   {
+      fc::temp_directory tempdir;
+      const uint32_t width = 10;
+      store_provider sp(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(), 0);
+      sp.append(block_trace1_v2);
+      sp.append_lib(1);
+      sp.append(block_trace2_v2);
+
+      slice_directory sd(tempdir.path(), width, std::optional<uint32_t>(), std::optional<uint32_t>(0), 0, slice_compression::zstd);
+      sd.run_maintenance_tasks(2 * width, {});
+      std::set<bfs::path> files;
+      files.insert("trace_index_0000000000-0000000010.log");
+      files.insert("trace_trx_0000000000-0000000010.log");
+      files.insert("trace_0000000000-0000000010.zlog");
+      verify_directory_contents(tempdir.path(), files);
+
+      // the index of a compressed slice is not compressed again
+      BOOST_REQUIRE(!compress_slice_blocks(tempdir.path() / "trace_0000000000-0000000010.zlog",
+                                           tempdir.path() / "trace_index_0000000000-0000000010.log",
+                                           tempdir.path() / "trace_copy.zlog", tempdir.path() / "trace_index_copy.log", 1));
+      verify_directory_contents(tempdir.path(), files);
+
+      get_block_t block1 = sp.get_block(1);
+      BOOST_REQUIRE(block1);
+      BOOST_REQUIRE(std::get<1>(*block1));
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block1)), block_trace1_v2);
+
+      get_block_t block2 = sp.get_block(5);
+      BOOST_REQUIRE(block2);
+      BOOST_REQUIRE(!std::get<1>(*block2));
+      BOOST_REQUIRE_EQUAL(std::get<block_trace_v2>(std::get<0>(*block2)), block_trace2_v2);
+
+      BOOST_REQUIRE(!sp.get_block(2));
+   }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -87,6 +87,10 @@ namespace {
          return store->get_block(height, yield);
       }
 
+      get_block_t get_transaction_block(const chain::transaction_id_type& trx_id, const yield_function& yield) {
+         return store->get_transaction_block(trx_id, yield);
+      }
+
       std::shared_ptr<Store> store;
    };
 }
@@ -109,6 +113,10 @@ struct trace_api_common_impl {
       cfg_options("trace-minimum-uncompressed-irreversible-history-blocks", boost::program_options::value<int32_t>()->default_value(-1),
                   "Number of blocks to ensure are uncompressed past LIB. Compressed \"slice\" files are still accessible but may carry a performance loss on retrieval\n"
                   "A value of -1 indicates that automatic compression of \"slice\" files will be turned off.");
+      cfg_options("trace-slice-compression", bpo::value<string>()->default_value("zlib"),
+                  "Format of automatically compressed \"slice\" files.\n"
+                  "\"zlib\" compresses a slice into a single seekable stream (\"clog\").\n"
+                  "\"zstd\" compresses every block trace of a slice separately (\"zlog\") so retrieving a block only decompresses that block.");
    }
 
    void plugin_initialize(const appbase::variables_map& options) {
@@ -137,12 +145,18 @@ struct trace_api_common_impl {
          minimum_uncompressed_irreversible_history_blocks = uncompressed_blocks;
       }
 
+      const auto compression_option = options.at("trace-slice-compression").as<string>();
+      EOS_ASSERT(compression_option == "zlib" || compression_option == "zstd", chain::plugin_config_exception,
+                 "\"trace-slice-compression\" must be either \"zlib\" or \"zstd\".");
+      compression = compression_option == "zstd" ? slice_compression::zstd : slice_compression::zlib;
+
       store = std::make_shared<store_provider>(
          trace_dir,
          slice_stride,
          minimum_irreversible_history_blocks,
          minimum_uncompressed_irreversible_history_blocks,
-         compression_seek_point_stride
+         compression_seek_point_stride,
+         compression
       );
    }
 
@@ -162,6 +176,7 @@ struct trace_api_common_impl {
 
    std::optional<uint32_t> minimum_irreversible_history_blocks;
    std::optional<uint32_t> minimum_uncompressed_irreversible_history_blocks;
+   slice_compression compression = slice_compression::zlib;
 
    static constexpr int32_t manual_slice_file_value = -1;
    static constexpr uint32_t compression_seek_point_stride = 6 * 1024 * 1024; // 6 MiB strides for clog seek points
@@ -285,6 +300,52 @@ struct trace_api_rpc_plugin_impl : public std::enable_shared_from_this<trace_api
             http_plugin::handle_exception("trace_api", "get_block", body, cb);
          }
       });
+
+      http.add_async_handler("/v1/trace_api/get_transaction_trace",
+            [wthis=weak_from_this(), max_response_time](std::string, std::string body, url_response_callback cb)
+      {
+         auto that = wthis.lock();
+         if (!that) {
+            return;
+         }
+
+         auto trx_id = ([&body]() -> std::optional<chain::transaction_id_type> {
+            if (body.empty()) {
+               return {};
+            }
+
+            try {
+               auto input = fc::json::from_string(body);
+               auto id = input.get_object()["id"].as_string();
+               if (id.size() != 2 * sizeof(chain::transaction_id_type)) {
+                  return {};
+               }
+               return chain::transaction_id_type(id);
+            } catch (...) {
+               return {};
+            }
+         })();
+
+         if (!trx_id) {
+            error_results results{400, "Bad or missing id"};
+            cb( 400, fc::variant( results ));
+            return;
+         }
+
+         try {
+
+            const auto deadline = that->calc_deadline( max_response_time );
+            auto resp = that->req_handler->get_transaction_trace(*trx_id, [deadline]() { FC_CHECK_DEADLINE(deadline); });
+            if (resp.is_null()) {
+               error_results results{404, "Transaction trace missing"};
+               cb( 404, fc::variant( results ));
+            } else {
+               cb( 200, std::move(resp) );
+            }
+         } catch (...) {
+            http_plugin::handle_exception("trace_api", "get_transaction_trace", body, cb);
+         }
+      });
    }
 
    void plugin_shutdown() {
@@ -1,4 +1,5 @@
 #include <eosio/trace_api/compressed_file.hpp>
+#include <eosio/trace_api/store_provider.hpp>
 #include <eosio/trace_api/cmd_registration.hpp>
 
 #include <iostream>
@@ -31,7 +32,7 @@ namespace {
    }
 
    std::string validate_output_path(const bpo::variables_map& vmap, const std::string& input_path) {
-      static const std::string default_output_extension = ".clog";
+      const std::string default_output_extension = vmap.count("zstd") ? ".zlog" : ".clog";
       std::string output_path;
       if (vmap.count("output-path")) {
          output_path = vmap.at("output-path").as<std::string>();
@@ -58,13 +59,30 @@ namespace {
       return output_path;
    }
 
+   /**
+    * the trace index of a slice is the file next to it with the "trace_" filename prefix replaced by "trace_index_"
+    */
+   bfs::path index_path_for(const bfs::path& trace_path) {
+      static const std::string trace_prefix = "trace_";
+      auto filename = trace_path.filename().generic_string();
+      if (filename.compare(0, trace_prefix.size(), trace_prefix) != 0) {
+         throw std::logic_error(std::string("Cannot locate the trace index of: ") + trace_path.generic_string() +
+                                ", trace file names start with \"" + trace_prefix + "\"");
+      }
+      return (trace_path.parent_path() / ("trace_index_" + filename.substr(trace_prefix.size()))).replace_extension(".log");
+   }
+
    void print_help_text(std::ostream& os, const bpo::options_description& opts) {
       os <<
          "Usage: trace_api_util compress <options> input-path [output-path]\n"
          "\n"
          "Compress a trace file to into the \"clog\" format.  By default the name of the\n"
          "of the compressed file will the the same as the input-path with a changing the\n"
-         "extension to \"clog\"."
+         "extension to \"clog\".\n"
+         "\n"
+         "With --zstd the file is compressed into the \"zlog\" format instead, where every\n"
+         "block trace is an independent zstd frame.  This reads the trace index next to the\n"
+         "input-path and writes the rewritten index next to the output file."
          "\n\n"
          "Positional Options:\n"
          "  input-path                      path to the file to compress\n"
@@ -80,6 +98,8 @@ namespace {
       opts("seek-point-stride,s", bpo::value<uint32_t>()->default_value(512),
            "the number of bytes between seek points in a compressed trace.  "
            "A smaller stride may degrade compression efficiency but increase read efficiency");
+      opts("zstd", "compress every block trace into an independent zstd frame (\"zlog\") instead");
+      opts("zstd-level", bpo::value<int>()->default_value(9), "the zstd compression level when using --zstd");
 
       if (global_args.count("help")) {
          print_help_text(std::cout, vis_desc);
@@ -105,10 +125,17 @@ namespace {
          if (global_args.count("help") == 0) {
             auto input_path = validate_input_path(vmap);
             auto output_path = validate_output_path(vmap, input_path);
-            auto seek_point_stride = vmap.at("seek-point-stride").as<uint32_t>();
-
-            if (!compressed_file::process(input_path, output_path, seek_point_stride)) {
-               throw std::runtime_error("Unexpected compression failure");
+            if (vmap.count("zstd")) {
+               if (!compress_slice_blocks(input_path, index_path_for(input_path), output_path, index_path_for(output_path),
+                                          vmap.at("zstd-level").as<int>())) {
+                  throw std::logic_error(input_path + " is already compressed");
+               }
+            } else {
+               auto seek_point_stride = vmap.at("seek-point-stride").as<uint32_t>();
+
+               if (!compressed_file::process(input_path, output_path, seek_point_stride)) {
+                  throw std::runtime_error("Unexpected compression failure");
+               }
             }
          } else {
             print_help_text(std::cout, vis_desc);
@@ -52,6 +52,7 @@ if [[ "$(echo ${VERSION} | sed 's/ .*//g')" == 8 ]]; then
 	install-package gmp-devel
     	install-package file
 	install-package libusbx-devel
+	install-package libzstd-devel
     	install-package libcurl-devel
 	install-package patch
         install-package vim-common
@@ -43,6 +43,7 @@ echo "class Eosio < Formula
    depends_on \"gmp\"
    depends_on \"openssl@1.1\"
    depends_on \"libusb\"
+   depends_on \"zstd\"
    depends_on \"libpqxx\"
    depends_on :macos => :mojave
    depends_on :arch =>  :intel
@@ -45,7 +45,7 @@ Version: ${VERSION_NO_SUFFIX}
 License: MIT
 Vendor: ${VENDOR} 
 Source: ${URL} 
-Requires: openssl, gmp, libstdc++, bzip2, libcurl, libusbx, ${LIBPQ}
+Requires: openssl, gmp, libstdc++, bzip2, libcurl, libusbx, libzstd, ${LIBPQ}
 URL: ${URL} 
 Packager: ${VENDOR} <${EMAIL}>
 Summary: ${DESC}
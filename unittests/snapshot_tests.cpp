@@ -389,6 +389,84 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(test_chain_id_in_snapshot, SNAPSHOT_SUITE, snapsho
    verify_integrity_hash<SNAPSHOT_SUITE>(*chain.control, *snap_chain.control);
 }
 
+BOOST_AUTO_TEST_CASE(test_parallel_snapshot_compatibility)
+{
+   tester chain;
+
+   chain.create_accounts({"snapshot"_n, "snapshot1"_n});
+   chain.produce_blocks(1);
+   chain.set_code("snapshot"_n, contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, contracts::snapshot_test_abi().data());
+   chain.set_code("snapshot1"_n, contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot1"_n, contracts::snapshot_test_abi().data());
+   chain.produce_blocks(1);
+   chain.push_action("snapshot"_n, "increment"_n, "snapshot"_n, mutable_variant_object()( "value", 1 ));
+   chain.push_action("snapshot1"_n, "increment"_n, "snapshot1"_n, mutable_variant_object()( "value", 1 ));
+   chain.produce_blocks(1);
+   chain.control->abort_block();
+
+   auto writer = parallel_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer);
+   auto snapshot = parallel_snapshot_suite::finalize(writer);
+
+   // readers of the binary format stop at the directory
+   snapshotted_tester binary_chain(chain.get_config(), buffered_snapshot_suite::get_reader(snapshot), 0);
+   verify_integrity_hash<buffered_snapshot_suite>(*chain.control, *binary_chain.control);
+
+   auto reader = parallel_snapshot_suite::get_reader(snapshot);
+   reader->validate();
+   BOOST_REQUIRE_EQUAL(16u, reader->section_parts("contract_tables"));
+   BOOST_REQUIRE_EQUAL(1u, reader->section_parts(eosio::chain::detail::snapshot_section_traits<account_object>::section_name()));
+
+   // a binary snapshot is read without a directory, in one part per section
+   auto binary_writer = buffered_snapshot_suite::get_writer();
+   chain.control->write_snapshot(binary_writer);
+   auto binary_snapshot = buffered_snapshot_suite::finalize(binary_writer);
+   auto binary_reader = parallel_snapshot_suite::get_reader(binary_snapshot);
+   binary_reader->validate();
+   BOOST_REQUIRE_EQUAL(1u, binary_reader->section_parts("contract_tables"));
+
+   snapshotted_tester parallel_chain(chain.get_config(), binary_reader, 1);
+   verify_integrity_hash<parallel_snapshot_suite>(*chain.control, *parallel_chain.control);
+}
+
+BOOST_AUTO_TEST_CASE(test_zstd_snapshot_integrity_hash)
+{
+   tester chain;
+
+   chain.create_account("snapshot"_n);
+   chain.produce_blocks(1);
+   chain.set_code("snapshot"_n, contracts::snapshot_test_wasm());
+   chain.set_abi("snapshot"_n, contracts::snapshot_test_abi().data());
+   chain.produce_blocks(1);
+   chain.push_action("snapshot"_n, "increment"_n, "snapshot"_n, mutable_variant_object()( "value", 1 ));
+   chain.produce_blocks(1);
+   chain.control->abort_block();
+
+   // the hash computed while writing is the hash of the state
+   auto writer = zstd_snapshot_suite::get_writer();
+   chain.control->write_snapshot(writer);
+   auto snapshot = zstd_snapshot_suite::finalize(writer);
+   BOOST_REQUIRE_EQUAL(chain.control->calculate_integrity_hash().str(), writer->get_integrity_hash().str());
+
+   // the header can only be returned to once, the sections read before are kept for the second pass
+   auto reader = zstd_snapshot_suite::get_reader(snapshot);
+   reader->validate();
+   BOOST_REQUIRE_EQUAL(chain.control->get_chain_id(), controller::extract_chain_id(*reader));
+   reader->return_to_header();
+   BOOST_REQUIRE_EQUAL(chain.control->get_chain_id(), controller::extract_chain_id(*reader));
+   BOOST_REQUIRE_THROW(reader->return_to_header(), snapshot_exception);
+
+   // a reader for one pass keeps no sections and cannot return to its header
+   auto one_pass_reader = zstd_snapshot_suite::get_reader(snapshot, false);
+   one_pass_reader->validate();
+   BOOST_REQUIRE_EQUAL(chain.control->get_chain_id(), controller::extract_chain_id(*one_pass_reader));
+   BOOST_REQUIRE_THROW(one_pass_reader->return_to_header(), snapshot_exception);
+
+   snapshotted_tester snap_chain(chain.get_config(), zstd_snapshot_suite::get_reader(snapshot), 0);
+   verify_integrity_hash<zstd_snapshot_suite>(*chain.control, *snap_chain.control);
+}
+
 static auto get_extra_args() {
    bool save_snapshot = false;
    bool generate_log = false;
@@ -406,7 +484,7 @@ static auto get_extra_args() {
    return std::make_tuple(save_snapshot, generate_log);
 }
 
-BOOST_AUTO_TEST_CASE_TEMPLATE(test_compatible_versions, SNAPSHOT_SUITE, snapshot_suites)
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_compatible_versions, SNAPSHOT_SUITE, stored_snapshot_suites)
 {
    const uint32_t legacy_default_max_inline_action_size = 4 * 1024;
    bool save_snapshot = false;
@@ -491,7 +569,7 @@ The fix is to save block.log and its corresponding snapshot with infight
 schedule changes, load the snapshot and replay the block.log on the new
 version, and verify their integrity.
 */
-BOOST_AUTO_TEST_CASE_TEMPLATE(test_pending_schedule_snapshot, SNAPSHOT_SUITE, snapshot_suites)
+BOOST_AUTO_TEST_CASE_TEMPLATE(test_pending_schedule_snapshot, SNAPSHOT_SUITE, stored_snapshot_suites)
 {
    static_assert(chain_snapshot_header::minimum_compatible_version <= 2, "version 2 unit test is no longer needed.  Please clean up data files");
 
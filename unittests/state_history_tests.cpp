@@ -10,6 +10,7 @@
 
 #include "test_cfd_transaction.hpp"
 #include <boost/filesystem.hpp>
+#include <boost/iostreams/device/array.hpp>
 
 #include <eosio/ship_protocol.hpp>
 #include <eosio/stream.hpp>
@@ -262,6 +263,89 @@ BOOST_AUTO_TEST_CASE(test_chain_state_log) {
    BOOST_CHECK_NO_THROW(from_bin(deltas, deltas_bin));
 }
 
+BOOST_AUTO_TEST_CASE(test_chain_state_log_stored_entry) {
+   using namespace eosio::state_history;
+   tester chain;
+
+   scoped_temp_path state_history_dir;
+   fc::create_directories(state_history_dir.path);
+   eosio::state_history_chain_state_log log({ .log_dir = state_history_dir.path });
+
+   uint32_t last_accepted_block_num = 0;
+
+   chain.control->accepted_block.connect([&](const block_state_ptr& block_state) {
+      log.store(chain.control->kv_db(), block_state);
+      last_accepted_block_num = block_state->block_num;
+   });
+
+   chain.produce_blocks(10);
+
+   log_entry stored = log.get_stored_log_entry(last_accepted_block_num);
+   BOOST_REQUIRE(stored.has_value());
+   BOOST_CHECK(stored.compression == static_cast<uint8_t>(log_entry_compression::zlib));
+
+   std::vector<char>         decompressed;
+   bio::filtering_istreambuf strm(bio::zlib_decompressor() | bio::array_source(stored.data.data(), stored.data.size()));
+   bio::copy(strm, bio::back_inserter(decompressed));
+   BOOST_CHECK(decompressed == log.get_log_entry(last_accepted_block_num));
+
+   // the stored entry is sent as is in get_blocks_result_v3
+   get_blocks_result_v3 message;
+   message.this_block = block_position{last_accepted_block_num, chain.control->head_block_id()};
+   message.deltas     = stored;
+   auto packed        = fc::raw::pack(state_result{message});
+
+   state_history_abi_serializer serializer(chain);
+   auto result = serializer.deserialize(packed, "result");
+   auto& result_variant = result.get_array();
+   BOOST_CHECK(result_variant[0].as_string() == "get_blocks_result_v3");
+   auto& deltas = result_variant[1].get_object()["deltas"].get_object();
+   BOOST_CHECK(deltas["compression"].as<uint8_t>() == stored.compression);
+   BOOST_CHECK(deltas["data"].as<eosio::chain::bytes>() == stored.data);
+}
+BOOST_AUTO_TEST_CASE(test_chain_state_log_zstd) {
+   using namespace eosio::state_history;
+   tester chain;
+
+   scoped_temp_path state_history_dir;
+   fc::create_directories(state_history_dir.path);
+   eosio::state_history_config config{ .log_dir                   = state_history_dir.path,
+                                       .compression               = eosio::state_history_compression::zstd,
+                                       .zstd_dict_training_blocks = 5 };
+   std::optional<eosio::state_history_chain_state_log> log;
+   log.emplace(config);
+
+   chain.control->accepted_block.connect([&](const block_state_ptr& block_state) {
+      log->store(chain.control->kv_db(), block_state);
+   });
+
+   chain.create_accounts({"alice"_n, "bob"_n, "carol"_n});
+   chain.produce_blocks(10);
+   // the dictionary is trained in the background, entries are stored without it until it is ready
+   log->wait_for_dictionary();
+   BOOST_CHECK(boost::filesystem::exists(state_history_dir.path / "chain_state_history.dict"));
+   chain.produce_blocks(10);
+
+   auto check_entries = [&]() {
+      for (auto block_num = log->begin_block(); block_num < log->end_block(); ++block_num) {
+         eosio::chain::bytes                            entry = log->get_log_entry(block_num);
+         std::vector<eosio::ship_protocol::table_delta> deltas;
+         eosio::input_stream                            deltas_bin{entry.data(), entry.data() + entry.size()};
+         BOOST_CHECK_NO_THROW(from_bin(deltas, deltas_bin));
+
+         log_entry stored = log->get_stored_log_entry(block_num);
+         if (stored.compression == static_cast<uint8_t>(log_entry_compression::none))
+            BOOST_CHECK(stored.data == entry);
+         else
+            BOOST_CHECK(stored.compression == static_cast<uint8_t>(log_entry_compression::zstd));
+      }
+   };
+   check_entries();
+
+   // entries written with and without the dictionary are readable after reopening the log
+   log.emplace(config);
+   check_entries();
+}
 
 struct state_history_tester_logs  {
    state_history_tester_logs(const eosio::state_history_config& config) 
@@ -709,6 +793,26 @@ BOOST_AUTO_TEST_CASE(test_deltas_account_metadata) {
 }
 
 
+BOOST_AUTO_TEST_CASE(test_deltas_parallel) {
+   for (backing_store_type backing_store : { backing_store_type::CHAINBASE, backing_store_type::ROCKSDB }) {
+      table_deltas_tester chain { backing_store };
+      chain.produce_block();
+
+      chain.create_account("newacc"_n);
+      chain.create_account("newacc2"_n);
+
+      eosio::chain::named_thread_pool thread_pool("test", 4);
+      for (bool full_snapshot : { false, true }) {
+         auto serial   = eosio::state_history::create_deltas(chain.control->kv_db(), full_snapshot);
+         auto parallel = eosio::state_history::create_deltas(chain.control->kv_db(), full_snapshot,
+                                                             &thread_pool.get_executor());
+         BOOST_REQUIRE(!serial.empty());
+         BOOST_REQUIRE(fc::raw::pack(serial) == fc::raw::pack(parallel));
+      }
+      thread_pool.stop();
+   }
+}
+
 BOOST_AUTO_TEST_CASE(test_deltas_account_permission) {
    for (backing_store_type backing_store : { backing_store_type::CHAINBASE, backing_store_type::ROCKSDB }) {
       table_deltas_tester chain { backing_store };
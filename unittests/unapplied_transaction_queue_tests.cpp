@@ -8,13 +8,13 @@ using namespace eosio::chain;
 
 BOOST_AUTO_TEST_SUITE(unapplied_transaction_queue_tests)
 
-auto unique_trx_meta_data( fc::time_point expire = fc::time_point::now() + fc::seconds( 120 ) ) {
+auto unique_trx_meta_data( fc::time_point expire = fc::time_point::now() + fc::seconds( 120 ),
+                          account_name creator = config::system_account_name ) {
 
    static uint64_t nextid = 0;
    ++nextid;
 
    signed_transaction trx;
-   account_name creator = config::system_account_name;
    trx.expiration = expire;
    trx.actions.emplace_back( vector<permission_level>{{creator,config::active_name}},
                              onerror{ nextid, "test", 4 });
@@ -496,4 +496,67 @@ BOOST_AUTO_TEST_CASE( unapplied_transaction_queue_incoming_count ) try {
 
 } FC_LOG_AND_RETHROW() /// unapplied_transaction_queue_incoming_count
 
+BOOST_AUTO_TEST_CASE( unapplied_transaction_queue_by_account ) try {
+
+   unapplied_transaction_queue q;
+   const auto expire = fc::time_point::now() + fc::seconds( 120 );
+   const account_name alice = "alice"_n;
+   const account_name bob = "bob"_n;
+
+   auto trx1 = unique_trx_meta_data( expire, alice );
+   auto trx2 = unique_trx_meta_data( expire, bob );
+   auto trx3 = unique_trx_meta_data( expire, alice );
+   auto trx4 = unique_trx_meta_data( expire, alice );
+   auto trx5 = unique_trx_meta_data( expire, bob );
+   auto trx6 = unique_trx_meta_data( expire, alice );
+
+   q.add_aborted( { trx1, trx2 } );
+   q.add_persisted( trx3 );
+   q.add_incoming( trx4, false, [](auto){} );
+   q.add_incoming( trx5, false, [](auto){} );
+   q.add_incoming( trx6, true, [](auto){} );
+
+   BOOST_CHECK_EQUAL( q.account_size( alice ), 4u );
+   BOOST_CHECK_EQUAL( q.account_size( bob ), 2u );
+   BOOST_CHECK_EQUAL( q.account_size( "carol"_n ), 0u );
+
+   std::vector<std::pair<account_name, size_t>> depths;
+   q.for_each_account( account_name(), [&]( const account_name& a, size_t n ) {
+      depths.emplace_back( a, n );
+      return true;
+   } );
+   BOOST_CHECK( depths == (std::vector<std::pair<account_name, size_t>>{ { alice, 4 }, { bob, 2 } }) );
+   depths.clear();
+   q.for_each_account( "alicf"_n, [&]( const account_name& a, size_t n ) {
+      depths.emplace_back( a, n );
+      return false;
+   } );
+   BOOST_CHECK( depths == (std::vector<std::pair<account_name, size_t>>{ { bob, 2 } }) );
+
+   // only the incoming transactions of alice
+   std::vector<transaction_metadata_ptr> erased;
+   size_t n = q.erase_account( alice, trx_enum_type::incoming_persisted, trx_enum_type::incoming,
+                               [&]( const unapplied_transaction& un ) { erased.push_back( un.trx_meta ); } );
+   BOOST_CHECK_EQUAL( n, 2u );
+   BOOST_REQUIRE_EQUAL( erased.size(), 2u );
+   BOOST_CHECK( erased[0] == trx6 );
+   BOOST_CHECK( erased[1] == trx4 );
+   BOOST_CHECK_EQUAL( q.account_size( alice ), 2u );
+   BOOST_CHECK_EQUAL( q.incoming_size(), 1u );
+   BOOST_CHECK_EQUAL( q.size(), 4u );
+
+   // a type changed by add_persisted is reindexed
+   q.add_persisted( trx1 );
+   n = q.erase_account( alice, trx_enum_type::forked, trx_enum_type::aborted, []( const auto& ) {} );
+   BOOST_CHECK_EQUAL( n, 0u );
+   n = q.erase_account( alice, trx_enum_type::persisted, trx_enum_type::persisted, []( const auto& ) {} );
+   BOOST_CHECK_EQUAL( n, 2u );
+   BOOST_CHECK_EQUAL( q.account_size( alice ), 0u );
+
+   BOOST_CHECK( next( q ) == trx2 );
+   BOOST_CHECK( next( q ) == trx5 );
+   BOOST_CHECK( q.empty() );
+
+} FC_LOG_AND_RETHROW() /// unapplied_transaction_queue_by_account
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// Microbenchmark of the fixed width RSA engine behind verify_rsa_sha256_sig against the generic
+// boost::multiprecision implementation it replaces.
+//
+// usage: benchmark_rsa [iterations]
+
+#include <eosio/chain/rsa.hpp>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace {
+
+using namespace boost::multiprecision;
+using clock_type = std::chrono::steady_clock;
+
+std::string random_hex(std::mt19937_64& rng, size_t digits) {
+   std::string hex;
+   for (size_t i = 0; i < digits; ++i)
+      hex += "0123456789abcdef"[rng() % 16];
+   return hex;
+}
+
+template <typename F>
+double average_us(uint32_t iterations, F&& f) {
+   auto start = clock_type::now();
+   for (uint32_t i = 0; i < iterations; ++i)
+      f();
+   return std::chrono::duration<double, std::micro>(clock_type::now() - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+   const uint32_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+   const std::string exponent = "010001";
+   std::mt19937_64 rng(0);
+
+   eosio::chain::rsa::key_cache cache(8);
+
+   std::cout << "bits  generic(us)  montgomery(us)  montgomery+parse(us)  montgomery+cache(us)\n";
+   for (size_t bits : { 1024, 2048, 4096 }) {
+      std::string modulus = random_hex(rng, bits / 4);
+      modulus.front() = 'c';
+      modulus.back() = 'b';
+      std::string signature = random_hex(rng, bits / 4);
+      signature.front() = '1';
+
+      double generic = average_us(iterations, [&]() {
+         const cpp_int signature_int{ "0x" + signature };
+         const cpp_int exponent_int{ "0x" + exponent };
+         const cpp_int modulus_int{ "0x" + modulus };
+         volatile bool r = powm(signature_int, exponent_int, modulus_int) == 0;
+         (void)r;
+      });
+
+      unsigned char out[eosio::chain::rsa::public_key::max_size];
+      auto key = *eosio::chain::rsa::public_key::from_hex(exponent, modulus);
+      double montgomery = average_us(iterations, [&]() { key.power(signature, out); });
+      double with_parse = average_us(iterations, [&]() {
+         eosio::chain::rsa::public_key::from_hex(exponent, modulus)->power(signature, out);
+      });
+
+      double with_cache = average_us(iterations, [&]() { cache.get(exponent, modulus)->power(signature, out); });
+
+      std::cout << bits << "  " << generic << "  " << montgomery << "  " << with_parse << "  " << with_cache << "\n";
+   }
+   return 0;
+}
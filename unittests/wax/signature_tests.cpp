@@ -3,14 +3,17 @@
 #include <eosio/chain/types.hpp>
 #include <eosio/testing/tester.hpp>
 
+#include <boost/algorithm/string/case_conv.hpp>
 #include <boost/multiprecision/cpp_int.hpp>
 
 #include <cstdint>
 #include <iterator>
+#include <random>
 #include <string>
 #include <vector>
 
 #include <contracts.hpp>
+#include <eosio/chain/rsa.hpp>
 #include "rsa_signer.hpp"
 
 using namespace eosio;
@@ -35,6 +38,20 @@ const std::string private_exponent_1024 =
 const std::string modulus_1024 =           
     "dff568a53cafdba7b1cd654fef54ed61649cdd6cb29fa743e35c73fcba7ef9c2b25a3b91e295abcea9aa5af0625f8b06428ec3140f2dd3c60c7dbb698cb3dbf6c64b1160daec4eb7d6deca1dfc45b83d5f30e5398f6f737ee394d57c8d2bf412f056c2e8a54d9bf554149c0da31346e31f23ffb516b1f9797d650169199b7add";
 
+const std::string public_exponent_65537 = "010001";
+
+const std::string private_exponent_2048 =
+    "409f7a596f4f934aa776ccc7c49642baa9a849fde692a3f5abae4278dd74e9e5f2c11378c90a9d6059c40c1e88f7653b62e2a4f5e02aba4d83a395466ea8cfcbfaa2677851a7d04cf1afbe9ebfd29fa359dfb1d44d74041a43bdeefb50b3798ca624dafcf94e3d574f5e3ff03db409dc98908ca3955cc0ab88ae9e7901359401873a208341abb3125aff1b7d362370f4fa40686ed5d6549dd3f6a34993e51c2cebcfdf4550721f475d03b84bb04e2c202ce6aaea41d5cebf5e3920da56c96bae8180f5243a1ec5c095307651ab75c08e3cb244e60930e36433f23cc8a799261e5866963091819af8cc0a4c2ca35558cada46581b1e4eb5f5382be064624ae7b1";
+
+const std::string modulus_2048 =
+    "a6f0bf54f4dffb9520117ad63136a14a9ee90b785d490c4c81580a0aaa5243a5d0833e74b9e3415f8e8adbefa4c1fd177516ee0f043811cd7ea2dd95d55bc6a1a12e19e3edb24f5f4afa1ae07eea9df8dc5febb2798c2ec8b7362b83a842045489c160a224924899636017e142775c40814badae1cda68268f8b42abea2b551411a04f0002b3f5c957d1b199e2d779b63fe538725b8396ed3c2f0d306f4d3c4a48404b8df4477612906c6befd0bbd4811922352781ceb1576f85a8f2d36a511c8843f9c9ac4ae0ba962e3364fd6f5c42bbfb87a6d14aff020d8fb88085c7e39e418e9bfc7753b15ab63e2ee33fbc8a14212695df58a0e8291ec020e958ad5f5f";
+
+const std::string private_exponent_4096 =
+    "2abea141a324e780f303e7078a738baf96817a7dca25f0bcc245aa12f816a541b4be990c2effb607ff76895ef449642513953c192df14b23a7c8d728c96748df90f94bfdc74063e68cb6bf26c972b510fe125ece40d4676a4694d3ae724b0aa28c307f19c0d566e27a5996014920019571967758494c68883b797578c0632cc00b7c3bca94a43ad42b9bbdc786fd32645b04427871d875ff18e40e2da269fbb87b7662c0024ad8d3ae4640afaa0693ae9483b6959ba8fcfcb80e1b58d4cdfc5bf082a15654c7e979d4a8fbe8924fa145ac6911c843958f357014688d1efb12f1cfbadffbb3a39d9d797a4cb10673e971d6d6f64917b9a01ca96532fd3d6117a698ddb677884c9f5f4f40b2465eb41b1386869e27a2ee484e5657270a5b31dd07c28d6e1211a54427e062eb365253d7077c8b9758d9d13c2250cf536144588630ec28b2c07f0a396636c42e2fe3eec4e60319b233917de8225b6ea122c8576daabe3c860e8dcfbf9fa43621cd4640f1249cad691394440ba2c34c582fb6526ea690c860bdd014be535a3eef6a77d88550bed1c0f51d6ce008a2f507279cf06fe396fda610dd7e4c4b51f1215c253eeb0b37a5831b341d35c43e321ac5c068553a701a71c2f8450264add32dbaba0776cbbe82c3390619a60e7514f171044217a0034961d376e95458cb7ef786883f4fa18f61ca9abdeca4479e2cef7e30647d";
+
+const std::string modulus_4096 =
+    "c523fe77ad2791815571ac246cb65ccd7ff543f19573351a996d51fdf5c75e3737df948bddf94b80bc9364a9b1584707b659b12cb6033ac2cb9fc21bb312e1cbcfead314feeb384a369d2041c55790e3d11ea34cc5c06fd11a037a58adbd8f5f9ee5c11e8925c93e5f1196eebde6951afc903ba52272852d0e75dbc39df07f1d594ebe93a28ad019e238aef2878b6d9d6eee1e4495bd63caabdee1f4db371545202f53f5f0e465bbed2e445e82f38533e901f2691c8e167b3e3654a9199c6af87e284ac3f8942561a81752ced12e3edaee6dd9f767d158628412b78bc9b656cb4eaf46c1c6fbfa76dc323fbdb7391d7856011c25022e25c06838f032f0797185fa85049c0013a0141e6c4cc13f480e4da9491c1d880404db6a1be4d53affa53705406de6329e55bb0ff723c1b8dda066d70a39b79cc281a42a138b7ef98d6eb85ac7e3ffc6de19fd1bd7496946bde8444eca1b7e3b5644b1a0fe9a85d7b1260e19c72998853d40bda878946cb7b5f8f31537f0e2a4be7c52e1a52eb1115f79fcb4e38dd31b148d0b306ac64e10db5200f70d6b696f3b35a0248fada21aca8e069133ecd15e5964fb7867c584bd9f1739840afb09fac60d12078dcbf5a17878aa814b7da33037263e2ecc5b93b238e58488dfaf6e1eb2fd31604ece550b40c357f30737d455ff2c1ed6d6a41430a85cbe4e159b9146bb7cc05fbde561c303ad99";
+
 struct __attribute((packed)) results_entry {
     std::uint64_t id;
     bool          value;
@@ -169,4 +186,157 @@ BOOST_FIXTURE_TEST_CASE(corrupted_sginature, wax_fixture) {
 }
 
 
+BOOST_FIXTURE_TEST_CASE(signing_2048_and_4096, wax_fixture) {
+    try {
+        const std::string msg = "message to sign";
+
+        for (const auto& [private_exp, modulus] : { std::pair{ private_exponent_2048, modulus_2048 },
+                                                    std::pair{ private_exponent_4096, modulus_4096 } }) {
+            wax::rsa_signer wide_signer(private_exp, modulus);
+            std::string signature = wide_signer.sign(msg);
+            signature.insert(0, modulus.size() - signature.size(), '0');
+
+            action_verrsasig(msg, signature, public_exponent_65537, modulus);
+            BOOST_REQUIRE(get_last_result());
+
+            // odd number of exponent digits and upper case digits
+            action_verrsasig(msg, signature, "10001", boost::algorithm::to_upper_copy(modulus));
+            BOOST_REQUIRE(get_last_result());
+
+            action_verrsasig("another message", signature, public_exponent_65537, modulus);
+            BOOST_REQUIRE(!get_last_result());
+        }
+    }
+    FC_LOG_AND_RETHROW();
+}
+
+// moduli the fixed width engine does not cover take the generic path with the same results
+BOOST_FIXTURE_TEST_CASE(generic_path_moduli, wax_fixture) {
+    try {
+        const std::string msg = "message to sign";
+        const auto digest = fc::sha256::hash(msg.data(), msg.size());
+
+        for (size_t size : { 128, 256, 600 }) {
+            // with an exponent of 1 the encoded message is its own signature
+            std::string em = "0001" + std::string(2 * (size - 54), 'f') + "00" +
+                             "3031300d060960864801650304020105000420" + digest.str();
+            BOOST_REQUIRE_EQUAL(em.size(), 2 * size);
+
+            const std::string odd_modulus = std::string(2 * size, 'f');
+            const std::string even_modulus = std::string(2 * size - 1, 'f') + "e";
+            BOOST_REQUIRE_EQUAL(eosio::chain::rsa::public_key::from_hex("1", odd_modulus).has_value(), size <= 512);
+            BOOST_REQUIRE(!eosio::chain::rsa::public_key::from_hex("1", even_modulus));
+
+            action_verrsasig(msg, em, "1", odd_modulus);
+            BOOST_REQUIRE(get_last_result());
+            action_verrsasig(msg, em, "0001", even_modulus);
+            BOOST_REQUIRE(get_last_result());
+            action_verrsasig(msg, em, "3", odd_modulus);
+            BOOST_REQUIRE(!get_last_result());
+            action_verrsasig(msg, "X" + em.substr(1), "1", odd_modulus);
+            BOOST_REQUIRE(!get_last_result());
+        }
+    }
+    FC_LOG_AND_RETHROW();
+}
+
+BOOST_AUTO_TEST_CASE(montgomery_engine_equivalence) {
+    using namespace boost::multiprecision;
+
+    std::mt19937_64 rng(7);
+    auto random_hex = [&](size_t digits) {
+        std::string hex;
+        for (size_t i = 0; i < digits; ++i)
+            hex += "0123456789abcdef"[rng() % 16];
+        return hex;
+    };
+
+    for (size_t size : { 62, 64, 100, 128, 129, 200, 256, 300, 384, 512 }) {
+        for (int i = 0; i < 24; ++i) {
+            std::string modulus = random_hex(2 * size);
+            modulus.back() = "13579bdf"[rng() % 8];
+            if (i % 4 == 1)
+                modulus.replace(0, 3, "000");
+
+            std::string exponent;
+            switch (i % 6) {
+                case 0: exponent = public_exponent_65537; break;
+                case 1: exponent = "3"; break;
+                case 2: exponent = "0"; break;
+                case 3: exponent = "1"; break;
+                case 4: exponent = random_hex(2 * size); break;
+                default: exponent = random_hex(1 + rng() % 20); break;
+            }
+
+            // includes signatures larger than the modulus
+            std::string signature = i % 3 ? random_hex(2 * size) : std::string(2 * size, 'f');
+
+            auto key = eosio::chain::rsa::public_key::from_hex(exponent, modulus);
+            BOOST_REQUIRE(key);
+            BOOST_REQUIRE_EQUAL(key->size(), size);
+
+            unsigned char out[eosio::chain::rsa::public_key::max_size];
+            BOOST_REQUIRE(key->power(signature, out));
+
+            const cpp_int expected = powm(cpp_int{ "0x" + signature }, cpp_int{ "0x" + exponent },
+                                          cpp_int{ "0x" + modulus });
+            cpp_int result;
+            import_bits(result, out, out + size);
+            BOOST_REQUIRE_EQUAL(result, expected);
+
+            BOOST_REQUIRE(!key->power(signature.substr(1), out));
+            BOOST_REQUIRE(!key->verify_sha256(fc::sha256(), "g" + signature.substr(1)));
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_CASE(intrinsic_key_cache_hits, wax_fixture) {
+    try {
+        const std::string msg = "message to sign";
+        std::string signature = signer.sign(msg);
+
+        action_verrsasig(msg, signature, public_exponent_1024, modulus_1024);
+        BOOST_REQUIRE(get_last_result());
+        const auto before = eosio::chain::rsa::intrinsic_key_cache().get_stats();
+
+        action_verrsasig(msg, signature, public_exponent_1024, modulus_1024);
+        BOOST_REQUIRE(get_last_result());
+        const auto after = eosio::chain::rsa::intrinsic_key_cache().get_stats();
+
+        // the action may be applied more than once by validating testers, but the key is never parsed again
+        BOOST_REQUIRE_GT(after.hits, before.hits);
+        BOOST_REQUIRE_EQUAL(after.misses, before.misses);
+    }
+    FC_LOG_AND_RETHROW();
+}
+
+BOOST_AUTO_TEST_CASE(key_cache_eviction) {
+    eosio::chain::rsa::key_cache cache(2);
+
+    auto key_1 = cache.get(public_exponent_1024, modulus_1024);
+    auto key_2 = cache.get(public_exponent_65537, modulus_2048);
+    BOOST_REQUIRE(key_1 && key_2);
+    BOOST_REQUIRE(cache.get(public_exponent_1024, modulus_1024) == key_1);
+    BOOST_REQUIRE_EQUAL(cache.get_stats().hits, 1u);
+    BOOST_REQUIRE_EQUAL(cache.get_stats().misses, 2u);
+
+    // the same modulus with another exponent is another key
+    auto key_3 = cache.get(public_exponent_65537, modulus_1024);
+    BOOST_REQUIRE(key_3 && key_3 != key_1);
+    BOOST_REQUIRE_EQUAL(cache.get_stats().size, 2u);
+
+    // key_2 was the least recently used
+    BOOST_REQUIRE(cache.get(public_exponent_1024, modulus_1024) == key_1);
+    BOOST_REQUIRE(cache.get(public_exponent_65537, modulus_2048) != key_2);
+    BOOST_REQUIRE_EQUAL(cache.get_stats().hits, 2u);
+    BOOST_REQUIRE_EQUAL(cache.get_stats().misses, 4u);
+
+    // unsupported keys are not cached
+    BOOST_REQUIRE(!cache.get("3", std::string(256, 'e')));
+    BOOST_REQUIRE_EQUAL(cache.get_stats().size, 2u);
+
+    cache.clear();
+    BOOST_REQUIRE_EQUAL(cache.get_stats().size, 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END() // wax_tests